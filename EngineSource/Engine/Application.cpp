@@ -153,20 +153,18 @@ static void ApplicationLoop()
 	}
 #endif
 #if SERVER
-
-	if (Networking::GetTickDelta() > Stats::DeltaTime)
+	// Sleep to maintain a constant update rate on a server.
+	// Ticks are scheduled at absolute deadlines, so the time spent in each tick and oversleeping don't add up.
+	static uint64_t NextTickTime = OS::GetMonotonicTime();
+	uint64_t TickInterval = uint64_t(1'000'000'000.0 / Networking::GetTickRate());
+	uint64_t Now = OS::GetMonotonicTime();
+	NextTickTime += TickInterval;
+	if (NextTickTime + TickInterval < Now)
 	{
-		// Sleep to maintain a constant update rate on a server
-		float SleepDelay = Networking::GetTickDelta() - Stats::DeltaTime;
-
-		SDL_Delay(std::max(Uint32(1000.0f * SleepDelay), Uint32(1)) - 1);
-
-		// Hack since Windows doesn't allow sleeping for less than one millisecond.
-		while (FrameTimer.Get() < Networking::GetTickDelta())
-		{
-			continue;
-		}
+		// More than a whole tick behind, don't try to catch up with a burst of ticks.
+		NextTickTime = Now;
 	}
+	OS::SleepUntil(NextTickTime);
 
 	Stats::DeltaTime = FrameTimer.Get();
 #endif
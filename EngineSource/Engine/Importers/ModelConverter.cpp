@@ -8,6 +8,7 @@
 #include <assimp/postprocess.h>
 #include <UI/EditorUI/Popups/DialogBox.h>
 #include <Engine/EngineError.h>
+#include <Rendering/Mesh/ModelGenerator.h>
 
 namespace fs = std::filesystem;
 uint8_t NumMaterials = 0;
@@ -106,53 +107,31 @@ std::string ModelImporter::Import(std::string Name, std::string CurrentFilepath)
 			});
 			return "";
 		}
-		std::ofstream Output(OutputFileName, std::ios::out | std::ios::binary);
-		int iNumMaterials = NumMaterials;
-		Output.write((char*)&iNumMaterials, sizeof(int));
+		ModelGenerator::ModelData ImportedModel;
+		ImportedModel.CastShadow = true;
+		ImportedModel.HasCollision = true;
+		ImportedModel.TwoSided = false;
 
 		float Scale = FileUtil::GetExtension(Name) == "fbx" ? 1.0f : 100.0f;
 
 		for (int j = 0; j < NumMaterials; j++)
 		{
-			ImportMesh CurrentMesh = Meshes.at(j);
-			int NumVertices = (int)CurrentMesh.Positions.size();
-			int NumIndices = (int)CurrentMesh.Indicies.size();
-
-			Output.write((char*)&NumVertices, sizeof(int));
-			Output.write((char*)&NumIndices, sizeof(int));
-
-			for (auto& i : CurrentMesh.Positions)
-			{
-				i = i * Scale;
-			}
-
-
-			for (int i = 0; i < NumVertices; i++)
-			{
-				Output.write((char*)&CurrentMesh.Positions.at(i).X, sizeof(float));
-				Output.write((char*)&CurrentMesh.Positions.at(i).Y, sizeof(float));
-				Output.write((char*)&CurrentMesh.Positions.at(i).Z, sizeof(float));
-				Output.write((char*)&CurrentMesh.Normals.at(i).X, sizeof(float));
-				Output.write((char*)&CurrentMesh.Normals.at(i).Y, sizeof(float));
-				Output.write((char*)&CurrentMesh.Normals.at(i).Z, sizeof(float));
-				Output.write((char*)&CurrentMesh.UVs.at(i).X, sizeof(float));
-				Output.write((char*)&CurrentMesh.UVs.at(i).Y, sizeof(float));
-			}
-			for (int i = 0; i < NumIndices; i++)
+			const ImportMesh& CurrentMesh = Meshes.at(j);
+			auto& Elem = ImportedModel.AddElement();
+			Elem.ElemMaterial = "NONE";
+			Elem.Vertices.resize(CurrentMesh.Positions.size());
+			for (size_t i = 0; i < CurrentMesh.Positions.size(); i++)
 			{
-				Output.write((char*)&CurrentMesh.Indicies.at(i), sizeof(int));
+				Elem.Vertices[i].Position = CurrentMesh.Positions[i] * Scale;
+				Elem.Vertices[i].Normal = CurrentMesh.Normals[i];
+				Elem.Vertices[i].TexCoord = glm::vec2(CurrentMesh.UVs[i].X, CurrentMesh.UVs[i].Y);
 			}
-			std::string DefaultMaterial = "NONE";
-			size_t size = DefaultMaterial.size();
-			Output.write((char*)&size, sizeof(size_t));
-			Output.write(DefaultMaterial.c_str(), sizeof(char) * size);
+			Elem.Indices.assign(CurrentMesh.Indicies.begin(), CurrentMesh.Indicies.end());
+			Elem.RemoveDuplicateVertices(0.001f, true);
+			Elem.Optimize();
+			Elem.GenerateLODs();
 		}
-		bool CastShadow = true;
-		bool TwoSided = false;
-		Output.write((char*)&CastShadow, sizeof(uint8_t));
-		Output.write((char*)&CastShadow, sizeof(uint8_t));
-		Output.write((char*)&TwoSided, sizeof(uint8_t));
-		Output.close();
+		ImportedModel.SaveModelData(OutputFileName);
 		return OutputFileName;
 	}
 	else Log::Print(Name + " does not exist");
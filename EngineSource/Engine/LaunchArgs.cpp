@@ -11,6 +11,7 @@
 #include <Engine/Application.h>
 #include "AppWindow.h"
 #include "LaunchArgs.h"
+#include <Networking/Networking.h>
 
 namespace LaunchArgs
 {
@@ -103,6 +104,23 @@ namespace LaunchArgs
 		Log::EnableColoredOutput(false);
 	}
 
+	static void SetTickRate(std::vector<std::string> AdditionalArgs)
+	{
+		if (AdditionalArgs.size() != 1)
+		{
+			Log::Print("Unexpected or missing arguments in -tickrate", Log::LogColor::Yellow);
+			return;
+		}
+		try
+		{
+			Networking::TickRate = std::stoi(AdditionalArgs[0]);
+		}
+		catch (std::exception&)
+		{
+			Log::Print("Invalid tick rate in -tickrate: " + AdditionalArgs[0], Log::LogColor::Yellow);
+		}
+	}
+
 	std::map<std::string, void(*)(std::vector<std::string>)> Commands =
 	{
 		std::pair("neverhideconsole", &NeverHideConsole),
@@ -117,6 +135,7 @@ namespace LaunchArgs
 		std::pair("nocolor", &NoColor),
 		std::pair("connect", &Connect),
 		std::pair("verbose", &LogVerbose),
+		std::pair("tickrate", &SetTickRate),
 #if !RELEASE
 		std::pair("editorPath", &EditorPath),
 #endif
@@ -124,6 +143,9 @@ namespace LaunchArgs
 		std::pair("quitondisconnect", [](std::vector<std::string> arg) {
 			NetworkSubsystem::QuitOnDisconnect();
 		}),
+		std::pair("adaptivetickrate", [](std::vector<std::string> arg) {
+			Networking::AdaptiveTickRate = true;
+		}),
 #endif
 	};
 
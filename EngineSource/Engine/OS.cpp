@@ -10,6 +10,8 @@
 
 #if __linux__
 #include <unistd.h>
+#include <time.h>
+#include <cerrno>
 #include <ios>
 #include <iostream>
 #include <pwd.h>
@@ -330,3 +332,69 @@ void OS::OpenFile(std::string Path)
 	int ret = system(("xdg-open " + Path + " &").c_str());
 }
 #endif
+
+#if _WIN32
+uint64_t OS::GetMonotonicTime()
+{
+	static LARGE_INTEGER Frequency = []()
+		{
+			LARGE_INTEGER Value;
+			QueryPerformanceFrequency(&Value);
+			return Value;
+		}();
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	return uint64_t(Counter.QuadPart / Frequency.QuadPart) * 1'000'000'000ull
+		+ uint64_t(Counter.QuadPart % Frequency.QuadPart) * 1'000'000'000ull / uint64_t(Frequency.QuadPart);
+}
+
+void OS::SleepUntil(uint64_t Deadline)
+{
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+	// High resolution timers aren't limited to the 1ms (or worse) resolution of Sleep(). Requires Windows 10 1803.
+	static HANDLE Timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+	uint64_t Now = GetMonotonicTime();
+	while (Now < Deadline)
+	{
+		if (Timer)
+		{
+			LARGE_INTEGER DueTime;
+			// Negative values are relative, in 100 nanosecond intervals.
+			DueTime.QuadPart = -int64_t((Deadline - Now) / 100);
+			if (DueTime.QuadPart == 0 || !SetWaitableTimer(Timer, &DueTime, 0, NULL, NULL, FALSE))
+			{
+				return;
+			}
+			WaitForSingleObject(Timer, INFINITE);
+		}
+		else
+		{
+			uint64_t Milliseconds = (Deadline - Now) / 1'000'000;
+			Sleep(DWORD(Milliseconds > 0 ? Milliseconds : 1));
+		}
+		Now = GetMonotonicTime();
+	}
+}
+#endif
+#if __linux__
+uint64_t OS::GetMonotonicTime()
+{
+	timespec Time;
+	clock_gettime(CLOCK_MONOTONIC, &Time);
+	return uint64_t(Time.tv_sec) * 1'000'000'000ull + uint64_t(Time.tv_nsec);
+}
+
+void OS::SleepUntil(uint64_t Deadline)
+{
+	timespec Time;
+	Time.tv_sec = time_t(Deadline / 1'000'000'000ull);
+	Time.tv_nsec = long(Deadline % 1'000'000'000ull);
+	// An absolute deadline doesn't drift if the sleep is interrupted by a signal and restarted.
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Time, nullptr) == EINTR)
+	{
+	}
+}
+#endif
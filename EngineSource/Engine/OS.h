@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <cstdint>
 
 /*
 * For the compilation to work on both Linux and Windows, 
@@ -33,4 +34,14 @@ namespace OS
 	std::string GetOSString();
 	void SetConsoleColor(ConsoleColor NewColor);
 	void OpenFile(std::string Path);
+
+	/// Returns the time of a monotonic clock in nanoseconds. Only useful for comparing with other results and SleepUntil().
+	uint64_t GetMonotonicTime();
+	/**
+	* @brief
+	* Sleeps until GetMonotonicTime() reaches Deadline. Returns immediately if the deadline has passed.
+	*
+	* Uses clock_nanosleep() on Linux and a high resolution waitable timer on Windows, so it doesn't busy wait.
+	*/
+	void SleepUntil(uint64_t Deadline);
 }
\ No newline at end of file
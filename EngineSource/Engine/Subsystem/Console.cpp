@@ -14,6 +14,9 @@
 #include <Engine/File/Assets.h>
 #include <Engine/Stats.h>
 #include <Rendering/Graphics.h>
+#include <Rendering/Mesh/ModelCache.h>
+#include <Rendering/Mesh/ModelGenerator.h>
+#include <Engine/Utility/FileUtility.h>
 #include <iostream>
 #if __linux__
 #include <poll.h>
@@ -287,8 +290,56 @@ Console::Console()
 			{
 				Print(i.Filepath + " - " + i.Name);
 			}
+#if !SERVER
+			Print("Loaded models:");
+			for (const ModelCache::CachedModel* i : ModelCache::GetCachedModels())
+			{
+				Print(i->File + " - " + std::to_string(i->References) + " references, "
+					+ std::to_string(i->GetMemorySize() / 1024) + "KB");
+			}
+			ModelCache::CacheStats ModelStats = ModelCache::GetStats();
+			size_t TotalLoads = ModelStats.Hits + ModelStats.Misses;
+			Print("Model cache: " + std::to_string(ModelStats.Hits) + "/" + std::to_string(TotalLoads) + " hits ("
+				+ std::to_string(TotalLoads ? ModelStats.Hits * 100 / TotalLoads : 0) + "%), "
+				+ std::to_string(ModelStats.UsedBytes / 1024) + "KB used, "
+				+ std::to_string(ModelStats.SavedBytes / 1024) + "KB saved");
+#endif
 		}, {  }));
 
+	RegisterCommand(Command("convert_models", [this]()
+		{
+			bool Quantize = CommandArgs().size() > 0 && CommandArgs()[0] != "0";
+			size_t NumConverted = 0;
+			uintmax_t OldSize = 0, NewSize = 0;
+			for (auto& i : Assets::Assets)
+			{
+				if (FileUtil::GetExtension(i.Filepath) != "jsm")
+				{
+					continue;
+				}
+				// Files that are already in the current format are only written again if they should be quantized.
+				if (!Quantize && ModelGenerator::ModelData::GetFileVersion(i.Filepath) != 1)
+				{
+					continue;
+				}
+				uintmax_t PreviousSize = std::filesystem::file_size(i.Filepath);
+				ModelGenerator::ModelData Data;
+				Data.LoadModelFromFile(i.Filepath);
+				if (Data.Elements.empty())
+				{
+					Print("Could not convert " + i.Filepath, ErrorLevel::Error);
+					continue;
+				}
+				Data.SaveModelData(i.Filepath, Quantize);
+				OldSize += PreviousSize;
+				NewSize += std::filesystem::file_size(i.Filepath);
+				NumConverted++;
+				Print("Converted " + i.Filepath);
+			}
+			Print("Converted " + std::to_string(NumConverted) + " models ("
+				+ std::to_string(OldSize / 1024) + "KB -> " + std::to_string(NewSize / 1024) + "KB)");
+		}, { Command::Argument("quantize", NativeType::Bool, true) }));
+
 	RegisterCommand(Command("get_class", [this]()
 		{
 			for (const auto& i : Objects::ObjectTypes)
@@ -19,6 +19,7 @@
 #include <Engine/EngineProperties.h>
 #include <Engine/Subsystem/Console.h>
 #include <Networking/Server.h>
+#include <Networking/Networking.h>
 
 // Old scene files do not save the fog and sun properties
 #define SAVE_FOG_AND_SUN 1
@@ -95,6 +96,7 @@ void Scene::LoadSceneInternally(std::string FilePath)
 		SceneObject::DestroyMarkedObjects(false);
 
 		Objects::AllObjects.clear();
+		Networking::ClearReplicatedObjects();
 #if !SERVER
 		BakedLighting::LoadEmpty();
 		if (!IsInEditor)
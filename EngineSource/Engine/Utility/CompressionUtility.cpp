@@ -0,0 +1,151 @@
+#include "CompressionUtility.h"
+#include <cstring>
+#include <algorithm>
+
+namespace CompressionUtil
+{
+	constexpr size_t HASH_BITS = 12;
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t MAX_OFFSET = UINT16_MAX;
+	// Like LZ4, the last bytes of the input are always literals.
+	constexpr size_t END_LITERALS = 5;
+
+	static void WriteLength(std::vector<uint8_t>& Out, size_t Length)
+	{
+		while (Length >= 255)
+		{
+			Out.push_back(255);
+			Length -= 255;
+		}
+		Out.push_back((uint8_t)Length);
+	}
+
+	static void WriteSequence(std::vector<uint8_t>& Out, const uint8_t* Literals, size_t NumLiterals, size_t Offset, size_t MatchLength)
+	{
+		size_t MatchToken = MatchLength ? MatchLength - MIN_MATCH : 0;
+		Out.push_back((uint8_t)((std::min(NumLiterals, size_t(15)) << 4) | std::min(MatchToken, size_t(15))));
+		if (NumLiterals >= 15)
+		{
+			WriteLength(Out, NumLiterals - 15);
+		}
+		Out.insert(Out.end(), Literals, Literals + NumLiterals);
+
+		// The last sequence only has literals.
+		if (!MatchLength)
+		{
+			return;
+		}
+		Out.push_back((uint8_t)(Offset & 0xff));
+		Out.push_back((uint8_t)(Offset >> 8));
+		if (MatchToken >= 15)
+		{
+			WriteLength(Out, MatchToken - 15);
+		}
+	}
+
+	static bool ReadLength(const uint8_t*& Data, const uint8_t* End, size_t& Length)
+	{
+		uint8_t Next = 255;
+		while (Next == 255)
+		{
+			if (Data >= End)
+			{
+				return false;
+			}
+			Next = *Data++;
+			Length += Next;
+		}
+		return true;
+	}
+
+	size_t Compress(const uint8_t* Data, size_t Size, std::vector<uint8_t>& Out)
+	{
+		const size_t StartSize = Out.size();
+		// Positions + 1 of the last occurrence of each hashed 4 byte sequence. 0 means empty.
+		std::vector<uint32_t> Table = std::vector<uint32_t>(size_t(1) << HASH_BITS, 0);
+
+		const size_t MatchEnd = Size > END_LITERALS ? Size - END_LITERALS : 0;
+		size_t Anchor = 0;
+		size_t i = 0;
+		while (i + MIN_MATCH <= MatchEnd)
+		{
+			uint32_t Sequence;
+			std::memcpy(&Sequence, Data + i, sizeof(Sequence));
+			uint32_t Hash = (Sequence * 2654435761u) >> (32 - HASH_BITS);
+			size_t Candidate = Table[Hash];
+			Table[Hash] = (uint32_t)(i + 1);
+
+			if (Candidate == 0 || i - (Candidate - 1) > MAX_OFFSET || std::memcmp(Data + Candidate - 1, Data + i, MIN_MATCH) != 0)
+			{
+				i++;
+				continue;
+			}
+
+			const size_t Match = Candidate - 1;
+			size_t Length = MIN_MATCH;
+			while (i + Length < MatchEnd && Data[Match + Length] == Data[i + Length])
+			{
+				Length++;
+			}
+			WriteSequence(Out, Data + Anchor, i - Anchor, i - Match, Length);
+			i += Length;
+			Anchor = i;
+		}
+		WriteSequence(Out, Data + Anchor, Size - Anchor, 0, 0);
+		return Out.size() - StartSize;
+	}
+
+	bool Decompress(const uint8_t* Data, size_t Size, uint8_t* Out, size_t OutSize)
+	{
+		const uint8_t* End = Data + Size;
+		size_t Written = 0;
+		while (Data < End)
+		{
+			uint8_t Token = *Data++;
+
+			size_t NumLiterals = Token >> 4;
+			if (NumLiterals == 15 && !ReadLength(Data, End, NumLiterals))
+			{
+				return false;
+			}
+			if (NumLiterals > size_t(End - Data) || NumLiterals > OutSize - Written)
+			{
+				return false;
+			}
+			std::memcpy(Out + Written, Data, NumLiterals);
+			Data += NumLiterals;
+			Written += NumLiterals;
+
+			if (Data == End)
+			{
+				break;
+			}
+
+			if (End - Data < 2)
+			{
+				return false;
+			}
+			size_t Offset = size_t(Data[0]) | (size_t(Data[1]) << 8);
+			Data += 2;
+			size_t Length = Token & 0xf;
+			if (Length == 15 && !ReadLength(Data, End, Length))
+			{
+				return false;
+			}
+			Length += MIN_MATCH;
+
+			if (Offset == 0 || Offset > Written || Length > OutSize - Written)
+			{
+				return false;
+			}
+			// The match may overlap with the bytes it writes, so it's copied byte by byte.
+			const uint8_t* From = Out + Written - Offset;
+			for (size_t i = 0; i < Length; i++)
+			{
+				Out[Written + i] = From[i];
+			}
+			Written += Length;
+		}
+		return Written == OutSize;
+	}
+}
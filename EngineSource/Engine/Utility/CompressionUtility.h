@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+* @file
+*
+* @brief
+* Fast lossless compression for binary data.
+*/
+
+/**
+* @brief
+* Namespace containing a small LZ77 codec.
+*
+* The format follows the LZ4 block format: Each sequence is a token byte, a run of literal bytes,
+* a 2 byte offset and a match length. It's meant for data that has to be decompressed quickly, like lightmaps.
+* Runs of the same byte are encoded as a match with an offset of 1, so data with long runs compresses well.
+*/
+namespace CompressionUtil
+{
+	/**
+	* @brief
+	* Compresses Size bytes of Data and appends the result to Out.
+	*
+	* @return
+	* The number of bytes appended to Out.
+	*/
+	size_t Compress(const uint8_t* Data, size_t Size, std::vector<uint8_t>& Out);
+
+	/**
+	* @brief
+	* Decompresses data created with Compress().
+	*
+	* @param Out
+	* The buffer the decompressed data is written to. Must be OutSize bytes large.
+	*
+	* @return
+	* True if the data was valid and decompressed to exactly OutSize bytes, false if not.
+	*/
+	bool Decompress(const uint8_t* Data, size_t Size, uint8_t* Out, size_t OutSize);
+}
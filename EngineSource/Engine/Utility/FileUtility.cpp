@@ -6,6 +6,11 @@
 
 #if _WIN32
 #include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 #include <filesystem>
 namespace FileUtil
@@ -131,4 +136,72 @@ namespace FileUtil
 
 		return Latest;
 	}
+
+	MappedFile::MappedFile(std::string FilePath)
+	{
+#if _WIN32
+		HANDLE File = CreateFileA(FilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+		FileHandle = File;
+		LARGE_INTEGER FileSize;
+		if (!GetFileSizeEx(File, &FileSize) || FileSize.QuadPart == 0)
+		{
+			return;
+		}
+		MappingHandle = CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!MappingHandle)
+		{
+			return;
+		}
+		Data = static_cast<const uint8_t*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (Data)
+		{
+			Size = (size_t)FileSize.QuadPart;
+		}
+#else
+		int File = open(FilePath.c_str(), O_RDONLY);
+		if (File < 0)
+		{
+			return;
+		}
+		struct stat FileStat;
+		if (fstat(File, &FileStat) == 0 && FileStat.st_size > 0)
+		{
+			void* Mapped = mmap(nullptr, (size_t)FileStat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+			if (Mapped != MAP_FAILED)
+			{
+				Data = static_cast<const uint8_t*>(Mapped);
+				Size = (size_t)FileStat.st_size;
+			}
+		}
+		// The mapping stays valid after the file is closed.
+		close(File);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#if _WIN32
+		if (Data)
+		{
+			UnmapViewOfFile(Data);
+		}
+		if (MappingHandle)
+		{
+			CloseHandle(MappingHandle);
+		}
+		if (FileHandle)
+		{
+			CloseHandle(FileHandle);
+		}
+#else
+		if (Data)
+		{
+			munmap(const_cast<uint8_t*>(Data), Size);
+		}
+#endif
+	}
 }
\ No newline at end of file
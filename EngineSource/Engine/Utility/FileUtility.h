@@ -3,6 +3,7 @@
 #include <vector>
 #include <filesystem>
 #include <set>
+#include <cstdint>
 
 /**
 * @file
@@ -64,4 +65,39 @@ namespace FileUtil
 	std::vector<std::string> GetAllFilesInFolder(std::string Folder, std::string ext = "");
 
 	std::filesystem::file_time_type GetLastWriteTimeOfFolder(std::string Folder, std::set<std::string> FoldersToIgnore);
+
+	/**
+	* @brief
+	* A read only view of the content of a file, mapped into memory.
+	*
+	* Parts of the file are only loaded from disk when they are accessed, and no copy of the content is made.
+	*/
+	class MappedFile
+	{
+	public:
+		MappedFile(std::string FilePath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// The content of the file, or nullptr if the file couldn't be opened or is empty.
+		const uint8_t* GetData() const
+		{
+			return Data;
+		}
+
+		size_t GetSize() const
+		{
+			return Size;
+		}
+
+	private:
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+#if _WIN32
+		void* FileHandle = nullptr;
+		void* MappingHandle = nullptr;
+#endif
+	};
 }
\ No newline at end of file
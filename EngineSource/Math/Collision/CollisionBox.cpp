@@ -12,7 +12,7 @@ Collision::Box Collision::operator+(Box a, Vector3 b)
     return Box(a.minX + b.X, a.maxX + b.X, a.minY + b.Y, a.maxY + b.Y, a.minZ + b.Z, a.maxZ + b.Z);
 }
 
-Vector3 Collision::Box::GetCenter()
+Vector3 Collision::Box::GetCenter() const
 {
 	return (Vector3(minX, minY, minZ) + Vector3(maxX, maxY, maxZ)) * 0.5f;
 }
@@ -104,13 +104,13 @@ bool Collision::Box::SphereInBox(const Vector3& SpherePoint, float Radius)
 	return distance < Radius;
 }
 
-Vector3 Collision::Box::GetExtent()
+Vector3 Collision::Box::GetExtent() const
 {
 	Vector3 center = GetCenter();
 	return Vector3(maxX - center.X, maxY - center.Y, maxZ - center.Z);
 }
 
-float Collision::Box::GetLength()
+float Collision::Box::GetLength() const
 {
 	return sqrt(minX * minX + minY * minY + minZ * minZ + maxX * maxX + maxY * maxY + maxZ * maxZ);
 }
\ No newline at end of file
@@ -12,7 +12,7 @@ namespace Collision
 		float minZ = 0;
 		float maxZ = 0;
 
-		Vector3 GetCenter();
+		Vector3 GetCenter() const;
 
 		Box(Vector3 Triangle1, Vector3 Triangle2, Vector3 Triangle3);
 
@@ -37,9 +37,9 @@ namespace Collision
 
 		bool SphereInBox(const Vector3& SpherePoint, float Radius);
 
-		Vector3 GetExtent();
+		Vector3 GetExtent() const;
 
-		float GetLength();
+		float GetLength() const;
 	};
 	Box operator*(Box a, Vector3 b);
 	Box operator+(Box a, Vector3 b);
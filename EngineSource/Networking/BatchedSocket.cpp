@@ -0,0 +1,176 @@
+#if !EDITOR
+#include "BatchedSocket.h"
+#if BATCHED_SOCKET_IO
+#include <Engine/Log.h>
+#include <Engine/Utility/StringUtility.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <array>
+#include <algorithm>
+
+namespace BatchedSocket
+{
+	constexpr size_t BATCH_SIZE = 64;
+	// A larger kernel receive buffer, so bursts from many clients aren't dropped while the receive thread is busy.
+	constexpr int RECEIVE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+	static int SocketHandle = -1;
+
+	static std::array<Networking::PacketBuffer, BATCH_SIZE> SendQueue;
+	static size_t NumQueued = 0;
+
+	static sockaddr_in ToSockAddr(const IPaddress& Address)
+	{
+		sockaddr_in SockAddr;
+		std::memset(&SockAddr, 0, sizeof(SockAddr));
+		SockAddr.sin_family = AF_INET;
+		// Both IPaddress and sockaddr_in store the host and port in network byte order.
+		SockAddr.sin_addr.s_addr = Address.host;
+		SockAddr.sin_port = Address.port;
+		return SockAddr;
+	}
+}
+
+bool BatchedSocket::Open(uint16_t Port)
+{
+	SocketHandle = socket(AF_INET, SOCK_DGRAM, 0);
+	if (SocketHandle < 0)
+	{
+		Log::Print(StrUtil::Format("Could not create socket: %s", strerror(errno)), Log::LogColor::Red);
+		return false;
+	}
+
+	int BufferSize = RECEIVE_BUFFER_SIZE;
+	setsockopt(SocketHandle, SOL_SOCKET, SO_RCVBUF, &BufferSize, sizeof(BufferSize));
+
+	sockaddr_in Address;
+	std::memset(&Address, 0, sizeof(Address));
+	Address.sin_family = AF_INET;
+	Address.sin_addr.s_addr = htonl(INADDR_ANY);
+	Address.sin_port = htons(Port);
+	if (bind(SocketHandle, (sockaddr*)&Address, sizeof(Address)) < 0)
+	{
+		Log::Print(StrUtil::Format("Could not create socket on port '%i': %s", int(Port), strerror(errno)), Log::LogColor::Red);
+		close(SocketHandle);
+		SocketHandle = -1;
+		return false;
+	}
+	return true;
+}
+
+bool BatchedSocket::IsOpen()
+{
+	return SocketHandle >= 0;
+}
+
+size_t BatchedSocket::Receive(Networking::PacketBuffer* Buffers, size_t Count, int TimeoutMs)
+{
+	if (SocketHandle < 0 || Count == 0)
+	{
+		return 0;
+	}
+
+	pollfd PollInfo = { SocketHandle, POLLIN, 0 };
+	if (poll(&PollInfo, 1, TimeoutMs) <= 0)
+	{
+		return 0;
+	}
+
+	Count = std::min(Count, BATCH_SIZE);
+	std::array<mmsghdr, BATCH_SIZE> Messages;
+	std::array<iovec, BATCH_SIZE> Vectors;
+	std::array<sockaddr_in, BATCH_SIZE> Addresses;
+	for (size_t i = 0; i < Count; i++)
+	{
+		Vectors[i] = { Buffers[i].Data, sizeof(Buffers[i].Data) };
+		std::memset(&Messages[i], 0, sizeof(mmsghdr));
+		Messages[i].msg_hdr.msg_iov = &Vectors[i];
+		Messages[i].msg_hdr.msg_iovlen = 1;
+		Messages[i].msg_hdr.msg_name = &Addresses[i];
+		Messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	int Received = recvmmsg(SocketHandle, Messages.data(), (unsigned int)Count, MSG_DONTWAIT, nullptr);
+	if (Received < 0)
+	{
+		if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+		{
+			Log::Print(StrUtil::Format("Error reading sockets: %s", strerror(errno)));
+		}
+		return 0;
+	}
+
+	for (int i = 0; i < Received; i++)
+	{
+		Buffers[i].Length = Messages[i].msg_len;
+		Buffers[i].Address.host = Addresses[i].sin_addr.s_addr;
+		Buffers[i].Address.port = Addresses[i].sin_port;
+	}
+	return (size_t)Received;
+}
+
+void BatchedSocket::Send(const void* Data, size_t Size, const IPaddress& Target)
+{
+	if (Size > Networking::PACKET_BUFFER_SIZE)
+	{
+		return;
+	}
+
+	Networking::PacketBuffer& Buffer = SendQueue[NumQueued++];
+	std::memcpy(Buffer.Data, Data, Size);
+	Buffer.Length = Size;
+	Buffer.Address = Target;
+
+	if (NumQueued == BATCH_SIZE)
+	{
+		Flush();
+	}
+}
+
+void BatchedSocket::Flush()
+{
+	if (NumQueued == 0 || SocketHandle < 0)
+	{
+		NumQueued = 0;
+		return;
+	}
+
+	std::array<mmsghdr, BATCH_SIZE> Messages;
+	std::array<iovec, BATCH_SIZE> Vectors;
+	std::array<sockaddr_in, BATCH_SIZE> Addresses;
+	for (size_t i = 0; i < NumQueued; i++)
+	{
+		Addresses[i] = ToSockAddr(SendQueue[i].Address);
+		Vectors[i] = { SendQueue[i].Data, SendQueue[i].Length };
+		std::memset(&Messages[i], 0, sizeof(mmsghdr));
+		Messages[i].msg_hdr.msg_iov = &Vectors[i];
+		Messages[i].msg_hdr.msg_iovlen = 1;
+		Messages[i].msg_hdr.msg_name = &Addresses[i];
+		Messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+
+	size_t Sent = 0;
+	while (Sent < NumQueued)
+	{
+		int Result = sendmmsg(SocketHandle, Messages.data() + Sent, (unsigned int)(NumQueued - Sent), 0);
+		if (Result < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			Log::Print(StrUtil::Format("Error sending packet: %s", strerror(errno)));
+			// Skip the packet that failed, the other packets might still be sent.
+			Sent++;
+			continue;
+		}
+		Sent += (size_t)Result;
+	}
+	NumQueued = 0;
+}
+#endif
+#endif
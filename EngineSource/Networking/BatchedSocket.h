@@ -0,0 +1,39 @@
+#if !EDITOR
+#pragma once
+#include "NetworkingInternal.h"
+
+#if BATCHED_SOCKET_IO
+/**
+* @brief
+* UDP socket for Linux servers that receives and sends many packets per system call using recvmmsg() and sendmmsg().
+*/
+namespace BatchedSocket
+{
+	/// Opens the socket on the given port. Returns false if it couldn't be opened.
+	bool Open(uint16_t Port);
+	/// True if Open() succeeded. If it didn't, the SDL_net socket is used instead.
+	bool IsOpen();
+
+	/**
+	* @brief
+	* Waits up to TimeoutMs milliseconds for packets, then receives up to Count packets into the given buffers.
+	*
+	* Called by the receive thread only.
+	*
+	* @return
+	* The number of packets received.
+	*/
+	size_t Receive(Networking::PacketBuffer* Buffers, size_t Count, int TimeoutMs);
+
+	/**
+	* @brief
+	* Queues a packet to be sent to Target.
+	*
+	* The queue is sent once it is full or when Flush() is called.
+	*/
+	void Send(const void* Data, size_t Size, const IPaddress& Target);
+	/// Sends all queued packets.
+	void Flush();
+}
+#endif
+#endif
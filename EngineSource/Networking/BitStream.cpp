@@ -0,0 +1,200 @@
+#if !EDITOR
+#include "BitStream.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+
+void BitWriter::WriteBits(uint32_t Value, uint8_t Count)
+{
+	if (Count < 32)
+	{
+		Value &= (1u << Count) - 1;
+	}
+
+	while (Count > 0)
+	{
+		size_t BitInByte = NumBits % 8;
+		if (BitInByte == 0)
+		{
+			Data.push_back(0);
+		}
+		uint8_t Written = (uint8_t)std::min<size_t>(8 - BitInByte, Count);
+		Data.back() |= (uint8_t)((Value & ((1u << Written) - 1)) << BitInByte);
+		Value = Written < 32 ? Value >> Written : 0;
+		Count -= Written;
+		NumBits += Written;
+	}
+}
+
+void BitWriter::WriteBool(bool Value)
+{
+	WriteBits(Value ? 1 : 0, 1);
+}
+
+void BitWriter::WriteFloat(float Value)
+{
+	uint32_t Bits;
+	std::memcpy(&Bits, &Value, sizeof(Bits));
+	WriteBits(Bits, 32);
+}
+
+void BitWriter::WriteVarUInt(uint64_t Value)
+{
+	do
+	{
+		uint8_t Group = Value & 0x7f;
+		Value >>= 7;
+		WriteBits(Group | (Value ? 0x80 : 0), 8);
+	} while (Value);
+}
+
+void BitWriter::WriteVarInt(int64_t Value)
+{
+	// Zig-zag encoding: 0, -1, 1, -2, 2... become 0, 1, 2, 3, 4...
+	WriteVarUInt(((uint64_t)Value << 1) ^ (uint64_t)(Value >> 63));
+}
+
+void BitWriter::WriteString(const std::string& Value)
+{
+	WriteVarUInt(Value.size());
+	for (char c : Value)
+	{
+		WriteBits((uint8_t)c, 8);
+	}
+}
+
+void BitWriter::WriteQuantized(float Value, float Precision, uint8_t Count)
+{
+	const float Limit = (float)(1u << (Count - 1));
+	float Scaled = std::round(Value / Precision);
+	if (Scaled >= -Limit && Scaled < Limit)
+	{
+		WriteBool(true);
+		WriteBits((uint32_t)(int32_t)Scaled, Count);
+	}
+	else
+	{
+		WriteBool(false);
+		WriteFloat(Value);
+	}
+}
+
+void BitWriter::Append(const BitWriter& Other)
+{
+	size_t Remaining = Other.NumBits;
+	for (size_t i = 0; Remaining > 0; i++)
+	{
+		uint8_t Count = (uint8_t)std::min<size_t>(8, Remaining);
+		WriteBits(Other.Data[i], Count);
+		Remaining -= Count;
+	}
+}
+
+BitReader::BitReader(const uint8_t* Data, size_t Size)
+{
+	this->Data = Data;
+	this->Size = Size;
+}
+
+uint32_t BitReader::ReadBits(uint8_t Count)
+{
+	if (Count > GetRemainingBits())
+	{
+		Error = true;
+		Position = Size * 8;
+		return 0;
+	}
+
+	uint32_t Value = 0;
+	uint8_t Read = 0;
+	while (Read < Count)
+	{
+		size_t BitInByte = Position % 8;
+		uint8_t NumBits = (uint8_t)std::min<size_t>(8 - BitInByte, Count - Read);
+		uint32_t Bits = (Data[Position / 8] >> BitInByte) & ((1u << NumBits) - 1);
+		Value |= Bits << Read;
+		Read += NumBits;
+		Position += NumBits;
+	}
+	return Value;
+}
+
+bool BitReader::ReadBool()
+{
+	return ReadBits(1);
+}
+
+float BitReader::ReadFloat()
+{
+	uint32_t Bits = ReadBits(32);
+	float Value;
+	std::memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+uint64_t BitReader::ReadVarUInt()
+{
+	uint64_t Value = 0;
+	for (int Shift = 0; Shift < 64; Shift += 7)
+	{
+		uint32_t Group = ReadBits(8);
+		Value |= (uint64_t)(Group & 0x7f) << Shift;
+		if (!(Group & 0x80))
+		{
+			return Value;
+		}
+	}
+	// More than 64 bits.
+	Error = true;
+	return 0;
+}
+
+int64_t BitReader::ReadVarInt()
+{
+	uint64_t Value = ReadVarUInt();
+	return (int64_t)(Value >> 1) ^ -(int64_t)(Value & 1);
+}
+
+std::string BitReader::ReadString()
+{
+	uint64_t Length = ReadVarUInt();
+	if (Length > GetRemainingBits() / 8)
+	{
+		Error = true;
+		return "";
+	}
+	std::string Value;
+	Value.resize(Length);
+	for (char& c : Value)
+	{
+		c = (char)ReadBits(8);
+	}
+	return Value;
+}
+
+float BitReader::ReadQuantized(float Precision, uint8_t Count)
+{
+	if (!ReadBool())
+	{
+		return ReadFloat();
+	}
+	uint32_t Bits = ReadBits(Count);
+	// Sign extend the value.
+	if (Count < 32 && (Bits & (1u << (Count - 1))))
+	{
+		Bits |= ~((1u << Count) - 1);
+	}
+	return (float)(int32_t)Bits * Precision;
+}
+
+void BitReader::Skip(size_t NumBits)
+{
+	if (NumBits > GetRemainingBits())
+	{
+		Error = true;
+		Position = Size * 8;
+		return;
+	}
+	Position += NumBits;
+}
+#endif
@@ -0,0 +1,100 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+
+/**
+* @brief
+* Writes values into a buffer using only as many bits as needed for each value.
+*
+* Bits are written starting with the lowest bit of each byte. The last byte is padded with zero bits.
+*/
+class BitWriter
+{
+public:
+	/// Writes the lowest NumBits bits of Value. NumBits must be 32 or less.
+	void WriteBits(uint32_t Value, uint8_t NumBits);
+	void WriteBool(bool Value);
+	void WriteFloat(float Value);
+
+	/// Writes an unsigned integer using 8 bits for every 7 bits of the value, so small values take fewer bits.
+	void WriteVarUInt(uint64_t Value);
+	/// Like WriteVarUInt(), but also keeps small negative values small.
+	void WriteVarInt(int64_t Value);
+
+	void WriteString(const std::string& Value);
+
+	/**
+	* @brief
+	* Writes Value as a fixed point number with the given precision.
+	*
+	* If the value doesn't fit into NumBits bits at that precision, the full float is written instead.
+	* Read with BitReader::ReadQuantized() using the same precision and number of bits.
+	*/
+	void WriteQuantized(float Value, float Precision, uint8_t NumBits);
+
+	/// Appends all bits written to another writer.
+	void Append(const BitWriter& Other);
+
+	size_t GetNumBits() const
+	{
+		return NumBits;
+	}
+
+	const std::vector<uint8_t>& GetData() const
+	{
+		return Data;
+	}
+
+private:
+	std::vector<uint8_t> Data;
+	size_t NumBits = 0;
+};
+
+/**
+* @brief
+* Reads values written by a BitWriter.
+*
+* Reading past the end of the buffer returns zero and sets an error flag, see HasError().
+*/
+class BitReader
+{
+public:
+	BitReader(const uint8_t* Data, size_t Size);
+
+	uint32_t ReadBits(uint8_t NumBits);
+	bool ReadBool();
+	float ReadFloat();
+	uint64_t ReadVarUInt();
+	int64_t ReadVarInt();
+	std::string ReadString();
+	float ReadQuantized(float Precision, uint8_t NumBits);
+
+	/// Skips the given number of bits.
+	void Skip(size_t NumBits);
+
+	size_t GetPosition() const
+	{
+		return Position;
+	}
+
+	size_t GetRemainingBits() const
+	{
+		return Position < Size * 8 ? Size * 8 - Position : 0;
+	}
+
+	/// True if anything has been read past the end of the buffer.
+	bool HasError() const
+	{
+		return Error;
+	}
+
+private:
+	const uint8_t* Data = nullptr;
+	size_t Size = 0;
+	size_t Position = 0;
+	bool Error = false;
+};
+#endif
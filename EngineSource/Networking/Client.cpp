@@ -4,6 +4,9 @@
 #include <Engine/Log.h>
 #include "Packet.h"
 #include "Networking.h"
+#include "Replication.h"
+#include "Connection.h"
+#include "Interpolation.h"
 #include <Engine/Utility/StringUtility.h>
 #include <Objects/SceneObject.h>
 #include <Engine/Application.h>
@@ -58,6 +61,7 @@ void Client::ConnectToServer(std::string Address, uint16_t Port)
 	IsConnected = false;
 
 	ConnectedServer = ip;
+	Networking::GetConnections().Reset();
 	Networking::Socket = Networking::InitSocketFrom(&ip);
 	Packet::Init();
 	ConnectionTimer.Reset();
@@ -79,6 +83,9 @@ void Client::Disconnect()
 	}
 	IsConnected = false;
 	IsConnecting = false;
+	Replication::Reset();
+	Interpolation::Reset();
+	Networking::GetConnections().Reset();
 }
 
 void Client::OnConnected(Packet* p)
@@ -97,6 +104,8 @@ void Client::OnConnected(Packet* p)
 	IsConnecting = false;
 	memcpy(&ClientID, &p->Data[1], sizeof(uint64_t));
 	IsConnected = true;
+	Replication::Reset();
+	Interpolation::Reset();
 	Log::PrintMultiLine(StrUtil::Format("Connected to server: %s\nClientUID: %i",
 			Networking::IPtoStr(p->FromAddr).c_str(),
 			(int)ClientID
@@ -139,13 +148,16 @@ void Client::Update()
 		return;
 	}
 
+	std::vector<SceneObject*> OwnedObjects;
 	for (SceneObject* i : Objects::AllObjects)
 	{
 		if (i->NetOwner == GetClientID())
 		{
-			Networking::SendObjectInfo(i, &ConnectedServer);
+			OwnedObjects.push_back(i);
 		}
 	}
+	Replication::SendObjects(OwnedObjects, &ConnectedServer, Networking::ServerID);
+	Replication::SendAcknowledgements(&ConnectedServer);
 }
 
 uint64_t Client::GetClientID()
@@ -196,21 +208,32 @@ bool Client::HandleValueUpdate(uint64_t ObjNetID, std::string Name, std::string
 		return true;
 	}
 
-	if (Name == "_pos")
+	if (Name == "_pos" || Name == "_rot" || Name == "_scl")
 	{
-		obj->GetTransform().Position = Vector3::FromString(Value);
-		return true;
-	}
-
-	if (Name == "_rot")
-	{
-		obj->GetTransform().Rotation = Vector3::FromString(Value);
-		return true;
-	}
+		bool Interpolate = Interpolation::ShouldInterpolate(obj);
+		Transform NewTransform = Interpolate ? Interpolation::GetLatestTransform(obj) : obj->GetTransform();
+		Vector3 NewValue = Vector3::FromString(Value);
+		if (Name == "_pos")
+		{
+			NewTransform.Position = NewValue;
+		}
+		else if (Name == "_rot")
+		{
+			NewTransform.Rotation = NewValue;
+		}
+		else
+		{
+			NewTransform.Scale = NewValue;
+		}
 
-	if (Name == "_scl")
-	{
-		obj->GetTransform().Scale = Vector3::FromString(Value);
+		if (Interpolate)
+		{
+			Interpolation::AddUpdate(obj, NewTransform);
+		}
+		else
+		{
+			obj->GetTransform() = NewTransform;
+		}
 		return true;
 	}
 	try
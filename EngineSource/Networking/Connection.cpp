@@ -0,0 +1,647 @@
+#if !EDITOR
+#include "Connection.h"
+#include "NetworkingInternal.h"
+#include <unordered_map>
+#include <deque>
+#include <array>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace Connection
+{
+	enum class DatagramType : uint8_t
+	{
+		Unreliable = (uint8_t)Channel::Unreliable,
+		UnreliableSequenced = (uint8_t)Channel::UnreliableSequenced,
+		ReliableOrdered = (uint8_t)Channel::ReliableOrdered,
+		/// Only contains the header, sent if nothing else was sent after receiving a datagram.
+		AckOnly = 3,
+	};
+
+	// MessageID, FragmentIndex and FragmentCount, following the datagram header.
+	constexpr size_t FRAGMENT_HEADER_SIZE = 3 * sizeof(uint16_t);
+	constexpr size_t FRAGMENT_SIZE = Networking::PACKET_BUFFER_SIZE - HEADER_SIZE - FRAGMENT_HEADER_SIZE;
+	constexpr size_t MAX_FRAGMENTS = 256;
+	// Number of sent datagrams remembered for acknowledgements. Datagrams acknowledged later than this are ignored.
+	constexpr size_t SENT_HISTORY_SIZE = 1024;
+	// Reliable messages further ahead of the next expected message than this are dropped. The sender resends them later.
+	constexpr uint16_t RECEIVE_WINDOW = 1024;
+	// A datagram counts as lost if it hasn't been acknowledged, but a datagram sent this many datagrams later has been.
+	constexpr uint16_t LOSS_THRESHOLD = 3;
+	// The number of unacknowledged reliable fragments allowed with a send scale of 1.
+	constexpr float MAX_FRAGMENTS_IN_FLIGHT = 32;
+	constexpr float MIN_SEND_SCALE = 0.125f;
+	constexpr float SEND_SCALE_INCREASE = 0.01f;
+	constexpr double MIN_RESEND_TIME = 0.05;
+	constexpr double MAX_RESEND_TIME = 1.0;
+	// Connections that haven't received anything for this long are forgotten.
+	constexpr double CONNECTION_TIMEOUT = 60.0;
+	/// The maximum number of acknowledged messages kept per connection to reuse their buffers.
+	constexpr size_t MAX_FREE_MESSAGES = 32;
+
+	struct SentDatagram
+	{
+		bool Valid = false;
+		bool Acked = false;
+		bool Lost = false;
+		bool Reliable = false;
+		uint16_t Sequence = 0;
+		uint16_t MessageID = 0;
+		uint16_t Fragment = 0;
+		double Time = 0;
+	};
+
+	struct OutgoingMessage
+	{
+		uint16_t ID = 0;
+		std::vector<uint8_t> Data;
+		/// The time each fragment was last sent. Negative if the fragment should be sent as soon as possible.
+		std::vector<double> LastSent;
+		std::vector<bool> Acked;
+		size_t NumAcked = 0;
+	};
+
+	struct IncomingMessage
+	{
+		std::vector<std::vector<uint8_t>> Fragments;
+		size_t NumReceived = 0;
+	};
+
+	struct State
+	{
+		IPaddress Address;
+		Endpoint* Owner = nullptr;
+		const Endpoint::SendFunction* Sender = nullptr;
+
+		uint16_t NextSequence = 0;
+		std::array<SentDatagram, SENT_HISTORY_SIZE> SentDatagrams;
+		double LastSendTime = 0;
+
+		bool HasReceived = false;
+		/// The newest sequence number received.
+		uint16_t RemoteSequence = 0;
+		/// Bit n is set if RemoteSequence - 1 - n has been received.
+		uint32_t ReceivedBits = 0;
+		/// True if a datagram has been received that hasn't been acknowledged yet.
+		bool AckPending = false;
+		bool HasSequenced = false;
+		uint16_t LastSequenced = 0;
+		double LastReceiveTime = 0;
+
+		uint16_t NextMessageID = 0;
+		std::deque<OutgoingMessage> OutgoingMessages;
+		/// Acknowledged messages kept to reuse their buffers, so sending a message usually doesn't allocate.
+		std::vector<OutgoingMessage> FreeMessages;
+		uint16_t NextExpectedMessage = 0;
+		std::unordered_map<uint16_t, IncomingMessage> IncomingMessages;
+
+		bool HasRoundTripTime = false;
+		double SmoothedRoundTripTime = 0.1;
+		double RoundTripVariance = 0.05;
+		float SendScale = 1;
+		float PacketLoss = 0;
+		double LastDecreaseTime = 0;
+		uint64_t NumSent = 0;
+		uint64_t NumReceived = 0;
+		uint64_t NumResent = 0;
+	};
+
+	static double GetTime(std::chrono::steady_clock::time_point Time = std::chrono::steady_clock::now())
+	{
+		static const auto StartTime = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(Time - StartTime).count();
+	}
+
+	static uint64_t GetAddressKey(const IPaddress& Address)
+	{
+		return ((uint64_t)Address.host << 16) | (uint64_t)Address.port;
+	}
+
+	/// True if sequence number A is newer than B, taking wrap around into account.
+	static bool IsNewer(uint16_t A, uint16_t B)
+	{
+		return (int16_t)(uint16_t)(A - B) > 0;
+	}
+
+	using ConnectionMap = std::unordered_map<uint64_t, State>;
+
+	static State* FindState(ConnectionMap& Connections, void* Address)
+	{
+		auto Found = Connections.find(GetAddressKey(*(IPaddress*)Address));
+		return Found != Connections.end() ? &Found->second : nullptr;
+	}
+
+	static double GetResendTime(const State& Connection)
+	{
+		double Time = Connection.SmoothedRoundTripTime + 4 * Connection.RoundTripVariance;
+		return std::clamp(Time, MIN_RESEND_TIME, MAX_RESEND_TIME);
+	}
+
+	static OutgoingMessage* FindOutgoingMessage(State& Connection, uint16_t ID)
+	{
+		for (OutgoingMessage& i : Connection.OutgoingMessages)
+		{
+			if (i.ID == ID)
+			{
+				return &i;
+			}
+		}
+		return nullptr;
+	}
+
+	template<typename T>
+	static void WriteValue(uint8_t*& Target, T Value)
+	{
+		memcpy(Target, &Value, sizeof(T));
+		Target += sizeof(T);
+	}
+
+	template<typename T>
+	static T ReadValue(const uint8_t*& Source)
+	{
+		T Value;
+		memcpy(&Value, Source, sizeof(T));
+		Source += sizeof(T);
+		return Value;
+	}
+
+	static void SendDatagram(State& Connection, DatagramType Type, const uint8_t* Payload, size_t PayloadSize,
+		const OutgoingMessage* Message = nullptr, uint16_t Fragment = 0)
+	{
+		uint8_t Buffer[Networking::PACKET_BUFFER_SIZE];
+		uint8_t* Pos = Buffer;
+		uint16_t Sequence = Connection.NextSequence++;
+		WriteValue(Pos, (uint8_t)Type);
+		WriteValue(Pos, Sequence);
+		WriteValue(Pos, Connection.RemoteSequence);
+		WriteValue(Pos, Connection.ReceivedBits);
+
+		if (Message)
+		{
+			WriteValue(Pos, Message->ID);
+			WriteValue(Pos, Fragment);
+			WriteValue(Pos, (uint16_t)Message->LastSent.size());
+		}
+		memcpy(Pos, Payload, PayloadSize);
+		Pos += PayloadSize;
+
+		double Now = GetTime();
+		SentDatagram& Sent = Connection.SentDatagrams[Sequence % SENT_HISTORY_SIZE];
+		Sent = SentDatagram();
+		// Ack only datagrams aren't acknowledged themselves, so they are not tracked.
+		Sent.Valid = Type != DatagramType::AckOnly;
+		Sent.Sequence = Sequence;
+		Sent.Time = Now;
+		Sent.Reliable = Message != nullptr;
+		if (Message)
+		{
+			Sent.MessageID = Message->ID;
+			Sent.Fragment = Fragment;
+		}
+
+		Connection.LastSendTime = Now;
+		Connection.AckPending = false;
+		Connection.NumSent++;
+		(*Connection.Sender)(Buffer, Pos - Buffer, &Connection.Address);
+	}
+
+	/// Sends fragments of reliable messages that haven't been sent yet or haven't been acknowledged in time.
+	static void SendReliableFragments(State& Connection)
+	{
+		double Now = GetTime();
+		double ResendTime = GetResendTime(Connection);
+
+		size_t InFlight = 0;
+		for (const OutgoingMessage& Message : Connection.OutgoingMessages)
+		{
+			for (size_t i = 0; i < Message.LastSent.size(); i++)
+			{
+				if (!Message.Acked[i] && Message.LastSent[i] >= 0 && Now - Message.LastSent[i] < ResendTime)
+				{
+					InFlight++;
+				}
+			}
+		}
+
+		size_t MaxInFlight = std::max((size_t)2, (size_t)(MAX_FRAGMENTS_IN_FLIGHT * Connection.SendScale));
+		for (OutgoingMessage& Message : Connection.OutgoingMessages)
+		{
+			for (size_t i = 0; i < Message.LastSent.size(); i++)
+			{
+				if (InFlight >= MaxInFlight)
+				{
+					return;
+				}
+				if (Message.Acked[i] || (Message.LastSent[i] >= 0 && Now - Message.LastSent[i] < ResendTime))
+				{
+					continue;
+				}
+				if (Message.LastSent[i] != -1)
+				{
+					Connection.NumResent++;
+				}
+				size_t Start = i * FRAGMENT_SIZE;
+				size_t Size = std::min(FRAGMENT_SIZE, Message.Data.size() - Start);
+				SendDatagram(Connection, DatagramType::ReliableOrdered, Message.Data.data() + Start, Size, &Message, (uint16_t)i);
+				Message.LastSent[i] = Now;
+				InFlight++;
+			}
+		}
+	}
+
+	static void OnDatagramAcked(State& Connection, SentDatagram& Sent, double Now)
+	{
+		Sent.Acked = true;
+
+		double Sample = Now - Sent.Time;
+		if (!Connection.HasRoundTripTime)
+		{
+			Connection.SmoothedRoundTripTime = Sample;
+			Connection.RoundTripVariance = Sample / 2;
+			Connection.HasRoundTripTime = true;
+		}
+		else
+		{
+			Connection.RoundTripVariance = 0.75 * Connection.RoundTripVariance + 0.25 * std::abs(Connection.SmoothedRoundTripTime - Sample);
+			Connection.SmoothedRoundTripTime = 0.875 * Connection.SmoothedRoundTripTime + 0.125 * Sample;
+		}
+		if (Connection.Owner->RoundTripSamples)
+		{
+			Connection.Owner->RoundTripSamples->push_back((float)Sample);
+		}
+		Connection.PacketLoss *= 0.99f;
+		Connection.SendScale = std::min(1.0f, Connection.SendScale + SEND_SCALE_INCREASE);
+
+		if (!Sent.Reliable)
+		{
+			return;
+		}
+		OutgoingMessage* Message = FindOutgoingMessage(Connection, Sent.MessageID);
+		if (Message && Sent.Fragment < Message->Acked.size() && !Message->Acked[Sent.Fragment])
+		{
+			Message->Acked[Sent.Fragment] = true;
+			Message->NumAcked++;
+		}
+	}
+
+	static void OnDatagramLost(State& Connection, SentDatagram& Sent, double Now)
+	{
+		Sent.Lost = true;
+		Connection.PacketLoss = Connection.PacketLoss * 0.99f + 0.01f;
+
+		// Only decrease once per round trip, since all datagrams lost in that time were lost to the same congestion.
+		if (Now - Connection.LastDecreaseTime > Connection.SmoothedRoundTripTime)
+		{
+			Connection.SendScale = std::max(MIN_SEND_SCALE, Connection.SendScale * 0.5f);
+			Connection.LastDecreaseTime = Now;
+		}
+
+		if (!Sent.Reliable)
+		{
+			return;
+		}
+		OutgoingMessage* Message = FindOutgoingMessage(Connection, Sent.MessageID);
+		if (Message && Sent.Fragment < Message->Acked.size() && !Message->Acked[Sent.Fragment])
+		{
+			// Resend right away instead of waiting for the resend timeout. -2 marks a resend, -1 a fragment never sent.
+			Message->LastSent[Sent.Fragment] = -2;
+		}
+	}
+
+	static void ReadAcknowledgements(State& Connection, uint16_t Ack, uint32_t AckBits, double Now)
+	{
+		for (uint16_t i = 0; i <= 32; i++)
+		{
+			if (i > 0 && !(AckBits & (1u << (i - 1))))
+			{
+				continue;
+			}
+			uint16_t Sequence = Ack - i;
+			SentDatagram& Sent = Connection.SentDatagrams[Sequence % SENT_HISTORY_SIZE];
+			if (Sent.Valid && Sent.Sequence == Sequence && !Sent.Acked)
+			{
+				OnDatagramAcked(Connection, Sent, Now);
+			}
+		}
+
+		for (uint16_t i = LOSS_THRESHOLD; i <= 32; i++)
+		{
+			if (AckBits & (1u << (i - 1)))
+			{
+				continue;
+			}
+			uint16_t Sequence = Ack - i;
+			SentDatagram& Sent = Connection.SentDatagrams[Sequence % SENT_HISTORY_SIZE];
+			if (Sent.Valid && Sent.Sequence == Sequence && !Sent.Acked && !Sent.Lost)
+			{
+				OnDatagramLost(Connection, Sent, Now);
+			}
+		}
+
+		while (!Connection.OutgoingMessages.empty()
+			&& Connection.OutgoingMessages.front().NumAcked == Connection.OutgoingMessages.front().Acked.size())
+		{
+			if (Connection.FreeMessages.size() < MAX_FREE_MESSAGES)
+			{
+				Connection.FreeMessages.push_back(std::move(Connection.OutgoingMessages.front()));
+			}
+			Connection.OutgoingMessages.pop_front();
+		}
+	}
+
+	/// Marks Sequence as received. Returns false if it has been received before.
+	static bool RecordReceived(State& Connection, uint16_t Sequence)
+	{
+		if (!Connection.HasReceived)
+		{
+			Connection.HasReceived = true;
+			Connection.RemoteSequence = Sequence;
+			Connection.ReceivedBits = 0;
+			return true;
+		}
+
+		if (IsNewer(Sequence, Connection.RemoteSequence))
+		{
+			uint16_t Shift = Sequence - Connection.RemoteSequence;
+			if (Shift > 32)
+			{
+				Connection.ReceivedBits = 0;
+			}
+			else
+			{
+				Connection.ReceivedBits = (Shift == 32 ? 0 : Connection.ReceivedBits << Shift) | (1u << (Shift - 1));
+			}
+			Connection.RemoteSequence = Sequence;
+			return true;
+		}
+
+		uint16_t Age = Connection.RemoteSequence - Sequence;
+		if (Age == 0)
+		{
+			return false;
+		}
+		if (Age <= 32)
+		{
+			uint32_t Bit = 1u << (Age - 1);
+			if (Connection.ReceivedBits & Bit)
+			{
+				return false;
+			}
+			Connection.ReceivedBits |= Bit;
+		}
+		return true;
+	}
+
+	static void ReceiveFragment(State& Connection, const uint8_t* Data, size_t Length, std::vector<Packet>& Received)
+	{
+		if (Length < FRAGMENT_HEADER_SIZE)
+		{
+			return;
+		}
+		uint16_t MessageID = ReadValue<uint16_t>(Data);
+		uint16_t FragmentIndex = ReadValue<uint16_t>(Data);
+		uint16_t FragmentCount = ReadValue<uint16_t>(Data);
+		Length -= FRAGMENT_HEADER_SIZE;
+
+		uint16_t Distance = MessageID - Connection.NextExpectedMessage;
+		if (FragmentCount == 0 || FragmentCount > MAX_FRAGMENTS || FragmentIndex >= FragmentCount || Distance >= RECEIVE_WINDOW)
+		{
+			return;
+		}
+
+		IncomingMessage& Message = Connection.IncomingMessages[MessageID];
+		if (Message.Fragments.empty())
+		{
+			Message.Fragments.resize(FragmentCount);
+		}
+		if (Message.Fragments.size() != FragmentCount || !Message.Fragments[FragmentIndex].empty())
+		{
+			return;
+		}
+		// Empty fragments aren't sent, so an empty vector always means the fragment is missing.
+		Message.Fragments[FragmentIndex].assign(Data, Data + Length);
+		Message.NumReceived++;
+
+		while (true)
+		{
+			auto Next = Connection.IncomingMessages.find(Connection.NextExpectedMessage);
+			if (Next == Connection.IncomingMessages.end() || Next->second.NumReceived != Next->second.Fragments.size())
+			{
+				break;
+			}
+			Packet Complete;
+			for (auto& i : Next->second.Fragments)
+			{
+				Complete.Data.insert(Complete.Data.end(), i.begin(), i.end());
+			}
+			Received.push_back(std::move(Complete));
+			Connection.IncomingMessages.erase(Next);
+			Connection.NextExpectedMessage++;
+		}
+	}
+}
+
+struct Connection::Endpoint::Impl
+{
+	SendFunction Sender;
+	ConnectionMap Connections;
+
+	State& GetState(Endpoint* Owner, void* Address)
+	{
+		IPaddress& Target = *(IPaddress*)Address;
+		auto Found = Connections.find(GetAddressKey(Target));
+		if (Found != Connections.end())
+		{
+			return Found->second;
+		}
+		State& NewState = Connections[GetAddressKey(Target)];
+		NewState.Address = Target;
+		NewState.Owner = Owner;
+		NewState.Sender = &Sender;
+		NewState.LastReceiveTime = GetTime();
+		return NewState;
+	}
+};
+
+size_t Connection::GetMaxReliableSize()
+{
+	return MAX_FRAGMENTS * FRAGMENT_SIZE;
+}
+
+Connection::Endpoint::Endpoint(SendFunction DatagramSender)
+	: Internal(std::make_unique<Impl>())
+{
+	Internal->Sender = std::move(DatagramSender);
+}
+
+Connection::Endpoint::~Endpoint()
+{
+}
+
+bool Connection::Endpoint::Send(const std::vector<uint8_t>& Data, void* Target, Channel UsedChannel)
+{
+	if (UsedChannel == Channel::ReliableOrdered && (Data.empty() || Data.size() > GetMaxReliableSize()))
+	{
+		return false;
+	}
+	if (UsedChannel != Channel::ReliableOrdered && Data.size() + HEADER_SIZE > Networking::PACKET_BUFFER_SIZE)
+	{
+		return false;
+	}
+
+	State& Connection = Internal->GetState(this, Target);
+
+	if (UsedChannel != Channel::ReliableOrdered)
+	{
+		SendDatagram(Connection, (DatagramType)UsedChannel, Data.data(), Data.size());
+		return true;
+	}
+
+	OutgoingMessage Message;
+	if (!Connection.FreeMessages.empty())
+	{
+		Message = std::move(Connection.FreeMessages.back());
+		Connection.FreeMessages.pop_back();
+	}
+	Message.ID = Connection.NextMessageID++;
+	Message.Data.assign(Data.begin(), Data.end());
+	size_t NumFragments = (Data.size() + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE;
+	Message.LastSent.assign(NumFragments, -1);
+	Message.Acked.assign(NumFragments, false);
+	Message.NumAcked = 0;
+	Connection.OutgoingMessages.push_back(std::move(Message));
+	SendReliableFragments(Connection);
+	return true;
+}
+
+void Connection::Endpoint::Receive(const uint8_t* Data, size_t Length, void* From, std::vector<Packet>& Received,
+	std::chrono::steady_clock::time_point ReceiveTime)
+{
+	if (Length < HEADER_SIZE)
+	{
+		return;
+	}
+
+	const uint8_t* Pos = Data;
+	DatagramType Type = (DatagramType)ReadValue<uint8_t>(Pos);
+	uint16_t Sequence = ReadValue<uint16_t>(Pos);
+	uint16_t Ack = ReadValue<uint16_t>(Pos);
+	uint32_t AckBits = ReadValue<uint32_t>(Pos);
+	if ((uint8_t)Type > (uint8_t)DatagramType::AckOnly)
+	{
+		return;
+	}
+
+	State& Connection = Internal->GetState(this, From);
+	double Now = GetTime(ReceiveTime);
+	Connection.LastReceiveTime = Now;
+	if (!RecordReceived(Connection, Sequence))
+	{
+		return;
+	}
+	Connection.NumReceived++;
+	ReadAcknowledgements(Connection, Ack, AckBits, Now);
+
+	if (Type == DatagramType::AckOnly)
+	{
+		return;
+	}
+	Connection.AckPending = true;
+
+	size_t PayloadSize = Length - HEADER_SIZE;
+	switch (Type)
+	{
+	case DatagramType::UnreliableSequenced:
+		if (Connection.HasSequenced && !IsNewer(Sequence, Connection.LastSequenced))
+		{
+			return;
+		}
+		Connection.HasSequenced = true;
+		Connection.LastSequenced = Sequence;
+		[[fallthrough]];
+	case DatagramType::Unreliable:
+	{
+		if (PayloadSize == 0)
+		{
+			return;
+		}
+		Packet NewPacket;
+		NewPacket.Data.assign(Pos, Pos + PayloadSize);
+		Received.push_back(std::move(NewPacket));
+		break;
+	}
+	case DatagramType::ReliableOrdered:
+		ReceiveFragment(Connection, Pos, PayloadSize, Received);
+		break;
+	default:
+		break;
+	}
+}
+
+void Connection::Endpoint::Update()
+{
+	double Now = GetTime();
+	for (auto i = Internal->Connections.begin(); i != Internal->Connections.end();)
+	{
+		State& Connection = i->second;
+		if (Now - Connection.LastReceiveTime > CONNECTION_TIMEOUT)
+		{
+			i = Internal->Connections.erase(i);
+			continue;
+		}
+
+		SendReliableFragments(Connection);
+		if (Connection.AckPending)
+		{
+			SendDatagram(Connection, DatagramType::AckOnly, nullptr, 0);
+		}
+		i++;
+	}
+}
+
+float Connection::Endpoint::GetSendScale(void* Address)
+{
+	State* Connection = FindState(Internal->Connections, Address);
+	return Connection ? Connection->SendScale : 1.0f;
+}
+
+float Connection::Endpoint::GetRoundTripTime(void* Address)
+{
+	State* Connection = FindState(Internal->Connections, Address);
+	return Connection && Connection->HasRoundTripTime ? (float)Connection->SmoothedRoundTripTime : 0.0f;
+}
+
+void Connection::Endpoint::Remove(void* Address)
+{
+	Internal->Connections.erase(GetAddressKey(*(IPaddress*)Address));
+}
+
+void Connection::Endpoint::Reset()
+{
+	Internal->Connections.clear();
+}
+
+std::vector<Connection::Stats> Connection::Endpoint::GetStats()
+{
+	std::vector<Stats> AllStats;
+	for (auto& [Key, Connection] : Internal->Connections)
+	{
+		Stats NewStats;
+		NewStats.Address = Connection.Address;
+		NewStats.RoundTripTime = Connection.HasRoundTripTime ? (float)Connection.SmoothedRoundTripTime : 0.0f;
+		NewStats.PacketLoss = Connection.PacketLoss;
+		NewStats.SendScale = Connection.SendScale;
+		NewStats.NumSent = Connection.NumSent;
+		NewStats.NumReceived = Connection.NumReceived;
+		NewStats.NumResent = Connection.NumResent;
+		for (const OutgoingMessage& Message : Connection.OutgoingMessages)
+		{
+			NewStats.PendingFragments += Message.Acked.size() - Message.NumAcked;
+		}
+		AllStats.push_back(NewStats);
+	}
+	return AllStats;
+}
+#endif
@@ -0,0 +1,120 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <chrono>
+#include <SDL_net.h>
+#include "Packet.h"
+
+/**
+* @brief
+* Per address state for sending and receiving packets over UDP.
+*
+* Every datagram starts with a header containing a sequence number and acknowledgements for the last 33 received datagrams.
+* The acknowledgements are used to estimate the round trip time and packet loss, and to resend reliable messages.
+*
+* Packets can be sent on three channels:
+* - Unreliable: The packet might get lost, duplicated datagrams are dropped.
+* - UnreliableSequenced: Like Unreliable, but packets older than the newest received sequenced packet are dropped.
+* - ReliableOrdered: The packet is resent until it has been acknowledged and received packets are processed in the order
+*   they were sent. Packets larger than a datagram are split into fragments.
+*
+* Reliable packets are paced with a congestion window: The number of unacknowledged fragments is limited by the send scale,
+* which is halved when datagrams get lost and slowly grows again with each acknowledged datagram.
+*/
+namespace Connection
+{
+	enum class Channel : uint8_t
+	{
+		Unreliable = 0,
+		UnreliableSequenced = 1,
+		ReliableOrdered = 2,
+	};
+
+	/// The size of the header at the start of each datagram.
+	constexpr size_t HEADER_SIZE = 9;
+	/// The largest packet that can be sent on the ReliableOrdered channel.
+	size_t GetMaxReliableSize();
+
+	/// Statistics of a single connection, see Endpoint::GetStats().
+	struct Stats
+	{
+		IPaddress Address;
+		/// The smoothed round trip time in seconds.
+		float RoundTripTime = 0;
+		/// The estimated fraction of datagrams lost.
+		float PacketLoss = 0;
+		float SendScale = 1;
+		uint64_t NumSent = 0;
+		uint64_t NumReceived = 0;
+		uint64_t NumResent = 0;
+		size_t PendingFragments = 0;
+	};
+
+	/**
+	* @brief
+	* The connections of a socket to all addresses it talks to.
+	*
+	* The engine uses a single endpoint for its socket, see Networking::GetConnections().
+	* Tools simulating multiple clients in one process (Tools/NetLoadTest) use one for each client.
+	*/
+	class Endpoint
+	{
+	public:
+		/// Sends a datagram including the connection header to Target.
+		using SendFunction = std::function<void(const uint8_t* Data, size_t Length, IPaddress* Target)>;
+
+		Endpoint(SendFunction DatagramSender);
+		~Endpoint();
+		Endpoint(const Endpoint&) = delete;
+		Endpoint& operator=(const Endpoint&) = delete;
+
+		/// Sends Data to Target on the given channel. Returns false if Data is too large for the channel.
+		bool Send(const std::vector<uint8_t>& Data, void* Target, Channel UsedChannel);
+
+		/**
+		* @brief
+		* Reads a datagram received from From.
+		*
+		* The packets that can be processed now are appended to Received.
+		* This might be none (duplicates, fragments, reliable packets waiting for an earlier one) or multiple.
+		*
+		* @param ReceiveTime
+		* The time the datagram was read from the socket. Round trip times are measured up to this time,
+		* so they don't include the time the datagram waited before it was processed.
+		*/
+		void Receive(const uint8_t* Data, size_t Length, void* From, std::vector<Packet>& Received,
+			std::chrono::steady_clock::time_point ReceiveTime = std::chrono::steady_clock::now());
+
+		/// Resends lost reliable fragments and acknowledges received datagrams. Called once per tick.
+		void Update();
+
+		/**
+		* @brief
+		* Returns a value between 0 and 1 that should be multiplied with the amount of data sent to Address.
+		*
+		* Lower if datagrams sent to the address have been lost recently.
+		*/
+		float GetSendScale(void* Address);
+		/// The smoothed round trip time to Address, in seconds. 0 if unknown.
+		float GetRoundTripTime(void* Address);
+
+		/// Forgets the state of the connection to Address. The next packet to or from it starts a new connection.
+		void Remove(void* Address);
+		/// Forgets all connections.
+		void Reset();
+
+		std::vector<Stats> GetStats();
+
+		/// If not null, every measured round trip time is appended to it, in seconds.
+		std::vector<float>* RoundTripSamples = nullptr;
+
+	private:
+		struct Impl;
+		std::unique_ptr<Impl> Internal;
+	};
+}
+#endif
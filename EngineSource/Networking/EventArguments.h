@@ -0,0 +1,257 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <tuple>
+#include <type_traits>
+
+class SceneObject;
+
+/**
+* @brief
+* Binary serialization of network event arguments.
+*
+* Trivially copyable values (numbers, bool, enums, Vector2, Vector3, Transform) are copied as they are.
+* Strings are written as a uint32_t length followed by the characters, std::vector<std::string> as a uint32_t count
+* followed by the strings.
+*
+* Reading a std::string_view returns a view into the received packet, so events taking std::string_view arguments
+* don't allocate anything when they are received.
+*/
+namespace NetworkEvent
+{
+	/**
+	* @brief
+	* Identifies an event on the network. A 32 bit FNV-1a hash of the event's name.
+	*
+	* The name is the same on the client and the server, so the hash is too, unlike the address of a function.
+	*/
+	constexpr uint32_t GetEventHash(std::string_view Name)
+	{
+		uint32_t Hash = 2166136261u;
+		for (char c : Name)
+		{
+			Hash = (Hash ^ (uint8_t)c) * 16777619u;
+		}
+		return Hash;
+	}
+
+	/// Destroys the target object on the receiver.
+	constexpr uint32_t DESTROY_EVENT = GetEventHash("__destr");
+	/// Loads a new scene on the client. Takes the scene name as a string argument.
+	constexpr uint32_t SCENE_EVENT = GetEventHash("__scene");
+
+	template<typename T>
+	constexpr bool IsTrivialArgument = std::is_trivially_copyable_v<T> && !std::is_pointer_v<T>;
+
+	template<typename T>
+	constexpr bool IsStringArgument = std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+	/// Appends serialized arguments to a byte buffer.
+	class ArgumentWriter
+	{
+	public:
+		ArgumentWriter(std::vector<uint8_t>& Target)
+			: Data(Target)
+		{
+		}
+
+		template<typename T>
+		void Write(const T& Value)
+		{
+			static_assert(IsTrivialArgument<T>, "Network event arguments must be trivially copyable, strings or vectors of strings.");
+			size_t Position = Data.size();
+			Data.resize(Position + sizeof(T));
+			memcpy(Data.data() + Position, &Value, sizeof(T));
+		}
+
+		void Write(std::string_view Value)
+		{
+			Write((uint32_t)Value.size());
+			Data.insert(Data.end(), Value.begin(), Value.end());
+		}
+
+		void Write(const std::string& Value)
+		{
+			Write(std::string_view(Value));
+		}
+
+		void Write(const char* Value)
+		{
+			Write(std::string_view(Value));
+		}
+
+		void Write(const std::vector<std::string>& Value)
+		{
+			Write((uint32_t)Value.size());
+			for (const std::string& i : Value)
+			{
+				Write(std::string_view(i));
+			}
+		}
+
+	private:
+		std::vector<uint8_t>& Data;
+	};
+
+	/// Reads serialized arguments. After a failed read, HasError() is true and all further reads fail.
+	class ArgumentReader
+	{
+	public:
+		ArgumentReader(const uint8_t* Data, size_t Size)
+			: Data(Data), Size(Size)
+		{
+		}
+
+		template<typename T>
+		bool Read(T& Value)
+		{
+			static_assert(IsTrivialArgument<T>, "Network event arguments must be trivially copyable, strings or vectors of strings.");
+			if (!Require(sizeof(T)))
+			{
+				return false;
+			}
+			memcpy(&Value, Data + Position, sizeof(T));
+			Position += sizeof(T);
+			return true;
+		}
+
+		bool Read(std::string_view& Value)
+		{
+			uint32_t Length = 0;
+			if (!Read(Length) || !Require(Length))
+			{
+				return false;
+			}
+			Value = std::string_view((const char*)Data + Position, Length);
+			Position += Length;
+			return true;
+		}
+
+		bool Read(std::string& Value)
+		{
+			std::string_view View;
+			if (!Read(View))
+			{
+				return false;
+			}
+			Value.assign(View);
+			return true;
+		}
+
+		bool Read(std::vector<std::string>& Value)
+		{
+			uint32_t Count = 0;
+			if (!Read(Count))
+			{
+				return false;
+			}
+			// Every string takes at least its length, so this limits the allocation to the size of the packet.
+			if (!Require((size_t)Count * sizeof(uint32_t)))
+			{
+				return false;
+			}
+			Value.resize(Count);
+			for (std::string& i : Value)
+			{
+				if (!Read(i))
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool HasError() const
+		{
+			return Error;
+		}
+
+		bool IsAtEnd() const
+		{
+			return Position == Size;
+		}
+
+	private:
+		bool Require(size_t Bytes)
+		{
+			if (Error || Size - Position < Bytes)
+			{
+				Error = true;
+				return false;
+			}
+			return true;
+		}
+
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+		size_t Position = 0;
+		bool Error = false;
+	};
+
+	/// The class and argument types of a member function used as a network event.
+	template<typename T>
+	struct EventFunction;
+
+	template<typename Class, typename... Args>
+	struct EventFunction<void(Class::*)(Args...)>
+	{
+		using ObjectType = Class;
+		using Arguments = std::tuple<std::decay_t<Args>...>;
+		static constexpr size_t NumArguments = sizeof...(Args);
+	};
+
+	/// Writes Value as the argument type Param, so a literal 1 is sent as a float if the event takes a float.
+	template<typename Param, typename T>
+	void WriteArgument(ArgumentWriter& Writer, const T& Value)
+	{
+		if constexpr (IsStringArgument<Param>)
+		{
+			Writer.Write(std::string_view(Value));
+		}
+		else if constexpr (std::is_same_v<Param, std::vector<std::string>>)
+		{
+			Writer.Write(Value);
+		}
+		else
+		{
+			Writer.Write(static_cast<Param>(Value));
+		}
+	}
+
+	template<typename... Params, typename... Args>
+	void WriteArguments(ArgumentWriter& Writer, std::tuple<Params...>*, const Args&... Arguments)
+	{
+		static_assert(sizeof...(Params) == sizeof...(Args), "Wrong number of arguments for network event.");
+		(WriteArgument<Params>(Writer, Arguments), ...);
+	}
+
+	/**
+	* @brief
+	* Reads the arguments of Function from Reader and calls it on Object.
+	*
+	* Returns false without calling the function if the arguments don't match the function.
+	*/
+	template<auto Function>
+	bool CallWithArguments(SceneObject* Object, ArgumentReader& Reader)
+	{
+		using Event = EventFunction<decltype(Function)>;
+		typename Event::Arguments Values;
+		bool Valid = std::apply([&Reader](auto&... Value)
+			{
+				return (Reader.Read(Value) && ...);
+			}, Values);
+		if (!Valid || !Reader.IsAtEnd())
+		{
+			return false;
+		}
+		std::apply([Object](auto&... Value)
+			{
+				(static_cast<typename Event::ObjectType*>(Object)->*Function)(std::move(Value)...);
+			}, Values);
+		return true;
+	}
+}
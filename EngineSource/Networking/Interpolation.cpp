@@ -0,0 +1,216 @@
+#if !EDITOR
+#include "Interpolation.h"
+#include "Networking.h"
+#include "Client.h"
+#include <Objects/SceneObject.h>
+#include <unordered_map>
+#include <deque>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace Interpolation
+{
+	float Delay = 0.1f;
+	float MaxExtrapolation = 0.25f;
+
+	// Buffered transforms older than the one needed for interpolation are removed, this only limits bursts.
+	constexpr size_t MAX_SAMPLES = 32;
+	// If the estimated server clock is off by more than this, it is reset instead of slowly adjusted.
+	constexpr double MAX_CLOCK_ERROR = 0.5;
+	// How much each received snapshot moves the estimated server clock towards the time it was sent.
+	constexpr double CLOCK_ADJUST_FACTOR = 0.05;
+	// Objects that haven't been sent for this long are assumed to have been standing still.
+	constexpr double STATIONARY_TIME = 0.1;
+
+	struct Sample
+	{
+		/// The estimated server time the transform was sent at, in seconds.
+		double Time = 0;
+		Transform SampleTransform;
+	};
+
+	struct InterpolatedObject
+	{
+		SceneObject* Object = nullptr;
+		std::deque<Sample> Samples;
+	};
+
+	static std::unordered_map<uint64_t, InterpolatedObject> Objects;
+
+	/// Server time minus local time, estimated from the game times of received snapshots.
+	static double ServerTimeOffset = 0;
+	static bool HasServerTime = false;
+	/// The time of the newest sample of any object.
+	static double LatestSampleTime = 0;
+
+	static double GetLocalTime()
+	{
+		static const auto StartTime = std::chrono::steady_clock::now();
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - StartTime).count();
+	}
+
+	static double GetServerTime()
+	{
+		return GetLocalTime() + ServerTimeOffset;
+	}
+
+	static float InterpolateAngle(float a, float b, float Alpha)
+	{
+		return a + std::remainder(b - a, 6.2831853f) * Alpha;
+	}
+
+	static Transform InterpolateTransform(const Transform& a, const Transform& b, float Alpha)
+	{
+		Transform Out;
+		Out.Position = Vector3::Lerp(a.Position, b.Position, Alpha);
+		Out.Rotation = Vector3(
+			InterpolateAngle(a.Rotation.X, b.Rotation.X, Alpha),
+			InterpolateAngle(a.Rotation.Y, b.Rotation.Y, Alpha),
+			InterpolateAngle(a.Rotation.Z, b.Rotation.Z, Alpha));
+		Out.Scale = Vector3::Lerp(a.Scale, b.Scale, std::clamp(Alpha, 0.0f, 1.0f));
+		return Out;
+	}
+
+	static void AddSample(SceneObject* Object, double Time, const Transform& NewTransform)
+	{
+		InterpolatedObject& Entry = Objects[Object->NetID];
+		if (Entry.Object != Object)
+		{
+			Entry.Object = Object;
+			Entry.Samples.clear();
+		}
+
+		// Snapshots can arrive out of order, so the sample is inserted sorted by time.
+		auto Position = std::upper_bound(Entry.Samples.begin(), Entry.Samples.end(), Time,
+			[](double Value, const Sample& s)
+			{
+				return Value < s.Time;
+			});
+		if (Position == Entry.Samples.end() && !Entry.Samples.empty() && Time - Entry.Samples.back().Time > STATIONARY_TIME)
+		{
+			// Unchanged objects aren't sent, so the object only started moving again right before this sample.
+			// Without this, it would slowly move from the old state to the new one over the whole gap.
+			Sample Stationary = Entry.Samples.back();
+			Stationary.Time = Time - 1.0 / (double)Networking::GetTickRate();
+			Entry.Samples.push_back(Stationary);
+			Position = Entry.Samples.end();
+		}
+
+		if (Position != Entry.Samples.begin() && (Position - 1)->Time == Time)
+		{
+			(Position - 1)->SampleTransform = NewTransform;
+		}
+		else
+		{
+			Entry.Samples.insert(Position, Sample{ Time, NewTransform });
+		}
+		if (Entry.Samples.size() > MAX_SAMPLES)
+		{
+			Entry.Samples.pop_front();
+		}
+		LatestSampleTime = std::max(LatestSampleTime, Time);
+
+		// The first transform is applied directly, so the object doesn't sit at its spawn position until the delay has passed.
+		if (Entry.Samples.size() == 1)
+		{
+			Object->GetTransform() = NewTransform;
+		}
+	}
+}
+
+bool Interpolation::ShouldInterpolate([[maybe_unused]] SceneObject* Object)
+{
+#if SERVER
+	return false;
+#else
+	return Object->GetIsReplicated() && Object->NetOwner != Client::GetClientID() && Delay > 0;
+#endif
+}
+
+void Interpolation::AddSnapshot(SceneObject* Object, uint64_t ServerTime, const Transform& NewTransform)
+{
+	double SentTime = (double)ServerTime / 1000000.0;
+	double Offset = SentTime - GetLocalTime();
+	if (!HasServerTime || std::abs(Offset - ServerTimeOffset) > MAX_CLOCK_ERROR)
+	{
+		ServerTimeOffset = Offset;
+		HasServerTime = true;
+	}
+	else
+	{
+		ServerTimeOffset += (Offset - ServerTimeOffset) * CLOCK_ADJUST_FACTOR;
+	}
+	AddSample(Object, SentTime, NewTransform);
+}
+
+void Interpolation::AddUpdate(SceneObject* Object, const Transform& NewTransform)
+{
+	AddSample(Object, GetServerTime(), NewTransform);
+}
+
+Transform Interpolation::GetLatestTransform(SceneObject* Object)
+{
+	auto Found = Objects.find(Object->NetID);
+	if (Found == Objects.end() || Found->second.Object != Object || Found->second.Samples.empty())
+	{
+		return Object->GetTransform();
+	}
+	return Found->second.Samples.back().SampleTransform;
+}
+
+void Interpolation::Update()
+{
+	double RenderTime = GetServerTime() - Delay;
+
+	for (auto i = Objects.begin(); i != Objects.end();)
+	{
+		InterpolatedObject& Entry = i->second;
+		if (Networking::GetObjectFromNetID(i->first) != Entry.Object || !ShouldInterpolate(Entry.Object) || Entry.Samples.empty())
+		{
+			i = Objects.erase(i);
+			continue;
+		}
+
+		auto& Samples = Entry.Samples;
+		// Only the last sample before the render time is needed.
+		while (Samples.size() > 2 && Samples[1].Time <= RenderTime)
+		{
+			Samples.pop_front();
+		}
+
+		const Sample& First = Samples.front();
+		if (RenderTime <= First.Time || Samples.size() == 1)
+		{
+			Entry.Object->GetTransform() = First.SampleTransform;
+		}
+		else if (RenderTime < Samples[1].Time)
+		{
+			float Alpha = float((RenderTime - First.Time) / (Samples[1].Time - First.Time));
+			Entry.Object->GetTransform() = InterpolateTransform(First.SampleTransform, Samples[1].SampleTransform, Alpha);
+		}
+		else if (LatestSampleTime > Samples[1].Time)
+		{
+			// Newer states of other objects have arrived, so this object hasn't changed since. Unchanged objects aren't sent.
+			Entry.Object->GetTransform() = Samples[1].SampleTransform;
+		}
+		else
+		{
+			// Nothing newer has arrived (packet loss), keep moving with the velocity between the last two states.
+			const Sample& Last = Samples[1];
+			double Extrapolated = std::min(RenderTime - Last.Time, (double)MaxExtrapolation);
+			float Alpha = 1.0f + float(Extrapolated / (Last.Time - First.Time));
+			Entry.Object->GetTransform() = InterpolateTransform(First.SampleTransform, Last.SampleTransform, Alpha);
+		}
+		i++;
+	}
+}
+
+void Interpolation::Reset()
+{
+	Objects.clear();
+	HasServerTime = false;
+	ServerTimeOffset = 0;
+	LatestSampleTime = 0;
+}
+#endif
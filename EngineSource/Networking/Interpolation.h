@@ -0,0 +1,42 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include <Math/Vector.h>
+
+class SceneObject;
+
+/**
+* @brief
+* Smooths the movement of replicated objects on clients.
+*
+* Received transforms of objects owned by someone else are not applied right away. They are buffered together with the
+* server time they were sent at, and each frame the object is placed at the transform interpolated for the current server
+* time minus Delay. If no newer transform has arrived (packet loss), the object keeps moving with its last velocity
+* for up to MaxExtrapolation seconds.
+*
+* Objects owned by the client are simulated locally and aren't interpolated.
+*/
+namespace Interpolation
+{
+	/// How far behind the latest received state remote objects are shown, in seconds.
+	extern float Delay;
+	/// How long objects keep moving when no newer state arrives, in seconds.
+	extern float MaxExtrapolation;
+
+	/// True if received transforms of Object should be passed to this namespace instead of being applied.
+	bool ShouldInterpolate(SceneObject* Object);
+
+	/// Adds a transform of Object sent by the server at the given game time of the server, in microseconds (see Networking::GetGameTime()).
+	void AddSnapshot(SceneObject* Object, uint64_t ServerTime, const Transform& NewTransform);
+	/// Adds a transform of Object that has no server tick (text value updates). The arrival time is used instead.
+	void AddUpdate(SceneObject* Object, const Transform& NewTransform);
+	/// The newest transform received for Object, or its current transform if nothing has been buffered.
+	Transform GetLatestTransform(SceneObject* Object);
+
+	/// Moves interpolated objects. Called every frame on clients.
+	void Update();
+
+	/// Forgets all buffered transforms. Called when connecting, disconnecting or changing the scene.
+	void Reset();
+}
+#endif
@@ -1,81 +1,63 @@
 #if !EDITOR
 #include "NetworkEvent.h"
 #include "Packet.h"
+#include "PacketLayout.h"
 #include <Engine/Log.h>
 #include "Client.h"
 #include "Networking.h"
 #include "Server.h"
-#include <unordered_set>
 #include <Objects/SceneObject.h>
 #include <Engine/Utility/StringUtility.h>
 #include <Engine/Subsystem/Scene.h>
+#include <algorithm>
 
 namespace NetworkEvent
 {
 	uint64_t EventID = 0;
 	struct Event
 	{
-		std::string Name;
-		uint64_t Object = 0;
-		uint64_t LastTick = 0;
 		uint64_t EventID = 0;
 		uint64_t TargetClient = Networking::ServerID;
 	};
 
-	std::unordered_set<uint64_t> ReceivedEvents;
-
+	/// Events waiting for the receiver to accept them. Events are sent reliably, so only events that need a response are stored.
 	std::vector<Event> SentEvents;
 	static void* CallingClient = nullptr;
-	
-	static void SendEvent(const Event& e)
+
+	static void* GetTargetAddress(uint64_t TargetClient)
 	{
-		Packet p;
-		p.Write((uint8_t)Packet::PacketType::NetworkEventTrigger);
-		p.Write(e.EventID);
-		p.Write(e.Object);
-		p.AppendStringToData(e.Name);
-		void* IP = nullptr;
-		if (e.TargetClient == Networking::ServerID)
+		if (TargetClient == Networking::ServerID)
 		{
-			IP = Client::GetCurrentServerAddr();
-		}
-		else
-		{
-			auto Client = Server::GetClientInfoFromID(e.TargetClient);
-			if (Client)
-			{
-				IP = Client->IP;
-			}
-			else
-			{
-				return;
-			}
+			return Client::GetCurrentServerAddr();
 		}
-		p.Send(IP);
+		auto Client = Server::GetClientInfoFromID(TargetClient);
+		return Client ? Client->IP : nullptr;
 	}
 }
 
-void NetworkEvent::TriggerNetworkEvent(std::string Name, std::vector<std::string> Arguments, SceneObject* Target, uint64_t TargetClient)
+void NetworkEvent::TriggerNetworkEvent(uint32_t Event, const std::vector<uint8_t>& Arguments, SceneObject* Target, uint64_t TargetClient)
 {
-	Event e;
-	e.EventID = EventID++;
-	e.LastTick = Networking::GetGameTick();
-	e.Name = Name;
-	for (auto& i : Arguments)
-	{
-		e.Name.append(";" + i);
-	}
-	e.TargetClient = TargetClient;
-	if (Target)
+	void* IP = GetTargetAddress(TargetClient);
+	uint64_t ObjectID = Target ? Target->NetID : UINT64_MAX;
+	uint64_t ID = EventID++;
+	if (!IP)
 	{
-		e.Object = Target->NetID;
+		return;
 	}
-	else
+	if (ObjectID == UINT64_MAX && Event == SCENE_EVENT)
 	{
-		e.Object = UINT64_MAX;
+		SentEvents.push_back(NetworkEvent::Event{ ID, TargetClient });
 	}
-	SentEvents.push_back(e);
-	SendEvent(e);
+
+	// Reused, so sending an event doesn't allocate once the buffer is large enough.
+	static Packet p;
+	p.Data.clear();
+	p.Write((uint8_t)Packet::PacketType::NetworkEventTrigger);
+	p.Write(ID);
+	p.Write(ObjectID);
+	p.Write(Event);
+	p.Data.insert(p.Data.end(), Arguments.begin(), Arguments.end());
+	p.SendReliable(IP);
 }
 
 void NetworkEvent::HandleNetworkEvent(Packet* Data)
@@ -83,49 +65,31 @@ void NetworkEvent::HandleNetworkEvent(Packet* Data)
 	uint64_t EventID = 0;
 	uint64_t ObjID = 0;
 
-	if (Data->Data.size() < sizeof(EventID) + sizeof(ObjID) + 1)
+	uint32_t Event = 0;
+
+	if (Data->Data.size() < PacketLayout::EVENT_ARGUMENTS_OFFSET)
 	{
 		return;
 	}
 
 	Data->Read(EventID);
 	Data->Read(ObjID);
-
-	std::string Value;
-	for (size_t i = 1 + sizeof(uint64_t) + sizeof(uint64_t); i < Data->Data.size(); i++)
-	{
-		if (Data->Data[i] == 0)
-		{
-			break;
-		}
-		Value.append({ (char)Data->Data[i] });
-	}
-	std::vector<std::string> Values = StrUtil::SeparateString(Value, ';');
-	if (Values.empty())
-	{
-		return;
-	}
-	std::string Name = Values[0];
-	Values.erase(Values.begin());
-
-	Packet p;
-	p.Write((uint8_t)Packet::PacketType::NetworkEventAccept);
-	p.Write(EventID);
-	p.Send(Data->FromAddr);
-
-	if (ReceivedEvents.contains(EventID))
-	{
-		return;
-	}
-
-	ReceivedEvents.insert(EventID);
+	Data->Read(Event);
+	ArgumentReader Arguments = ArgumentReader(Data->Data.data() + PacketLayout::EVENT_ARGUMENTS_OFFSET, Data->Data.size() - PacketLayout::EVENT_ARGUMENTS_OFFSET);
 
 #if !SERVER
 	if (ObjID == UINT64_MAX)
 	{
-		if (Name == "__scene" && Values.size() == 1)
+		std::string SceneName;
+		if (Event == SCENE_EVENT && Arguments.Read(SceneName) && Arguments.IsAtEnd())
 		{
-			Scene::LoadNewScene(Values.at(0), true);
+			// The server waits for this before sending objects of the new scene.
+			Packet p;
+			p.Write((uint8_t)Packet::PacketType::NetworkEventAccept);
+			p.Write(EventID);
+			p.SendReliable(Data->FromAddr);
+
+			Scene::LoadNewScene(SceneName, true);
 		}
 		return;
 	}
@@ -149,7 +113,7 @@ void NetworkEvent::HandleNetworkEvent(Packet* Data)
 #if !SERVER
 	if (Networking::IPEqual(Client::GetCurrentServerAddr(), Data->FromAddr))
 	{
-		if (Name == "__destr")
+		if (Event == DESTROY_EVENT)
 		{
 			Objects::DestroyObject(Target);
 			return;
@@ -165,10 +129,13 @@ void NetworkEvent::HandleNetworkEvent(Packet* Data)
 			continue;
 		}
 #endif
-		if (i.Name == Name)
+		if (i.Hash == Event)
 		{
 			CallingClient = Data->FromAddr;
-			(Target->*i.Function)(Values);
+			if (!i.Handler(Target, Arguments))
+			{
+				Log::Print(StrUtil::Format("[Net]: Received invalid arguments for event %s", i.Name.c_str()), Log::LogColor::Yellow);
+			}
 			CallingClient = nullptr;
 			break;
 		}
@@ -192,12 +159,7 @@ void NetworkEvent::HandleEventAccept(Packet* Data)
 			continue;
 		}
 #if SERVER
-		auto& EventName = SentEvents[i].Name;
-		size_t FirstSemicolon = EventName.find_first_of(";");
-		if (EventName.substr(0, FirstSemicolon) == "__scene" && SentEvents[i].Object == UINT64_MAX)
-		{
-			Server::OnClientAcceptSceneChange(SentEvents[i].TargetClient);
-		}
+		Server::OnClientAcceptSceneChange(SentEvents[i].TargetClient);
 #endif
 
 		SentEvents.erase(SentEvents.begin() + i);
@@ -218,14 +180,6 @@ void NetworkEvent::Update()
 		SentEvents.clear();
 	}
 #endif
-	for (size_t i = 0; i < SentEvents.size(); i++)
-	{
-		if (Networking::GetGameTick() - SentEvents[i].LastTick > 8)
-		{
-			SentEvents[i].LastTick = Networking::GetGameTick();
-			SendEvent(SentEvents[i]);
-		}
-	}
 }
 void NetworkEvent::ClearEventsFor(uint64_t PlayerID)
 {
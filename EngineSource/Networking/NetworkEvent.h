@@ -1,14 +1,29 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
+#include "EventArguments.h"
 
 class SceneObject;
 struct Packet;
 
 namespace NetworkEvent
 {
-	void TriggerNetworkEvent(std::string Name, std::vector<std::string> Arguments, SceneObject* Target, uint64_t TargetClient);
+	/**
+	* @brief
+	* Sends the event to TargetClient.
+	*
+	* @param Event
+	* The hash of the event's name, see GetEventHash(). Only the hash is sent.
+	*
+	* @param Arguments
+	* The arguments of the event, serialized with an ArgumentWriter.
+	*
+	* @param Target
+	* The object the event is called on. nullptr for engine events like SCENE_EVENT.
+	*/
+	void TriggerNetworkEvent(uint32_t Event, const std::vector<uint8_t>& Arguments, SceneObject* Target, uint64_t TargetClient);
 
 	void HandleNetworkEvent(Packet* Data);
 	void HandleEventAccept(Packet* Data);
@@ -1,5 +1,6 @@
 #include "Networking.h"
 #include <Objects/SceneObject.h>
+#include <unordered_map>
 #if !EDITOR
 #include <iostream>
 #include <Engine/Log.h>
@@ -11,9 +12,15 @@
 #include <Networking/NetworkingInternal.h>
 #include <Networking/Client.h>
 #include "NetworkEvent.h"
+#include "Replication.h"
+#include "BatchedSocket.h"
+#include "Connection.h"
+#include "Interpolation.h"
 #include "Server.h"
 #include <Engine/Subsystem/Console.h>
 #include <Engine/EngineError.h>
+#include <Engine/Application.h>
+#include <algorithm>
 #if _WIN32
 // Undefine macros first defined in SDL_net.h to avoid warnings.
 #undef INADDR_ANY
@@ -28,7 +35,94 @@
 
 namespace Networking
 {
-	constexpr uint32_t TICK_RATE = 64;
+	int TickRate = 64;
+	bool AdaptiveTickRate = false;
+	int IdleTickRate = 8;
+
+	constexpr uint32_t MAX_TICK_RATE = 1000;
+	// How long the server waits after the last client disconnected before it lowers the tick rate.
+	constexpr float IDLE_DELAY = 5.0f;
+	// Minimum time between two changes of the tick rate under load, so the tick cost can settle at the new rate.
+	constexpr float LOAD_ADJUST_DELAY = 0.5f;
+	// Weight of the newest tick in the average tick cost.
+	constexpr float TICK_COST_SMOOTHING = 0.1f;
+	// Fractions of the tick interval spent working above which the tick rate is lowered and below which it is raised.
+	constexpr float HIGH_LOAD = 0.8f;
+	constexpr float LOW_LOAD = 0.4f;
+
+	static uint32_t CurrentTickRate = 64;
+	static uint32_t ServerTickRate = 0;
+	static Application::Timer IdleTimer;
+#if SERVER
+	// The tick rate the server can sustain with its measured tick cost, between IdleTickRate and TickRate.
+	static uint32_t LoadTickRate = 64;
+	static float AverageTickCost = 0;
+	static Application::Timer LoadAdjustTimer;
+#endif
+
+	static uint32_t ClampTickRate(int Rate)
+	{
+		return (uint32_t)std::clamp(Rate, 1, (int)MAX_TICK_RATE);
+	}
+
+#if SERVER
+	static void UpdateLoadTickRate()
+	{
+		uint32_t MaxRate = ClampTickRate(TickRate);
+		uint32_t MinRate = std::min(ClampTickRate(IdleTickRate), MaxRate);
+
+		// The logic time of the server is the time spent in the last tick, without sleeping.
+		AverageTickCost += (Stats::LogicTime - AverageTickCost) * TICK_COST_SMOOTHING;
+		LoadTickRate = std::clamp(LoadTickRate, MinRate, MaxRate);
+		if (LoadAdjustTimer.Get() < LOAD_ADJUST_DELAY)
+		{
+			return;
+		}
+
+		// The cost of a tick mostly depends on the number of objects and clients, not on the tick rate,
+		// so the load at a different tick rate can be estimated from the current cost.
+		float Load = AverageTickCost * (float)LoadTickRate;
+		uint32_t NewRate = LoadTickRate;
+		if (Load > HIGH_LOAD)
+		{
+			NewRate = std::max(MinRate, LoadTickRate * 3 / 4);
+		}
+		else if (Load < LOW_LOAD)
+		{
+			NewRate = std::min(MaxRate, LoadTickRate + std::max(1u, LoadTickRate / 8));
+		}
+		if (NewRate != LoadTickRate)
+		{
+			LoadTickRate = NewRate;
+			LoadAdjustTimer.Reset();
+		}
+	}
+#endif
+
+	static void UpdateTickRate()
+	{
+#if SERVER
+		if (!AdaptiveTickRate)
+		{
+			CurrentTickRate = ClampTickRate(TickRate);
+			IdleTimer.Reset();
+			return;
+		}
+
+		UpdateLoadTickRate();
+		CurrentTickRate = LoadTickRate;
+		if (!Server::GetClients().empty())
+		{
+			IdleTimer.Reset();
+		}
+		else if (IdleTimer.Get() > IDLE_DELAY)
+		{
+			CurrentTickRate = std::min(CurrentTickRate, ClampTickRate(IdleTickRate));
+		}
+#else
+		CurrentTickRate = Client::GetIsConnected() && ServerTickRate ? ServerTickRate : ClampTickRate(TickRate);
+#endif
+	}
 
 	void InitPacket(IPaddress* Target);
 	void InitSockets(uint16_t Port);
@@ -40,6 +134,7 @@ namespace Networking
 	UDPpacket* PacketData;
 	float TickTimer = 0;
 	uint64_t GameTick = 0;
+	uint64_t GameTime = 0;
 	bool IsServerTickFrame = false;
 	uint64_t NetIDCounter = 0;
 
@@ -57,6 +152,14 @@ void Networking::InitPacket(IPaddress* Target)
 
 void Networking::InitSockets(uint16_t Port)
 {
+#if BATCHED_SOCKET_IO
+	if (BatchedSocket::Open(Port))
+	{
+		Log::Print(StrUtil::Format("[Net]: Starting server on port %i (batched socket I/O)", Port), Log::LogColor::Blue);
+		return;
+	}
+	Log::Print("[Net]: Batched socket I/O is unavailable, using SDL_net instead", Log::LogColor::Yellow);
+#endif
 	if (!(Socket = SDLNet_UDP_Open(Port)))
 	{
 		Log::Print(StrUtil::Format("Could not create socket on port '%i'", int(Port)), Log::LogColor::Red);
@@ -139,68 +242,6 @@ UDPsocket Networking::InitSocketFrom(IPaddress* Target)
 	return fret;
 }
 
-void Networking::SendObjectInfo(SceneObject* obj, void* TargetAddr)
-{
-	if (!obj->GetIsReplicated())
-	{
-		return;
-	}
-
-	if (Client::GetClientID() == obj->NetOwner
-		|| (Client::GetClientID() == Networking::ServerID
-			&& Server::GetClientInfoFromIP(TargetAddr)->ID != obj->NetOwner))
-	{
-		Packet p;
-		p.Data =
-		{
-			(uint8_t)Packet::PacketType::ValueUpdate,
-		};
-
-		p.Write(obj->NetID);
-		p.AppendStringToData("_pos=" + obj->GetTransform().Position.ToString());
-		p.AppendStringToData(";_rot=" + obj->GetTransform().Rotation.ToString());
-		p.AppendStringToData(";_scl=" + obj->GetTransform().Scale.ToString());
-		p.AppendStringToData(";_owner=" + std::to_string(obj->NetOwner));
-		p.Send(TargetAddr);
-	}
-	else if (Client::GetClientID() != Networking::ServerID)
-	{
-		return;
-	}
-
-	Packet Properties;
-	for (auto& i : obj->Properties)
-	{
-		if (i.PType != SceneObject::Property::PropertyType::NetProperty)
-		{
-			continue;
-		}
-#if SERVER
-		if (i.PropertyOwner == SceneObject::Property::NetOwner::Server || obj->NetOwner != Server::GetClientInfoFromIP(TargetAddr)->ID)
-#else
-		if (i.PropertyOwner == SceneObject::Property::NetOwner::Client && obj->NetOwner == Client::GetClientID())
-#endif
-		{
-			if (Properties.Data.empty())
-			{
-				Properties.Data =
-				{
-					(uint8_t)Packet::PacketType::ValueUpdate,
-				};
-
-				Properties.Data.resize(9);
-				memcpy(&Properties.Data[1], &obj->NetID, sizeof(size_t));
-			}
-
-			Properties.AppendStringToData(i.Name + "=" + i.ValueToString(obj) + ";");
-		}
-	}
-	if (!Properties.Data.empty())
-	{
-		Properties.Send(TargetAddr);
-	}
-}
-
 void Networking::Init(uint16_t DefaultPort)
 {
 	Networking::DefaultPort = DefaultPort;
@@ -227,12 +268,41 @@ void Networking::Init(uint16_t DefaultPort)
 		{
 			Client::Disconnect();
 		}, {}));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_interp_delay", NativeType::Float, &Interpolation::Delay, nullptr));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_extrapolation_limit", NativeType::Float, &Interpolation::MaxExtrapolation, nullptr));
 #else
 	Console::ConsoleSystem->RegisterCommand(Console::Command("disconnect", []()
 		{
 			Server::DisconnectPlayer(std::stoi(Console::ConsoleSystem->CommandArgs()[0]));
 		}, { Console::Command::Argument("player_uid", NativeType::Int) }));
 #endif
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_binary_snapshots", NativeType::Bool, &Replication::UseBinarySnapshots, nullptr));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_tickrate", NativeType::Int, &Networking::TickRate, nullptr));
+#if SERVER
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_adaptive_tickrate", NativeType::Bool, &Networking::AdaptiveTickRate, nullptr));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_idle_tickrate", NativeType::Int, &Networking::IdleTickRate, nullptr));
+#endif
+	Console::ConsoleSystem->RegisterCommand(Console::Command("net_stats", []()
+		{
+			std::vector<Connection::Stats> AllStats = GetConnections().GetStats();
+			if (AllStats.empty())
+			{
+				Log::Print("[Net]: No connections");
+			}
+			for (const Connection::Stats& i : AllStats)
+			{
+				Log::Print(StrUtil::Format("[Net]: %s - RTT: %.1fms, loss: %.1f%%, send scale: %.2f, sent: %i, received: %i, resent: %i, pending reliable fragments: %i",
+					IPtoStr((void*)&i.Address).c_str(),
+					i.RoundTripTime * 1000.0f,
+					i.PacketLoss * 100.0f,
+					i.SendScale,
+					int(i.NumSent),
+					int(i.NumReceived),
+					int(i.NumResent),
+					int(i.PendingFragments)));
+			}
+		}, {}));
+
 #if SERVER
 	Server::Init();
 	Packet::Init();
@@ -249,6 +319,8 @@ void Networking::HandleTick()
 	Server::Update();
 #endif
 	NetworkEvent::Update();
+	GetConnections().Update();
+	Packet::FlushSends();
 }
 
 void Networking::ReceivePackets()
@@ -257,18 +329,21 @@ void Networking::ReceivePackets()
 
 	for (auto& i : p)
 	{
-		i.second.EvaluatePacket();
+		i.EvaluatePacket();
 	}
 }
 
 void Networking::Update()
 {
+	UpdateTickRate();
 #if !SERVER
-	float TickInterval = 1.0f / (float)TICK_RATE;
+	float TickInterval = 1.0f / (float)CurrentTickRate;
 	TickTimer += Stats::DeltaTime;
 	if (TickTimer > TickInterval)
 	{
-		GameTick += (uint64_t)(TickTimer / TickInterval);
+		uint64_t NumTicks = (uint64_t)(TickTimer / TickInterval);
+		GameTick += NumTicks;
+		GameTime += NumTicks * 1000000 / CurrentTickRate;
 		TickTimer = 0;
 		IsServerTickFrame = true;
 		HandleTick();
@@ -277,10 +352,13 @@ void Networking::Update()
 	{
 		IsServerTickFrame = false;
 	}
+	// Remote objects are moved every frame, not just on ticks, so they move smoothly at any frame rate.
+	Interpolation::Update();
 #else
 	HandleTick();
 	IsServerTickFrame = true;
 	GameTick++;
+	GameTime += 1000000 / CurrentTickRate;
 #endif
 }
 
@@ -309,6 +387,7 @@ std::string Networking::IPtoStr(void* addr)
 void Networking::Exit()
 {
 	Client::Exit();
+	Packet::FlushSends();
 }
 
 bool Networking::IPEqual(void* ip1, void* ip2)
@@ -320,7 +399,12 @@ bool Networking::IPEqual(void* ip1, void* ip2)
 
 uint32_t Networking::GetTickRate()
 {
-	return TICK_RATE;
+	return CurrentTickRate;
+}
+
+void Networking::SetServerTickRate(uint32_t NewTickRate)
+{
+	ServerTickRate = std::min(NewTickRate, MAX_TICK_RATE);
 }
 
 uint64_t Networking::GetGameTick()
@@ -328,6 +412,11 @@ uint64_t Networking::GetGameTick()
 	return GameTick;
 }
 
+uint64_t Networking::GetGameTime()
+{
+	return GameTime;
+}
+
 bool Networking::GetIsServerTickFrame()
 {
 	return IsServerTickFrame;
@@ -335,7 +424,7 @@ bool Networking::GetIsServerTickFrame()
 
 float Networking::GetTickDelta()
 {
-	return 1.0f / (float)TICK_RATE;
+	return 1.0f / (float)CurrentTickRate;
 }
 
 std::string Networking::ClientIDToString(uint64_t ID)
@@ -350,17 +439,167 @@ uint16_t Networking::GetDefaultPort()
 {
 	return DefaultPort;
 }
+
+void Networking::RunObjectLookupTest(size_t NumObjects)
+{
+	SceneObject* Template = nullptr;
+	for (SceneObject* i : Objects::AllObjects)
+	{
+		if (i->GetIsReplicated())
+		{
+			Template = i;
+			break;
+		}
+	}
+	if (!Template)
+	{
+		Log::Print("[Net]: The object lookup test needs at least one replicated object in the scene.", Log::LogColor::Yellow);
+		return;
+	}
+
+	// Objects spawned with a NetID only exist locally, nothing is sent to clients.
+	std::vector<SceneObject*> TestObjects;
+	TestObjects.reserve(NumObjects);
+	for (size_t i = 0; i < NumObjects; i++)
+	{
+		SceneObject* NewObject = Objects::SpawnObjectFromID(Template->GetObjectDescription().ID, Transform(), NetIDCounter++);
+		if (NewObject)
+		{
+			TestObjects.push_back(NewObject);
+		}
+	}
+
+	size_t NumErrors = 0;
+	Application::Timer LookupTimer;
+	for (SceneObject* i : TestObjects)
+	{
+		if (GetObjectFromNetID(i->NetID) != i)
+		{
+			NumErrors++;
+		}
+	}
+	float IndexTime = LookupTimer.Get();
+
+	// Compare with searching through all objects, on a sample of the objects since it gets very slow.
+	const size_t NumScanned = std::min<size_t>(TestObjects.size(), 1000);
+	LookupTimer.Reset();
+	for (size_t i = 0; i < NumScanned; i++)
+	{
+		SceneObject* Found = nullptr;
+		for (SceneObject* o : Objects::AllObjects)
+		{
+			if (o->GetIsReplicated() && o->NetID == TestObjects[i]->NetID)
+			{
+				Found = o;
+				break;
+			}
+		}
+		if (Found != TestObjects[i])
+		{
+			NumErrors++;
+		}
+	}
+	float ScanTime = LookupTimer.Get();
+
+	// Destroy the test objects right away without touching objects that are already marked for destruction.
+	std::set<SceneObject*> MarkedObjects;
+	std::swap(MarkedObjects, Objects::ObjectsToDestroy);
+	Objects::ObjectsToDestroy.insert(TestObjects.begin(), TestObjects.end());
+	std::vector<uint64_t> TestNetIDs;
+	for (SceneObject* i : TestObjects)
+	{
+		TestNetIDs.push_back(i->NetID);
+	}
+	SceneObject::DestroyMarkedObjects(false);
+	std::swap(MarkedObjects, Objects::ObjectsToDestroy);
+
+	for (uint64_t i : TestNetIDs)
+	{
+		if (GetObjectFromNetID(i))
+		{
+			NumErrors++;
+		}
+	}
+
+	Log::PrintMultiLine(StrUtil::Format("Object lookup test, %i replicated objects:\n\tIndex: %fus/lookup\n\tSearch: %fus/lookup\n\tErrors: %i",
+		int(TestObjects.size()),
+		1000000.0f * IndexTime / std::max<size_t>(TestObjects.size(), 1),
+		1000000.0f * ScanTime / std::max<size_t>(NumScanned, 1),
+		int(NumErrors)),
+		NumErrors ? Log::LogColor::Red : Log::LogColor::White,
+		"[Net]: ");
+}
 #endif
 
-// TODO: Have a map of all replicated objects to speed this up.
+namespace Networking
+{
+	static std::unordered_map<uint64_t, SceneObject*> ReplicatedObjects;
+	// The number of objects in the index with a NetID that is already used by another object, for each NetID.
+	static std::unordered_map<uint64_t, size_t> DuplicateNetIDs;
+}
+
 SceneObject* Networking::GetObjectFromNetID(uint64_t NetID)
 {
-	for (SceneObject* i : Objects::AllObjects)
+	auto Found = ReplicatedObjects.find(NetID);
+	if (Found == ReplicatedObjects.end())
+	{
+		return nullptr;
+	}
+	return Found->second;
+}
+
+void Networking::AddReplicatedObject(SceneObject* Object)
+{
+	// If two objects share a NetID, the first one is found, like with a search through Objects::AllObjects.
+	auto Inserted = ReplicatedObjects.insert({ Object->NetID, Object });
+	if (!Inserted.second && Inserted.first->second != Object)
+	{
+		Log::Print(StrUtil::Format("[Net]: Object %s has the NetID %i, which is already used by %s (NetIDs must be unique)",
+			Object->Name.c_str(),
+			int(Object->NetID),
+			Inserted.first->second->Name.c_str()), Log::LogColor::Yellow);
+		DuplicateNetIDs[Object->NetID]++;
+	}
+}
+
+void Networking::RemoveReplicatedObject(SceneObject* Object)
+{
+	auto Found = ReplicatedObjects.find(Object->NetID);
+	if (Found == ReplicatedObjects.end())
+	{
+		return;
+	}
+
+	auto Duplicate = DuplicateNetIDs.find(Object->NetID);
+	if (Duplicate != DuplicateNetIDs.end())
 	{
-		if (i->GetIsReplicated() && i->NetID == NetID)
+		if (--Duplicate->second == 0)
+		{
+			DuplicateNetIDs.erase(Duplicate);
+		}
+		if (Found->second != Object)
 		{
-			return i;
+			return;
 		}
+		// Another object with the same NetID is still alive, it is found from now on.
+		for (SceneObject* i : Objects::AllObjects)
+		{
+			if (i != Object && i->GetIsReplicated() && i->NetID == Object->NetID)
+			{
+				Found->second = i;
+				return;
+			}
+		}
+	}
+
+	if (Found->second == Object)
+	{
+		ReplicatedObjects.erase(Found);
 	}
-	return nullptr;
-}
\ No newline at end of file
+}
+
+void Networking::ClearReplicatedObjects()
+{
+	ReplicatedObjects.clear();
+	DuplicateNetIDs.clear();
+}
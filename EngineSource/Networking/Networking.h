@@ -19,8 +19,35 @@ namespace Networking
 	void DisconnectPlayer(void* IP);
 	void Exit();
 	bool IPEqual(void* ip1, void* ip2);
+
+	/// The number of ticks per second. Set with the -tickrate launch argument or the net_tickrate console variable.
+	extern int TickRate;
+	/**
+	* @brief
+	* If true, the server adapts its tick rate to its load.
+	*
+	* The server measures how long its ticks take. If they use most of the tick interval, the tick rate is lowered
+	* so the server doesn't fall behind, and once the load drops it is raised again, up to TickRate.
+	* After no client has been connected for a few seconds, the server runs at IdleTickRate, and goes back
+	* as soon as a client connects.
+	*
+	* Set with the -adaptivetickrate launch argument or the net_adaptive_tickrate console variable.
+	*/
+	extern bool AdaptiveTickRate;
+	/// The tick rate of an idle server if AdaptiveTickRate is enabled. Also the lowest tick rate used under load.
+	extern int IdleTickRate;
+
+	/// The current number of ticks per second. On clients connected to a server, this is the tick rate of the server.
 	uint32_t GetTickRate();
 	uint64_t GetGameTick();
+	/**
+	* @brief
+	* The time of the current tick in microseconds, the sum of the intervals of all ticks so far.
+	*
+	* Unlike the game tick, this keeps increasing at the same speed when the tick rate changes,
+	* so it can be used to order received states in time.
+	*/
+	uint64_t GetGameTime();
 
 	bool GetIsServerTickFrame();
 	float GetTickDelta();
@@ -28,6 +55,15 @@ namespace Networking
 	std::string ClientIDToString(uint64_t ID);
 
 	uint16_t GetDefaultPort();
+
+	/**
+	* @brief
+	* Spawns NumObjects local replicated objects, checks that GetObjectFromNetID() finds all of them
+	* and compares the lookup time with a search through all objects. The objects are destroyed afterwards.
+	*
+	* The type of the first replicated object in the scene is used for the test objects.
+	*/
+	void RunObjectLookupTest(size_t NumObjects);
 }
 #endif
 
@@ -35,4 +71,11 @@ namespace Networking
 {
 	const uint64_t ServerID = UINT64_MAX;
 	SceneObject* GetObjectFromNetID(uint64_t NetID);
+
+	/// Adds a replicated object to the index used by GetObjectFromNetID(). Called by SceneObject::Start().
+	void AddReplicatedObject(SceneObject* Object);
+	/// Removes an object from the index used by GetObjectFromNetID(). Called when the object is destroyed.
+	void RemoveReplicatedObject(SceneObject* Object);
+	/// Removes all objects from the index used by GetObjectFromNetID(). Called when a new scene is loaded.
+	void ClearReplicatedObjects();
 }
@@ -1,10 +1,23 @@
 #pragma once
 #include <SDL_net.h>
 #include <cstdint>
+#include <cstddef>
 
 class SceneObject;
 class SceneObject;
 
+namespace Connection
+{
+	class Endpoint;
+}
+
+// On Linux servers, packets are received and sent in batches with recvmmsg() and sendmmsg() instead of SDL_net.
+#if SERVER && __linux__
+#define BATCHED_SOCKET_IO 1
+#else
+#define BATCHED_SOCKET_IO 0
+#endif
+
 namespace Networking
 {
 	extern SDLNet_SocketSet SocketSet;
@@ -14,6 +27,22 @@ namespace Networking
 	extern float TickTimer;
 	extern size_t GameTick;
 	UDPsocket InitSocketFrom(IPaddress* Target);
+	/// Called by clients when the server sends its tick rate. Clients tick at the same rate while connected.
+	void SetServerTickRate(uint32_t NewTickRate);
+
+	/// The size of a packet buffer. Packet::MAX_PACKET_SIZE is the same value.
+	constexpr size_t PACKET_BUFFER_SIZE = 512;
+
+	/// Sends a datagram to Target. Used by the connections of the socket, which add the header to each packet.
+	void SendDatagram(const uint8_t* Data, size_t Length, IPaddress* Target);
+	/// The connections of the engine's socket to all addresses it talks to.
+	Connection::Endpoint& GetConnections();
 
-	void SendObjectInfo(SceneObject* obj, void* TargetAddr);
-}
\ No newline at end of file
+	/// A buffer for a packet as it is sent over the network, including the connection header.
+	struct PacketBuffer
+	{
+		uint8_t Data[PACKET_BUFFER_SIZE];
+		size_t Length = 0;
+		IPaddress Address;
+	};
+}
@@ -9,20 +9,38 @@
 #include <Engine/Utility/StringUtility.h>
 #include <Engine/Subsystem/Scene.h>
 #include <thread>
-#include <condition_variable>
-#include <mutex>
 #include "Networking.h"
+#include "Replication.h"
+#include "RingBuffer.h"
+#include "BatchedSocket.h"
+#include "Connection.h"
+#include "PacketLayout.h"
+#include <chrono>
 
-const int Packet::MAX_PACKET_SIZE = 512;
-uint64_t Packet::PacketID = 0;
+const int Packet::MAX_PACKET_SIZE = Networking::PACKET_BUFFER_SIZE;
 namespace pkt
 {
 	std::thread* pktThread = nullptr;
 	static bool RecvPacket = false;
-	std::condition_variable cv;
-	std::mutex PacketReceiveMutex;
-	std::map<uint64_t, Packet> Lines;
 	UDPpacket* threadPacket;
+
+	constexpr size_t RECEIVE_QUEUE_SIZE = 4096;
+	/// Packets received by the receive thread, waiting to be processed by Packet::Receive().
+	static SPSCRingBuffer<Networking::PacketBuffer, RECEIVE_QUEUE_SIZE> ReceiveQueue;
+	/// The senders of the packets returned by the last call to Packet::Receive().
+	static std::vector<IPaddress> ReceivedAddresses;
+
+	/// Waits until there is space in the receive queue, then returns the free slots.
+	static size_t WaitForReceiveSpace(Networking::PacketBuffer*& First)
+	{
+		size_t NumFree = ReceiveQueue.GetWritable(First);
+		while (NumFree == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			NumFree = ReceiveQueue.GetWritable(First);
+		}
+		return NumFree;
+	}
 }
 using namespace pkt;
 
@@ -89,7 +107,7 @@ void Packet::EvaluatePacket()
 		{
 			return;
 		}
-		if (Data.size() < (1 + sizeof(int32_t) + sizeof(uint64_t) + sizeof(uint64_t) + sizeof(Transform)))
+		if (Data.size() < PacketLayout::SPAWN_TRANSFORM_OFFSET + sizeof(Transform))
 		{
 			break;
 		}
@@ -132,6 +150,30 @@ void Packet::EvaluatePacket()
 	case PacketType::NetworkEventAccept:
 		NetworkEvent::HandleEventAccept(this);
 		break;
+	case PacketType::Snapshot:
+		Replication::ReadSnapshot(this);
+		break;
+	case PacketType::SnapshotAck:
+#if SERVER
+	{
+		auto Sender = Server::GetClientInfoFromIP(FromAddr);
+		if (Sender)
+		{
+			Replication::ReadAcknowledgements(this, Sender->ID);
+		}
+	}
+#endif
+		break;
+	case PacketType::TickRate:
+#if !SERVER
+		if (Data.size() >= 1 + sizeof(uint32_t))
+		{
+			uint32_t NewTickRate = 0;
+			Read(NewTickRate);
+			Networking::SetServerTickRate(NewTickRate);
+		}
+#endif
+		break;
 	default:
 		break;
 	}
@@ -153,15 +195,52 @@ void Packet::AppendStringToData(std::string str)
 
 void Packet::Send(void* TargetAddr)
 {
-	IPaddress* Target = (IPaddress*)TargetAddr;
-	Networking::PacketData->address.host = Target->host;
-	Networking::PacketData->address.port = Target->port;
-	Networking::PacketData->len = (int)Data.size() + sizeof(uint64_t);
-	
-	memcpy(Networking::PacketData->data + sizeof(uint64_t), Data.data(), Networking::PacketData->len);
-	memcpy(Networking::PacketData->data, &PacketID, sizeof(uint64_t));
-	PacketID++;
-	int Result = SDLNet_UDP_Send(Networking::Socket, -1, Networking::PacketData);
+	if (!Networking::GetConnections().Send(Data, TargetAddr, Connection::Channel::Unreliable))
+	{
+		Log::Print(StrUtil::Format("Error sending packet: %i bytes is larger than the maximum packet size", int(Data.size())));
+	}
+}
+
+void Packet::SendSequenced(void* TargetAddr)
+{
+	if (!Networking::GetConnections().Send(Data, TargetAddr, Connection::Channel::UnreliableSequenced))
+	{
+		Log::Print(StrUtil::Format("Error sending packet: %i bytes is larger than the maximum packet size", int(Data.size())));
+	}
+}
+
+void Packet::SendReliable(void* TargetAddr)
+{
+	if (!Networking::GetConnections().Send(Data, TargetAddr, Connection::Channel::ReliableOrdered))
+	{
+		Log::Print(StrUtil::Format("Error sending packet: %i bytes is larger than the maximum reliable packet size", int(Data.size())));
+	}
+}
+
+Connection::Endpoint& Networking::GetConnections()
+{
+	static Connection::Endpoint Connections(&Networking::SendDatagram);
+	return Connections;
+}
+
+void Networking::SendDatagram(const uint8_t* DatagramData, size_t Length, IPaddress* Target)
+{
+#if BATCHED_SOCKET_IO
+	if (BatchedSocket::IsOpen())
+	{
+		BatchedSocket::Send(DatagramData, Length, *Target);
+		return;
+	}
+#endif
+	if (!PacketData)
+	{
+		return;
+	}
+	PacketData->address.host = Target->host;
+	PacketData->address.port = Target->port;
+	PacketData->len = (int)Length;
+	memcpy(PacketData->data, DatagramData, Length);
+	int Result = SDLNet_UDP_Send(Socket, -1, PacketData);
 
 	if (!Result)
 	{
@@ -169,10 +248,27 @@ void Packet::Send(void* TargetAddr)
 	}
 }
 
+void Packet::FlushSends()
+{
+#if BATCHED_SOCKET_IO
+	BatchedSocket::Flush();
+#endif
+}
+
 void PacketReceive()
 {
 	while (true)
 	{
+#if BATCHED_SOCKET_IO
+		if (BatchedSocket::IsOpen())
+		{
+			Networking::PacketBuffer* Slots = nullptr;
+			size_t NumFree = WaitForReceiveSpace(Slots);
+			ReceiveQueue.Commit(BatchedSocket::Receive(Slots, NumFree, 150));
+			continue;
+		}
+#endif
+		// Without a socket there is nothing to receive, so the thread exits instead of spinning.
 		if (!Networking::SocketSet)
 		{
 			return;
@@ -186,26 +282,12 @@ void PacketReceive()
 		{
 			if (SDLNet_UDP_Recv(Networking::Socket, threadPacket))
 			{
-				Packet NewP;
-
-				if (threadPacket->len < 9)
-				{
-					continue;
-				}
-
-				NewP.Data.reserve(threadPacket->len);
-
-				uint64_t pID = 0;
-
-				memcpy(&pID, threadPacket->data, sizeof(pID));
-
-				for (int i = sizeof(uint64_t); i < threadPacket->len; i++)
-				{
-					NewP.Data.push_back(threadPacket->data[i]);
-				}
-				NewP.FromAddr = &threadPacket->address;
-				std::lock_guard lock{ PacketReceiveMutex };
-				Lines.insert(std::pair(pID, NewP));
+				Networking::PacketBuffer* Slot = nullptr;
+				WaitForReceiveSpace(Slot);
+				Slot->Length = std::min((size_t)threadPacket->len, sizeof(Slot->Data));
+				memcpy(Slot->Data, threadPacket->data, Slot->Length);
+				Slot->Address = threadPacket->address;
+				ReceiveQueue.Commit(1);
 			}
 			else
 			{
@@ -215,23 +297,34 @@ void PacketReceive()
 	}
 }
 
-std::map<uint64_t, Packet> Packet::Receive()
+std::vector<Packet> Packet::Receive()
 {
-	std::lock_guard lock{ PacketReceiveMutex };
-	std::map<uint64_t, Packet> toProcess;
-	std::swap(Lines, toProcess);
-#if 0
-	for (auto& i : toProcess)
+	std::vector<Packet> toProcess;
+	ReceivedAddresses.clear();
+
+	// Only takes the packets that are in the queue right now, even if the receive thread keeps adding more.
+	size_t Remaining = RECEIVE_QUEUE_SIZE;
+	Networking::PacketBuffer* Slots = nullptr;
+	while (size_t NumReadable = std::min(ReceiveQueue.GetReadable(Slots), Remaining))
 	{
-		for (char c : i.second.Data)
+		for (size_t i = 0; i < NumReadable; i++)
 		{
-			std::hex(std::cout);
-			std::cout << (int)c << " ";
-			std::dec(std::cout);
+			// A datagram can contain no packet (acknowledgements, fragments) or complete multiple reliable packets.
+			size_t NumPackets = toProcess.size();
+			Networking::GetConnections().Receive(Slots[i].Data, Slots[i].Length, &Slots[i].Address, toProcess);
+			for (size_t j = NumPackets; j < toProcess.size(); j++)
+			{
+				ReceivedAddresses.push_back(Slots[i].Address);
+			}
 		}
-		std::cout << std::endl;
+		ReceiveQueue.Release(NumReadable);
+		Remaining -= NumReadable;
+	}
+
+	for (size_t i = 0; i < toProcess.size(); i++)
+	{
+		toProcess[i].FromAddr = &ReceivedAddresses[i];
 	}
-#endif
 	return toProcess;
 }
 
@@ -9,7 +9,6 @@
 struct Packet
 {
 	static const int MAX_PACKET_SIZE;
-	static uint64_t PacketID;
 
 	std::vector<uint8_t> Data;
 	void* FromAddr = nullptr;
@@ -23,14 +22,38 @@ struct Packet
 		SpawnObject = 4,
 		NetworkEventTrigger = 5,
 		NetworkEventAccept = 6,
+		/// Binary object state, see Replication.
+		Snapshot = 7,
+		/// Acknowledges received snapshots, see Replication.
+		SnapshotAck = 8,
+		/// The tick rate of the server. Sent to clients when they connect and when it changes.
+		TickRate = 9,
 	};
 
 
 	void AppendStringToData(std::string str);
 
 	void EvaluatePacket();
+	/// Sends the packet without guarantees. It might get lost or arrive after packets sent later.
 	void Send(void* TargetAddr);
-	static std::map<uint64_t, Packet> Receive();
+	/// Sends the packet, dropped by the receiver if a newer sequenced packet has already arrived.
+	void SendSequenced(void* TargetAddr);
+	/**
+	* @brief
+	* Sends the packet until it has been received. Reliable packets are received in the order they were sent.
+	*
+	* Can be larger than MAX_PACKET_SIZE, see Connection::GetMaxReliableSize().
+	*/
+	void SendReliable(void* TargetAddr);
+	/**
+	* @brief
+	* Returns all packets received since the last call, in the order they arrived.
+	*
+	* FromAddr of the returned packets is valid until the next call.
+	*/
+	static std::vector<Packet> Receive();
+	/// Sends packets queued by Send(). Only needed if packets are sent in batches, otherwise Send() sends them right away.
+	static void FlushSends();
 	static void Init();
 
 	size_t StreamPos = 0;
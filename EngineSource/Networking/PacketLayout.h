@@ -0,0 +1,174 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include "BitStream.h"
+#include "Connection.h"
+#include "NetworkingInternal.h"
+
+/**
+* @file
+* @brief
+* The binary layout of packets that are also read or written by tools that don't have the engine's object system, like NetLoadTest.
+*
+* The engine reads and writes these parts of the packets with the constants and functions here, so when the layout changes,
+* such tools change with it instead of sending packets the receiver rejects.
+*/
+namespace PacketLayout
+{
+	/// SpawnObject: PacketType, int32_t object type, uint64_t NetID, uint64_t owner, Transform, then the properties as a string.
+	constexpr size_t SPAWN_NETID_OFFSET = 1 + sizeof(int32_t);
+	constexpr size_t SPAWN_OWNER_OFFSET = SPAWN_NETID_OFFSET + sizeof(uint64_t);
+	constexpr size_t SPAWN_TRANSFORM_OFFSET = SPAWN_OWNER_OFFSET + sizeof(uint64_t);
+
+	/// NetworkEventTrigger: PacketType, uint64_t event ID, uint64_t object ID, uint32_t event hash, then the arguments.
+	constexpr size_t EVENT_OBJECT_OFFSET = 1 + sizeof(uint64_t);
+	constexpr size_t EVENT_HASH_OFFSET = EVENT_OBJECT_OFFSET + sizeof(uint64_t);
+	constexpr size_t EVENT_ARGUMENTS_OFFSET = EVENT_HASH_OFFSET + sizeof(uint32_t);
+
+	// Positions are sent with a precision of 1/512 units, in a range of +-4096 units.
+	constexpr float POSITION_PRECISION = 1.0f / 512.0f;
+	constexpr uint8_t POSITION_BITS = 22;
+	// Rotations are wrapped to -pi..pi and sent as 16 bits.
+	constexpr float ROTATION_PRECISION = 6.2831853f / 65536.0f;
+	constexpr uint8_t ROTATION_BITS = 16;
+	constexpr float SCALE_PRECISION = 1.0f / 1024.0f;
+	constexpr uint8_t SCALE_BITS = 20;
+
+	/// The number of bits available for the content of a snapshot packet, without the connection header and the packet type.
+	constexpr size_t SNAPSHOT_CAPACITY = (Networking::PACKET_BUFFER_SIZE - Connection::HEADER_SIZE - 1) * 8;
+
+	/// The owner of objects that no client owns. The same as Networking::ServerID.
+	constexpr uint64_t SERVER_OWNER = UINT64_MAX;
+
+	/// The start of a snapshot packet, after the packet type. It is followed by the objects.
+	struct SnapshotHeader
+	{
+		/// Acknowledged by the receiver. Clients don't keep track of sequences and always send 0.
+		uint32_t Sequence = 0;
+		/// The tick of the sender. Baseline ages of the objects are relative to it.
+		uint64_t Tick = 0;
+		/// The game time of the sender in microseconds, see Networking::GetGameTime().
+		uint64_t Time = 0;
+
+		void Write(BitWriter& Writer) const
+		{
+			Writer.WriteVarUInt(Sequence);
+			Writer.WriteVarUInt(Tick);
+			Writer.WriteVarUInt(Time);
+		}
+
+		static SnapshotHeader Read(BitReader& Reader)
+		{
+			SnapshotHeader Header;
+			Header.Sequence = (uint32_t)Reader.ReadVarUInt();
+			Header.Tick = Reader.ReadVarUInt();
+			Header.Time = Reader.ReadVarUInt();
+			return Header;
+		}
+	};
+
+	/**
+	* @brief
+	* Writes the size of an object in a snapshot. Each object is prefixed with its size in bits,
+	* so objects the receiver can't read can be skipped.
+	*/
+	inline void WriteObjectSize(BitWriter& Writer, size_t ObjectBits)
+	{
+		Writer.WriteVarUInt(ObjectBits);
+	}
+
+	/**
+	* @brief
+	* Writes the start of an object in a snapshot, followed by its state.
+	*
+	* @param BaselineAge
+	* The number of ticks since the state the object is written relative to, or 0 if the full state is written.
+	*/
+	inline void WriteObjectStart(BitWriter& ObjectData, uint64_t NetID, uint64_t BaselineAge)
+	{
+		ObjectData.WriteVarUInt(NetID);
+		ObjectData.WriteVarUInt(BaselineAge);
+	}
+
+	/**
+	* @brief
+	* The transform of an object state written without a baseline, following the flag that the state has a transform.
+	*
+	* Layout: A flag that is set if the owner is SERVER_OWNER, otherwise followed by the owner. A flag that is set if there
+	* is a correction, followed by the correction. The quantized position and rotation, then a flag that is set if the scale is 1,
+	* otherwise followed by the quantized scale.
+	*
+	* The flags of the net properties come after the transform. Flags missing at the end of an object are read as unchanged,
+	* so a writer that doesn't know the net properties of an object can end it after the transform.
+	*/
+	struct FullTransform
+	{
+		uint64_t Owner = SERVER_OWNER;
+		uint32_t Correction = 0;
+		float Position[3] = { 0, 0, 0 };
+		float Rotation[3] = { 0, 0, 0 };
+		float Scale[3] = { 1, 1, 1 };
+
+		void Write(BitWriter& Writer) const
+		{
+			Writer.WriteBool(Owner == SERVER_OWNER);
+			if (Owner != SERVER_OWNER)
+			{
+				Writer.WriteVarUInt(Owner);
+			}
+			Writer.WriteBool(Correction != 0);
+			if (Correction != 0)
+			{
+				Writer.WriteVarUInt(Correction);
+			}
+			for (float Value : Position)
+			{
+				Writer.WriteQuantized(Value, POSITION_PRECISION, POSITION_BITS);
+			}
+			for (float Value : Rotation)
+			{
+				Writer.WriteQuantized(Value, ROTATION_PRECISION, ROTATION_BITS);
+			}
+			bool UnitScale = Scale[0] == 1 && Scale[1] == 1 && Scale[2] == 1;
+			Writer.WriteBool(UnitScale);
+			if (!UnitScale)
+			{
+				for (float Value : Scale)
+				{
+					Writer.WriteQuantized(Value, SCALE_PRECISION, SCALE_BITS);
+				}
+			}
+		}
+
+		static FullTransform Read(BitReader& Reader)
+		{
+			FullTransform t;
+			if (!Reader.ReadBool())
+			{
+				t.Owner = Reader.ReadVarUInt();
+			}
+			if (Reader.ReadBool())
+			{
+				t.Correction = (uint32_t)Reader.ReadVarUInt();
+			}
+			for (float& Value : t.Position)
+			{
+				Value = Reader.ReadQuantized(POSITION_PRECISION, POSITION_BITS);
+			}
+			for (float& Value : t.Rotation)
+			{
+				Value = Reader.ReadQuantized(ROTATION_PRECISION, ROTATION_BITS);
+			}
+			if (!Reader.ReadBool())
+			{
+				for (float& Value : t.Scale)
+				{
+					Value = Reader.ReadQuantized(SCALE_PRECISION, SCALE_BITS);
+				}
+			}
+			return t;
+		}
+	};
+}
+#endif
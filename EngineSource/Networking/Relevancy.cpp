@@ -0,0 +1,311 @@
+#if !EDITOR
+#include "Relevancy.h"
+#include "Replication.h"
+#include "NetworkEvent.h"
+#include "Networking.h"
+#include "Connection.h"
+#include "NetworkingInternal.h"
+#include <Objects/SceneObject.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <cmath>
+
+namespace Relevancy
+{
+	float GridCellSize = 32;
+	int ClientBudget = 8192;
+
+	// Objects stop being relevant a bit further away than they start being relevant,
+	// so objects near the edge of the relevancy distance aren't spawned and destroyed over and over.
+	constexpr float DESPAWN_DISTANCE_FACTOR = 1.2f;
+	// How much the priority of an object grows for each unit it moved in the last tick.
+	constexpr float SPEED_PRIORITY = 4.0f;
+
+	struct TrackedObject
+	{
+		SceneObject* Object = nullptr;
+		Vector3 Position;
+		/// The distance the object has moved since the last tick.
+		float Speed = 0;
+	};
+
+	/// All replicated objects, updated by Update().
+	static std::vector<TrackedObject> TrackedObjects;
+	/// Indices into TrackedObjects of objects with a relevancy distance, by grid cell.
+	static std::unordered_map<uint64_t, std::vector<size_t>> Grid;
+	/// Indices into TrackedObjects of objects without a relevancy distance. These are relevant to all clients.
+	static std::vector<size_t> GlobalObjects;
+	/// Indices into TrackedObjects of the objects owned by each client, by client ID. Their positions are the client's viewpoints.
+	static std::unordered_map<uint64_t, std::vector<size_t>> OwnedObjects;
+	/// Index into TrackedObjects of each object, by NetID.
+	static std::unordered_map<uint64_t, size_t> TrackedIndices;
+	/// The position of each replicated object (by NetID) in the last tick.
+	static std::unordered_map<uint64_t, Vector3> LastPositions;
+	/// The cell size used for the grid. Larger than GridCellSize if objects have a large relevancy distance.
+	static float CellSize = GridCellSize;
+	/// The largest distance from a client at which an object can still be relevant.
+	static float MaxDistance = 0;
+
+	struct ClientState
+	{
+		std::unordered_set<uint64_t> SpawnedObjects;
+		/// The priority of each relevant object, by NetID.
+		std::unordered_map<uint64_t, float> Priorities;
+	};
+
+	static std::unordered_map<uint64_t, ClientState> ClientStates;
+
+	static int32_t GetCellCoordinate(float Value)
+	{
+		return (int32_t)std::floor(Value / CellSize);
+	}
+
+	static uint64_t GetCellKey(int32_t X, int32_t Y, int32_t Z)
+	{
+		constexpr uint64_t MASK = (1 << 21) - 1;
+		return ((uint64_t)(X & MASK) << 42) | ((uint64_t)(Y & MASK) << 21) | (uint64_t)(Z & MASK);
+	}
+
+	static void SpawnOnClient(Server::ClientInfo* Client, SceneObject* Object)
+	{
+		Client->SendClientSpawnRequest(Object->GetObjectDescription().ID,
+			Object->NetID,
+			Object->NetOwner,
+			Object->GetTransform(),
+			Object->GetPropertiesAsString());
+		ClientStates[Client->ID].SpawnedObjects.insert(Object->NetID);
+	}
+
+	static void DestroyOnClient(Server::ClientInfo* Client, SceneObject* Object)
+	{
+		NetworkEvent::TriggerNetworkEvent(NetworkEvent::DESTROY_EVENT, {}, Object, Client->ID);
+		ClientState& State = ClientStates[Client->ID];
+		State.SpawnedObjects.erase(Object->NetID);
+		State.Priorities.erase(Object->NetID);
+		Replication::RemoveObjectForClient(Client->ID, Object->NetID);
+	}
+}
+
+void Relevancy::Update()
+{
+	TrackedObjects.clear();
+	Grid.clear();
+	GlobalObjects.clear();
+	OwnedObjects.clear();
+	TrackedIndices.clear();
+	MaxDistance = 0;
+
+	std::unordered_map<uint64_t, Vector3> NewPositions;
+	for (SceneObject* i : Objects::AllObjects)
+	{
+		if (!i->GetIsReplicated())
+		{
+			continue;
+		}
+
+		TrackedObject Tracked;
+		Tracked.Object = i;
+		Tracked.Position = i->GetTransform().Position;
+		auto Last = LastPositions.find(i->NetID);
+		if (Last != LastPositions.end())
+		{
+			Tracked.Speed = Vector3::Distance(Last->second, Tracked.Position);
+		}
+		NewPositions[i->NetID] = Tracked.Position;
+		MaxDistance = std::max(MaxDistance, i->NetRelevancyDistance * DESPAWN_DISTANCE_FACTOR);
+		TrackedIndices[i->NetID] = TrackedObjects.size();
+		OwnedObjects[i->NetOwner].push_back(TrackedObjects.size());
+		TrackedObjects.push_back(Tracked);
+	}
+	std::swap(LastPositions, NewPositions);
+
+	// Keeps the number of cells checked around each client small, even with large relevancy distances.
+	CellSize = std::max({ GridCellSize, MaxDistance / 2, 1.0f });
+
+	for (size_t i = 0; i < TrackedObjects.size(); i++)
+	{
+		if (TrackedObjects[i].Object->NetRelevancyDistance <= 0)
+		{
+			GlobalObjects.push_back(i);
+			continue;
+		}
+		const Vector3& Position = TrackedObjects[i].Position;
+		Grid[GetCellKey(GetCellCoordinate(Position.X), GetCellCoordinate(Position.Y), GetCellCoordinate(Position.Z))].push_back(i);
+	}
+}
+
+void Relevancy::SendObjects(Server::ClientInfo* Client)
+{
+	if (!Client->LoadedInScene)
+	{
+		return;
+	}
+
+	ClientState& State = ClientStates[Client->ID];
+
+	// Only objects that can be relevant to this client or that have to be destroyed on it are checked,
+	// so the cost per client doesn't grow with the number of objects far away from it.
+	std::vector<size_t> Candidates;
+	std::vector<Vector3> Viewpoints;
+	auto Owned = OwnedObjects.find(Client->ID);
+	if (Owned != OwnedObjects.end())
+	{
+		for (size_t i : Owned->second)
+		{
+			Viewpoints.push_back(TrackedObjects[i].Position);
+			Candidates.push_back(i);
+		}
+	}
+	Candidates.insert(Candidates.end(), GlobalObjects.begin(), GlobalObjects.end());
+	for (uint64_t NetID : State.SpawnedObjects)
+	{
+		auto Found = TrackedIndices.find(NetID);
+		if (Found != TrackedIndices.end())
+		{
+			Candidates.push_back(Found->second);
+		}
+	}
+
+	// The distance to the closest viewpoint, for objects in grid cells near any viewpoint.
+	std::unordered_map<size_t, float> NearbyObjects;
+	for (const Vector3& Viewpoint : Viewpoints)
+	{
+		int32_t MinX = GetCellCoordinate(Viewpoint.X - MaxDistance), MaxX = GetCellCoordinate(Viewpoint.X + MaxDistance);
+		int32_t MinY = GetCellCoordinate(Viewpoint.Y - MaxDistance), MaxY = GetCellCoordinate(Viewpoint.Y + MaxDistance);
+		int32_t MinZ = GetCellCoordinate(Viewpoint.Z - MaxDistance), MaxZ = GetCellCoordinate(Viewpoint.Z + MaxDistance);
+		for (int32_t x = MinX; x <= MaxX; x++)
+		{
+			for (int32_t y = MinY; y <= MaxY; y++)
+			{
+				for (int32_t z = MinZ; z <= MaxZ; z++)
+				{
+					auto Cell = Grid.find(GetCellKey(x, y, z));
+					if (Cell == Grid.end())
+					{
+						continue;
+					}
+					for (size_t i : Cell->second)
+					{
+						float Distance = Vector3::Distance(Viewpoint, TrackedObjects[i].Position);
+						auto Found = NearbyObjects.find(i);
+						if (Found == NearbyObjects.end())
+						{
+							NearbyObjects.insert({ i, Distance });
+							Candidates.push_back(i);
+						}
+						else
+						{
+							Found->second = std::min(Found->second, Distance);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	std::sort(Candidates.begin(), Candidates.end());
+	Candidates.erase(std::unique(Candidates.begin(), Candidates.end()), Candidates.end());
+
+	std::vector<std::pair<SceneObject*, float>> RelevantObjects;
+	for (size_t i : Candidates)
+	{
+		const TrackedObject& Tracked = TrackedObjects[i];
+		SceneObject* Object = Tracked.Object;
+		bool Spawned = State.SpawnedObjects.contains(Object->NetID);
+
+		float Distance = 0;
+		bool Relevant = IsAlwaysRelevant(Object, Client->ID);
+		if (Relevant)
+		{
+			if (!Viewpoints.empty())
+			{
+				Distance = INFINITY;
+				for (const Vector3& Viewpoint : Viewpoints)
+				{
+					Distance = std::min(Distance, Vector3::Distance(Viewpoint, Tracked.Position));
+				}
+			}
+		}
+		else
+		{
+			auto Found = NearbyObjects.find(i);
+			float MaxObjectDistance = Object->NetRelevancyDistance * (Spawned ? DESPAWN_DISTANCE_FACTOR : 1);
+			Relevant = Found != NearbyObjects.end() && Found->second <= MaxObjectDistance;
+			if (Relevant)
+			{
+				Distance = Found->second;
+			}
+		}
+
+		if (!Relevant)
+		{
+			if (Spawned)
+			{
+				DestroyOnClient(Client, Object);
+			}
+			continue;
+		}
+
+		if (!Spawned)
+		{
+			SpawnOnClient(Client, Object);
+		}
+
+		float& Priority = State.Priorities[Object->NetID];
+		Priority += Object->NetPriority * (1 + Tracked.Speed * SPEED_PRIORITY) / (1 + Distance / std::max(GridCellSize, 1.0f));
+		RelevantObjects.push_back({ Object, Priority });
+	}
+
+	std::sort(RelevantObjects.begin(), RelevantObjects.end(), [](const auto& a, const auto& b)
+		{
+			return a.second > b.second;
+		});
+
+	std::vector<SceneObject*> SortedObjects;
+	SortedObjects.reserve(RelevantObjects.size());
+	for (auto& i : RelevantObjects)
+	{
+		SortedObjects.push_back(i.first);
+	}
+
+	// Less is sent to clients that have been losing packets, so the connection isn't congested further.
+	size_t Budget = ClientBudget > 0 ? (size_t)(ClientBudget * Networking::GetConnections().GetSendScale(Client->IP)) : SIZE_MAX;
+	size_t NumSent = Replication::SendObjects(SortedObjects, Client->IP, Client->ID, Budget);
+	for (size_t i = 0; i < NumSent; i++)
+	{
+		State.Priorities[SortedObjects[i]->NetID] = 0;
+	}
+}
+
+bool Relevancy::IsAlwaysRelevant(SceneObject* Object, uint64_t ClientID)
+{
+	return Object->NetRelevancyDistance <= 0 || Object->NetOwner == ClientID;
+}
+
+bool Relevancy::IsSpawnedOnClient(uint64_t ClientID, uint64_t NetID)
+{
+	auto Found = ClientStates.find(ClientID);
+	return Found != ClientStates.end() && Found->second.SpawnedObjects.contains(NetID);
+}
+
+void Relevancy::SetSpawnedOnClient(uint64_t ClientID, uint64_t NetID)
+{
+	ClientStates[ClientID].SpawnedObjects.insert(NetID);
+}
+
+void Relevancy::RemoveObject(uint64_t NetID)
+{
+	for (auto& [ID, State] : ClientStates)
+	{
+		State.SpawnedObjects.erase(NetID);
+		State.Priorities.erase(NetID);
+	}
+	LastPositions.erase(NetID);
+}
+
+void Relevancy::RemoveClient(uint64_t ClientID)
+{
+	ClientStates.erase(ClientID);
+}
+#endif
@@ -0,0 +1,45 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include "Server.h"
+
+class SceneObject;
+
+/**
+* @brief
+* Decides which replicated objects the server sends to each client, and in which order.
+*
+* An object is relevant to a client if the client owns it, if its SceneObject::NetRelevancyDistance is 0 or less,
+* or if it is closer than NetRelevancyDistance to any object the client owns.
+* Objects that become relevant to a client are spawned on that client, objects that stop being relevant are destroyed on it.
+*
+* Relevant objects are sent in the order of a priority value that grows each tick the object isn't sent.
+* It grows faster for objects that are close to the client, moving fast or have a high SceneObject::NetPriority.
+* Objects that don't fit into the bandwidth budget of a client are sent in a later tick.
+*/
+namespace Relevancy
+{
+	/// The size of the grid cells used to find objects near clients. Also the distance at which the priority of an object halves.
+	extern float GridCellSize;
+	/// The maximum number of bytes of object state sent to each client per tick. 0 means there is no limit.
+	extern int ClientBudget;
+
+	/// Updates the positions of all replicated objects. Called once per tick before sending objects to clients.
+	void Update();
+
+	/// Spawns and destroys objects on the given client as they become relevant or irrelevant, then sends the state of relevant objects.
+	void SendObjects(Server::ClientInfo* Client);
+
+	/// True if Object is relevant to the client with the given ID regardless of its position.
+	bool IsAlwaysRelevant(SceneObject* Object, uint64_t ClientID);
+	/// True if the object with the given NetID has been spawned on the client with the given ID.
+	bool IsSpawnedOnClient(uint64_t ClientID, uint64_t NetID);
+	/// Marks the object with the given NetID as spawned on the client with the given ID.
+	void SetSpawnedOnClient(uint64_t ClientID, uint64_t NetID);
+
+	/// Forgets the object with the given NetID. Called when it is destroyed.
+	void RemoveObject(uint64_t NetID);
+	/// Forgets which objects have been spawned on the given client. Called when it disconnects or loads a new scene.
+	void RemoveClient(uint64_t ClientID);
+}
+#endif
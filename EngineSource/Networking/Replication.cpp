@@ -0,0 +1,1208 @@
+#if !EDITOR
+#include "Replication.h"
+#include "BitStream.h"
+#include "Networking.h"
+#include "Client.h"
+#include "Server.h"
+#include "Connection.h"
+#include "Interpolation.h"
+#include "PacketLayout.h"
+#include <Engine/Log.h>
+#include <Engine/Application.h>
+#include <Engine/Utility/StringUtility.h>
+#include <unordered_map>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace Replication
+{
+	bool UseBinarySnapshots = true;
+
+	using PacketLayout::POSITION_PRECISION;
+	using PacketLayout::POSITION_BITS;
+	using PacketLayout::ROTATION_PRECISION;
+	using PacketLayout::ROTATION_BITS;
+	using PacketLayout::SCALE_PRECISION;
+	using PacketLayout::SCALE_BITS;
+
+	static_assert(PacketLayout::SERVER_OWNER == Networking::ServerID, "Objects owned by the server must be written with SERVER_OWNER.");
+
+	// The number of ticks the state of an object is kept for, so it can be used as a baseline.
+	constexpr uint64_t HISTORY_TICKS = 32;
+	// Every object is sent without a baseline once every KEYFRAME_INTERVAL ticks, so clients recover from any errors.
+	constexpr uint64_t KEYFRAME_INTERVAL = 256;
+
+	// The number of bits available for the content of a snapshot packet.
+	// The connection header written by Packet::Send() and the packet type are subtracted.
+	static size_t GetSnapshotCapacity()
+	{
+		return PacketLayout::SNAPSHOT_CAPACITY;
+	}
+
+	/**
+	* The state of a replicated object as the receiver sees it.
+	*
+	* Transform values are already quantized, so a state can be compared with a state that has been received.
+	*/
+	struct ObjectState
+	{
+		bool HasTransform = false;
+		uint64_t Owner = Networking::ServerID;
+		Transform ObjectTransform;
+		/// From the server to the owner: The last correction of the transform. From the owner: The last correction it applied.
+		uint32_t Correction = 0;
+
+		struct PropertyValue
+		{
+			bool Sent = false;
+			/// The bytes of the value, or the string for string properties.
+			std::string Value;
+
+			bool operator==(const PropertyValue& Other) const
+			{
+				return Sent == Other.Sent && Value == Other.Value;
+			}
+		};
+
+		/// One value for every net property of the object, in the order of SceneObject::Properties.
+		std::vector<PropertyValue> Properties;
+
+		bool operator==(const ObjectState& Other) const
+		{
+			return HasTransform == Other.HasTransform
+				&& (!HasTransform || (Owner == Other.Owner && ObjectTransform == Other.ObjectTransform && Correction == Other.Correction))
+				&& Properties == Other.Properties;
+		}
+	};
+
+	static const ObjectState EmptyState;
+
+	/// Replication state the server keeps for each client.
+	struct ClientState
+	{
+		struct Baseline
+		{
+			uint64_t Tick = 0;
+			ObjectState State;
+		};
+
+		struct SentPacket
+		{
+			uint64_t Tick = 0;
+			std::vector<std::pair<uint64_t, ObjectState>> Objects;
+		};
+
+		/// The most recent state of each object (by NetID) the client has acknowledged.
+		std::unordered_map<uint64_t, Baseline> Baselines;
+		/// Sent snapshot packets that haven't been acknowledged yet, by sequence number.
+		std::unordered_map<uint32_t, SentPacket> SentPackets;
+		uint32_t NextSequence = 0;
+	};
+
+	static std::unordered_map<uint64_t, ClientState> ClientStates;
+
+	/// The states of an object received in the last HISTORY_TICKS ticks.
+	struct ReceivedObject
+	{
+		ReceivedObject()
+		{
+			History.fill({ UINT64_MAX, ObjectState() });
+		}
+
+		uint64_t LatestTick = 0;
+		std::array<std::pair<uint64_t, ObjectState>, HISTORY_TICKS> History;
+	};
+
+	static std::unordered_map<uint64_t, ReceivedObject> ReceivedObjects;
+
+	struct Acknowledgement
+	{
+		uint32_t Sequence = 0;
+		/// Objects in the packet that couldn't be read.
+		std::vector<uint64_t> FailedObjects;
+	};
+
+	static std::vector<Acknowledgement> PendingAcknowledgements;
+
+	/**
+	* State the server keeps for objects owned by a client.
+	*
+	* Clients simulate the objects they own and send their transform to the server. If the server changes the transform
+	* of such an object itself, it sends the transform to the owner with a new correction number. The owner applies it
+	* and sends the number back with its own transforms, so the server can ignore transforms from before the correction.
+	*/
+	struct OwnedObject
+	{
+		uint64_t Owner = Networking::ServerID;
+		/// The last transform received from the owner.
+		Transform ReceivedTransform;
+		bool HasReceived = false;
+		uint32_t SentCorrection = 0;
+		/// The last correction the owner has applied.
+		uint32_t AppliedCorrection = 0;
+	};
+
+	/// Objects owned by clients, by NetID. Only used by the server.
+	static std::unordered_map<uint64_t, OwnedObject> OwnedObjects;
+	/// The last correction applied to each object owned by this client, by NetID. Only used by clients.
+	static std::unordered_map<uint64_t, uint32_t> AppliedCorrections;
+
+	static bool IsPropertyTypeSupported(NativeType::NativeType Type)
+	{
+		switch (Type)
+		{
+		case NativeType::Int:
+		case NativeType::Float:
+		case NativeType::Vector3:
+		case NativeType::Vector3Color:
+		case NativeType::Vector3Rotation:
+		case NativeType::Bool:
+		case NativeType::Byte:
+		case NativeType::String:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	static size_t GetPropertySize(NativeType::NativeType Type)
+	{
+		switch (Type)
+		{
+		case NativeType::Int:
+			return sizeof(int);
+		case NativeType::Float:
+			return sizeof(float);
+		case NativeType::Vector3:
+		case NativeType::Vector3Color:
+		case NativeType::Vector3Rotation:
+			return sizeof(float) * 3;
+		case NativeType::Bool:
+			return sizeof(bool);
+		case NativeType::Byte:
+			return sizeof(uint8_t);
+		default:
+			return 0;
+		}
+	}
+
+	static std::string GetPropertyValue(const SceneObject::Property& Prop)
+	{
+		if (Prop.NativeType == NativeType::String)
+		{
+			return *(std::string*)Prop.Data;
+		}
+		return std::string((const char*)Prop.Data, GetPropertySize(Prop.NativeType));
+	}
+
+	static void SetPropertyValue(SceneObject::Property& Prop, const std::string& Value)
+	{
+		if (Prop.NativeType == NativeType::String)
+		{
+			*(std::string*)Prop.Data = Value;
+		}
+		else if (Value.size() == GetPropertySize(Prop.NativeType))
+		{
+			std::memcpy(Prop.Data, Value.data(), Value.size());
+		}
+	}
+
+	static void WritePropertyValue(BitWriter& Writer, NativeType::NativeType Type, const std::string& Value)
+	{
+		switch (Type)
+		{
+		case NativeType::Int:
+		{
+			int IntValue;
+			std::memcpy(&IntValue, Value.data(), sizeof(IntValue));
+			Writer.WriteVarInt(IntValue);
+			break;
+		}
+		case NativeType::Float:
+		case NativeType::Vector3:
+		case NativeType::Vector3Color:
+		case NativeType::Vector3Rotation:
+			for (size_t i = 0; i < Value.size(); i += sizeof(float))
+			{
+				float FloatValue;
+				std::memcpy(&FloatValue, Value.data() + i, sizeof(FloatValue));
+				Writer.WriteFloat(FloatValue);
+			}
+			break;
+		case NativeType::Bool:
+			Writer.WriteBool(Value[0]);
+			break;
+		case NativeType::Byte:
+			Writer.WriteBits((uint8_t)Value[0], 8);
+			break;
+		case NativeType::String:
+			Writer.WriteString(Value);
+			break;
+		default:
+			break;
+		}
+	}
+
+	static std::string ReadPropertyValue(BitReader& Reader, NativeType::NativeType Type)
+	{
+		std::string Value;
+		switch (Type)
+		{
+		case NativeType::Int:
+		{
+			int IntValue = (int)Reader.ReadVarInt();
+			Value.assign((const char*)&IntValue, sizeof(IntValue));
+			break;
+		}
+		case NativeType::Float:
+		case NativeType::Vector3:
+		case NativeType::Vector3Color:
+		case NativeType::Vector3Rotation:
+			for (size_t i = 0; i < GetPropertySize(Type); i += sizeof(float))
+			{
+				float FloatValue = Reader.ReadFloat();
+				Value.append((const char*)&FloatValue, sizeof(FloatValue));
+			}
+			break;
+		case NativeType::Bool:
+		{
+			bool BoolValue = Reader.ReadBool();
+			Value.assign((const char*)&BoolValue, sizeof(BoolValue));
+			break;
+		}
+		case NativeType::Byte:
+			Value.push_back((char)Reader.ReadBits(8));
+			break;
+		case NativeType::String:
+			Value = Reader.ReadString();
+			break;
+		default:
+			break;
+		}
+		return Value;
+	}
+
+	/// Returns the value the receiver reads after Value is written with BitWriter::WriteQuantized().
+	static float Quantize(float Value, float Precision, uint8_t NumBits)
+	{
+		const float Limit = (float)(1u << (NumBits - 1));
+		float Scaled = std::round(Value / Precision);
+		if (Scaled >= -Limit && Scaled < Limit)
+		{
+			return (float)(int32_t)Scaled * Precision;
+		}
+		return Value;
+	}
+
+	static Transform QuantizeTransform(const Transform& In)
+	{
+		Transform Out;
+		Out.Position = Vector3(
+			Quantize(In.Position.X, POSITION_PRECISION, POSITION_BITS),
+			Quantize(In.Position.Y, POSITION_PRECISION, POSITION_BITS),
+			Quantize(In.Position.Z, POSITION_PRECISION, POSITION_BITS));
+		Out.Rotation = Vector3(
+			Quantize(std::remainder(In.Rotation.X, 6.2831853f), ROTATION_PRECISION, ROTATION_BITS),
+			Quantize(std::remainder(In.Rotation.Y, 6.2831853f), ROTATION_PRECISION, ROTATION_BITS),
+			Quantize(std::remainder(In.Rotation.Z, 6.2831853f), ROTATION_PRECISION, ROTATION_BITS));
+		Out.Scale = Vector3(
+			Quantize(In.Scale.X, SCALE_PRECISION, SCALE_BITS),
+			Quantize(In.Scale.Y, SCALE_PRECISION, SCALE_BITS),
+			Quantize(In.Scale.Z, SCALE_PRECISION, SCALE_BITS));
+		return Out;
+	}
+
+	/// True if the server has moved an object owned by TargetClient, and the owner hasn't applied the correction yet.
+	static bool NeedsCorrection(SceneObject* Object, uint64_t TargetClient)
+	{
+		if (Client::GetClientID() != Networking::ServerID || Object->NetOwner != TargetClient)
+		{
+			return false;
+		}
+		auto Found = OwnedObjects.find(Object->NetID);
+		if (Found == OwnedObjects.end() || !Found->second.HasReceived)
+		{
+			return false;
+		}
+
+		OwnedObject& Owned = Found->second;
+		if (Owned.AppliedCorrection == Owned.SentCorrection
+			&& !(QuantizeTransform(Object->GetTransform()) == Owned.ReceivedTransform))
+		{
+			Owned.SentCorrection++;
+		}
+		return Owned.AppliedCorrection != Owned.SentCorrection;
+	}
+
+	static ObjectState CaptureState(SceneObject* Object, uint64_t TargetClient)
+	{
+		ObjectState State;
+		State.HasTransform = ShouldSendTransform(Object, TargetClient) || NeedsCorrection(Object, TargetClient);
+		if (State.HasTransform)
+		{
+			State.Owner = Object->NetOwner;
+			State.ObjectTransform = QuantizeTransform(Object->GetTransform());
+#if SERVER
+			auto Found = OwnedObjects.find(Object->NetID);
+			if (TargetClient == Object->NetOwner && Found != OwnedObjects.end())
+			{
+				State.Correction = Found->second.SentCorrection;
+			}
+#else
+			auto Found = AppliedCorrections.find(Object->NetID);
+			if (Found != AppliedCorrections.end())
+			{
+				State.Correction = Found->second;
+			}
+#endif
+		}
+
+		for (const SceneObject::Property& i : Object->Properties)
+		{
+			if (i.PType != SceneObject::Property::PropertyType::NetProperty)
+			{
+				continue;
+			}
+			ObjectState::PropertyValue Value;
+			Value.Sent = IsPropertyTypeSupported(i.NativeType) && ShouldSendProperty(Object, i, TargetClient);
+			if (Value.Sent)
+			{
+				Value.Value = GetPropertyValue(i);
+			}
+			State.Properties.push_back(std::move(Value));
+		}
+		return State;
+	}
+
+	static bool HasContent(const ObjectState& State)
+	{
+		if (State.HasTransform)
+		{
+			return true;
+		}
+		for (const auto& i : State.Properties)
+		{
+			if (i.Sent)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void ApplyTransform(SceneObject* Object, const ObjectState& State, [[maybe_unused]] uint64_t SentTime)
+	{
+#if SERVER
+		OwnedObject& Owned = OwnedObjects[Object->NetID];
+		if (Owned.Owner != Object->NetOwner)
+		{
+			Owned = OwnedObject();
+			Owned.Owner = Object->NetOwner;
+		}
+		Owned.AppliedCorrection = State.Correction;
+		// The transform was sent before the owner applied the latest correction.
+		if (State.Correction != Owned.SentCorrection)
+		{
+			return;
+		}
+		Owned.ReceivedTransform = State.ObjectTransform;
+		Owned.HasReceived = true;
+		Object->NetOwner = State.Owner;
+		Object->GetTransform() = State.ObjectTransform;
+#else
+		Object->NetOwner = State.Owner;
+		if (Object->NetOwner == Client::GetClientID())
+		{
+			// The server only sends the transform of owned objects to correct them. Corrections might be sent multiple times.
+			uint32_t& Applied = AppliedCorrections[Object->NetID];
+			if (State.Correction != Applied)
+			{
+				Applied = State.Correction;
+				Object->GetTransform() = State.ObjectTransform;
+			}
+		}
+		else if (Interpolation::ShouldInterpolate(Object))
+		{
+			Interpolation::AddSnapshot(Object, SentTime, State.ObjectTransform);
+		}
+		else
+		{
+			Object->GetTransform() = State.ObjectTransform;
+		}
+#endif
+	}
+
+	static void ApplyState(SceneObject* Object, const ObjectState& State, uint64_t SentTime)
+	{
+		if (State.HasTransform)
+		{
+			ApplyTransform(Object, State, SentTime);
+		}
+
+		size_t PropertyIndex = 0;
+		for (SceneObject::Property& i : Object->Properties)
+		{
+			if (i.PType != SceneObject::Property::PropertyType::NetProperty)
+			{
+				continue;
+			}
+			if (PropertyIndex < State.Properties.size() && State.Properties[PropertyIndex].Sent)
+			{
+				SetPropertyValue(i, State.Properties[PropertyIndex].Value);
+			}
+			PropertyIndex++;
+		}
+	}
+
+	static void WriteVector3Delta(BitWriter& Writer, Vector3 Value, Vector3 Baseline, float Precision, uint8_t NumBits)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			bool Changed = Value[i] != Baseline[i];
+			Writer.WriteBool(Changed);
+			if (Changed)
+			{
+				Writer.WriteQuantized(Value[i], Precision, NumBits);
+			}
+		}
+	}
+
+	static Vector3 ReadVector3Delta(BitReader& Reader, Vector3 Baseline, float Precision, uint8_t NumBits)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (Reader.ReadBool())
+			{
+				Baseline[i] = Reader.ReadQuantized(Precision, NumBits);
+			}
+		}
+		return Baseline;
+	}
+
+	/**
+	* Writes the difference between State and Baseline. Writing with EmptyState as the baseline writes the full state.
+	*
+	* Layout:
+	* - Transform flag. If set: if the baseline has a transform, the owner, the correction and each transform component
+	*   are written with a flag that is set if they changed. Otherwise, a PacketLayout::FullTransform is written.
+	* - For each net property: A flag that is set if it changed. If set, a flag that is set if the property is sent,
+	*   followed by the value. Missing flags at the end of the object are read as unchanged.
+	*/
+	static void WriteState(BitWriter& Writer, const ObjectState& State, const ObjectState& Baseline, SceneObject* Object)
+	{
+		Writer.WriteBool(State.HasTransform);
+		if (State.HasTransform && Baseline.HasTransform)
+		{
+			Writer.WriteBool(State.Owner != Baseline.Owner);
+			if (State.Owner != Baseline.Owner)
+			{
+				Writer.WriteVarUInt(State.Owner);
+			}
+			Writer.WriteBool(State.Correction != Baseline.Correction);
+			if (State.Correction != Baseline.Correction)
+			{
+				Writer.WriteVarUInt(State.Correction);
+			}
+			WriteVector3Delta(Writer, State.ObjectTransform.Position, Baseline.ObjectTransform.Position, POSITION_PRECISION, POSITION_BITS);
+			WriteVector3Delta(Writer, State.ObjectTransform.Rotation, Baseline.ObjectTransform.Rotation, ROTATION_PRECISION, ROTATION_BITS);
+			WriteVector3Delta(Writer, State.ObjectTransform.Scale, Baseline.ObjectTransform.Scale, SCALE_PRECISION, SCALE_BITS);
+		}
+		else if (State.HasTransform)
+		{
+			Transform t = State.ObjectTransform;
+			PacketLayout::FullTransform Full;
+			Full.Owner = State.Owner;
+			Full.Correction = State.Correction;
+			for (int i = 0; i < 3; i++)
+			{
+				Full.Position[i] = t.Position[i];
+				Full.Rotation[i] = t.Rotation[i];
+				Full.Scale[i] = t.Scale[i];
+			}
+			Full.Write(Writer);
+		}
+
+		size_t PropertyIndex = 0;
+		for (const SceneObject::Property& i : Object->Properties)
+		{
+			if (i.PType != SceneObject::Property::PropertyType::NetProperty)
+			{
+				continue;
+			}
+			const ObjectState::PropertyValue& Value = State.Properties[PropertyIndex];
+			bool Changed = PropertyIndex >= Baseline.Properties.size() || !(Baseline.Properties[PropertyIndex] == Value);
+			Writer.WriteBool(Changed);
+			if (Changed)
+			{
+				Writer.WriteBool(Value.Sent);
+				if (Value.Sent)
+				{
+					WritePropertyValue(Writer, i.NativeType, Value.Value);
+				}
+			}
+			PropertyIndex++;
+		}
+	}
+
+	static ObjectState ReadState(BitReader& Reader, const ObjectState& Baseline, SceneObject* Object, size_t ObjectEnd)
+	{
+		ObjectState State;
+		State.HasTransform = Reader.ReadBool();
+		if (State.HasTransform && Baseline.HasTransform)
+		{
+			State.Owner = Baseline.Owner;
+			if (Reader.ReadBool())
+			{
+				State.Owner = Reader.ReadVarUInt();
+			}
+			State.Correction = Baseline.Correction;
+			if (Reader.ReadBool())
+			{
+				State.Correction = (uint32_t)Reader.ReadVarUInt();
+			}
+			State.ObjectTransform.Position = ReadVector3Delta(Reader, Baseline.ObjectTransform.Position, POSITION_PRECISION, POSITION_BITS);
+			State.ObjectTransform.Rotation = ReadVector3Delta(Reader, Baseline.ObjectTransform.Rotation, ROTATION_PRECISION, ROTATION_BITS);
+			State.ObjectTransform.Scale = ReadVector3Delta(Reader, Baseline.ObjectTransform.Scale, SCALE_PRECISION, SCALE_BITS);
+		}
+		else if (State.HasTransform)
+		{
+			PacketLayout::FullTransform Full = PacketLayout::FullTransform::Read(Reader);
+			State.Owner = Full.Owner;
+			State.Correction = Full.Correction;
+			Transform& t = State.ObjectTransform;
+			for (int i = 0; i < 3; i++)
+			{
+				t.Position[i] = Full.Position[i];
+				t.Rotation[i] = Full.Rotation[i];
+				t.Scale[i] = Full.Scale[i];
+			}
+		}
+
+		size_t PropertyIndex = 0;
+		for (const SceneObject::Property& i : Object->Properties)
+		{
+			if (i.PType != SceneObject::Property::PropertyType::NetProperty)
+			{
+				continue;
+			}
+			ObjectState::PropertyValue Value;
+			if (PropertyIndex < Baseline.Properties.size())
+			{
+				Value = Baseline.Properties[PropertyIndex];
+			}
+			// Flags missing at the end of the object mean that the property hasn't changed, see PacketLayout::FullTransform.
+			if (Reader.GetPosition() < ObjectEnd && Reader.ReadBool())
+			{
+				Value.Sent = Reader.ReadBool();
+				Value.Value = Value.Sent ? ReadPropertyValue(Reader, i.NativeType) : "";
+			}
+			State.Properties.push_back(std::move(Value));
+			PropertyIndex++;
+		}
+		return State;
+	}
+
+	static Packet MakeSnapshotPacket(const BitWriter& Content)
+	{
+		Packet p;
+		p.Data.reserve(Content.GetData().size() + 1);
+		p.Write((uint8_t)Packet::PacketType::Snapshot);
+		p.Data.insert(p.Data.end(), Content.GetData().begin(), Content.GetData().end());
+		return p;
+	}
+
+	static void ForgetOldPackets(ClientState& Client, uint64_t Tick)
+	{
+		for (auto i = Client.SentPackets.begin(); i != Client.SentPackets.end();)
+		{
+			if (Tick - i->second.Tick >= HISTORY_TICKS)
+			{
+				i = Client.SentPackets.erase(i);
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	/**
+	* Packet layout: PacketLayout::SnapshotHeader, then a list of objects.
+	* Each object is prefixed with its size, so objects the receiver can't read can be skipped.
+	* Object layout: NetID, the number of ticks since the baseline (0 for no baseline), state (see WriteState()).
+	*
+	* Stops before the packets get larger than MaxBytes. NumHandled is set to the number of objects
+	* from the start of Objects that have been written or didn't need to be written.
+	*/
+	static std::vector<Packet> WriteSnapshotsAt(const std::vector<SceneObject*>& Objects,
+		uint64_t TargetClient,
+		ClientState* Client,
+		uint64_t Tick,
+		size_t MaxBytes,
+		size_t& NumHandled)
+	{
+		// The connection header and the packet type.
+		constexpr size_t PACKET_OVERHEAD = Connection::HEADER_SIZE + 1;
+
+		std::vector<Packet> Packets;
+		size_t PacketBytes = 0;
+		NumHandled = 0;
+		BitWriter Content;
+		BitWriter ObjectData;
+		BitWriter ObjectHeader;
+		ClientState::SentPacket CurrentPacket;
+		CurrentPacket.Tick = Tick;
+
+		if (Client)
+		{
+			ForgetOldPackets(*Client, Tick);
+		}
+
+		auto StartPacket = [&]()
+			{
+				Content = BitWriter();
+				PacketLayout::SnapshotHeader Header;
+				Header.Sequence = Client ? Client->NextSequence : 0;
+				Header.Tick = Tick;
+				Header.Time = Networking::GetGameTime();
+				Header.Write(Content);
+			};
+
+		auto FinishPacket = [&]()
+			{
+				Packets.push_back(MakeSnapshotPacket(Content));
+				PacketBytes += Packets.back().Data.size() + Connection::HEADER_SIZE;
+				if (Client)
+				{
+					Client->SentPackets[Client->NextSequence++] = std::move(CurrentPacket);
+					CurrentPacket = ClientState::SentPacket();
+					CurrentPacket.Tick = Tick;
+				}
+			};
+
+		StartPacket();
+		const size_t HeaderBits = Content.GetNumBits();
+
+		for (; NumHandled < Objects.size(); NumHandled++)
+		{
+			SceneObject* i = Objects[NumHandled];
+			if (!i->GetIsReplicated())
+			{
+				continue;
+			}
+
+			ObjectState State = CaptureState(i, TargetClient);
+			if (!HasContent(State))
+			{
+				continue;
+			}
+
+			const ObjectState* Baseline = &EmptyState;
+			uint64_t BaselineAge = 0;
+			if (Client)
+			{
+				auto Found = Client->Baselines.find(i->NetID);
+				bool Keyframe = (Tick + i->NetID) % KEYFRAME_INTERVAL == 0;
+				if (Found != Client->Baselines.end() && !Keyframe
+					&& Found->second.Tick < Tick && Tick - Found->second.Tick < HISTORY_TICKS)
+				{
+					Baseline = &Found->second.State;
+					BaselineAge = Tick - Found->second.Tick;
+					// Unchanged objects are only sent to keep the baseline from getting too old.
+					if (State == *Baseline && BaselineAge < HISTORY_TICKS / 2)
+					{
+						continue;
+					}
+				}
+			}
+
+			ObjectData = BitWriter();
+			PacketLayout::WriteObjectStart(ObjectData, i->NetID, BaselineAge);
+			WriteState(ObjectData, State, *Baseline, i);
+
+			ObjectHeader = BitWriter();
+			PacketLayout::WriteObjectSize(ObjectHeader, ObjectData.GetNumBits());
+			size_t ObjectBits = ObjectHeader.GetNumBits() + ObjectData.GetNumBits();
+
+			if (ObjectBits + HeaderBits > GetSnapshotCapacity())
+			{
+				auto TextPackets = WriteTextUpdates(i, TargetClient);
+				size_t TextBytes = 0;
+				for (const Packet& p : TextPackets)
+				{
+					TextBytes += p.Data.size() + Connection::HEADER_SIZE;
+				}
+				if (NumHandled > 0 && PacketBytes + TextBytes > MaxBytes)
+				{
+					break;
+				}
+				PacketBytes += TextBytes;
+				Packets.insert(Packets.end(), TextPackets.begin(), TextPackets.end());
+				continue;
+			}
+
+			bool NewPacket = Content.GetNumBits() + ObjectBits > GetSnapshotCapacity();
+			size_t TotalBytes = PacketBytes + PACKET_OVERHEAD
+				+ (NewPacket ? (Content.GetNumBits() + 7) / 8 + PACKET_OVERHEAD + (HeaderBits + ObjectBits + 7) / 8 : (Content.GetNumBits() + ObjectBits + 7) / 8);
+			// Always write at least one object, so one large object can't block all others.
+			if (NumHandled > 0 && TotalBytes > MaxBytes)
+			{
+				break;
+			}
+
+			if (NewPacket)
+			{
+				FinishPacket();
+				StartPacket();
+			}
+			Content.Append(ObjectHeader);
+			Content.Append(ObjectData);
+			if (Client)
+			{
+				CurrentPacket.Objects.push_back({ i->NetID, std::move(State) });
+			}
+		}
+
+		if (Content.GetNumBits() > HeaderBits)
+		{
+			FinishPacket();
+		}
+		return Packets;
+	}
+
+	static void Acknowledge(ClientState& Client, const Acknowledgement& Ack)
+	{
+		auto Found = Client.SentPackets.find(Ack.Sequence);
+		if (Found == Client.SentPackets.end())
+		{
+			return;
+		}
+
+		ClientState::SentPacket& Sent = Found->second;
+		for (auto& [NetID, State] : Sent.Objects)
+		{
+			if (std::find(Ack.FailedObjects.begin(), Ack.FailedObjects.end(), NetID) != Ack.FailedObjects.end())
+			{
+				// The client doesn't have a usable baseline for this object anymore.
+				Client.Baselines.erase(NetID);
+				continue;
+			}
+
+			ClientState::Baseline& Baseline = Client.Baselines[NetID];
+			if (Baseline.Tick < Sent.Tick)
+			{
+				Baseline.Tick = Sent.Tick;
+				Baseline.State = std::move(State);
+			}
+		}
+		Client.SentPackets.erase(Found);
+	}
+}
+
+bool Replication::ShouldSendTransform(SceneObject* Object, uint64_t TargetClient)
+{
+	if (Client::GetClientID() == Object->NetOwner)
+	{
+		return true;
+	}
+	return Client::GetClientID() == Networking::ServerID && TargetClient != Object->NetOwner;
+}
+
+bool Replication::ShouldSendProperty(SceneObject* Object, const SceneObject::Property& Prop, [[maybe_unused]] uint64_t TargetClient)
+{
+#if SERVER
+	return Prop.PropertyOwner == SceneObject::Property::NetOwner::Server || Object->NetOwner != TargetClient;
+#else
+	return Prop.PropertyOwner == SceneObject::Property::NetOwner::Client && Object->NetOwner == Client::GetClientID();
+#endif
+}
+
+std::vector<Packet> Replication::WriteTextUpdates(SceneObject* Object, uint64_t TargetClient)
+{
+	std::vector<Packet> Packets;
+	if (!Object->GetIsReplicated())
+	{
+		return Packets;
+	}
+
+	if (ShouldSendTransform(Object, TargetClient))
+	{
+		Packet p;
+		p.Data =
+		{
+			(uint8_t)Packet::PacketType::ValueUpdate,
+		};
+
+		p.Write(Object->NetID);
+		p.AppendStringToData("_pos=" + Object->GetTransform().Position.ToString());
+		p.AppendStringToData(";_rot=" + Object->GetTransform().Rotation.ToString());
+		p.AppendStringToData(";_scl=" + Object->GetTransform().Scale.ToString());
+		p.AppendStringToData(";_owner=" + std::to_string(Object->NetOwner));
+		Packets.push_back(std::move(p));
+	}
+	else if (Client::GetClientID() != Networking::ServerID)
+	{
+		return Packets;
+	}
+
+	Packet Properties;
+	for (auto& i : Object->Properties)
+	{
+		if (i.PType != SceneObject::Property::PropertyType::NetProperty)
+		{
+			continue;
+		}
+		if (ShouldSendProperty(Object, i, TargetClient))
+		{
+			if (Properties.Data.empty())
+			{
+				Properties.Data =
+				{
+					(uint8_t)Packet::PacketType::ValueUpdate,
+				};
+
+				Properties.Write(Object->NetID);
+			}
+
+			Properties.AppendStringToData(i.Name + "=" + i.ValueToString(Object) + ";");
+		}
+	}
+	if (!Properties.Data.empty())
+	{
+		Packets.push_back(std::move(Properties));
+	}
+	return Packets;
+}
+
+std::vector<Packet> Replication::WriteSnapshots(const std::vector<SceneObject*>& Objects, uint64_t TargetClient, bool Delta)
+{
+	size_t NumHandled = 0;
+	return WriteSnapshotsAt(Objects, TargetClient, Delta ? &ClientStates[TargetClient] : nullptr, Networking::GetGameTick(), SIZE_MAX, NumHandled);
+}
+
+size_t Replication::SendObjects(const std::vector<SceneObject*>& Objects, void* TargetAddr, uint64_t TargetClient, size_t MaxBytes)
+{
+	if (UseBinarySnapshots)
+	{
+		// Clients always send their full state, only the server keeps track of baselines.
+		bool Delta = Client::GetClientID() == Networking::ServerID;
+		size_t NumHandled = 0;
+		auto Packets = WriteSnapshotsAt(Objects,
+			TargetClient,
+			Delta ? &ClientStates[TargetClient] : nullptr,
+			Networking::GetGameTick(),
+			MaxBytes,
+			NumHandled);
+		for (Packet& p : Packets)
+		{
+			p.Send(TargetAddr);
+		}
+		return NumHandled;
+	}
+
+	size_t SentBytes = 0;
+	for (size_t i = 0; i < Objects.size(); i++)
+	{
+		auto Packets = WriteTextUpdates(Objects[i], TargetClient);
+		size_t ObjectBytes = 0;
+		for (const Packet& p : Packets)
+		{
+			ObjectBytes += p.Data.size() + Connection::HEADER_SIZE;
+		}
+		if (i > 0 && SentBytes + ObjectBytes > MaxBytes)
+		{
+			return i;
+		}
+		SentBytes += ObjectBytes;
+		for (Packet& p : Packets)
+		{
+			// Text updates contain the full state, so older updates arriving late can be dropped.
+			p.SendSequenced(TargetAddr);
+		}
+	}
+	return Objects.size();
+}
+
+void Replication::ReadSnapshot(Packet* p)
+{
+	if (p->Data.size() < 2)
+	{
+		return;
+	}
+
+	BitReader Reader = BitReader(p->Data.data() + 1, p->Data.size() - 1);
+	PacketLayout::SnapshotHeader Header = PacketLayout::SnapshotHeader::Read(Reader);
+	Acknowledgement Ack;
+	Ack.Sequence = Header.Sequence;
+
+	// The last byte might contain up to 7 bits of padding. Every object takes at least 8 bits.
+	while (Reader.GetRemainingBits() >= 8)
+	{
+		uint64_t ObjectBits = Reader.ReadVarUInt();
+		if (Reader.HasError() || ObjectBits > Reader.GetRemainingBits())
+		{
+			return;
+		}
+		size_t ObjectEnd = Reader.GetPosition() + ObjectBits;
+
+		uint64_t NetID = Reader.ReadVarUInt();
+		uint64_t BaselineAge = Reader.ReadVarUInt();
+		SceneObject* Object = Networking::GetObjectFromNetID(NetID);
+
+		const ObjectState* Baseline = &EmptyState;
+#if SERVER
+		if (Object && BaselineAge != 0)
+		{
+			Baseline = nullptr;
+		}
+#else
+		ReceivedObject* Received = nullptr;
+		if (Object)
+		{
+			Received = &ReceivedObjects[NetID];
+			if (BaselineAge != 0)
+			{
+				uint64_t BaselineTick = Header.Tick - BaselineAge;
+				auto& Entry = Received->History[BaselineTick % HISTORY_TICKS];
+				Baseline = Entry.first == BaselineTick && BaselineAge < HISTORY_TICKS ? &Entry.second : nullptr;
+			}
+		}
+		else
+		{
+			ReceivedObjects.erase(NetID);
+		}
+#endif
+
+		if (Object && Baseline)
+		{
+			ObjectState State = ReadState(Reader, *Baseline, Object, ObjectEnd);
+			if (Reader.HasError() || Reader.GetPosition() > ObjectEnd)
+			{
+				Log::Print("[Net]: Received a snapshot with invalid object data", Log::LogColor::Yellow);
+				return;
+			}
+#if SERVER
+			// Clients always send full snapshots using their own tick, so there's nothing to keep.
+			ApplyState(Object, State, Header.Time);
+#else
+			// Snapshots might arrive out of order. Older states are kept, since they might be used as a baseline.
+			if (Header.Tick >= Received->LatestTick)
+			{
+				Received->LatestTick = Header.Tick;
+				ApplyState(Object, State, Header.Time);
+			}
+			Received->History[Header.Tick % HISTORY_TICKS] = { Header.Tick, std::move(State) };
+#endif
+		}
+		else
+		{
+			Ack.FailedObjects.push_back(NetID);
+		}
+
+		if (Reader.GetPosition() > ObjectEnd)
+		{
+			return;
+		}
+		Reader.Skip(ObjectEnd - Reader.GetPosition());
+	}
+
+#if !SERVER
+	PendingAcknowledgements.push_back(std::move(Ack));
+#endif
+}
+
+void Replication::SendAcknowledgements(void* TargetAddr)
+{
+	if (PendingAcknowledgements.empty())
+	{
+		return;
+	}
+
+	BitWriter Content;
+	BitWriter AckData;
+	size_t NumAcks = 0;
+	for (const Acknowledgement& i : PendingAcknowledgements)
+	{
+		AckData = BitWriter();
+		AckData.WriteVarUInt(i.Sequence);
+		AckData.WriteVarUInt(i.FailedObjects.size());
+		for (uint64_t NetID : i.FailedObjects)
+		{
+			AckData.WriteVarUInt(NetID);
+		}
+		// Acknowledgements that don't fit are dropped. The server then keeps using older baselines.
+		if (Content.GetNumBits() + AckData.GetNumBits() > GetSnapshotCapacity())
+		{
+			break;
+		}
+		Content.Append(AckData);
+		NumAcks++;
+	}
+	PendingAcknowledgements.clear();
+
+	Packet p;
+	p.Write((uint8_t)Packet::PacketType::SnapshotAck);
+	BitWriter Header;
+	Header.WriteVarUInt(NumAcks);
+	Header.Append(Content);
+	p.Data.insert(p.Data.end(), Header.GetData().begin(), Header.GetData().end());
+	p.Send(TargetAddr);
+}
+
+void Replication::ReadAcknowledgements(Packet* p, uint64_t FromClient)
+{
+	auto Client = ClientStates.find(FromClient);
+	if (Client == ClientStates.end() || p->Data.size() < 2)
+	{
+		return;
+	}
+
+	BitReader Reader = BitReader(p->Data.data() + 1, p->Data.size() - 1);
+	uint64_t NumAcks = Reader.ReadVarUInt();
+	for (uint64_t i = 0; i < NumAcks && !Reader.HasError(); i++)
+	{
+		Acknowledgement Ack;
+		Ack.Sequence = (uint32_t)Reader.ReadVarUInt();
+		uint64_t NumFailed = Reader.ReadVarUInt();
+		for (uint64_t j = 0; j < NumFailed && !Reader.HasError(); j++)
+		{
+			Ack.FailedObjects.push_back(Reader.ReadVarUInt());
+		}
+		if (!Reader.HasError())
+		{
+			Acknowledge(Client->second, Ack);
+		}
+	}
+}
+
+void Replication::RemoveClient(uint64_t ClientID)
+{
+	ClientStates.erase(ClientID);
+}
+
+void Replication::RemoveObjectForClient(uint64_t ClientID, uint64_t NetID)
+{
+	auto Found = ClientStates.find(ClientID);
+	if (Found != ClientStates.end())
+	{
+		Found->second.Baselines.erase(NetID);
+	}
+}
+
+void Replication::RemoveObject(uint64_t NetID)
+{
+	for (auto& [ID, Client] : ClientStates)
+	{
+		Client.Baselines.erase(NetID);
+	}
+	ReceivedObjects.erase(NetID);
+	OwnedObjects.erase(NetID);
+	AppliedCorrections.erase(NetID);
+}
+
+void Replication::Reset()
+{
+	ClientStates.clear();
+	ReceivedObjects.clear();
+	PendingAcknowledgements.clear();
+	OwnedObjects.clear();
+	AppliedCorrections.clear();
+}
+
+void Replication::RunBenchmark(size_t NumObjects)
+{
+	constexpr size_t NUM_ITERATIONS = 100;
+	// A client ID no client has. All objects are owned by someone else, so their full state is written.
+	constexpr uint64_t BENCHMARK_CLIENT = Networking::ServerID - 1;
+
+	std::vector<SceneObject*> ReplicatedObjects;
+	for (SceneObject* i : Objects::AllObjects)
+	{
+		if (i->GetIsReplicated())
+		{
+			ReplicatedObjects.push_back(i);
+		}
+	}
+	if (ReplicatedObjects.empty())
+	{
+		Log::Print("[Net]: The replication benchmark needs at least one replicated object in the scene.", Log::LogColor::Yellow);
+		return;
+	}
+
+	std::vector<SceneObject*> BenchmarkObjects;
+	BenchmarkObjects.reserve(NumObjects);
+	for (size_t i = 0; i < NumObjects; i++)
+	{
+		BenchmarkObjects.push_back(ReplicatedObjects[i % ReplicatedObjects.size()]);
+	}
+
+	struct Result
+	{
+		size_t Bytes = 0;
+		size_t Packets = 0;
+		float Time = 0;
+
+		void Add(const std::vector<Packet>& Packets)
+		{
+			for (const Packet& p : Packets)
+			{
+				Bytes += p.Data.size() + Connection::HEADER_SIZE;
+				this->Packets++;
+			}
+		}
+	};
+
+	Result TextResult, BinaryResult, DeltaResult;
+
+	Application::Timer BenchmarkTimer;
+	for (size_t Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++)
+	{
+		for (SceneObject* i : BenchmarkObjects)
+		{
+			TextResult.Add(WriteTextUpdates(i, BENCHMARK_CLIENT));
+		}
+	}
+	TextResult.Time = BenchmarkTimer.Get();
+
+	BenchmarkTimer.Reset();
+	for (size_t Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++)
+	{
+		BinaryResult.Add(WriteSnapshots(BenchmarkObjects, BENCHMARK_CLIENT, false));
+	}
+	BinaryResult.Time = BenchmarkTimer.Get();
+
+	// Simulates a client that acknowledges every packet right away, while nothing in the scene changes.
+	ClientState DeltaClient;
+	BenchmarkTimer.Reset();
+	for (size_t Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++)
+	{
+		uint32_t FirstSequence = DeltaClient.NextSequence;
+		size_t NumHandled = 0;
+		DeltaResult.Add(WriteSnapshotsAt(BenchmarkObjects, BENCHMARK_CLIENT, &DeltaClient, Networking::GetGameTick() + Iteration, SIZE_MAX, NumHandled));
+		for (uint32_t Sequence = FirstSequence; Sequence < DeltaClient.NextSequence; Sequence++)
+		{
+			Acknowledge(DeltaClient, Acknowledgement{ .Sequence = Sequence, .FailedObjects = {} });
+		}
+	}
+	DeltaResult.Time = BenchmarkTimer.Get();
+
+	auto FormatResult = [](std::string Name, const Result& r)
+		{
+			return StrUtil::Format("%s: %i bytes/tick in %i packets/tick, %fms/tick",
+				Name.c_str(),
+				int(r.Bytes / NUM_ITERATIONS),
+				int(r.Packets / NUM_ITERATIONS),
+				1000.0f * r.Time / NUM_ITERATIONS);
+		};
+
+	Log::PrintMultiLine(StrUtil::Format("Replication benchmark, %i objects:\n\t%s\n\t%s\n\t%s",
+		int(NumObjects),
+		FormatResult("Text", TextResult).c_str(),
+		FormatResult("Binary", BinaryResult).c_str(),
+		FormatResult("Binary, delta to acknowledged state (static scene)", DeltaResult).c_str()),
+		Log::LogColor::White,
+		"[Net]: ");
+}
+#endif
@@ -0,0 +1,102 @@
+#if !EDITOR
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Packet.h"
+#include <Objects/SceneObject.h>
+
+/**
+* @brief
+* Functions for sending the transforms and net properties of replicated objects.
+*
+* The state of objects can be sent in two formats:
+* - Binary snapshots (Packet::PacketType::Snapshot). The state of many objects is packed into one packet.
+*   Positions, rotations and scales are quantized and net properties are encoded by their NativeType.
+*   Both sides read the net properties of an object in the order they were added, so property names aren't sent.
+* - Text value updates (Packet::PacketType::ValueUpdate). Each object is sent as one or two packets
+*   containing "name=value;" pairs.
+*
+* Both formats can always be received. UseBinarySnapshots selects the format that is sent.
+*
+* The server sends snapshots to each client as deltas. For each object, it keeps the last state the client
+* has acknowledged (Packet::PacketType::SnapshotAck) and only sends the values that changed since then.
+* Unchanged objects are skipped until their baseline gets old, and every object is regularly sent in full,
+* so a client that lost its baseline recovers without a round trip.
+*
+* Clients simulate the objects they own and send their transforms to the server, the server doesn't send them back.
+* If the server moves such an object itself, it sends a correction to the owner and ignores the owner's transforms
+* until the owner confirms it has applied the correction.
+*
+* Transforms of objects owned by someone else are smoothed on the client, see Interpolation.
+*/
+namespace Replication
+{
+	/// If true, object state is sent as binary snapshots. Otherwise, text value updates are sent.
+	extern bool UseBinarySnapshots;
+
+	/// True if the transform of Object should be sent to TargetClient.
+	bool ShouldSendTransform(SceneObject* Object, uint64_t TargetClient);
+	/// True if the net property Prop of Object should be sent to TargetClient.
+	bool ShouldSendProperty(SceneObject* Object, const SceneObject::Property& Prop, uint64_t TargetClient);
+
+	/// Creates text value update packets for the given object.
+	std::vector<Packet> WriteTextUpdates(SceneObject* Object, uint64_t TargetClient);
+
+	/**
+	* @brief
+	* Creates snapshot packets for the given objects.
+	*
+	* As many objects as possible are packed into each packet, without exceeding Packet::MAX_PACKET_SIZE.
+	* Objects that are too large for a single snapshot packet are sent as text value updates instead.
+	*
+	* @param Delta
+	* If true, objects are written as deltas to the state TargetClient has acknowledged, and the
+	* written packets are remembered until they are acknowledged. Only used by the server.
+	*/
+	std::vector<Packet> WriteSnapshots(const std::vector<SceneObject*>& Objects, uint64_t TargetClient, bool Delta = false);
+
+	/**
+	* @brief
+	* Sends the state of the given objects to a client or the server.
+	*
+	* @param TargetAddr
+	* The IP address to send the packets to.
+	*
+	* @param TargetClient
+	* The ID of the client the packets are sent to, or Networking::ServerID.
+	*
+	* @param MaxBytes
+	* The maximum number of bytes to send. The first object is always sent.
+	*
+	* @return
+	* The number of objects from the start of Objects that have been sent or didn't need to be sent.
+	* The remaining objects didn't fit into MaxBytes.
+	*/
+	size_t SendObjects(const std::vector<SceneObject*>& Objects, void* TargetAddr, uint64_t TargetClient, size_t MaxBytes = SIZE_MAX);
+
+	/// Applies a received snapshot packet to the objects in the scene.
+	void ReadSnapshot(Packet* p);
+
+	/// Acknowledges all snapshot packets received since the last call. Called by the client.
+	void SendAcknowledgements(void* TargetAddr);
+	/// Reads a snapshot acknowledgement packet sent by the client with the ID FromClient.
+	void ReadAcknowledgements(Packet* p, uint64_t FromClient);
+
+	/// Forgets all baselines of the given client.
+	void RemoveClient(uint64_t ClientID);
+	/// Forgets all baselines of the object with the given NetID.
+	void RemoveObject(uint64_t NetID);
+	/// Forgets the baseline of the object with the given NetID for one client, so it is sent in full next time.
+	void RemoveObjectForClient(uint64_t ClientID, uint64_t NetID);
+	/// Forgets all baselines. Called when disconnecting or changing the scene.
+	void Reset();
+
+	/**
+	* @brief
+	* Compares the size and CPU time of both formats by writing the state of NumObjects objects, without sending anything.
+	*
+	* The replicated objects in the current scene are used, repeated until there are NumObjects objects.
+	*/
+	void RunBenchmark(size_t NumObjects);
+}
+#endif
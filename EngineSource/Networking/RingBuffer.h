@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <algorithm>
+
+/**
+* @brief
+* A fixed size queue for passing items from one producer thread to one consumer thread without locks.
+*
+* Items are never constructed or destroyed by the queue. The producer fills slots returned by GetWritable()
+* and publishes them with Commit(), the consumer reads slots returned by GetReadable() and frees them with Release().
+* Both functions return contiguous ranges, so a full or empty range might need two calls when the queue wraps around.
+*/
+template<typename T, size_t Capacity>
+class SPSCRingBuffer
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "The capacity of a ring buffer must be a power of two.");
+
+public:
+	/// Producer: Sets First to the first free slot and returns the number of free slots following it.
+	size_t GetWritable(T*& First)
+	{
+		size_t Write = WriteIndex.load(std::memory_order_relaxed);
+		size_t Read = ReadIndex.load(std::memory_order_acquire);
+		size_t Offset = Write % Capacity;
+		First = &Items[Offset];
+		return std::min(Capacity - (Write - Read), Capacity - Offset);
+	}
+
+	/// Producer: Makes the next Count slots returned by GetWritable() available to the consumer.
+	void Commit(size_t Count)
+	{
+		WriteIndex.store(WriteIndex.load(std::memory_order_relaxed) + Count, std::memory_order_release);
+	}
+
+	/// Consumer: Sets First to the oldest item and returns the number of items following it.
+	size_t GetReadable(T*& First)
+	{
+		size_t Read = ReadIndex.load(std::memory_order_relaxed);
+		size_t Write = WriteIndex.load(std::memory_order_acquire);
+		size_t Offset = Read % Capacity;
+		First = &Items[Offset];
+		return std::min(Write - Read, Capacity - Offset);
+	}
+
+	/// Consumer: Frees the next Count slots returned by GetReadable(), so the producer can reuse them.
+	void Release(size_t Count)
+	{
+		ReadIndex.store(ReadIndex.load(std::memory_order_relaxed) + Count, std::memory_order_release);
+	}
+
+private:
+	// Both indices only ever grow. They are on separate cache lines, so the threads don't invalidate each other's cache.
+	alignas(64) std::atomic<size_t> WriteIndex = 0;
+	alignas(64) std::atomic<size_t> ReadIndex = 0;
+	alignas(64) std::array<T, Capacity> Items;
+};
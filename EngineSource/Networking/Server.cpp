@@ -36,14 +36,23 @@ void Server::ClearOnPlayerDisconnectedCallbacks()
 #include <Engine/Subsystem/Scene.h>
 #include <Engine/Utility/FileUtility.h>
 #include "NetworkEvent.h"
+#include "Replication.h"
+#include "Relevancy.h"
+#include "Connection.h"
 #include <Engine/Stats.h>
+#include <unordered_map>
 
 namespace Server
 {
 	bool ShouldQuitOnPlayerDisconnect = false;
 	static std::vector<ClientInfo> Clients;
+	// Indices into Clients, by client ID and by IP address. Rebuilt whenever a client connects or disconnects.
+	static std::unordered_map<uint64_t, size_t> ClientIndexFromID;
+	static std::unordered_map<uint64_t, size_t> ClientIndexFromIP;
 	static uint64_t UIDCounter = 0;
 	static bool LoadingNewScene = false;
+	/// The tick rate last sent to all clients. 0 if it needs to be sent again.
+	static uint32_t SentTickRate = 0;
 	namespace TPS
 	{
 		static bool PrintTPS = false;
@@ -67,6 +76,23 @@ namespace Server
 
 	static ClientInfo* ServerClient = new ClientInfo();
 
+	static uint64_t GetIPKey(void* IP)
+	{
+		IPaddress* Address = (IPaddress*)IP;
+		return ((uint64_t)Address->host << 16) | Address->port;
+	}
+
+	static void UpdateClientIndices()
+	{
+		ClientIndexFromID.clear();
+		ClientIndexFromIP.clear();
+		for (size_t i = 0; i < Clients.size(); i++)
+		{
+			ClientIndexFromID[Clients[i].ID] = i;
+			ClientIndexFromIP[GetIPKey(Clients[i].IP)] = i;
+		}
+	}
+
 	void ClientInfo::SendClientSpawnRequest(int32_t ObjID, uint64_t NetID, uint64_t NetOwner, Transform SpawnTransform, std::string ObjProperties) const
 	{
 		Packet p;
@@ -76,13 +102,15 @@ namespace Server
 		p.Write(NetOwner);
 		p.Write(SpawnTransform);
 		p.AppendStringToData(ObjProperties);
-		p.Send(IP);
+		p.SendReliable(IP);
 
 	}
 	void ClientInfo::SendServerTravelRequest(std::string SceneName)
 	{
 		LoadedInScene = false;
-		NetworkEvent::TriggerNetworkEvent("__scene", { SceneName }, nullptr, ID);
+		std::vector<uint8_t> Arguments;
+		NetworkEvent::ArgumentWriter(Arguments).Write(SceneName);
+		NetworkEvent::TriggerNetworkEvent(NetworkEvent::SCENE_EVENT, Arguments, nullptr, ID);
 	}
 
 	static void HandleClientDisconnect(ClientInfo* Client)
@@ -91,15 +119,20 @@ namespace Server
 		{
 			i(Client->ID);
 		}
+		Replication::RemoveClient(Client->ID);
+		Relevancy::RemoveClient(Client->ID);
+		Networking::GetConnections().Remove(Client->IP);
 
+		uint64_t ClientID = Client->ID;
 		for (size_t i = 0; i < Clients.size(); i++)
 		{
-			if (Clients[i].ID == Client->ID)
+			if (Clients[i].ID == ClientID)
 			{
 				Clients.erase(Clients.begin() + i);
 			}
 		}
-		NetworkEvent::ClearEventsFor(Client->ID);
+		UpdateClientIndices();
+		NetworkEvent::ClearEventsFor(ClientID);
 
 		if (ShouldQuitOnPlayerDisconnect && Clients.empty())
 		{
@@ -111,6 +144,11 @@ namespace Server
 void Server::OnConnectRequestReceived(Packet p)
 {
 	auto Info = GetClientInfoFromIP(p.FromAddr);
+	if (!Info)
+	{
+		// A new client starts with fresh sequence numbers and reliable message IDs.
+		Networking::GetConnections().Remove(p.FromAddr);
+	}
 
 	Packet ReturnPacket;
 	ReturnPacket.Data =
@@ -144,6 +182,9 @@ void Server::OnConnectRequestReceived(Packet p)
 	}
 	UIDCounter++;
 	Clients.push_back(NewClient);
+	UpdateClientIndices();
+	// Sends the tick rate to all clients in the next tick, including the new one.
+	SentTickRate = 0;
 	Log::PrintMultiLine(StrUtil::Format("Client connected to server:\n\tip: %s\n\tuid: %s",
 		Networking::IPtoStr(NewClient.IP).c_str(),
 		std::to_string(NewClient.ID).c_str()
@@ -193,12 +234,15 @@ void Server::DisconnectPlayer(uint64_t UID)
 
 void Server::SpawnObject(int32_t ObjID, uint64_t NetID, Transform SpawnTransform, std::string ObjProperties)
 {
+	SceneObject* Object = Networking::GetObjectFromNetID(NetID);
 	for (auto& i : Clients)
 	{
 		// The client will receive a list of all replicated objects once it finishes loading into the scene.
-		if (i.LoadedInScene)
+		// Objects with a relevancy distance are spawned by Relevancy::SendObjects() once they are close enough.
+		if (i.LoadedInScene && (!Object || Relevancy::IsAlwaysRelevant(Object, i.ID)))
 		{
 			i.SendClientSpawnRequest(ObjID, NetID, Networking::ServerID, SpawnTransform, ObjProperties);
+			Relevancy::SetSpawnedOnClient(i.ID, NetID);
 		}
 	}
 }
@@ -207,8 +251,13 @@ void Server::HandleDestroyObject(SceneObject* o)
 {
 	for (auto& i : Server::Clients)
 	{
-		NetworkEvent::TriggerNetworkEvent("__destr", {}, o, i.ID);
+		if (Relevancy::IsSpawnedOnClient(i.ID, o->NetID))
+		{
+			NetworkEvent::TriggerNetworkEvent(NetworkEvent::DESTROY_EVENT, {}, o, i.ID);
+		}
 	}
+	Replication::RemoveObject(o->NetID);
+	Relevancy::RemoveObject(o->NetID);
 }
 
 void Server::SetObjNetOwner(SceneObject* obj, uint64_t NetOwner)
@@ -225,9 +274,10 @@ void Server::SetObjNetOwner(SceneObject* obj, uint64_t NetOwner)
 	p.AppendStringToData("_owner=" + std::to_string(NetOwner));
 	for (auto& i : Clients)
 	{
-		if (i.LoadedInScene)
+		// Clients that don't have the object receive the new owner when it is spawned on them.
+		if (i.LoadedInScene && Relevancy::IsSpawnedOnClient(i.ID, obj->NetID))
 		{
-			p.Send(i.IP);
+			p.SendReliable(i.IP);
 		}
 	}
 	obj->NetOwner = NetOwner;
@@ -255,6 +305,27 @@ void Server::Init()
 		TPS::PrintTickStats();
 		}, { }));
 
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_relevancy_cell_size", NativeType::Float, &Relevancy::GridCellSize, nullptr));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("net_client_budget", NativeType::Int, &Relevancy::ClientBudget, nullptr));
+
+	Console::ConsoleSystem->RegisterCommand(Console::Command("replication_benchmark", []() {
+		size_t NumObjects = 1000;
+		if (Console::ConsoleSystem->CommandArgs().size() > 0)
+		{
+			NumObjects = std::stoul(Console::ConsoleSystem->CommandArgs()[0]);
+		}
+		Replication::RunBenchmark(NumObjects);
+		}, { Console::Command::Argument("num_objects", NativeType::Int, true) }));
+
+	Console::ConsoleSystem->RegisterCommand(Console::Command("netid_lookup_test", []() {
+		size_t NumObjects = 10000;
+		if (Console::ConsoleSystem->CommandArgs().size() > 0)
+		{
+			NumObjects = std::stoul(Console::ConsoleSystem->CommandArgs()[0]);
+		}
+		Networking::RunObjectLookupTest(NumObjects);
+		}, { Console::Command::Argument("num_objects", NativeType::Int, true) }));
+
 	Console::ConsoleSystem->RegisterCommand(Console::Command("serverperf", []() {
 		TPS::PrintTPS = !TPS::PrintTPS;
 		if (TPS::PrintTPS)
@@ -268,6 +339,7 @@ void Server::ChangeScene(std::string NewSceneName)
 {
 	Log::Print(StrUtil::Format("[Net]: Server: Changing active scene to '%s'", NewSceneName.c_str()));
 	Scene::LoadNewScene(NewSceneName);
+	Replication::Reset();
 	for (auto& i : Clients)
 	{
 		i.SendServerTravelRequest(NewSceneName);
@@ -297,6 +369,19 @@ void Server::Update()
 		}
 	}
 
+	if (!Clients.empty() && SentTickRate != Networking::GetTickRate())
+	{
+		SentTickRate = Networking::GetTickRate();
+		Packet p;
+		p.Write((uint8_t)Packet::PacketType::TickRate);
+		p.Write(SentTickRate);
+		for (auto& i : Clients)
+		{
+			p.SendReliable(i.IP);
+		}
+	}
+
+	Relevancy::Update();
 	for (size_t i = 0; i < Clients.size(); i++)
 	{
 		SendClientInfo(&Clients[i]);
@@ -330,34 +415,27 @@ void Server::HandlePacket(Packet* p)
 
 void Server::SendClientInfo(ClientInfo* c)
 {
-	for (SceneObject* i : Objects::AllObjects)
-	{
-		Networking::SendObjectInfo(i, c->IP);
-	}
+	Relevancy::SendObjects(c);
 }
 
 Server::ClientInfo* Server::GetClientInfoFromIP(void* IP)
 {
-	for (auto& i : Clients)
+	auto Found = ClientIndexFromIP.find(GetIPKey(IP));
+	if (Found == ClientIndexFromIP.end())
 	{
-		if (Networking::IPEqual(i.IP, IP))
-		{
-			return &i;
-		}
+		return nullptr;
 	}
-	return nullptr;
+	return &Clients[Found->second];
 }
 
 Server::ClientInfo* Server::GetClientInfoFromID(uint64_t ID)
 {
-	for (auto& i : Clients)
+	auto Found = ClientIndexFromID.find(ID);
+	if (Found == ClientIndexFromID.end())
 	{
-		if (i.ID == ID)
-		{
-			return &i;
-		}
+		return nullptr;
 	}
-	return nullptr;
+	return &Clients[Found->second];
 }
 
 const std::vector<Server::ClientInfo>& Server::GetClients()
@@ -380,12 +458,15 @@ void Server::OnClientAcceptSceneChange(uint64_t ClientID)
 	}
 
 	Client->LoadedInScene = true;
+	Replication::RemoveClient(ClientID);
+	Relevancy::RemoveClient(ClientID);
 
 	for (SceneObject* i : Objects::AllObjects)
 	{
-		if (i->GetIsReplicated())
+		if (i->GetIsReplicated() && Relevancy::IsAlwaysRelevant(i, ClientID))
 		{
 			Client->SendClientSpawnRequest(i->GetObjectDescription().ID, i->NetID, i->NetOwner, i->GetTransform(), i->GetPropertiesAsString());
+			Relevancy::SetSpawnedOnClient(ClientID, i->NetID);
 		}
 	}
 
@@ -49,14 +49,14 @@ void MeshComponent::Update()
 	}
 #endif
 }
-void MeshComponent::Load(std::string File)
+void MeshComponent::Load(std::string File, const std::vector<std::string>& Materials)
 {
 #if !SERVER
 	if (MeshModel)
 	{
 		Destroy();
 	}
-	MeshModel = new Model(Assets::GetAsset(File + ".jsm"));
+	MeshModel = new Model(Assets::GetAsset(File + ".jsm"), Materials);
 	Graphics::MainFramebuffer->Renderables.push_back(MeshModel);
 	MeshModel->UpdateTransform();
 #endif
@@ -94,7 +94,7 @@ void MeshComponent::SetUniform(std::string Name, NativeType::NativeType NativeTy
 const ModelGenerator::ModelData& MeshComponent::GetModelData()
 {
 #if !SERVER
-	return MeshModel->ModelMeshData;
+	return MeshModel->GetModelData();
 #else
 	return FallbackModelData;
 #endif
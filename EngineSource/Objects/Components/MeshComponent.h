@@ -24,8 +24,11 @@ public:
 	*
 	* @param File
 	* The file to load.
+	*
+	* @param Materials
+	* Materials used instead of the ones in the file, one for each element of the mesh. Empty names use the material from the file.
 	*/
-	void Load(std::string File);
+	void Load(std::string File, const std::vector<std::string>& Materials = {});
 
 	/**
 	* @brief
@@ -26,21 +26,16 @@ void MeshObject::LoadFromFile(std::string Filename)
 		Detach(Mesh);
 	if (MeshCollision)
 		Detach(MeshCollision);
-	ModelGenerator::ModelData m;
-	m.LoadModelFromFile(Filename);
-	for (size_t i = 0; i < m.Elements.size(); i++)
-	{
-		if (i >= MaterialNames.size() || MaterialNames.at(i) == "")
-		{
-			continue;
-		}
-		m.Elements.at(i).ElemMaterial = MaterialNames.at(i);
-	}
-
+	// Loading the mesh by its file name shares it with all other objects using the same file,
+	// so it can be drawn with them in a single draw call.
 	Mesh = new MeshComponent();
-	Mesh->Load(m);
+	Mesh->Load(Filename, MaterialNames);
 #if !SERVER
 	Mesh->GetModel()->CastShadow = Mesh->GetModel()->CastShadow && MeshCastShadow;
+	const ModelGenerator::ModelData& m = Mesh->GetModelData();
+#else
+	ModelGenerator::ModelData m;
+	m.LoadModelFromFile(Filename);
 #endif
 	Attach(Mesh);
 	this->Filename = Filename;
@@ -57,10 +52,13 @@ void MeshObject::LoadFromFile(std::string Filename)
 	}
 
 #if !SERVER
-	MaterialNames.resize(Mesh->GetModel()->ModelMeshData.Elements.size());
-	for (size_t i = 0; i < Mesh->GetModel()->ModelMeshData.Elements.size(); i++)
+	MaterialNames.resize(m.Elements.size());
+	for (size_t i = 0; i < m.Elements.size(); i++)
 	{
-		MaterialNames[i] = Mesh->GetModel()->ModelMeshData.Elements[i].ElemMaterial;
+		if (MaterialNames[i].empty())
+		{
+			MaterialNames[i] = m.Elements[i].ElemMaterial;
+		}
 	}
 #endif
 }
@@ -41,6 +41,31 @@ void SceneObject::CallEventInternal(NetEvent::NetEventFunction Function, std::ve
 	Log::Print("[Net]: Could not invoke Event", Log::LogColor::Yellow);
 }
 
+void SceneObject::RegisterNetEvent(NetEvent Event)
+{
+	for (const auto& i : NetEvents)
+	{
+		if (i.Hash == Event.Hash)
+		{
+			Log::Print("[Net]: Events " + i.Name + " and " + Event.Name + " have the same hash. Rename one of them.", Log::LogColor::Red);
+		}
+	}
+	NetEvents.push_back(std::move(Event));
+}
+
+const SceneObject::NetEvent* SceneObject::FindEvent(const void* Key) const
+{
+	for (const auto& i : NetEvents)
+	{
+		if (i.Key == Key)
+		{
+			return &i;
+		}
+	}
+	Log::Print("[Net]: Could not invoke Event", Log::LogColor::Yellow);
+	return nullptr;
+}
+
 SceneObject::SceneObject(ObjectDescription _d)
 {
 	TypeName = _d.Name;
@@ -61,6 +86,10 @@ SceneObject* SceneObject::Start(std::string ObjectName, Transform Transform, uin
 		Name = ObjectName;
 		CurrentScene = Scene::CurrentScene;
 		Objects::AllObjects.push_back(this);
+		if (GetIsReplicated())
+		{
+			Networking::AddReplicatedObject(this);
+		}
 		SetTransform(Transform);
 		Begin();
 	}
@@ -343,7 +372,7 @@ void SceneObject::DestroyMarkedObjects(bool SendNetworkEvents)
 			if (Client::GetClientID() == o->NetOwner || Client::GetClientID() == Networking::ServerID)
 			{
 #if !SERVER
-				NetworkEvent::TriggerNetworkEvent("__destr", {}, o, Networking::ServerID);
+				NetworkEvent::TriggerNetworkEvent(NetworkEvent::DESTROY_EVENT, {}, o, Networking::ServerID);
 #else
 				Server::HandleDestroyObject(o);
 #endif
@@ -358,6 +387,7 @@ void SceneObject::DestroyMarkedObjects(bool SendNetworkEvents)
 				break;
 			}
 		}
+		Networking::RemoveReplicatedObject(o);
 
 		o->Destroy();
 		for (Component* LoopComponent : o->GetComponents())
@@ -466,12 +496,28 @@ std::string SceneObject::Property::ValueToString(SceneObject* Context)
 }
 
 void SceneObject::NetEvent::Invoke(std::vector<std::string> Arguments) const
+{
+	std::vector<uint8_t>& Buffer = GetArgumentBuffer();
+	Buffer.clear();
+	NetworkEvent::ArgumentWriter(Buffer).Write(Arguments);
+	if (!Send(Buffer))
+	{
+		(Parent->*Function)(Arguments);
+	}
+}
+
+std::vector<uint8_t>& SceneObject::NetEvent::GetArgumentBuffer()
+{
+	static std::vector<uint8_t> Buffer;
+	return Buffer;
+}
+
+bool SceneObject::NetEvent::Send(const std::vector<uint8_t>& Arguments) const
 {
 #if !EDITOR
 	if (!Client::GetIsConnected())
 	{
-		(Parent->*Function)(Arguments);
-		return;
+		return false;
 	}
 
 	switch (NativeType)
@@ -479,7 +525,7 @@ void SceneObject::NetEvent::Invoke(std::vector<std::string> Arguments) const
 	case SceneObject::NetEvent::EventType::Server:
 		if (Client::GetClientID() == Parent->NetOwner)
 		{
-			NetworkEvent::TriggerNetworkEvent(Name, Arguments, Parent, Networking::ServerID);
+			NetworkEvent::TriggerNetworkEvent(Hash, Arguments, Parent, Networking::ServerID);
 		}
 		else
 		{
@@ -492,7 +538,7 @@ void SceneObject::NetEvent::Invoke(std::vector<std::string> Arguments) const
 	case SceneObject::NetEvent::EventType::Owner:
 		if (Client::GetClientID() == Networking::ServerID)
 		{
-			NetworkEvent::TriggerNetworkEvent(Name, Arguments, Parent, Parent->NetOwner);
+			NetworkEvent::TriggerNetworkEvent(Hash, Arguments, Parent, Parent->NetOwner);
 		}
 		else
 		{
@@ -507,7 +553,7 @@ void SceneObject::NetEvent::Invoke(std::vector<std::string> Arguments) const
 		{
 			for (const auto& i : Server::GetClients())
 			{
-				NetworkEvent::TriggerNetworkEvent(Name, Arguments, Parent, i.ID);
+				NetworkEvent::TriggerNetworkEvent(Hash, Arguments, Parent, i.ID);
 			}
 		}
 		else
@@ -522,4 +568,5 @@ void SceneObject::NetEvent::Invoke(std::vector<std::string> Arguments) const
 		break;
 	}
 #endif
+	return true;
 }
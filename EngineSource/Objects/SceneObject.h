@@ -1,6 +1,7 @@
 #pragma once
 #include "Math/Vector.h"
 #include <Engine/TypeEnun.h>
+#include <Networking/EventArguments.h>
 #include <set>
 
 class EditorUI;
@@ -29,14 +30,11 @@ class Component;
 * 
 * @brief
 * Registers a SceneObject::NetEvent. Should only be used in a SceneObject.
+*
+* The function can take a std::vector<std::string>, or any number of typed arguments, see SceneObject::CallEvent().
 */
 #define REGISTER_EVENT(InFunction, InType) do {\
-NetEvent e;\
-e.Name = # InFunction;\
-e.Function = static_cast<NetEvent::NetEventFunction>(& InFunction);\
-e.Parent = this;\
-e.NativeType = InType;\
-this->NetEvents.push_back(e);\
+this->RegisterNetEvent(NetEvent::Create<& InFunction>(# InFunction, this, InType));\
 } while (0)
 
 /**
@@ -88,13 +86,33 @@ public:
 		 */
 		std::string Name;
 		typedef void(SceneObject::* NetEventFunction)(std::vector<std::string> Arguments);
+		/// Reads the arguments of the event and calls its function. Returns false if the arguments don't match the function.
+		typedef bool(*HandlerFunction)(SceneObject* Object, NetworkEvent::ArgumentReader& Arguments);
 
 		/**
 		 * @brief
-		 * Function pointer to the function corresponding to the event.
+		 * Function pointer to the function corresponding to the event, if it takes a std::vector<std::string>.
 		 */
 		NetEventFunction Function = nullptr;
 
+		/**
+		 * @brief
+		 * Identifies the function of the event, see GetKey().
+		 */
+		const void* Key = nullptr;
+
+		/**
+		 * @brief
+		 * Identifies the event on the network, see NetworkEvent::GetEventHash(). Sent instead of the name.
+		 */
+		uint32_t Hash = 0;
+
+		/**
+		 * @brief
+		 * Calls the function of the event with received arguments.
+		 */
+		HandlerFunction Handler = nullptr;
+
 		/**
 		 * @brief
 		 * A pointer to the SceneObject owning this NetEvent.
@@ -118,6 +136,44 @@ public:
 		EventType NativeType = EventType::Server;
 		
 		void Invoke(std::vector<std::string> Arguments) const;
+
+		/**
+		 * @brief
+		 * Sends the event with serialized arguments to the server or clients.
+		 *
+		 * Returns false if not connected. The function should be called directly then.
+		 */
+		bool Send(const std::vector<uint8_t>& Arguments) const;
+
+		/// A buffer reused for serializing arguments, so calling events doesn't allocate.
+		static std::vector<uint8_t>& GetArgumentBuffer();
+
+		/// A unique value for each event function.
+		template<auto InFunction>
+		static const void* GetKey()
+		{
+			// Not const, so the linker can't merge the variables of different functions.
+			static char Key = 0;
+			return &Key;
+		}
+
+		/// Creates an event for InFunction. Used by REGISTER_EVENT.
+		template<auto InFunction>
+		static NetEvent Create(std::string Name, SceneObject* Parent, EventType NativeType)
+		{
+			NetEvent e;
+			e.Name = Name;
+			e.Key = GetKey<InFunction>();
+			e.Hash = NetworkEvent::GetEventHash(e.Name);
+			e.Handler = &NetworkEvent::CallWithArguments<InFunction>;
+			e.Parent = Parent;
+			e.NativeType = NativeType;
+			if constexpr (std::is_same_v<typename NetworkEvent::EventFunction<decltype(InFunction)>::Arguments, std::tuple<std::vector<std::string>>>)
+			{
+				e.Function = static_cast<NetEventFunction>(InFunction);
+			}
+			return e;
+		}
 	};
 
 	/// A property of the object.
@@ -219,6 +275,50 @@ public:
 		CallEventInternal(static_cast<NetEvent::NetEventFunction>(Function), Arguments);
 	}
 
+	/**
+	 * @brief
+	 * Calls the SceneObject::NetEvent that has the given function with typed arguments.
+	 *
+	 * The arguments are sent in binary instead of as strings. Supported are trivially copyable types (numbers, bool,
+	 * enums, Vector3, Transform...), std::string and std::string_view. A std::string_view argument points into the
+	 * received packet and is only valid during the call.
+	 *
+	 * @code
+	 * void MyObject::Shoot(Vector3 Direction, float Strength, std::string_view Weapon)
+	 * {
+	 * }
+	 *
+	 * void MyObject::Begin()
+	 * {
+	 *     REGISTER_EVENT(MyObject::Shoot, NetEvent::EventType::Server);
+	 * }
+	 *
+	 * void MyObject::Update()
+	 * {
+	 *     CallEvent<&MyObject::Shoot>(Vector3(0, 0, 1), 1, "Pistol");
+	 * }
+	 * @endcode
+	 */
+	template<auto Function, typename... Args>
+	void CallEvent(const Args&... Arguments)
+	{
+		using Event = NetworkEvent::EventFunction<decltype(Function)>;
+		const NetEvent* Found = FindEvent(NetEvent::GetKey<Function>());
+		if (!Found)
+		{
+			return;
+		}
+
+		std::vector<uint8_t>& Buffer = NetEvent::GetArgumentBuffer();
+		Buffer.clear();
+		NetworkEvent::ArgumentWriter Writer = NetworkEvent::ArgumentWriter(Buffer);
+		NetworkEvent::WriteArguments(Writer, (typename Event::Arguments*)nullptr, Arguments...);
+		if (!Found->Send(Buffer))
+		{
+			(static_cast<typename Event::ObjectType*>(this)->*Function)(Arguments...);
+		}
+	}
+
 
 	SceneObject(ObjectDescription Descr = ObjectDescription("Empty Object", 0));
 	virtual ~SceneObject();
@@ -308,10 +408,31 @@ public:
 	 * This can be set across all clients using the SetNetOwner() function.
 	 */
 	uint64_t NetOwner = UINT64_MAX;
+
+	/**
+	 * @brief
+	 * The distance from the objects owned by a client within which this object is replicated to that client.
+	 *
+	 * If this is 0 or less, the object is replicated to all clients. The object is always replicated to its owner.
+	 * Should be set in Begin() on the server.
+	 */
+	float NetRelevancyDistance = 0;
+
+	/**
+	 * @brief
+	 * How often the object is updated compared to other objects if not all objects fit into a client's bandwidth budget.
+	 */
+	float NetPriority = 1;
+
 	std::vector<Property> Properties;
 	std::vector<NetEvent> NetEvents;
+
+	/// Adds an event. Used by REGISTER_EVENT. Logs an error if another event of this object has the same hash.
+	void RegisterNetEvent(NetEvent Event);
 protected:
 	void CallEventInternal(NetEvent::NetEventFunction Function, std::vector<std::string> Arguments);
+	/// Finds the event with the given key. Logs a warning and returns nullptr if there is none.
+	const NetEvent* FindEvent(const void* Key) const;
 	std::string TypeName;
 	uint32_t TypeID = 0;
 	std::vector<Component*> Components;
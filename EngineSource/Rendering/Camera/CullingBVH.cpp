@@ -0,0 +1,460 @@
+#include "CullingBVH.h"
+#include <Rendering/Drawable.h>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define CULLING_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	constexpr uint32_t NUM_PLANES = 6;
+	constexpr uint32_t ALL_PLANES = (1 << NUM_PLANES) - 1;
+
+	struct FrustumPlanes
+	{
+		float NormalX[NUM_PLANES];
+		float NormalY[NUM_PLANES];
+		float NormalZ[NUM_PLANES];
+		float Distance[NUM_PLANES];
+
+		FrustumPlanes(const FrustumCulling::Frustum& f)
+		{
+			const FrustumCulling::Plan* Planes[NUM_PLANES] =
+			{
+				&f.nearFace, &f.leftFace, &f.rightFace, &f.topFace, &f.bottomFace, &f.farFace
+			};
+			for (uint32_t i = 0; i < NUM_PLANES; i++)
+			{
+				NormalX[i] = Planes[i]->normal.X;
+				NormalY[i] = Planes[i]->normal.Y;
+				NormalZ[i] = Planes[i]->normal.Z;
+				Distance[i] = Planes[i]->distance;
+			}
+		}
+	};
+
+	bool SameBounds(const FrustumCulling::AABB& a, const FrustumCulling::AABB& b)
+	{
+		return a.center == b.center && a.extents == b.extents;
+	}
+}
+
+void CullingBVH::Update(const std::vector<Drawable*>& NewDrawables)
+{
+	if (NewDrawables != Drawables)
+	{
+		Drawables = NewDrawables;
+		Build();
+		return;
+	}
+
+	// Refitting keeps the tree correct, but boxes of moving objects make it less efficient to traverse over time.
+	if (!Refit() || NumMovedItems > Items.size() / 4)
+	{
+		Build();
+	}
+}
+
+void CullingBVH::Build()
+{
+	// Drawables that are still in the tree keep how long they have been still, so rebuilding doesn't make them dynamic.
+	std::unordered_map<const Drawable*, uint32_t> PreviousItems;
+	size_t NumStaticBefore = 0;
+	for (uint32_t i = 0; i < Items.size(); i++)
+	{
+		PreviousItems.emplace(Items[i], i);
+		NumStaticBefore += IsStatic(i);
+	}
+
+	std::vector<Drawable*> AllItems;
+	std::vector<FrustumCulling::AABB> AllBounds;
+	std::vector<uint32_t> AllStillFrames;
+	std::vector<bool> AllShadowCasters;
+	size_t NumStaticAfter = 0;
+	Unbounded.clear();
+	for (Drawable* d : Drawables)
+	{
+		FrustumCulling::AABB Bounds;
+		if (d->GetWorldBounds(Bounds))
+		{
+			uint32_t StillFrames = 0;
+			bool ShadowCaster = d->IsShadowCaster();
+			auto Previous = PreviousItems.find(d);
+			if (Previous != PreviousItems.end()
+				&& SameBounds(ItemBounds[Previous->second], Bounds)
+				&& ItemShadowCasters[Previous->second] == ShadowCaster)
+			{
+				StillFrames = ItemStillFrames[Previous->second];
+			}
+			NumStaticAfter += StillFrames >= STATIC_FRAMES;
+			AllItems.push_back(d);
+			AllBounds.push_back(Bounds);
+			AllStillFrames.push_back(StillFrames);
+			AllShadowCasters.push_back(ShadowCaster);
+		}
+		else
+		{
+			Unbounded.push_back(d);
+		}
+	}
+
+	Nodes.clear();
+	Packets.clear();
+	NumMovedItems = 0;
+	ItemMoved.assign(AllItems.size(), false);
+	ItemMarks.assign(AllItems.size(), 0);
+	CurrentMark = 0;
+
+	// New items are never static, so the static items are the same if there are as many as before.
+	if (NumStaticAfter != NumStaticBefore)
+	{
+		StaticVersion++;
+	}
+
+	Items = std::move(AllItems);
+	ItemBounds = std::move(AllBounds);
+	ItemStillFrames = std::move(AllStillFrames);
+	ItemShadowCasters = std::move(AllShadowCasters);
+	if (Items.empty())
+	{
+		return;
+	}
+
+	BuildOrder.resize(Items.size());
+	for (uint32_t i = 0; i < BuildOrder.size(); i++)
+	{
+		BuildOrder[i] = i;
+	}
+
+	Nodes.reserve(Items.size() / PACKET_SIZE * 2 + 1);
+	Nodes.emplace_back();
+	BuildNode(0, 0, (uint32_t)Items.size());
+
+	// Sort the items in the order of the tree so every node's items are contiguous.
+	std::vector<Drawable*> SortedItems;
+	std::vector<FrustumCulling::AABB> SortedBounds;
+	std::vector<uint32_t> SortedStillFrames;
+	std::vector<bool> SortedShadowCasters;
+	SortedItems.reserve(Items.size());
+	SortedBounds.reserve(Items.size());
+	SortedStillFrames.reserve(Items.size());
+	for (uint32_t i : BuildOrder)
+	{
+		SortedItems.push_back(Items[i]);
+		SortedBounds.push_back(ItemBounds[i]);
+		SortedStillFrames.push_back(ItemStillFrames[i]);
+		SortedShadowCasters.push_back(ItemShadowCasters[i]);
+	}
+	Items = std::move(SortedItems);
+	ItemBounds = std::move(SortedBounds);
+	ItemStillFrames = std::move(SortedStillFrames);
+	ItemShadowCasters = std::move(SortedShadowCasters);
+
+	for (size_t i = Nodes.size(); i > 0; i--)
+	{
+		UpdateNodeBounds((uint32_t)i - 1);
+	}
+}
+
+void CullingBVH::BuildNode(uint32_t NodeIndex, uint32_t FirstItem, uint32_t NumItems)
+{
+	Nodes[NodeIndex].FirstItem = FirstItem;
+	Nodes[NodeIndex].NumItems = NumItems;
+
+	if (NumItems <= PACKET_SIZE)
+	{
+		Nodes[NodeIndex].Packet = (uint32_t)Packets.size();
+		Packets.emplace_back();
+		return;
+	}
+
+	glm::vec3 CenterMin = ItemBounds[BuildOrder[FirstItem]].center;
+	glm::vec3 CenterMax = CenterMin;
+	for (uint32_t i = FirstItem + 1; i < FirstItem + NumItems; i++)
+	{
+		CenterMin = glm::min(CenterMin, ItemBounds[BuildOrder[i]].center);
+		CenterMax = glm::max(CenterMax, ItemBounds[BuildOrder[i]].center);
+	}
+	glm::vec3 CenterSize = CenterMax - CenterMin;
+	int Axis = 0;
+	if (CenterSize.y > CenterSize[Axis])
+	{
+		Axis = 1;
+	}
+	if (CenterSize.z > CenterSize[Axis])
+	{
+		Axis = 2;
+	}
+
+	// Split at a multiple of the packet size, so most leaves use all lanes of their packet.
+	uint32_t NumLeft = (NumItems / 2 + PACKET_SIZE - 1) / PACKET_SIZE * PACKET_SIZE;
+	auto First = BuildOrder.begin() + FirstItem;
+	std::nth_element(First, First + NumLeft, First + NumItems, [this, Axis](uint32_t a, uint32_t b)
+		{
+			return ItemBounds[a].center[Axis] < ItemBounds[b].center[Axis];
+		});
+
+	uint32_t FirstChild = (uint32_t)Nodes.size();
+	Nodes[NodeIndex].FirstChild = FirstChild;
+	Nodes.emplace_back();
+	Nodes.emplace_back();
+	BuildNode(FirstChild, FirstItem, NumLeft);
+	BuildNode(FirstChild + 1, FirstItem + NumLeft, NumItems - NumLeft);
+}
+
+bool CullingBVH::Refit()
+{
+	bool AnyMoved = false;
+	for (size_t i = 0; i < Items.size(); i++)
+	{
+		FrustumCulling::AABB Bounds;
+		if (!Items[i]->GetWorldBounds(Bounds))
+		{
+			return false;
+		}
+		bool ShadowCaster = Items[i]->IsShadowCaster();
+		bool SameShadowCaster = ShadowCaster == ItemShadowCasters[i];
+		if (SameBounds(Bounds, ItemBounds[i]) && SameShadowCaster)
+		{
+			if (ItemStillFrames[i] < STATIC_FRAMES && ++ItemStillFrames[i] == STATIC_FRAMES)
+			{
+				StaticVersion++;
+			}
+			continue;
+		}
+		// The cached shadows of static items are only correct as long as they neither move nor change if they cast shadows.
+		if (IsStatic((uint32_t)i))
+		{
+			StaticVersion++;
+		}
+		ItemStillFrames[i] = 0;
+		ItemShadowCasters[i] = ShadowCaster;
+		if (SameBounds(Bounds, ItemBounds[i]))
+		{
+			continue;
+		}
+		ItemBounds[i] = Bounds;
+		AnyMoved = true;
+		if (!ItemMoved[i])
+		{
+			ItemMoved[i] = true;
+			NumMovedItems++;
+		}
+	}
+
+	if (AnyMoved)
+	{
+		// Children are always stored after their parent.
+		for (size_t i = Nodes.size(); i > 0; i--)
+		{
+			UpdateNodeBounds((uint32_t)i - 1);
+		}
+	}
+	return true;
+}
+
+void CullingBVH::UpdateNodeBounds(uint32_t NodeIndex)
+{
+	Node& n = Nodes[NodeIndex];
+	if (n.FirstChild)
+	{
+		const Node& Left = Nodes[n.FirstChild];
+		const Node& Right = Nodes[n.FirstChild + 1];
+		n.Min = glm::min(Left.Min, Right.Min);
+		n.Max = glm::max(Left.Max, Right.Max);
+		return;
+	}
+
+	BoundsPacket& p = Packets[n.Packet];
+	for (uint32_t Lane = 0; Lane < PACKET_SIZE; Lane++)
+	{
+		// Unused lanes repeat the first item. They are ignored when the packet is tested.
+		const FrustumCulling::AABB& Bounds = ItemBounds[n.FirstItem + (Lane < n.NumItems ? Lane : 0)];
+		p.CenterX[Lane] = Bounds.center.x;
+		p.CenterY[Lane] = Bounds.center.y;
+		p.CenterZ[Lane] = Bounds.center.z;
+		p.ExtentX[Lane] = Bounds.extents.x;
+		p.ExtentY[Lane] = Bounds.extents.y;
+		p.ExtentZ[Lane] = Bounds.extents.z;
+
+		if (Lane == 0)
+		{
+			n.Min = Bounds.center - Bounds.extents;
+			n.Max = Bounds.center + Bounds.extents;
+		}
+		else
+		{
+			n.Min = glm::min(n.Min, Bounds.center - Bounds.extents);
+			n.Max = glm::max(n.Max, Bounds.center + Bounds.extents);
+		}
+	}
+}
+
+void CullingBVH::Cull(const FrustumCulling::Frustum* Frusta, size_t NumFrusta, std::vector<Drawable*>& Visible, Filter UsedFilter)
+{
+	// Drawables without bounds can't be tracked, so they are dynamic.
+	if (UsedFilter != Filter::Static)
+	{
+		Visible.insert(Visible.end(), Unbounded.begin(), Unbounded.end());
+	}
+	if (Nodes.empty())
+	{
+		return;
+	}
+
+	if (++CurrentMark == 0)
+	{
+		std::fill(ItemMarks.begin(), ItemMarks.end(), 0);
+		CurrentMark = 1;
+	}
+	for (size_t i = 0; i < NumFrusta; i++)
+	{
+		CullTree(Frusta[i], Visible, UsedFilter);
+	}
+}
+
+void CullingBVH::AddItem(uint32_t Item, std::vector<Drawable*>& Visible, Filter UsedFilter)
+{
+	if ((UsedFilter == Filter::Static && !IsStatic(Item)) || (UsedFilter == Filter::Dynamic && IsStatic(Item)))
+	{
+		return;
+	}
+	if (ItemMarks[Item] != CurrentMark)
+	{
+		ItemMarks[Item] = CurrentMark;
+		Visible.push_back(Items[Item]);
+	}
+}
+
+void CullingBVH::CullTree(const FrustumCulling::Frustum& Frustum, std::vector<Drawable*>& Visible, Filter UsedFilter)
+{
+	const FrustumPlanes Planes = FrustumPlanes(Frustum);
+
+	NodeStack.clear();
+	NodeStack.push_back(0);
+	NodeStack.push_back(ALL_PLANES);
+
+	while (!NodeStack.empty())
+	{
+		uint32_t PlaneMask = NodeStack.back();
+		NodeStack.pop_back();
+		const Node& n = Nodes[NodeStack.back()];
+		NodeStack.pop_back();
+
+		// Planes that the node is completely in front of are removed from the mask, since its children are in front of them too.
+		glm::vec3 Center = (n.Min + n.Max) * 0.5f;
+		glm::vec3 Extents = (n.Max - n.Min) * 0.5f;
+		bool Outside = false;
+		for (uint32_t i = 0; i < NUM_PLANES && !Outside; i++)
+		{
+			if (!(PlaneMask & (1 << i)))
+			{
+				continue;
+			}
+			float Distance = Planes.NormalX[i] * Center.x + Planes.NormalY[i] * Center.y + Planes.NormalZ[i] * Center.z
+				- Planes.Distance[i];
+			float Radius = std::abs(Planes.NormalX[i]) * Extents.x
+				+ std::abs(Planes.NormalY[i]) * Extents.y
+				+ std::abs(Planes.NormalZ[i]) * Extents.z;
+			if (Distance < -Radius)
+			{
+				Outside = true;
+			}
+			else if (Distance >= Radius)
+			{
+				PlaneMask &= ~(1 << i);
+			}
+		}
+
+		if (Outside)
+		{
+			continue;
+		}
+
+		if (PlaneMask == 0)
+		{
+			for (uint32_t i = n.FirstItem; i < n.FirstItem + n.NumItems; i++)
+			{
+				AddItem(i, Visible, UsedFilter);
+			}
+			continue;
+		}
+
+		if (n.FirstChild)
+		{
+			NodeStack.push_back(n.FirstChild);
+			NodeStack.push_back(PlaneMask);
+			NodeStack.push_back(n.FirstChild + 1);
+			NodeStack.push_back(PlaneMask);
+			continue;
+		}
+
+		// Test all boxes of the leaf against the remaining planes at once.
+		const BoundsPacket& p = Packets[n.Packet];
+		uint32_t InsideMask = 0;
+#if CULLING_SSE
+		const __m128 SignMask = _mm_set1_ps(-0.0f);
+		__m128 Inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());
+		const __m128 CenterX = _mm_load_ps(p.CenterX);
+		const __m128 CenterY = _mm_load_ps(p.CenterY);
+		const __m128 CenterZ = _mm_load_ps(p.CenterZ);
+		const __m128 ExtentX = _mm_load_ps(p.ExtentX);
+		const __m128 ExtentY = _mm_load_ps(p.ExtentY);
+		const __m128 ExtentZ = _mm_load_ps(p.ExtentZ);
+		for (uint32_t i = 0; i < NUM_PLANES; i++)
+		{
+			if (!(PlaneMask & (1 << i)))
+			{
+				continue;
+			}
+			const __m128 NormalX = _mm_set1_ps(Planes.NormalX[i]);
+			const __m128 NormalY = _mm_set1_ps(Planes.NormalY[i]);
+			const __m128 NormalZ = _mm_set1_ps(Planes.NormalZ[i]);
+
+			__m128 Distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(CenterX, NormalX), _mm_mul_ps(CenterY, NormalY)),
+				_mm_mul_ps(CenterZ, NormalZ));
+			Distance = _mm_sub_ps(Distance, _mm_set1_ps(Planes.Distance[i]));
+
+			__m128 Radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ExtentX, _mm_andnot_ps(SignMask, NormalX)),
+				_mm_mul_ps(ExtentY, _mm_andnot_ps(SignMask, NormalY))),
+				_mm_mul_ps(ExtentZ, _mm_andnot_ps(SignMask, NormalZ)));
+
+			Inside = _mm_and_ps(Inside, _mm_cmpge_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+		}
+		InsideMask = (uint32_t)_mm_movemask_ps(Inside);
+#else
+		for (uint32_t Lane = 0; Lane < PACKET_SIZE; Lane++)
+		{
+			bool Inside = true;
+			for (uint32_t i = 0; i < NUM_PLANES && Inside; i++)
+			{
+				if (!(PlaneMask & (1 << i)))
+				{
+					continue;
+				}
+				float Distance = p.CenterX[Lane] * Planes.NormalX[i] + p.CenterY[Lane] * Planes.NormalY[i]
+					+ p.CenterZ[Lane] * Planes.NormalZ[i] - Planes.Distance[i];
+				float Radius = p.ExtentX[Lane] * std::abs(Planes.NormalX[i])
+					+ p.ExtentY[Lane] * std::abs(Planes.NormalY[i])
+					+ p.ExtentZ[Lane] * std::abs(Planes.NormalZ[i]);
+				Inside = Distance + Radius >= 0;
+			}
+			if (Inside)
+			{
+				InsideMask |= 1 << Lane;
+			}
+		}
+#endif
+		for (uint32_t Lane = 0; Lane < n.NumItems; Lane++)
+		{
+			if (InsideMask & (1 << Lane))
+			{
+				AddItem(n.FirstItem + Lane, Visible, UsedFilter);
+			}
+		}
+	}
+}
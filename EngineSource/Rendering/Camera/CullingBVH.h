@@ -0,0 +1,130 @@
+#pragma once
+#include <Rendering/Camera/FrustumCulling.h>
+#include <cstdint>
+#include <vector>
+
+class Drawable;
+
+/**
+* @brief
+* Bounding volume hierarchy over the world bounds of the drawables of a framebuffer, used to frustum cull them.
+*
+* The tree is refit every frame and only rebuilt if drawables were added or removed, or if too many of them moved
+* since the last build. Leaves store up to 4 bounding boxes as a structure of arrays so they can be tested against
+* a frustum plane in one SIMD operation.
+*
+* Subtrees that are completely inside of a frustum are added to the visible list without testing the boxes inside of them.
+*
+* Drawables whose bounds and shadow casting (see Drawable::IsShadowCaster()) didn't change for STATIC_FRAMES updates count as static. This is used to cache the shadows
+* of static objects, see CSM::BindStaticCascade().
+*/
+class CullingBVH
+{
+public:
+	/// Number of bounding boxes stored in one leaf.
+	static constexpr uint32_t PACKET_SIZE = 4;
+	/// Number of updates a drawable's bounds and shadow casting have to stay the same for it to count as static.
+	static constexpr uint32_t STATIC_FRAMES = 30;
+
+	/// Which drawables Cull() returns.
+	enum class Filter
+	{
+		All,
+		Static,
+		Dynamic
+	};
+
+	/**
+	* @brief
+	* Updates the tree to contain the given drawables.
+	*
+	* Drawables without bounds (see Drawable::GetWorldBounds()) aren't stored in the tree. They are always visible.
+	*/
+	void Update(const std::vector<Drawable*>& Drawables);
+
+	/**
+	* @brief
+	* Appends all drawables that are at least partially inside of one of the frusta to Visible.
+	*
+	* Every drawable is added at most once. Drawables without bounds are always added, unless only static drawables are requested.
+	*/
+	void Cull(const FrustumCulling::Frustum* Frusta, size_t NumFrusta, std::vector<Drawable*>& Visible, Filter UsedFilter = Filter::All);
+
+	/// Appends all drawables that are at least partially inside of the frustum to Visible.
+	void Cull(const FrustumCulling::Frustum& Frustum, std::vector<Drawable*>& Visible, Filter UsedFilter = Filter::All)
+	{
+		Cull(&Frustum, 1, Visible, UsedFilter);
+	}
+
+	/**
+	* @brief
+	* Changes every time a drawable starts or stops being static, or a static drawable is removed.
+	*
+	* A static drawable that is hidden or stops casting shadows becomes dynamic, so this changes too.
+	*/
+	uint64_t GetStaticVersion() const
+	{
+		return StaticVersion;
+	}
+
+private:
+	struct alignas(16) BoundsPacket
+	{
+		float CenterX[PACKET_SIZE];
+		float CenterY[PACKET_SIZE];
+		float CenterZ[PACKET_SIZE];
+		float ExtentX[PACKET_SIZE];
+		float ExtentY[PACKET_SIZE];
+		float ExtentZ[PACKET_SIZE];
+	};
+
+	struct Node
+	{
+		glm::vec3 Min;
+		glm::vec3 Max;
+		/// Range of the node's items in Items. The items of a node are always stored next to each other.
+		uint32_t FirstItem = 0;
+		uint32_t NumItems = 0;
+		/// Index of the first child node. The second child is stored right after it. 0 for leaves.
+		uint32_t FirstChild = 0;
+		/// Index of the leaf's packet in Packets.
+		uint32_t Packet = 0;
+	};
+
+	void Build();
+	void BuildNode(uint32_t NodeIndex, uint32_t FirstItem, uint32_t NumItems);
+	/// Updates the bounds of all items and nodes. Returns false if the tree needs to be rebuilt.
+	bool Refit();
+	void UpdateNodeBounds(uint32_t NodeIndex);
+	void CullTree(const FrustumCulling::Frustum& Frustum, std::vector<Drawable*>& Visible, Filter UsedFilter);
+	void AddItem(uint32_t Item, std::vector<Drawable*>& Visible, Filter UsedFilter);
+	bool IsStatic(uint32_t Item) const
+	{
+		return ItemStillFrames[Item] >= STATIC_FRAMES;
+	}
+
+	/// The drawables passed to the last call to Update(), in their original order.
+	std::vector<Drawable*> Drawables;
+	/// The drawables stored in the tree, sorted so the items of every node are contiguous.
+	std::vector<Drawable*> Items;
+	std::vector<FrustumCulling::AABB> ItemBounds;
+	/// True for every item whose bounds changed since the tree was built.
+	std::vector<bool> ItemMoved;
+	/// Number of updates since the bounds or shadow casting of each item last changed, up to STATIC_FRAMES.
+	std::vector<uint32_t> ItemStillFrames;
+	/// Drawable::IsShadowCaster() of each item at the last update.
+	std::vector<bool> ItemShadowCasters;
+	uint64_t StaticVersion = 0;
+	std::vector<Drawable*> Unbounded;
+	std::vector<Node> Nodes;
+	std::vector<BoundsPacket> Packets;
+	/// The call to Cull() that last added an item, so items inside of more than one frustum are only added once.
+	std::vector<uint32_t> ItemMarks;
+	uint32_t CurrentMark = 0;
+	/// Number of items whose bounds changed since the tree was built.
+	size_t NumMovedItems = 0;
+	/// Order of the items while the tree is built, as indices into Items.
+	std::vector<uint32_t> BuildOrder;
+	/// Node indices and plane masks of the nodes that still have to be tested by CullTree().
+	std::vector<uint32_t> NodeStack;
+};
@@ -5,25 +5,40 @@
 namespace FrustumCulling
 {
 	bool Active = true;
-	Frustum createFrustumFromCamera(const Camera& cam)
+	static Plan PlanFromRow(const glm::vec4& Row)
 	{
-		float aspect = 16.f/9.f;
-		float fovY = 2.f;
-		float zNear = NearPlane;
-		float zFar = FarPlane;
-		Frustum frustum;
-		const float halfVSide = zFar * tanf(fovY * .5f);
-		const float halfHSide = halfVSide * aspect;
-		const glm::vec3 frontMultFar = zFar * cam.LookAt;
+		// The plane Row.x * x + Row.y * y + Row.z * z + Row.w = 0, with the inside of the frustum on the positive side.
+		Plan NewPlan;
+		float Length = glm::length(glm::vec3(Row));
+		NewPlan.normal = glm::vec3(Row) / Length;
+		NewPlan.distance = -Row.w / Length;
+		return NewPlan;
+	}
+
+	Frustum createFrustumFromMatrix(const glm::mat4& ViewProjection)
+	{
+		// Gribb/Hartmann plane extraction. A point is inside if -w <= x, y, z <= w in clip space.
+		glm::vec4 Rows[4];
+		for (int i = 0; i < 4; i++)
+		{
+			Rows[i] = glm::vec4(ViewProjection[0][i], ViewProjection[1][i], ViewProjection[2][i], ViewProjection[3][i]);
+		}
 
-		frustum.nearFace = { cam.Position + zNear * cam.LookAt, cam.LookAt };
-		frustum.farFace = { cam.Position + frontMultFar, Vector3() - cam.LookAt};
-		frustum.rightFace = { cam.Position, Vector3::Cross(cam.Up, frontMultFar + cam.Right * halfHSide) };
-		frustum.leftFace = { cam.Position, Vector3::Cross(frontMultFar - cam.Right * halfHSide, cam.Up) };
-		frustum.topFace = { cam.Position, Vector3::Cross(cam.Right, frontMultFar - cam.Up * halfVSide) };
-		frustum.bottomFace = { cam.Position, Vector3::Cross(frontMultFar + cam.Up * halfVSide, cam.Right) };
+		Frustum frustum;
+		frustum.leftFace = PlanFromRow(Rows[3] + Rows[0]);
+		frustum.rightFace = PlanFromRow(Rows[3] - Rows[0]);
+		frustum.bottomFace = PlanFromRow(Rows[3] + Rows[1]);
+		frustum.topFace = PlanFromRow(Rows[3] - Rows[1]);
+		frustum.nearFace = PlanFromRow(Rows[3] + Rows[2]);
+		frustum.farFace = PlanFromRow(Rows[3] - Rows[2]);
 		return frustum;
 	}
+
+	Frustum createFrustumFromCamera(const Camera& cam)
+	{
+		return createFrustumFromMatrix(cam.GetViewProjection());
+	}
+
 	Frustum CurrentCameraFrustum;
 	bool AABB::isOnFrustum(const Frustum& camFrustum, const glm::vec3& transform, glm::vec3 scale) const
 	{
@@ -81,7 +81,16 @@ namespace FrustumCulling
 
 	};
 
+	/// Creates the frustum of the camera from its view projection matrix, so it uses the camera's real FOV and aspect ratio.
 	Frustum createFrustumFromCamera(const Camera& cam);
 
+	/**
+	* @brief
+	* Creates the frustum containing everything that is visible through the given view projection matrix.
+	*
+	* Works for both perspective and orthographic projections, for example the light space matrices of the shadow cascades.
+	*/
+	Frustum createFrustumFromMatrix(const glm::mat4& ViewProjection);
+
 	extern Frustum CurrentCameraFrustum;
 }
\ No newline at end of file
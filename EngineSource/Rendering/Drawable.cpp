@@ -11,59 +11,6 @@
 #include <Engine/Log.h>
 #include "ShaderPreprocessor.h"
 
-Graphics::Sun FullbrightSun =
-{
-	.Intensity = 0,
-	.AmbientIntensity = 1,
-	.SunColor = 1,
-	.AmbientColor = 1,
-};
-
-void Drawable::ApplyDefaultUniformsToShader(Shader* ShaderToApply, bool MainFramebuffer)
-{
-#if !SERVER
-	ShaderToApply->Bind();
-	glActiveTexture(GL_TEXTURE1);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, CSM::ShadowMaps);
-	ShaderToApply->SetFloat("farPlane", CSM::cameraFarPlane);
-	ShaderToApply->SetInt("cascadeCount", (int)CSM::shadowCascadeLevels.size());
-	ShaderToApply->SetInt("shadowMap", 1);
-	ShaderToApply->SetInt("GiMap", 3);
-	ShaderToApply->SetInt("GiRes", (int)BakedLighting::GetLightTextureSize());
-	ShaderToApply->SetInt("GiEnabled", (int)(BakedLighting::LoadedLightmap && MainFramebuffer));
-	ShaderToApply->SetVector3("GiScale", BakedLighting::GetLightMapScale());
-	ShaderToApply->SetInt("Skybox", 2);
-	ShaderToApply->SetFloat("u_biasmodifier", Vector3::Dot(
-		Vector3::GetForwardVector(Graphics::MainCamera->Rotation),
-		Vector3::GetForwardVector(Graphics::WorldSun.Rotation)));
-	ShaderToApply->SetVector3("u_cameraforward", Vector3::GetForwardVector(Graphics::MainCamera->Rotation));
-	ShaderToApply->SetVector3("u_cameraposition", Graphics::MainFramebuffer->FramebufferCamera->Position);
-	ShaderToApply->SetInt("u_shadowQuality", Graphics::PCFQuality);
-	ShaderToApply->SetInt("u_shadows", Graphics::RenderShadows);
-	ShaderToApply->SetFloat("FogFalloff", Graphics::WorldFog.Falloff);
-	ShaderToApply->SetFloat("FogDistance", Graphics::WorldFog.Distance);
-	ShaderToApply->SetFloat("FogMaxDensity", Graphics::WorldFog.MaxDensity);
-	ShaderToApply->SetVector3("FogColor", Graphics::WorldFog.FogColor);
-
-	ShaderToApply->SetVector3("u_directionallight.Direction", Vector3::GetForwardVector(Graphics::WorldSun.Rotation));
-
-	const Graphics::Sun& UsedSun = Graphics::RenderFullBright ? FullbrightSun : Graphics::WorldSun;
-
-	ShaderToApply->SetFloat("u_directionallight.Intensity", UsedSun.Intensity);
-	ShaderToApply->SetFloat("u_directionallight.AmbientIntensity", UsedSun.AmbientIntensity);
-	ShaderToApply->SetVector3("u_directionallight.SunColor", UsedSun.SunColor);
-	ShaderToApply->SetVector3("u_directionallight.AmbientColor", UsedSun.AmbientColor);
-
-	ShaderToApply->SetFloat("u_time", Stats::Time);
-
-	for (size_t i = 0; i < CSM::shadowCascadeLevels.size(); ++i)
-	{
-		glUniform1f(glGetUniformLocation(ShaderToApply->GetShaderID(),
-			((std::string("cascadePlaneDistances[") + std::to_string(i)) + "]").c_str()), CSM::shadowCascadeLevels[i] * CSM::CSMDistance);
-	}
-#endif
-}
-
 ObjectRenderContext::ObjectRenderContext(Material m)
 {
 #if !SERVER
@@ -111,23 +58,25 @@ void ObjectRenderContext::BindWithShader(Shader* s)
 		{
 			continue;
 		}
+		// Other shaders, like the shadow shader, don't have the locations of the context's shader.
+		int Location = s == ContextShader ? Uniforms.at(i).Location : s->GetUniformLocation(Uniforms.at(i).Name);
 		switch (Uniforms.at(i).NativeType)
 		{
 		case NativeType::Bool:
 		case NativeType::Int:
-			s->SetInt(Uniforms.at(i).Name, *static_cast<int*>(Uniforms.at(i).Content));
+			s->SetInt(Location, *static_cast<int*>(Uniforms.at(i).Content));
 			break;
 		case NativeType::Float:
-			s->SetFloat(Uniforms.at(i).Name, *static_cast<float*>(Uniforms.at(i).Content));
+			s->SetFloat(Location, *static_cast<float*>(Uniforms.at(i).Content));
 			break;
 		case NativeType::Vector3Color:
 		case NativeType::Vector3:
-			s->SetVector3(Uniforms.at(i).Name, *static_cast<Vector3*>(Uniforms.at(i).Content));
+			s->SetVector3(Location, *static_cast<Vector3*>(Uniforms.at(i).Content));
 			break;
 		case NativeType::GL_Texture:
 			glActiveTexture(GL_TEXTURE7 + TexIterator);
 			glBindTexture(GL_TEXTURE_2D, *(unsigned int*)Uniforms.at(i).Content);
-			glUniform1i(glGetUniformLocation(s->GetShaderID(), Uniforms.at(i).Name.c_str()), 7 + TexIterator);
+			s->SetInt(Location, 7 + TexIterator);
 			TexIterator++;
 			break;
 		default:
@@ -180,7 +129,7 @@ void ObjectRenderContext::LoadUniform(Material::Param u)
 
 	if (UniformIndex == SIZE_MAX)
 	{
-		Uniforms.push_back(Uniform(u.UniformName, u.NativeType, nullptr));
+		AddUniform(u.UniformName, u.NativeType, nullptr);
 		UniformIndex = Uniforms.size() - 1;
 	}
 
@@ -249,7 +198,18 @@ void ObjectRenderContext::LoadTexture(std::string UniformName, Texture::TextureT
 {
 	DeleteUniform(UniformName);
 
-	Uniforms.push_back(Uniform(UniformName, NativeType::GL_Texture, new unsigned int(TextureID)));
+	AddUniform(UniformName, NativeType::GL_Texture, new unsigned int(TextureID));
+}
+
+void ObjectRenderContext::AddUniform(std::string Name, NativeType::NativeType NativeType, void* Content)
+{
+	Uniforms.push_back(Uniform(Name, NativeType, Content));
+#if !SERVER
+	if (ContextShader)
+	{
+		Uniforms.back().Location = ContextShader->GetUniformLocation(Name);
+	}
+#endif
 }
 
 void ObjectRenderContext::Unload()
@@ -1,5 +1,6 @@
 #pragma once
 #include <Rendering/Camera/Camera.h>
+#include <Rendering/Camera/FrustumCulling.h>
 #include <Rendering/Shader.h>
 #include <Rendering/Texture/Material.h>
 #include <Rendering/Texture/Texture.h>
@@ -16,6 +17,8 @@ struct ObjectRenderContext
 		std::string Name;
 		NativeType::NativeType NativeType;
 		void* Content;
+		/// The location of the uniform in the context's shader. Resolved when the uniform is added, so binding doesn't look up the name.
+		int Location = -1;
 		Uniform(std::string Name, NativeType::NativeType NativeType, void* Content)
 		{
 			this->Content = Content;
@@ -34,6 +37,8 @@ struct ObjectRenderContext
 	bool DeleteUniform(std::string Name);
 
 protected:
+	void AddUniform(std::string Name, NativeType::NativeType NativeType, void* Content);
+
 	Shader* ContextShader = nullptr;
 	std::vector<Uniform> Uniforms;
 };
@@ -43,6 +48,24 @@ class Drawable
 public:
 	virtual void Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyPass) = 0;
 	virtual void SimpleRender(Shader* UsedShader) = 0;
+
+	/**
+	* @brief
+	* Gets the world space bounding box of this object, used to cull it before it is rendered.
+	*
+	* @return
+	* False if the object has no bounds. Objects without bounds are never culled.
+	*/
+	virtual bool GetWorldBounds([[maybe_unused]] FrustumCulling::AABB& Bounds) const
+	{
+		return false;
+	}
+
+	/// True if this object is currently drawn into the shadow maps.
+	virtual bool IsShadowCaster() const
+	{
+		return CastShadow;
+	}
 	Drawable()
 	{
 
@@ -52,8 +75,6 @@ public:
 
 	};
 
-	static void ApplyDefaultUniformsToShader(Shader* ShaderToApply, bool MainFramebuffer);
-
 	bool CastShadow = true;
 	bool DestroyOnUnload = true;
 };
@@ -0,0 +1,145 @@
+#if !SERVER
+#include "FrameUniforms.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <Rendering/Shader.h>
+#include <Rendering/Camera/Camera.h>
+#include <Rendering/RenderSubsystem/CSM.h>
+#include <Rendering/LightClusters.h>
+#include <Rendering/RenderSubsystem/BakedLighting.h>
+#include <Engine/Stats.h>
+#include <algorithm>
+#include <iterator>
+
+namespace FrameUniforms
+{
+	// The structs below must match the 'FrameData' block in shared.vert and shared.frag.
+	// std140 aligns vec3 to 16 bytes and pads every element of an array to 16 bytes.
+	struct DirectionalLightData
+	{
+		glm::vec3 Direction;
+		float Intensity;
+		glm::vec3 SunColor;
+		float AmbientIntensity;
+		glm::vec3 AmbientColor;
+		float Padding;
+	};
+
+	struct FrameData
+	{
+		glm::mat4 View;
+		glm::mat4 Projection;
+		glm::mat4 ViewProjection;
+		DirectionalLightData Sun;
+		glm::vec4 CascadePlaneDistances[8];
+		glm::vec3 CameraPosition;
+		float BiasModifier;
+		glm::vec3 CameraForward;
+		float Time;
+		glm::vec3 FogColor;
+		float FogFalloff;
+		glm::vec3 GiScale;
+		float FogDistance;
+		float FogMaxDensity;
+		int32_t CascadeCount;
+		int32_t Shadows;
+		int32_t ShadowQuality;
+		int32_t GiRes;
+		int32_t GiEnabled;
+		float FarPlane;
+		float ClusterScale;
+		glm::uvec3 ClusterCount;
+		float ClusterBias;
+		glm::vec2 ScreenSize;
+		float Padding[2];
+	};
+
+	static_assert(sizeof(DirectionalLightData) == 48 && sizeof(FrameData) == 496,
+		"FrameData must use the std140 layout.");
+
+	static unsigned int FrameBufferObject = 0;
+	static FrameData CurrentFrame;
+
+	static const Graphics::Sun FullbrightSun =
+	{
+		.Intensity = 0,
+		.AmbientIntensity = 1,
+		.SunColor = 1,
+		.AmbientColor = 1,
+	};
+}
+
+void FrameUniforms::BindToShader(Shader* Target)
+{
+	unsigned int BlockIndex = glGetUniformBlockIndex(Target->GetShaderID(), "FrameData");
+	if (BlockIndex != GL_INVALID_INDEX)
+	{
+		glUniformBlockBinding(Target->GetShaderID(), BlockIndex, BINDING);
+	}
+
+	// The texture units never change, so they only need to be set once.
+	glProgramUniform1i(Target->GetShaderID(), Target->GetUniformLocation("shadowMap"), 1);
+	glProgramUniform1i(Target->GetShaderID(), Target->GetUniformLocation("Skybox"), 2);
+	glProgramUniform1i(Target->GetShaderID(), Target->GetUniformLocation("GiMap"), 3);
+}
+
+void FrameUniforms::Update(Camera* FramebufferCamera, Vector2 Resolution, bool MainFramebuffer)
+{
+	if (!FrameBufferObject)
+	{
+		glGenBuffers(1, &FrameBufferObject);
+		glBindBuffer(GL_UNIFORM_BUFFER, FrameBufferObject);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, BINDING, FrameBufferObject);
+	}
+
+	FrameData& Data = CurrentFrame;
+	Data.View = FramebufferCamera->getView();
+	Data.Projection = FramebufferCamera->GetProjection();
+	Data.ViewProjection = FramebufferCamera->GetViewProjection();
+
+	const Graphics::Sun& UsedSun = Graphics::RenderFullBright ? FullbrightSun : Graphics::WorldSun;
+	Vector3 SunDirection = Vector3::GetForwardVector(Graphics::WorldSun.Rotation);
+	Data.Sun = DirectionalLightData{
+		.Direction = SunDirection,
+		.Intensity = UsedSun.Intensity,
+		.SunColor = UsedSun.SunColor,
+		.AmbientIntensity = UsedSun.AmbientIntensity,
+		.AmbientColor = UsedSun.AmbientColor,
+	};
+
+	size_t NumCascades = std::min(CSM::shadowCascadeLevels.size(), std::size(Data.CascadePlaneDistances));
+	for (size_t i = 0; i < NumCascades; ++i)
+	{
+		Data.CascadePlaneDistances[i].x = CSM::shadowCascadeLevels[i] * CSM::CSMDistance;
+	}
+	Data.CascadeCount = (int32_t)NumCascades;
+
+	Vector3 CameraForward = Vector3::GetForwardVector(FramebufferCamera->Rotation);
+	Data.CameraPosition = FramebufferCamera->Position;
+	Data.CameraForward = CameraForward;
+	Data.BiasModifier = Vector3::Dot(CameraForward, SunDirection);
+	Data.Time = Stats::Time;
+	Data.FogColor = Graphics::WorldFog.FogColor;
+	Data.FogFalloff = Graphics::WorldFog.Falloff;
+	Data.FogDistance = Graphics::WorldFog.Distance;
+	Data.FogMaxDensity = Graphics::WorldFog.MaxDensity;
+	Data.Shadows = Graphics::RenderShadows;
+	Data.ShadowQuality = (int32_t)Graphics::PCFQuality;
+	Data.GiScale = BakedLighting::GetLightMapScale();
+	Data.GiRes = (int32_t)BakedLighting::GetLightTextureSize();
+	Data.GiEnabled = BakedLighting::LoadedLightmap && MainFramebuffer;
+	Data.FarPlane = CSM::cameraFarPlane;
+	Data.ClusterCount = glm::uvec3(LightClusters::CLUSTERS_X, LightClusters::CLUSTERS_Y, LightClusters::CLUSTERS_Z);
+	Data.ClusterScale = LightClusters::GetSliceScale();
+	Data.ClusterBias = LightClusters::GetSliceBias();
+	Data.ScreenSize = glm::vec2(Resolution.X, Resolution.Y);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, FrameBufferObject);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &Data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, CSM::ShadowMaps);
+}
+#endif
@@ -0,0 +1,41 @@
+#if !SERVER
+#pragma once
+#include <Math/Vector.h>
+
+struct Shader;
+class Camera;
+
+/**
+* @brief
+* Uniforms that are the same for every shader drawn into a framebuffer.
+*
+* The camera, sun, fog, shadow cascades, light cluster grid and baked lighting parameters are stored in the std140
+* uniform block 'FrameData' declared in shared.vert and shared.frag. The block is uploaded once for each framebuffer
+* that is drawn instead of setting the values on every loaded shader.
+*
+* @ingroup Internal
+*/
+namespace FrameUniforms
+{
+	/// Uniform buffer binding point of the 'FrameData' block. Binding 0 is used by the CSM light space matrices.
+	constexpr unsigned int BINDING = 1;
+
+	/// Connects the 'FrameData' block of the shader to the frame uniform buffer and sets the texture units of the frame samplers.
+	void BindToShader(Shader* Target);
+
+	/**
+	* @brief
+	* Uploads the frame uniforms for drawing with the given camera.
+	*
+	* @param FramebufferCamera
+	* The camera of the framebuffer that is drawn.
+	*
+	* @param Resolution
+	* The resolution of the framebuffer, used to find the light cluster of a pixel.
+	*
+	* @param MainFramebuffer
+	* True if the main framebuffer is drawn. Baked lighting is only used in the main framebuffer.
+	*/
+	void Update(Camera* FramebufferCamera, Vector2 Resolution, bool MainFramebuffer);
+}
+#endif
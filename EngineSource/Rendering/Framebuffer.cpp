@@ -6,9 +6,14 @@
 #include <Rendering/Mesh/ModelGenerator.h>
 #include <Engine/Application.h>
 #include <Rendering/Mesh/Model.h>
+#include <Rendering/Mesh/ModelBatch.h>
+#include <Rendering/Camera/CullingBVH.h>
 #include <Engine/Stats.h>
 #include "RenderSubsystem/CSM.h"
 #include "ShaderManager.h"
+#include "FrameUniforms.h"
+#include "LightClusters.h"
+#include "RenderState.h"
 #include <Rendering/RenderSubsystem/BakedLighting.h>
 #include <Rendering/Texture/Cubemap.h>
 #include <Rendering/RenderSubsystem/OcclusionCulling.h>
@@ -22,6 +27,8 @@ FramebufferObject::FramebufferObject()
 	buf = new Framebuffer();
 	buf->ReInit((int)(Graphics::RenderResolution.X), (int)(Graphics::RenderResolution.Y));
 	Graphics::AllFramebuffers.push_back(this);
+	Batch = new ModelBatch();
+	Culling = new CullingBVH();
 	CullSubsystem = static_cast<OcclusionCulling*>(Subsystem::GetSubsystemByName("Occlude"));
 }
 
@@ -35,6 +42,8 @@ FramebufferObject::~FramebufferObject()
 		}
 	}
 	delete buf;
+	delete Batch;
+	delete Culling;
 }
 
 unsigned int FramebufferObject::GetTextureID()
@@ -118,9 +127,10 @@ void FramebufferObject::Draw()
 	{
 		p->Update(FramebufferCamera);
 	}
+	Culling->Update(Renderables);
+
 	Stats::EngineStatus = "Rendering (Framebuffer: Shadows)";
-	FrustumCulling::Active = false;
-	glEnable(GL_CULL_FACE);
+	RenderState::SetCullFace(true);
 	glDisable(GL_BLEND);
 	glEnable(GL_DEPTH_TEST);
 	glClearColor(0.f, 0.f, 0.f, 1.f);
@@ -133,76 +143,52 @@ void FramebufferObject::Draw()
 	{
 		glBindFramebuffer(GL_FRAMEBUFFER, CSM::LightFBO);
 		glClear(GL_DEPTH_BUFFER_BIT);
-		for (int j = 0; j < Renderables.size(); j++)
+
+		// Each cascade only draws the objects inside of its own light space volume.
+		const std::vector<glm::mat4> LightSpaceMatrices = CSM::GetLightSpaceMatrices(FramebufferCamera);
+		for (int Cascade = 0; Cascade < (int)LightSpaceMatrices.size(); Cascade++)
 		{
-			if (Renderables[j]->CastShadow)
-				Renderables.at(j)->SimpleRender(CSM::ShadowShader);
+			FrustumCulling::Frustum CascadeFrustum = FrustumCulling::createFrustumFromMatrix(LightSpaceMatrices[Cascade]);
+			CSM::ShadowShader->Bind();
+			CSM::ShadowShader->SetInt(Shader::Uniform::Cascade, Cascade);
+
+			ShadowCasters.clear();
+			if (Cascade >= CSM::FirstCachedCascade)
+			{
+				if (CSM::BindStaticCascade(Cascade, LightSpaceMatrices[Cascade], this, Culling->GetStaticVersion()))
+				{
+					Culling->Cull(CascadeFrustum, ShadowCasters, CullingBVH::Filter::Static);
+					RenderShadowCasters(ShadowCasters);
+					ShadowCasters.clear();
+				}
+				CSM::CopyStaticCascade(Cascade);
+				glBindFramebuffer(GL_FRAMEBUFFER, CSM::LightFBO);
+				Culling->Cull(CascadeFrustum, ShadowCasters, CullingBVH::Filter::Dynamic);
+			}
+			else
+			{
+				Culling->Cull(CascadeFrustum, ShadowCasters);
+			}
+			RenderShadowCasters(ShadowCasters);
 		}
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
 
-	FrustumCulling::Active = false;
 	FrustumCulling::CurrentCameraFrustum = FrustumCulling::createFrustumFromCamera(*FramebufferCamera);
+	VisibleRenderables.clear();
+	Culling->Cull(FrustumCulling::CurrentCameraFrustum, VisibleRenderables);
 	GetBuffer()->Bind();
 	Stats::EngineStatus = "Rendering (Framebuffer: Main pass)";
 
 	Vector2 BufferResolution = UseMainWindowResolution ? Graphics::RenderResolution : CustomFramebufferResolution;
 	glViewport(0, 0, (int)BufferResolution.X, (int)BufferResolution.Y);
-	const auto LightSpaceMatrices = CSM::GetLightSpaceMatrices(FramebufferCamera);
 
-	// Find the closest lights.
-	std::vector<Graphics::Light*> DrawnLights;
-	DrawnLights.reserve(std::min(size_t(Graphics::MAX_LIGHTS), Lights.size()));
+	LightClusters::Update(FramebufferCamera, Lights);
+	FrameUniforms::Update(FramebufferCamera, BufferResolution, this == Graphics::MainFramebuffer);
 
-	for (auto& Light : Lights)
-	{
-		float Distance = Vector3::DistanceSquared(FramebufferCamera->Position, Light.Position);
-		if (DrawnLights.size() < Graphics::MAX_LIGHTS)
-		{
-			Light.Distance = Distance;
-			DrawnLights.push_back(&Light);
-		}
-		else
-		{
-			for (Graphics::Light*& i : DrawnLights)
-			{
-				if (Distance < i->Distance)
-				{
-					i = &Light;
-					i->Distance = Distance;
-					break;
-				}
-			}
-		}
-	}
-
-	// Update uniform values for shaders.
-	for (auto& s : ShaderManager::Shaders)
-	{
-		Drawable::ApplyDefaultUniformsToShader(s.second.UsedShader, this == Graphics::MainFramebuffer);
-		CSM::BindLightSpaceMatricesToShader(LightSpaceMatrices, s.second.UsedShader);
-
-		for (int i = 0; i < Graphics::MAX_LIGHTS; i++)
-		{
-			std::string CurrentLight = "u_lights[" + std::to_string(i) + "]";
-			if (i < DrawnLights.size() && DrawnLights[i]->Intensity > 0 && DrawnLights[i]->Distance > 0)
-			{
-				s.second.UsedShader->SetVector3(CurrentLight + ".Position", DrawnLights[i]->Position);
-				s.second.UsedShader->SetVector3(CurrentLight + ".Color", DrawnLights[i]->Color);
-				s.second.UsedShader->SetFloat(CurrentLight + ".Falloff", DrawnLights[i]->Falloff);
-				s.second.UsedShader->SetFloat(CurrentLight + ".Intensity", DrawnLights[i]->Intensity);
-
-				s.second.UsedShader->SetInt(CurrentLight + ".Active", 1);
-			}
-			else
-			{
-				s.second.UsedShader->SetInt(CurrentLight + ".Active", 0);
-			}
-		}
-	}
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_BLEND);
-	glEnable(GL_CULL_FACE);
+	RenderState::SetCullFace(true);
 	glClearColor(0, 0, 0, 1);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	if (Graphics::IsWireframe)
@@ -225,7 +211,7 @@ void FramebufferObject::Draw()
 	BakedLighting::BindToTexture();
 
 	CullSubsystem->CullShader->Bind();
-	CullSubsystem->CullShader->SetMat4("u_viewpro", FramebufferCamera->GetViewProjection());
+	CullSubsystem->CullShader->SetMat4(Shader::Uniform::ViewProjection, FramebufferCamera->GetViewProjection());
 	size_t i = 0;
 	GetBuffer()->Bind();
 	
@@ -239,12 +225,36 @@ void FramebufferObject::Draw()
 		CullSubsystem->UpdateOcclusionStatus(m);
 	}
 
-	for (auto o : Renderables)
+	// Models are collected into the batch and drawn after all other objects.
+	// Models used for occlusion queries are drawn by QueryAllOccluded() after the batch, so their
+	// queries are tested against the depth of the other models.
+	// The translucent meshes of all models are collected in the same loop, so the transparency pass
+	// only has to draw the objects that aren't models.
+	ModelBatch* UsedBatch = ModelBatch::Active ? Batch : nullptr;
+	std::vector<Drawable*> OtherRenderables;
+	Batch->Clear();
+	for (auto o : VisibleRenderables)
 	{
 		Model* m = dynamic_cast<Model*>(o);
+		if (UsedBatch && !m)
+		{
+			OtherRenderables.push_back(o);
+		}
+
 		if (this == Graphics::MainFramebuffer && m && !Graphics::IsWireframe)
 		{
-			CullSubsystem->RenderOccluded(m, i, this);
+			CullSubsystem->RenderOccluded(m, i, VisibleRenderables.size(), this, UsedBatch);
+			if (UsedBatch && m->IsVisible())
+			{
+				UsedBatch->Add(m, m->GetLOD(FramebufferCamera, false), ModelBatch::MeshFilter::Translucent);
+			}
+		}
+		else if (UsedBatch && m)
+		{
+			if (m->IsVisible())
+			{
+				UsedBatch->Add(m, m->GetLOD(FramebufferCamera, false));
+			}
 		}
 		else
 		{
@@ -252,6 +262,7 @@ void FramebufferObject::Draw()
 		}
 		i++;
 	}
+	Batch->Render(FramebufferCamera, this == Graphics::MainFramebuffer, false);
 
 	CullSubsystem->QueryAllOccluded(this);
 
@@ -262,10 +273,21 @@ void FramebufferObject::Draw()
 		p->Draw(FramebufferCamera, this == Graphics::MainFramebuffer, true);
 	}
 	GetBuffer()->Bind();
-	for (auto o : Renderables)
+	if (UsedBatch)
+	{
+		for (auto o : OtherRenderables)
+		{
+			o->Render(FramebufferCamera, this == Graphics::MainFramebuffer, true);
+		}
+	}
+	else
 	{
-		o->Render(FramebufferCamera, this == Graphics::MainFramebuffer, true);
+		for (auto o : VisibleRenderables)
+		{
+			o->Render(FramebufferCamera, this == Graphics::MainFramebuffer, true);
+		}
 	}
+	Batch->Render(FramebufferCamera, this == Graphics::MainFramebuffer, true);
 
 	glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -273,6 +295,31 @@ void FramebufferObject::Draw()
 	glViewport(0, 0, (int)Graphics::WindowResolution.X, (int)Graphics::WindowResolution.Y);
 #endif
 }
+void FramebufferObject::RenderShadowCasters(const std::vector<Drawable*>& Casters)
+{
+	Batch->Clear();
+	for (Drawable* o : Casters)
+	{
+		if (!o->CastShadow)
+		{
+			continue;
+		}
+		Model* m = dynamic_cast<Model*>(o);
+		if (ModelBatch::Active && m)
+		{
+			if (m->IsShadowVisible())
+			{
+				Batch->Add(m, m->GetLOD(FramebufferCamera, true));
+			}
+		}
+		else
+		{
+			o->SimpleRender(CSM::ShadowShader);
+		}
+	}
+	Batch->SimpleRender(CSM::ShadowShader);
+}
+
 void FramebufferObject::AddEditorGrid()
 {
 	ModelGenerator::ModelData PlaneMesh;
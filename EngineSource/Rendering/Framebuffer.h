@@ -5,6 +5,9 @@
 #include <Rendering/Particle.h>
 #include <Rendering/Graphics.h>
 
+class ModelBatch;
+class CullingBVH;
+
 class Framebuffer
 {
 public:
@@ -56,5 +59,13 @@ public:
 
 protected:
 	Framebuffer* buf;
+	/// Draws the given objects into the shadow maps, using the cascade and framebuffer that are currently bound.
+	void RenderShadowCasters(const std::vector<Drawable*>& Casters);
+	/// Groups the models drawn in each pass into instanced draw calls.
+	ModelBatch* Batch = nullptr;
+	/// Spatial index over the bounds of the Renderables, used to find the objects drawn in each pass.
+	CullingBVH* Culling = nullptr;
+	std::vector<Drawable*> ShadowCasters;
+	std::vector<Drawable*> VisibleRenderables;
 };
 #endif
\ No newline at end of file
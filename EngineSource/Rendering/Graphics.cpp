@@ -15,7 +15,6 @@ bool Graphics::RenderAntiAlias = true;
 bool Graphics::RenderFullBright = false;
 Graphics::Sun Graphics::WorldSun;
 Graphics::Fog Graphics::WorldFog;
-const int Graphics::MAX_LIGHTS = 8;
 int Graphics::ShadowResolution = 2000;
 std::vector<UICanvas*> Graphics::UIToRender;
 Vector2 Graphics::WindowResolution(1600, 900);
@@ -70,6 +69,7 @@ void Graphics::SetWindowResolution(Vector2 NewResolution, bool Force)
 }
 
 float Graphics::Gamma = 1;
+float Graphics::LODBias = 0;
 float Graphics::ChrAbbSize = 0, Graphics::Vignette = 0.1f;
 #if !SERVER
 
@@ -25,8 +25,8 @@ public:
 	static bool Bloom;
 	static bool RenderFullBright;
 	static float Gamma;
-
-	static const int MAX_LIGHTS;
+	/// Added to the level of detail of all models. Positive values use lower detail meshes closer to the camera.
+	static float LODBias;
 
 	struct Fog
 	{
@@ -0,0 +1,210 @@
+#if !SERVER
+#include "LightClusters.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <Rendering/Camera/Camera.h>
+#include <algorithm>
+#include <cmath>
+
+namespace LightClusters
+{
+	constexpr unsigned int NUM_CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z;
+
+	// Must match the PointLight struct in shared.frag with std430 packing.
+	struct LightData
+	{
+		glm::vec3 Position;
+		float Intensity;
+		glm::vec3 Color;
+		float Falloff;
+	};
+	static_assert(sizeof(LightData) == 32, "LightData must use the std430 layout.");
+
+	struct ClusterRange
+	{
+		uint32_t Offset = 0;
+		uint32_t Count = 0;
+	};
+
+	// The clusters covered by a light. End values are exclusive.
+	struct LightBounds
+	{
+		uint32_t StartX, EndX;
+		uint32_t StartY, EndY;
+		uint32_t StartZ, EndZ;
+	};
+
+	static unsigned int LightBuffer = 0;
+	static unsigned int ClusterBuffer = 0;
+	static unsigned int IndexBuffer = 0;
+
+	static std::vector<LightData> VisibleLights;
+	static std::vector<LightBounds> VisibleBounds;
+	static std::vector<ClusterRange> Clusters;
+	static std::vector<uint32_t> LightIndices;
+
+	static uint32_t GetSlice(float Depth)
+	{
+		if (Depth <= NearPlane)
+		{
+			return 0;
+		}
+		float Slice = std::log(Depth) * GetSliceScale() + GetSliceBias();
+		return (uint32_t)std::clamp(Slice, 0.0f, float(CLUSTERS_Z - 1));
+	}
+
+	static uint32_t GetTile(float NDC, uint32_t NumTiles)
+	{
+		float Tile = (NDC * 0.5f + 0.5f) * float(NumTiles);
+		return (uint32_t)std::clamp(Tile, 0.0f, float(NumTiles - 1));
+	}
+
+	/**
+	* Finds the clusters covered by a sphere in view space.
+	*
+	* The screen space bounds are found by projecting the corners of the sphere's bounding box
+	* at its closest and furthest depth. Returns false if the sphere is outside of the view.
+	*/
+	static bool GetSphereBounds(glm::vec3 Center, float Radius, const glm::mat4& Projection, LightBounds& Bounds)
+	{
+		float MinDepth = std::max(-Center.z - Radius, NearPlane);
+		float MaxDepth = -Center.z + Radius;
+		if (MaxDepth < NearPlane)
+		{
+			return false;
+		}
+
+		glm::vec2 MinNDC = glm::vec2(INFINITY), MaxNDC = glm::vec2(-INFINITY);
+		for (float Depth : { MinDepth, MaxDepth })
+		{
+			for (float OffsetX : { -Radius, Radius })
+			{
+				for (float OffsetY : { -Radius, Radius })
+				{
+					glm::vec4 Clip = Projection * glm::vec4(Center.x + OffsetX, Center.y + OffsetY, -Depth, 1.0f);
+					glm::vec2 NDC = glm::vec2(Clip.x, Clip.y) / Clip.w;
+					MinNDC = glm::min(MinNDC, NDC);
+					MaxNDC = glm::max(MaxNDC, NDC);
+				}
+			}
+		}
+
+		if (MaxNDC.x < -1 || MaxNDC.y < -1 || MinNDC.x > 1 || MinNDC.y > 1)
+		{
+			return false;
+		}
+
+		Bounds.StartX = GetTile(MinNDC.x, CLUSTERS_X);
+		Bounds.EndX = GetTile(MaxNDC.x, CLUSTERS_X) + 1;
+		Bounds.StartY = GetTile(MinNDC.y, CLUSTERS_Y);
+		Bounds.EndY = GetTile(MaxNDC.y, CLUSTERS_Y) + 1;
+		Bounds.StartZ = GetSlice(MinDepth);
+		Bounds.EndZ = GetSlice(MaxDepth) + 1;
+		return true;
+	}
+
+	static void UploadBuffer(unsigned int& Buffer, unsigned int Binding, const void* Data, size_t Size)
+	{
+		if (!Buffer)
+		{
+			glGenBuffers(1, &Buffer);
+		}
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, Buffer);
+		// A buffer with a size of 0 can't be bound, so always allocate something.
+		glBufferData(GL_SHADER_STORAGE_BUFFER, std::max(Size, size_t(16)), nullptr, GL_DYNAMIC_DRAW);
+		if (Size)
+		{
+			glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, Size, Data);
+		}
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, Binding, Buffer);
+	}
+}
+
+float LightClusters::GetSliceScale()
+{
+	return float(CLUSTERS_Z) / std::log(MAX_DISTANCE / NearPlane);
+}
+
+float LightClusters::GetSliceBias()
+{
+	return -float(CLUSTERS_Z) * std::log(NearPlane) / std::log(MAX_DISTANCE / NearPlane);
+}
+
+void LightClusters::Update(Camera* FramebufferCamera, const std::vector<Graphics::Light>& Lights)
+{
+	const glm::mat4 View = FramebufferCamera->getView();
+	const glm::mat4 Projection = FramebufferCamera->GetProjection();
+
+	VisibleLights.clear();
+	VisibleBounds.clear();
+	Clusters.assign(NUM_CLUSTERS, ClusterRange());
+
+	// Find the clusters of each light and count the lights per cluster.
+	for (const Graphics::Light& Light : Lights)
+	{
+		if (Light.Intensity <= 0 || Light.Falloff <= 0)
+		{
+			continue;
+		}
+		// The shader's falloff reaches 0 at a distance of sqrt(Falloff * 100).
+		float Radius = std::sqrt(Light.Falloff * 100.0f);
+		glm::vec3 ViewPosition = View * glm::vec4(Light.Position.X, Light.Position.Y, Light.Position.Z, 1.0f);
+
+		LightBounds Bounds;
+		if (!GetSphereBounds(ViewPosition, Radius, Projection, Bounds))
+		{
+			continue;
+		}
+
+		VisibleLights.push_back(LightData{
+			.Position = Light.Position,
+			.Intensity = Light.Intensity,
+			.Color = Light.Color,
+			.Falloff = Light.Falloff,
+			});
+		VisibleBounds.push_back(Bounds);
+
+		for (uint32_t z = Bounds.StartZ; z < Bounds.EndZ; z++)
+		{
+			for (uint32_t y = Bounds.StartY; y < Bounds.EndY; y++)
+			{
+				for (uint32_t x = Bounds.StartX; x < Bounds.EndX; x++)
+				{
+					Clusters[x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y].Count++;
+				}
+			}
+		}
+	}
+
+	// Give every cluster its range in the index list, then fill the ranges.
+	uint32_t NumIndices = 0;
+	for (ClusterRange& Cluster : Clusters)
+	{
+		Cluster.Offset = NumIndices;
+		NumIndices += Cluster.Count;
+		Cluster.Count = 0;
+	}
+	LightIndices.resize(NumIndices);
+
+	for (uint32_t i = 0; i < VisibleBounds.size(); i++)
+	{
+		const LightBounds& Bounds = VisibleBounds[i];
+		for (uint32_t z = Bounds.StartZ; z < Bounds.EndZ; z++)
+		{
+			for (uint32_t y = Bounds.StartY; y < Bounds.EndY; y++)
+			{
+				for (uint32_t x = Bounds.StartX; x < Bounds.EndX; x++)
+				{
+					ClusterRange& Cluster = Clusters[x + y * CLUSTERS_X + z * CLUSTERS_X * CLUSTERS_Y];
+					LightIndices[Cluster.Offset + Cluster.Count++] = i;
+				}
+			}
+		}
+	}
+
+	UploadBuffer(LightBuffer, LIGHTS_BINDING, VisibleLights.data(), VisibleLights.size() * sizeof(LightData));
+	UploadBuffer(ClusterBuffer, CLUSTERS_BINDING, Clusters.data(), Clusters.size() * sizeof(ClusterRange));
+	UploadBuffer(IndexBuffer, INDICES_BINDING, LightIndices.data(), LightIndices.size() * sizeof(uint32_t));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+#endif
@@ -0,0 +1,49 @@
+#if !SERVER
+#pragma once
+#include <vector>
+#include <Rendering/Graphics.h>
+
+class Camera;
+
+/**
+* @brief
+* Clustered point light culling.
+*
+* The view frustum is split into a grid of clusters, CLUSTERS_X * CLUSTERS_Y screen tiles with CLUSTERS_Z
+* exponentially distributed depth slices each. Every frame, each light is added to all clusters its range overlaps.
+* The lights, the light list of each cluster and the light indices are uploaded as shader storage buffers, so the
+* fragment shader only loops over the lights of the fragment's cluster. There is no limit on the number of lights.
+*
+* @ingroup Internal
+*/
+namespace LightClusters
+{
+	constexpr unsigned int CLUSTERS_X = 16;
+	constexpr unsigned int CLUSTERS_Y = 9;
+	constexpr unsigned int CLUSTERS_Z = 24;
+
+	/// Depth of the end of the last slice. Fragments further away use the last slice.
+	constexpr float MAX_DISTANCE = 1000.0f;
+
+	/// Shader storage buffer binding points of the light, cluster and light index buffers.
+	constexpr unsigned int LIGHTS_BINDING = 0;
+	constexpr unsigned int CLUSTERS_BINDING = 1;
+	constexpr unsigned int INDICES_BINDING = 2;
+
+	/**
+	* @brief
+	* Sorts the lights into the clusters of the camera's view and uploads the result.
+	*
+	* @param FramebufferCamera
+	* The camera of the framebuffer that is drawn.
+	*
+	* @param Lights
+	* All lights of the framebuffer.
+	*/
+	void Update(Camera* FramebufferCamera, const std::vector<Graphics::Light>& Lights);
+
+	/// Depth slice of a view depth is log(depth) * GetSliceScale() + GetSliceBias().
+	float GetSliceScale();
+	float GetSliceBias();
+}
+#endif
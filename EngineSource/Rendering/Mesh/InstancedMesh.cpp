@@ -45,11 +45,11 @@ void InstancedMesh::SimpleRender(Shader* UsedShader)
 	if (RenderContext.Mat.UseShadowCutout)
 	{
 		RenderContext.BindWithShader(UsedShader);
-		UsedShader->SetInt("u_useTexture", 1);
+		UsedShader->SetInt(Shader::Uniform::UseTexture, 1);
 	}
 	else
 	{
-		UsedShader->SetInt("u_useTexture", 0);
+		UsedShader->SetInt(Shader::Uniform::UseTexture, 0);
 	}
 	MeshVertexBuffer->Bind();
 	glDrawElementsInstanced(GL_TRIANGLES, NumIndices, GL_UNSIGNED_INT, 0, (int)Instances.size());
@@ -10,6 +10,7 @@
 #include <Engine/Stats.h>
 #include <GL/glew.h>
 #include <Engine/EngineError.h>
+#include <Rendering/RenderState.h>
 
 
 InstancedModel::InstancedModel(std::string Filename)
@@ -53,27 +54,13 @@ void InstancedModel::Render(Camera* WorldCamera, bool MainFrameBuffer, bool Tran
 		return;
 	}
 
-	if (TwoSided)
-	{
-		glDisable(GL_CULL_FACE);
-	}
-	else
-	{
-		glEnable(GL_CULL_FACE);
-	}
-	glm::mat4 ModelView;
-	ModelView = WorldCamera->getView() * MatModel[0];
-	glm::mat4 InvModelView = glm::transpose(glm::inverse(ModelView));
+	RenderState::SetCullFace(!TwoSided);
 	glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
 	for (int i = 0; i < Meshes.size(); i++)
 	{
 		if (Meshes[i]->RenderContext.Mat.IsTranslucent != TransparencyPass) continue;
 		Shader* CurrentShader = Meshes[i]->RenderContext.GetShader();
 		CurrentShader->Bind();
-		glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_projection"), 1, GL_FALSE, &WorldCamera->GetProjection()[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_invmodelview"), 1, GL_FALSE, &InvModelView[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_viewpro"), 1, GL_FALSE, &WorldCamera->GetViewProjection()[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_view"), 1, GL_FALSE, &WorldCamera->getView()[0][0]);
 		Meshes.at(i)->Render(CurrentShader, MainFrameBuffer);
 		Stats::DrawCalls++;
 	}
@@ -149,14 +136,7 @@ void InstancedModel::ConfigureVAO()
 void InstancedModel::SimpleRender(Shader* UsedShader)
 {
 	UsedShader->Bind();
-	if (TwoSided)
-	{
-		glDisable(GL_CULL_FACE);
-	}
-	else
-	{
-		glEnable(GL_CULL_FACE);
-	}
+	RenderState::SetCullFace(!TwoSided);
 	glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
 	for (InstancedMesh* m : Meshes)
 	{
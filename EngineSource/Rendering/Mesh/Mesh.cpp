@@ -16,16 +16,23 @@ Mesh::Mesh(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices, Mate
 	RenderContext = ObjectRenderContext(Mat);
 }
 
+Mesh::Mesh(const VertexBuffer* SharedBuffer, Material Mat)
+{
+	NumVertices = (int)SharedBuffer->Vertices.size();
+	NumIndices = (int)SharedBuffer->IndicesSize;
+	MeshVertexBuffer = new VertexBuffer(SharedBuffer);
+	RenderContext = ObjectRenderContext(Mat);
+}
+
 
 Mesh::~Mesh()
 {
 	delete MeshVertexBuffer;
 	RenderContext.Unload();
 }
-void Mesh::Render(Shader* UsedShader, bool MainFrameBuffer)
+void Mesh::Render(Shader* UsedShader, bool MainFrameBuffer, size_t NumInstances, size_t LOD)
 {
 	RenderContext.Bind();
-	MeshVertexBuffer->Bind();
 	if (MainFrameBuffer)
 	{
 		unsigned int attachements[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
@@ -36,25 +43,26 @@ void Mesh::Render(Shader* UsedShader, bool MainFrameBuffer)
 		unsigned int attachements[] = { GL_COLOR_ATTACHMENT0 };
 		glDrawBuffers(1, attachements);
 	}
-	MeshVertexBuffer->Draw();
+	MeshVertexBuffer->DrawInstanced(NumInstances, LOD);
 }
-void Mesh::SimpleRender(Shader* UsedShader)
+void Mesh::SimpleRender(Shader* UsedShader, size_t NumInstances, size_t LOD)
 {
 	UsedShader->Bind();
 	if (RenderContext.Mat.UseShadowCutout)
 	{
 		RenderContext.BindWithShader(UsedShader);
-		UsedShader->SetInt("u_useTexture", 1);
+		UsedShader->SetInt(Shader::Uniform::UseTexture, 1);
 	}
 	else
 	{
-		UsedShader->SetInt("u_useTexture", 0);
+		UsedShader->SetInt(Shader::Uniform::UseTexture, 0);
 	}
-	MeshVertexBuffer->Draw();
+	MeshVertexBuffer->DrawInstanced(NumInstances, LOD);
 }
 
 void Mesh::SetUniform(Material::Param NewUniform)
 {
+	HasUniformOverrides = true;
 	RenderContext.LoadUniform(NewUniform);
 }
 #endif
\ No newline at end of file
@@ -10,15 +10,19 @@ class Mesh
 {
 public:
 	Mesh(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices, Material Mat);
+	/// Creates a mesh using the vertex data of SharedBuffer. See VertexBuffer::VertexBuffer(const VertexBuffer*).
+	Mesh(const VertexBuffer* SharedBuffer, Material Mat);
 	~Mesh();
 
-	void Render(Shader* UsedShader, bool MainFrameBuffer);
-	void SimpleRender(Shader* UsedShader);
+	void Render(Shader* UsedShader, bool MainFrameBuffer, size_t NumInstances = 1, size_t LOD = 0);
+	void SimpleRender(Shader* UsedShader, size_t NumInstances = 1, size_t LOD = 0);
 
 	void SetUniform(Material::Param NewUniform);
 
 	ObjectRenderContext RenderContext;
 	VertexBuffer* MeshVertexBuffer = nullptr;
+	/// True if SetUniform() was used to change the material of this mesh, so it's different from other meshes with the same material.
+	bool HasUniformOverrides = false;
 protected:
 private:
 	int NumIndices;
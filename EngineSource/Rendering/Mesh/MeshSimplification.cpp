@@ -0,0 +1,359 @@
+#include "MeshSimplification.h"
+#include <unordered_map>
+#include <queue>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace MeshSimplification
+{
+	/// A symmetric 4x4 matrix measuring the weighted sum of squared distances of a point to a set of planes.
+	struct Quadric
+	{
+		double XX = 0, XY = 0, XZ = 0, XW = 0, YY = 0, YZ = 0, YW = 0, ZZ = 0, ZW = 0, WW = 0;
+		/// The sum of the weights of all planes.
+		double Weight = 0;
+
+		static Quadric FromPlane(glm::dvec3 Normal, double Distance, double Weight)
+		{
+			Quadric Q;
+			Q.XX = Normal.x * Normal.x * Weight;
+			Q.XY = Normal.x * Normal.y * Weight;
+			Q.XZ = Normal.x * Normal.z * Weight;
+			Q.XW = Normal.x * Distance * Weight;
+			Q.YY = Normal.y * Normal.y * Weight;
+			Q.YZ = Normal.y * Normal.z * Weight;
+			Q.YW = Normal.y * Distance * Weight;
+			Q.ZZ = Normal.z * Normal.z * Weight;
+			Q.ZW = Normal.z * Distance * Weight;
+			Q.WW = Distance * Distance * Weight;
+			Q.Weight = Weight;
+			return Q;
+		}
+
+		Quadric& operator+=(const Quadric& Other)
+		{
+			XX += Other.XX; XY += Other.XY; XZ += Other.XZ; XW += Other.XW;
+			YY += Other.YY; YZ += Other.YZ; YW += Other.YW;
+			ZZ += Other.ZZ; ZW += Other.ZW;
+			WW += Other.WW;
+			Weight += Other.Weight;
+			return *this;
+		}
+
+		double Evaluate(glm::dvec3 p) const
+		{
+			return XX * p.x * p.x + 2 * XY * p.x * p.y + 2 * XZ * p.x * p.z + 2 * XW * p.x
+				+ YY * p.y * p.y + 2 * YZ * p.y * p.z + 2 * YW * p.y
+				+ ZZ * p.z * p.z + 2 * ZW * p.z
+				+ WW;
+		}
+
+		/// The weighted mean of the squared distances of the point to the planes.
+		double EvaluateMean(glm::dvec3 p) const
+		{
+			return Weight > 0 ? Evaluate(p) / Weight : 0;
+		}
+	};
+
+	struct Collapse
+	{
+		double Cost = 0;
+		/// The vertex that is removed.
+		uint32_t From = 0;
+		/// The vertex From is merged into.
+		uint32_t To = 0;
+		/// The versions of both vertices when the collapse was created. If either vertex changed since then, the collapse is outdated.
+		uint32_t FromVersion = 0;
+		uint32_t ToVersion = 0;
+
+		bool operator>(const Collapse& Other) const
+		{
+			return Cost > Other.Cost;
+		}
+	};
+
+	struct PositionKey
+	{
+		uint32_t X, Y, Z;
+		bool operator==(const PositionKey& Other) const
+		{
+			return X == Other.X && Y == Other.Y && Z == Other.Z;
+		}
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& Key) const
+		{
+			return (size_t)Key.X * 73856093u ^ (size_t)Key.Y * 19349663u ^ (size_t)Key.Z * 83492791u;
+		}
+	};
+
+	static PositionKey GetPositionKey(const glm::vec3& Position)
+	{
+		PositionKey Key;
+		std::memcpy(&Key.X, &Position.x, sizeof(float));
+		std::memcpy(&Key.Y, &Position.y, sizeof(float));
+		std::memcpy(&Key.Z, &Position.z, sizeof(float));
+		return Key;
+	}
+
+	// Vertices that must not be moved: Vertices on the border of the mesh, and vertices sharing their position with other vertices.
+	static std::vector<bool> FindLockedVertices(const std::vector<Vertex>& Vertices, const std::vector<unsigned int>& Indices)
+	{
+		std::vector<bool> Locked = std::vector<bool>(Vertices.size(), false);
+
+		// Vertices with the same position are treated as one vertex to find the border, so seams aren't seen as borders.
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> FirstAtPosition;
+		std::vector<uint32_t> PositionIDs = std::vector<uint32_t>(Vertices.size());
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			auto Inserted = FirstAtPosition.insert({ GetPositionKey(Vertices[i].Position), i });
+			PositionIDs[i] = Inserted.first->second;
+			if (!Inserted.second)
+			{
+				Locked[i] = true;
+				Locked[Inserted.first->second] = true;
+			}
+		}
+
+		// An edge is on the border if there's no triangle using it in the opposite direction.
+		std::unordered_map<uint64_t, int> DirectedEdges;
+		DirectedEdges.reserve(Indices.size());
+		auto EdgeKey = [](uint32_t A, uint32_t B) { return (uint64_t(A) << 32) | B; };
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				DirectedEdges[EdgeKey(PositionIDs[Indices[i + j]], PositionIDs[Indices[i + (j + 1) % 3]])]++;
+			}
+		}
+		for (size_t i = 0; i < Indices.size(); i += 3)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				unsigned int A = Indices[i + j], B = Indices[i + (j + 1) % 3];
+				if (!DirectedEdges.contains(EdgeKey(PositionIDs[B], PositionIDs[A])))
+				{
+					Locked[A] = true;
+					Locked[B] = true;
+				}
+			}
+		}
+		return Locked;
+	}
+
+	std::vector<unsigned int> Simplify(const std::vector<Vertex>& Vertices, const std::vector<unsigned int>& Indices,
+		size_t TargetIndexCount, float MaxError)
+	{
+		const size_t NumTriangles = Indices.size() / 3;
+		std::vector<unsigned int> Triangles = std::vector<unsigned int>(Indices.begin(), Indices.begin() + NumTriangles * 3);
+		if (Triangles.size() <= TargetIndexCount)
+		{
+			return Triangles;
+		}
+
+		const std::vector<bool> Locked = FindLockedVertices(Vertices, Triangles);
+
+		std::vector<Quadric> Quadrics = std::vector<Quadric>(Vertices.size());
+		std::vector<std::vector<uint32_t>> VertexTriangles = std::vector<std::vector<uint32_t>>(Vertices.size());
+		for (uint32_t t = 0; t < NumTriangles; t++)
+		{
+			glm::dvec3 A = glm::dvec3(Vertices[Triangles[t * 3]].Position);
+			glm::dvec3 B = glm::dvec3(Vertices[Triangles[t * 3 + 1]].Position);
+			glm::dvec3 C = glm::dvec3(Vertices[Triangles[t * 3 + 2]].Position);
+			glm::dvec3 Normal = glm::cross(B - A, C - A);
+			double Area = glm::length(Normal);
+			if (Area > 0)
+			{
+				Normal /= Area;
+				// Weighting by area makes the error independent of how finely the surface is tesselated.
+				Quadric Plane = Quadric::FromPlane(Normal, -glm::dot(Normal, A), Area * 0.5);
+				for (int j = 0; j < 3; j++)
+				{
+					Quadrics[Triangles[t * 3 + j]] += Plane;
+				}
+			}
+			for (int j = 0; j < 3; j++)
+			{
+				VertexTriangles[Triangles[t * 3 + j]].push_back(t);
+			}
+		}
+
+		std::vector<bool> TriangleRemoved = std::vector<bool>(NumTriangles, false);
+		std::vector<bool> VertexRemoved = std::vector<bool>(Vertices.size(), false);
+		std::vector<uint32_t> Versions = std::vector<uint32_t>(Vertices.size(), 0);
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> Collapses;
+
+		auto AddCollapse = [&](uint32_t From, uint32_t To)
+			{
+				if (Locked[From])
+				{
+					return;
+				}
+				Quadric Combined = Quadrics[From];
+				Combined += Quadrics[To];
+				Collapse New;
+				// Dividing by the area gives a squared distance, so the cost scales with the mesh like MaxError does.
+				New.Cost = Combined.EvaluateMean(glm::dvec3(Vertices[To].Position));
+				New.From = From;
+				New.To = To;
+				New.FromVersion = Versions[From];
+				New.ToVersion = Versions[To];
+				Collapses.push(New);
+			};
+
+		for (uint32_t t = 0; t < NumTriangles; t++)
+		{
+			for (int j = 0; j < 3; j++)
+			{
+				uint32_t A = Triangles[t * 3 + j], B = Triangles[t * 3 + (j + 1) % 3];
+				AddCollapse(A, B);
+				AddCollapse(B, A);
+			}
+		}
+
+		std::vector<uint32_t> FromNeighbors, ToNeighbors;
+		auto CollectNeighbors = [&](uint32_t Vertex, std::vector<uint32_t>& Out)
+			{
+				Out.clear();
+				for (uint32_t t : VertexTriangles[Vertex])
+				{
+					if (TriangleRemoved[t])
+					{
+						continue;
+					}
+					for (int j = 0; j < 3; j++)
+					{
+						uint32_t Other = Triangles[t * 3 + j];
+						if (Other != Vertex && std::find(Out.begin(), Out.end(), Other) == Out.end())
+						{
+							Out.push_back(Other);
+						}
+					}
+				}
+			};
+
+		size_t IndexCount = Triangles.size();
+		while (IndexCount > TargetIndexCount && !Collapses.empty())
+		{
+			Collapse Next = Collapses.top();
+			Collapses.pop();
+			if (VertexRemoved[Next.From] || VertexRemoved[Next.To]
+				|| Versions[Next.From] != Next.FromVersion || Versions[Next.To] != Next.ToVersion)
+			{
+				continue;
+			}
+			if (Next.Cost > MaxError)
+			{
+				break;
+			}
+
+			// The vertices must only share the triangles along the collapsed edge,
+			// otherwise the collapse would create a non manifold mesh.
+			CollectNeighbors(Next.From, FromNeighbors);
+			CollectNeighbors(Next.To, ToNeighbors);
+			if (std::find(FromNeighbors.begin(), FromNeighbors.end(), Next.To) == FromNeighbors.end())
+			{
+				continue;
+			}
+			size_t SharedNeighbors = 0;
+			for (uint32_t i : FromNeighbors)
+			{
+				if (std::find(ToNeighbors.begin(), ToNeighbors.end(), i) != ToNeighbors.end())
+				{
+					SharedNeighbors++;
+				}
+			}
+			size_t SharedTriangles = 0;
+			bool FlipsTriangle = false;
+			for (uint32_t t : VertexTriangles[Next.From])
+			{
+				if (TriangleRemoved[t])
+				{
+					continue;
+				}
+				const unsigned int* Triangle = &Triangles[t * 3];
+				if (Triangle[0] == Next.To || Triangle[1] == Next.To || Triangle[2] == Next.To)
+				{
+					SharedTriangles++;
+					continue;
+				}
+				// Triangles that stay must not be flipped by moving the vertex.
+				glm::vec3 Before[3], After[3];
+				for (int j = 0; j < 3; j++)
+				{
+					Before[j] = Vertices[Triangle[j]].Position;
+					After[j] = Triangle[j] == Next.From ? Vertices[Next.To].Position : Before[j];
+				}
+				glm::vec3 NormalBefore = glm::cross(Before[1] - Before[0], Before[2] - Before[0]);
+				glm::vec3 NormalAfter = glm::cross(After[1] - After[0], After[2] - After[0]);
+				if (glm::dot(NormalBefore, NormalAfter) <= 0)
+				{
+					FlipsTriangle = true;
+					break;
+				}
+			}
+			if (FlipsTriangle || SharedNeighbors != SharedTriangles)
+			{
+				continue;
+			}
+
+			for (uint32_t t : VertexTriangles[Next.From])
+			{
+				if (TriangleRemoved[t])
+				{
+					continue;
+				}
+				unsigned int* Triangle = &Triangles[t * 3];
+				if (Triangle[0] == Next.To || Triangle[1] == Next.To || Triangle[2] == Next.To)
+				{
+					TriangleRemoved[t] = true;
+					IndexCount -= 3;
+					continue;
+				}
+				for (int j = 0; j < 3; j++)
+				{
+					if (Triangle[j] == Next.From)
+					{
+						Triangle[j] = Next.To;
+					}
+				}
+				VertexTriangles[Next.To].push_back(t);
+			}
+			VertexRemoved[Next.From] = true;
+			VertexTriangles[Next.From].clear();
+			Quadrics[Next.To] += Quadrics[Next.From];
+			Versions[Next.To]++;
+
+			// Removed triangles are taken out of the list here, so it doesn't keep growing.
+			std::vector<uint32_t>& ToTriangles = VertexTriangles[Next.To];
+			std::erase_if(ToTriangles, [&](uint32_t t) { return TriangleRemoved[t]; });
+			for (uint32_t t : ToTriangles)
+			{
+				for (int j = 0; j < 3; j++)
+				{
+					uint32_t Other = Triangles[t * 3 + j];
+					if (Other != Next.To)
+					{
+						AddCollapse(Next.To, Other);
+						AddCollapse(Other, Next.To);
+					}
+				}
+			}
+		}
+
+		std::vector<unsigned int> Result;
+		Result.reserve(IndexCount);
+		for (size_t t = 0; t < NumTriangles; t++)
+		{
+			if (!TriangleRemoved[t])
+			{
+				Result.insert(Result.end(), Triangles.begin() + t * 3, Triangles.begin() + t * 3 + 3);
+			}
+		}
+		return Result;
+	}
+}
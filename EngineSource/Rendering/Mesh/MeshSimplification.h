@@ -0,0 +1,45 @@
+#pragma once
+#include <vector>
+#include <Rendering/Vertex.h>
+
+/**
+* @file
+* @brief
+* Functions for reducing the number of triangles in a mesh.
+*/
+
+/**
+* @brief
+* Mesh simplification using quadric error metrics ("Surface Simplification Using Quadric Error Metrics", Garland and Heckbert).
+*
+* Edges are collapsed into one of their vertices, starting with the edge that changes the surface the least.
+* Because no new vertices are created, the simplified mesh can use the same vertex buffer as the original mesh.
+*
+* Vertices on the border of the mesh and on seams (vertices with the same position, but different normals or texture coordinates)
+* are never moved, so the outline and texture mapping of the mesh are kept.
+*/
+namespace MeshSimplification
+{
+	/**
+	* @brief
+	* Simplifies the given triangles.
+	*
+	* @param Vertices
+	* The vertices of the mesh.
+	*
+	* @param Indices
+	* The triangles to simplify. Indices into Vertices.
+	*
+	* @param TargetIndexCount
+	* The number of indices the simplified mesh should have. It might have more if simplifying it further would exceed MaxError.
+	*
+	* @param MaxError
+	* The largest allowed error of a single edge collapse, as a squared distance. The error of a collapse is the mean squared distance
+	* of the new vertex position to the planes of the original triangles around both vertices, weighted by the triangle areas.
+	*
+	* @return
+	* The indices of the simplified mesh, using the same vertices.
+	*/
+	std::vector<unsigned int> Simplify(const std::vector<Vertex>& Vertices, const std::vector<unsigned int>& Indices,
+		size_t TargetIndexCount, float MaxError);
+}
@@ -4,6 +4,8 @@
 #include <fstream>
 #include <vector>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 #include "Rendering/Camera/Camera.h"
 #include <filesystem>
 #include <Rendering/ShaderManager.h>
@@ -14,61 +16,50 @@
 #include <GL/glew.h>
 #include <Rendering/Texture/Material.h>
 #include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Mesh/ModelCache.h>
 #include <Engine/Application.h>
 #include <Rendering/RenderSubsystem/OcclusionCulling.h>
+#include <Rendering/RenderState.h>
 
-Model::Model(std::string Filename)
+Model::Model(std::string Filename, const std::vector<std::string>& Materials)
 {
-	if (std::filesystem::exists(Filename))
+	SharedData = ModelCache::Load(Filename);
+	if (!SharedData)
 	{
-		ModelMeshData.LoadModelFromFile(Filename);
-		CastShadow = ModelMeshData.CastShadow;
-		TwoSided = ModelMeshData.TwoSided;
-		size_t NumVerts = 0;
-		for (size_t i = 0; i < ModelMeshData.Elements.size(); i++)
-		{
-			Mesh* NewMesh = new Mesh(ModelMeshData.Elements[i].Vertices, ModelMeshData.Elements[i].Indices, 
-				Material::LoadMaterialFile(ModelMeshData.Elements[i].ElemMaterial));
-			Meshes.push_back(NewMesh);
-		}
-		ShouldCull = NumVerts > 100;
-		HasCollision = ModelMeshData.HasCollision;
-		NonScaledSize = ModelMeshData.CollisionBox.GetLength();
-		ModelMeshData.MakeCollisionBox();
-		Vector3 Extent = ModelMeshData.CollisionBox.GetExtent() * 0.025f * 0.5f;
-		Size = FrustumCulling::AABB(ModelMeshData.CollisionBox.GetCenter() * 0.025f, Extent.X, Extent.Y, Extent.Z);
-		ConfigureVAO();
+		Log::Print("Model does not exist: " + Filename);
+		return;
 	}
-	else
+	for (size_t i = 0; i < SharedData->Data.Elements.size(); i++)
 	{
-		Log::Print("Model does not exist: " + Filename);
+		std::string MaterialName = SharedData->Data.Elements[i].ElemMaterial;
+		if (i < Materials.size() && !Materials[i].empty())
+		{
+			MaterialName = Materials[i];
+		}
+		Mesh* NewMesh = new Mesh(SharedData->Buffers[i], Material::LoadMaterialFile(MaterialName));
+		Meshes.push_back(NewMesh);
 	}
+	LoadSharedData();
 }
 
 Model::Model(ModelGenerator::ModelData Data)
 {
-	ModelMeshData = Data;
-	CastShadow = Data.CastShadow;
-	TwoSided = Data.TwoSided;
+	SharedData = ModelCache::Create(std::move(Data));
 	size_t NumVerts = 0;
-	for (auto& i : Data.Elements)
+	for (size_t i = 0; i < SharedData->Data.Elements.size(); i++)
 	{
+		const auto& Elem = SharedData->Data.Elements[i];
 		Material mat;
-		if (!i.ElemMaterial.empty())
+		if (!Elem.ElemMaterial.empty())
 		{
-			mat = Material::LoadMaterialFile(i.ElemMaterial);
+			mat = Material::LoadMaterialFile(Elem.ElemMaterial);
 		}
-		Mesh* NewMesh = new Mesh(i.Vertices, i.Indices, mat);
-		NumVerts += i.Vertices.size();
+		Mesh* NewMesh = new Mesh(SharedData->Buffers[i], mat);
+		NumVerts += Elem.Vertices.size();
 		Meshes.push_back(NewMesh);
 	}
 	ShouldCull = NumVerts > 100;
-	HasCollision = Data.HasCollision;
-	NonScaledSize = Data.CollisionBox.GetLength();
-	ModelMeshData.MakeCollisionBox();
-	Vector3 Extent = ModelMeshData.CollisionBox.GetExtent() * 0.025f * 0.5f;
-	Size = FrustumCulling::AABB(ModelMeshData.CollisionBox.GetCenter() * 0.025f, Extent.X, Extent.Y, Extent.Z);
-	ConfigureVAO();
+	LoadSharedData();
 }
 
 
@@ -78,6 +69,7 @@ Model::~Model()
 	{
 		delete m;
 	}
+	ModelCache::Release(SharedData);
 	glDeleteBuffers(1, &MatBuffer);
 	if (RunningQuery)
 	{
@@ -86,24 +78,89 @@ Model::~Model()
 	}
 }
 
+const ModelGenerator::ModelData& Model::GetModelData() const
+{
+	static const ModelGenerator::ModelData EmptyModelData;
+	return SharedData ? SharedData->Data : EmptyModelData;
+}
+
+void Model::LoadSharedData()
+{
+	const ModelGenerator::ModelData& Data = SharedData->Data;
+	CastShadow = Data.CastShadow;
+	TwoSided = Data.TwoSided;
+	HasCollision = Data.HasCollision;
+	NonScaledSize = SharedData->NonScaledSize;
+	Vector3 Extent = Data.CollisionBox.GetExtent() * 0.025f * 0.5f;
+	Size = FrustumCulling::AABB(Data.CollisionBox.GetCenter() * 0.025f, Extent.X, Extent.Y, Extent.Z);
+	ConfigureVAO();
+}
+
+bool Model::GetWorldBounds(FrustumCulling::AABB& Bounds) const
+{
+	if (!SharedData)
+	{
+		return false;
+	}
+	// Size is already scaled by the 0.025 that MatModel also contains.
+	glm::vec3 LocalCenter = Size.center / 0.025f;
+	glm::vec3 LocalExtents = Size.extents / 0.025f;
+	Bounds.center = glm::vec3(MatModel * glm::vec4(LocalCenter, 1));
+	for (int i = 0; i < 3; i++)
+	{
+		Bounds.extents[i] = std::abs(MatModel[0][i]) * LocalExtents.x
+			+ std::abs(MatModel[1][i]) * LocalExtents.y
+			+ std::abs(MatModel[2][i]) * LocalExtents.z;
+	}
+	return true;
+}
+
+bool Model::IsShadowCaster() const
+{
+	return CastShadow && IsShadowVisible();
+}
+
+bool Model::IsVisible() const
+{
+	return Visible;
+}
+
+bool Model::IsShadowVisible() const
+{
+	return Visible;
+}
+
+uint8_t Model::GetLOD(const Camera* WorldCamera, bool ShadowPass) const
+{
+	// The size on the screen (as a fraction of half the screen height) below which the first lower level is used.
+	constexpr float LOD_SCREEN_SIZE = 0.5f;
+	constexpr float MAX_LOD = 8;
+
+	if (!WorldCamera)
+	{
+		return 0;
+	}
+
+	float Radius = (Vector3(Size.extents) * ModelTransform.Scale).Length();
+	float Distance = Vector3::Distance(WorldCamera->Position, ModelTransform.Position);
+	// The camera's FOV is twice the vertical field of view.
+	float ScreenSize = Radius / std::max(Distance * std::tan(WorldCamera->FOV / 4), 0.001f);
+	if (ScreenSize <= 0)
+	{
+		return 0;
+	}
+
+	float LOD = std::log2(LOD_SCREEN_SIZE / ScreenSize) + Graphics::LODBias + (ShadowPass ? 1 : 0);
+	return (uint8_t)std::clamp(std::floor(LOD), 0.0f, MAX_LOD);
+}
+
 void Model::Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyPass)
 {
-	if (Visible
-		&& (Size.isOnFrustum(FrustumCulling::CurrentCameraFrustum, ModelTransform.Position, ModelTransform.Scale * NonScaledSize * 0.02f)
-			|| !MainFrameBuffer))
+	if (IsVisible())
 	{
-		if (TwoSided)
-		{
-			glDisable(GL_CULL_FACE);
-		}
-		else
-		{
-			glEnable(GL_CULL_FACE);
-		}
-		glm::mat4 ModelView;
+		uint8_t LOD = GetLOD(WorldCamera, false);
+		RenderState::SetCullFace(!TwoSided);
 		ModelViewProjection = WorldCamera->GetViewProjection() * MatModel;
-		ModelView = WorldCamera->getView() * MatModel;
-		glm::mat4 InvModelView = glm::transpose(glm::inverse(ModelView));
 		glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
 
 		for (int i = 0; i < Meshes.size(); i++)
@@ -111,11 +168,7 @@ void Model::Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyP
 			if (Meshes[i]->RenderContext.Mat.IsTranslucent != TransparencyPass) continue;
 			Shader* CurrentShader = Meshes[i]->RenderContext.GetShader();
 			CurrentShader->Bind();
-			glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_projection"), 1, GL_FALSE, &WorldCamera->GetProjection()[0][0]);
-			glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_invmodelview"), 1, GL_FALSE, &InvModelView[0][0]);
-			glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_viewpro"), 1, GL_FALSE, &WorldCamera->GetViewProjection()[0][0]);
-			glUniformMatrix4fv(glGetUniformLocation(CurrentShader->GetShaderID(), "u_view"), 1, GL_FALSE, &WorldCamera->getView()[0][0]);
-			Meshes.at(i)->Render(CurrentShader, MainFrameBuffer);
+			Meshes.at(i)->Render(CurrentShader, MainFrameBuffer, 1, LOD);
 			Stats::DrawCalls++;
 		}
 	}
@@ -123,54 +176,34 @@ void Model::Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyP
 
 void Model::ConfigureVAO()
 {
+	// The vertex arrays of the meshes already read from the buffer if it exists, so only its content needs to be updated.
 	if (MatBuffer != -1)
-		glDeleteBuffers(1, &MatBuffer);
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(glm::mat4), &MatModel);
+		return;
+	}
 	glGenBuffers(1, &MatBuffer);
 	glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
-	glBufferData(GL_ARRAY_BUFFER, 1 * sizeof(glm::mat4), &MatModel, GL_STATIC_DRAW);
-	for (int i = 0; i < Meshes.size(); i++)
+	glBufferData(GL_ARRAY_BUFFER, 1 * sizeof(glm::mat4), &MatModel, GL_DYNAMIC_DRAW);
+	for (Mesh* m : Meshes)
 	{
-		unsigned int VAO = Meshes[i]->MeshVertexBuffer->VAO;
-		glBindVertexArray(VAO);
-		// vertex attributes
-		std::size_t vec4Size = sizeof(glm::vec4);
-		glEnableVertexAttribArray(4);
-		glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 4 * (GLsizei)vec4Size, (void*)0);
-		glEnableVertexAttribArray(5);
-		glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, 4 * (GLsizei)vec4Size, (void*)(1 * vec4Size));
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, 4 * (GLsizei)vec4Size, (void*)(2 * vec4Size));
-		glEnableVertexAttribArray(7);
-		glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, 4 * (GLsizei)vec4Size, (void*)(3 * vec4Size));
-
-		glVertexAttribDivisor(4, 1);
-		glVertexAttribDivisor(5, 1);
-		glVertexAttribDivisor(6, 1);
-		glVertexAttribDivisor(7, 1);
-
-		glBindVertexArray(0);
+		m->MeshVertexBuffer->SetInstanceTransforms(MatBuffer);
 	}
 }
 
 void Model::SimpleRender(Shader* UsedShader)
 {
-	if (!Visible) return;
-	if (Size.isOnFrustum(FrustumCulling::CurrentCameraFrustum, ModelTransform.Position, ModelTransform.Scale * NonScaledSize * 0.025f))
+	if (IsShadowVisible())
 	{
 		UsedShader->Bind();
-		if (TwoSided)
-		{
-			glDisable(GL_CULL_FACE);
-		}
-		else
-		{
-			glEnable(GL_CULL_FACE);
-		}
-		glUniformMatrix4fv(glGetUniformLocation(UsedShader->GetShaderID(), "u_model"), 1, GL_FALSE, &MatModel[0][0]);
+		RenderState::SetCullFace(!TwoSided);
+		UsedShader->SetMat4(Shader::Uniform::Model, MatModel);
+		uint8_t LOD = GetLOD(Graphics::MainCamera, true);
 		for (Mesh* m : Meshes)
 		{
 			if (m->RenderContext.Mat.IsTranslucent) continue;
-			m->SimpleRender(UsedShader);
+			m->SimpleRender(UsedShader, 1, LOD);
 			Stats::DrawCalls++;
 		}
 	}
@@ -11,10 +11,22 @@
 #if !SERVER
 class Mesh;
 
+namespace ModelCache
+{
+	struct CachedModel;
+}
+
 class Model : public Drawable
 {
 public:
-	Model(std::string Filename);
+	/**
+	* @brief
+	* Loads a model file. The file is shared with all other models using it, see ModelCache.
+	*
+	* @param Materials
+	* Materials used instead of the ones defined in the file, one for each element of the model. Empty names use the material from the file.
+	*/
+	Model(std::string Filename, const std::vector<std::string>& Materials = {});
 
 	Model(ModelGenerator::ModelData Data);
 
@@ -62,6 +74,33 @@ public:
 	void ConfigureVAO();
 
 	virtual void SimpleRender(Shader* UsedShader) override;
+
+	/// The bounding box of the model transformed by MatModel.
+	virtual bool GetWorldBounds(FrustumCulling::AABB& Bounds) const override;
+	virtual bool IsShadowCaster() const override;
+
+	/**
+	* @brief
+	* True if the model should be drawn in the main pass of a framebuffer.
+	*
+	* Frustum culling isn't done here. The framebuffer only draws the models that CullingBVH found to be visible.
+	*/
+	bool IsVisible() const;
+	/// True if the model should be drawn into the shadow maps.
+	bool IsShadowVisible() const;
+
+	/**
+	* @brief
+	* Chooses the level of detail to draw this model with, based on its size on the screen.
+	*
+	* Each level is chosen when the model's size on the screen is half of the size at which the level before was chosen.
+	* The result is offset by Graphics::LODBias. Shadows are drawn one level lower than the model itself.
+	*
+	* @return
+	* The level of detail, 0 being the full mesh. Meshes that have fewer levels draw their lowest level.
+	*/
+	uint8_t GetLOD(const Camera* WorldCamera, bool ShadowPass) const;
+
 	glm::mat4 MatModel = glm::mat4(1.f);
 	Vector3 ModelCenter;
 	Transform ModelTransform;
@@ -76,10 +115,16 @@ public:
 	bool Visible = true;
 
 	unsigned int MatBuffer = -1;
+	/// The meshes of this model. The vertex data is shared with all other models using the same file, the materials are not.
 	std::vector<Mesh*> Meshes;
-	ModelGenerator::ModelData ModelMeshData;
+
+	/// The model data of this model. Shared with all other models using the same file.
+	const ModelGenerator::ModelData& GetModelData() const;
 protected:
 	glm::mat4 ModelViewProjection = glm::mat4(1);
 	float NonScaledSize = 1;
+	ModelCache::CachedModel* SharedData = nullptr;
+private:
+	void LoadSharedData();
 };
 #endif
\ No newline at end of file
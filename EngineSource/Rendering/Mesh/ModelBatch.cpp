@@ -0,0 +1,250 @@
+#if !SERVER
+#include "ModelBatch.h"
+#include <GL/glew.h>
+#include <Rendering/Mesh/Model.h>
+#include <Rendering/Mesh/Mesh.h>
+#include <Rendering/Camera/Camera.h>
+#include <Rendering/Shader.h>
+#include <Rendering/RenderState.h>
+#include <Engine/Stats.h>
+#include <algorithm>
+#include <bit>
+
+bool ModelBatch::Active = true;
+
+bool ModelBatch::GroupKey::operator==(const GroupKey& Other) const
+{
+	return VertexData == Other.VertexData
+		&& TwoSided == Other.TwoSided
+		&& LOD == Other.LOD
+		&& UniqueMesh == Other.UniqueMesh
+		&& Material == Other.Material;
+}
+
+size_t ModelBatch::GroupKeyHash::operator()(const GroupKey& Key) const
+{
+	size_t Hash = std::hash<std::string>()(Key.Material);
+	Hash ^= std::hash<unsigned int>()(Key.VertexData) + 0x9e3779b9 + (Hash << 6) + (Hash >> 2);
+	Hash ^= std::hash<const Mesh*>()(Key.UniqueMesh) + 0x9e3779b9 + (Hash << 6) + (Hash >> 2);
+	return Hash ^ ((size_t)Key.TwoSided | ((size_t)Key.LOD << 1));
+}
+
+ModelBatch::ModelBatch()
+{
+	glGenBuffers(1, &TransformBuffer);
+}
+
+ModelBatch::~ModelBatch()
+{
+	glDeleteBuffers(1, &TransformBuffer);
+}
+
+void ModelBatch::Clear()
+{
+	GroupIndices.clear();
+	MaterialIndices.clear();
+	NumMaterials = 0;
+	Groups.clear();
+	UploadedTransforms = false;
+}
+
+void ModelBatch::Add(Model* NewModel, uint8_t LOD, MeshFilter Filter)
+{
+	for (Mesh* m : NewModel->Meshes)
+	{
+		if (Filter != MeshFilter::All && m->RenderContext.Mat.IsTranslucent != (Filter == MeshFilter::Translucent))
+		{
+			continue;
+		}
+
+		GroupKey Key;
+		Key.VertexData = m->MeshVertexBuffer->VBO;
+		Key.TwoSided = NewModel->TwoSided;
+		Key.LOD = LOD;
+		Key.Material = m->RenderContext.Mat.Name;
+		// Meshes with changed uniforms or a material that doesn't come from a file can't be compared by the material name.
+		const bool UniqueMaterial = m->HasUniformOverrides || Key.Material.empty();
+		// Translucent meshes have to be drawn back to front, so each of them is sorted on its own instead of being instanced.
+		if (UniqueMaterial || m->RenderContext.Mat.IsTranslucent)
+		{
+			Key.UniqueMesh = m;
+		}
+
+		auto Found = GroupIndices.find(Key);
+		if (Found != GroupIndices.end())
+		{
+			Groups[Found->second].Transforms.push_back(NewModel->MatModel);
+			continue;
+		}
+
+		Group NewGroup;
+		NewGroup.FirstMesh = m;
+		NewGroup.FirstModel = NewModel;
+		NewGroup.TwoSided = NewModel->TwoSided;
+		NewGroup.LOD = LOD;
+		if (UniqueMaterial)
+		{
+			NewGroup.MaterialIndex = NumMaterials++;
+		}
+		else
+		{
+			auto FoundMaterial = MaterialIndices.find(Key.Material);
+			if (FoundMaterial == MaterialIndices.end())
+			{
+				FoundMaterial = MaterialIndices.insert({ Key.Material, NumMaterials++ }).first;
+			}
+			NewGroup.MaterialIndex = FoundMaterial->second;
+		}
+		NewGroup.Transforms.push_back(NewModel->MatModel);
+		GroupIndices.insert({ Key, Groups.size() });
+		Groups.push_back(std::move(NewGroup));
+	}
+}
+
+void ModelBatch::UploadTransforms()
+{
+	if (UploadedTransforms)
+	{
+		return;
+	}
+	UploadedTransforms = true;
+
+	size_t BufferSize = 0;
+	for (Group& g : Groups)
+	{
+		// Groups with a single model use the transform buffer of that model.
+		if (g.Transforms.size() > 1)
+		{
+			g.BufferOffset = BufferSize;
+			BufferSize += g.Transforms.size() * sizeof(glm::mat4);
+		}
+	}
+
+	if (BufferSize == 0)
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, TransformBuffer);
+	glBufferData(GL_ARRAY_BUFFER, BufferSize, nullptr, GL_STREAM_DRAW);
+	for (const Group& g : Groups)
+	{
+		if (g.Transforms.size() > 1)
+		{
+			glBufferSubData(GL_ARRAY_BUFFER, g.BufferOffset, g.Transforms.size() * sizeof(glm::mat4), g.Transforms.data());
+		}
+	}
+}
+
+uint64_t ModelBatch::GetSortKey(const Group& DrawnGroup, bool Translucent, float Depth)
+{
+	// The bits of a positive float sort like the float itself. The upper 20 bits are precise enough for sorting.
+	const uint64_t DepthBits = std::bit_cast<uint32_t>(std::max(Depth, 0.0f)) >> 11;
+	const uint64_t ShaderBits = DrawnGroup.FirstMesh->RenderContext.GetShader()->GetShaderID() & 0xFFF;
+	const uint64_t MaterialBits = DrawnGroup.MaterialIndex;
+	const uint64_t VertexArrayBits = DrawnGroup.FirstMesh->MeshVertexBuffer->VAO & 0x7FFF;
+
+	if (Translucent)
+	{
+		// 1 | depth (inverted, 20 bits) | shader (12 bits) | material (16 bits) | vertex array (15 bits)
+		return (uint64_t(1) << 63) | ((~DepthBits & 0xFFFFF) << 43) | (ShaderBits << 31) | (MaterialBits << 15) | VertexArrayBits;
+	}
+	// 0 | shader (12 bits) | material (16 bits) | vertex array (15 bits) | depth (20 bits)
+	return (ShaderBits << 51) | (MaterialBits << 35) | (VertexArrayBits << 20) | DepthBits;
+}
+
+void ModelBatch::SetCullFace(const Group& DrawnGroup)
+{
+	RenderState::SetCullFace(!DrawnGroup.TwoSided);
+}
+
+void ModelBatch::DrawGroup(Group& DrawnGroup, Shader* UsedShader, bool Simple)
+{
+	VertexBuffer* Buffer = DrawnGroup.FirstMesh->MeshVertexBuffer;
+	const size_t NumInstances = DrawnGroup.Transforms.size();
+
+	// The vertex array of the first mesh is used to draw all instances, so it has to read the transforms
+	// from the batch's buffer instead of the model's buffer while the group is drawn.
+	if (NumInstances > 1)
+	{
+		Buffer->SetInstanceTransforms(TransformBuffer, DrawnGroup.BufferOffset);
+	}
+
+	if (Simple)
+	{
+		DrawnGroup.FirstMesh->SimpleRender(UsedShader, NumInstances, DrawnGroup.LOD);
+	}
+	else
+	{
+		// The material has already been bound by Render().
+		Buffer->DrawInstanced(NumInstances, DrawnGroup.LOD);
+	}
+	Stats::DrawCalls++;
+
+	if (NumInstances > 1)
+	{
+		Buffer->SetInstanceTransforms(DrawnGroup.FirstModel->MatBuffer);
+	}
+}
+
+void ModelBatch::Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyPass)
+{
+	UploadTransforms();
+
+	const glm::mat4 View = WorldCamera->getView();
+	Queue.clear();
+	for (size_t i = 0; i < Groups.size(); i++)
+	{
+		const Group& g = Groups[i];
+		if (g.FirstMesh->RenderContext.Mat.IsTranslucent != TransparencyPass) continue;
+		// Groups are sorted by the depth of their first instance. Translucent groups only have one.
+		float Depth = -(View * g.Transforms[0][3]).z;
+		Queue.push_back(DrawItem{ GetSortKey(g, TransparencyPass, Depth), i });
+	}
+	std::sort(Queue.begin(), Queue.end(), [](const DrawItem& a, const DrawItem& b)
+		{
+			return a.SortKey < b.SortKey;
+		});
+
+	if (MainFrameBuffer)
+	{
+		unsigned int attachements[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+		glDrawBuffers(3, attachements);
+	}
+	else
+	{
+		unsigned int attachements[] = { GL_COLOR_ATTACHMENT0 };
+		glDrawBuffers(1, attachements);
+	}
+
+	Shader* BoundShader = nullptr;
+	uint16_t BoundMaterial = 0;
+	for (const DrawItem& Item : Queue)
+	{
+		Group& g = Groups[Item.GroupIndex];
+		SetCullFace(g);
+
+		Shader* CurrentShader = g.FirstMesh->RenderContext.GetShader();
+		if (CurrentShader != BoundShader || g.MaterialIndex != BoundMaterial)
+		{
+			g.FirstMesh->RenderContext.Bind();
+			BoundShader = CurrentShader;
+			BoundMaterial = g.MaterialIndex;
+		}
+
+		DrawGroup(g, CurrentShader, false);
+	}
+}
+
+void ModelBatch::SimpleRender(Shader* UsedShader)
+{
+	UploadTransforms();
+	UsedShader->Bind();
+	for (Group& g : Groups)
+	{
+		if (g.FirstMesh->RenderContext.Mat.IsTranslucent) continue;
+		SetCullFace(g);
+		DrawGroup(g, UsedShader, true);
+	}
+}
+#endif
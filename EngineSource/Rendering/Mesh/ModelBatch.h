@@ -0,0 +1,120 @@
+#if !SERVER
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+
+class Model;
+class Mesh;
+class Camera;
+struct Shader;
+
+/**
+* @brief
+* Draws the meshes of many models with as few draw calls as possible.
+*
+* Meshes of different models that use the same vertex data (see ModelCache) and the same material are
+* drawn with a single instanced draw call. The model matrices of all instances are written to a buffer once per pass.
+*
+* Meshes whose material was changed with Model::SetUniform() are always drawn on their own, and so are translucent meshes,
+* since they have to be sorted by depth. Shaders get the inverse model view matrix of each instance from shared.vert.
+*
+* Render() acts as a render queue: the groups of a pass are sorted by a 64 bit key made of the pass, shader,
+* material, vertex array and depth. Opaque groups are drawn sorted by state and then front to back, translucent
+* groups back to front. The shader and material are only bound when they change between groups.
+*
+* @ingroup Internal
+*/
+class ModelBatch
+{
+public:
+	ModelBatch();
+	~ModelBatch();
+
+	/// If false, each model is drawn on its own.
+	static bool Active;
+
+	/// Which meshes of a model are added by Add().
+	enum class MeshFilter
+	{
+		All,
+		Opaque,
+		Translucent,
+	};
+
+	/// Removes all models from the batch.
+	void Clear();
+
+	/**
+	* @brief
+	* Adds the meshes of a model to the batch. The model isn't checked for visibility.
+	*
+	* @param LOD
+	* The level of detail the model is drawn with, see Model::GetLOD(). Only models with the same level are drawn together.
+	*
+	* @param Filter
+	* Only meshes matching the filter are added.
+	*/
+	void Add(Model* NewModel, uint8_t LOD = 0, MeshFilter Filter = MeshFilter::All);
+
+	/// Draws all meshes that have been added, like Model::Render().
+	void Render(Camera* WorldCamera, bool MainFrameBuffer, bool TransparencyPass);
+
+	/// Draws all meshes that have been added with the given shader, like Model::SimpleRender().
+	void SimpleRender(Shader* UsedShader);
+
+private:
+	struct GroupKey
+	{
+		unsigned int VertexData = 0;
+		bool TwoSided = false;
+		uint8_t LOD = 0;
+		std::string Material;
+		/// Set for meshes that can't be grouped with other meshes.
+		const Mesh* UniqueMesh = nullptr;
+
+		bool operator==(const GroupKey& Other) const;
+	};
+
+	struct GroupKeyHash
+	{
+		size_t operator()(const GroupKey& Key) const;
+	};
+
+	struct Group
+	{
+		/// The mesh of the first model in the group. Its material and vertex array are used to draw the group.
+		Mesh* FirstMesh = nullptr;
+		Model* FirstModel = nullptr;
+		bool TwoSided = false;
+		uint8_t LOD = 0;
+		/// Groups with the same material index use the same material, so it doesn't need to be bound again.
+		uint16_t MaterialIndex = 0;
+		std::vector<glm::mat4> Transforms;
+		/// The offset of this group's transforms in the transform buffer, in bytes.
+		size_t BufferOffset = 0;
+	};
+
+	struct DrawItem
+	{
+		uint64_t SortKey = 0;
+		size_t GroupIndex = 0;
+	};
+
+	std::unordered_map<GroupKey, size_t, GroupKeyHash> GroupIndices;
+	std::unordered_map<std::string, uint16_t> MaterialIndices;
+	uint16_t NumMaterials = 0;
+	std::vector<Group> Groups;
+	std::vector<DrawItem> Queue;
+	unsigned int TransformBuffer = 0;
+	bool UploadedTransforms = false;
+
+	static uint64_t GetSortKey(const Group& DrawnGroup, bool Translucent, float Depth);
+
+	void UploadTransforms();
+	void SetCullFace(const Group& DrawnGroup);
+	void DrawGroup(Group& DrawnGroup, Shader* UsedShader, bool Simple);
+};
+#endif
@@ -0,0 +1,121 @@
+#if !SERVER
+#include "ModelCache.h"
+#include <unordered_map>
+#include <Rendering/VertexBuffer.h>
+
+namespace ModelCache
+{
+	static std::unordered_map<std::string, CachedModel*> CachedModels;
+	static size_t CacheHits = 0, CacheMisses = 0;
+
+	static CachedModel* MakeModel(ModelGenerator::ModelData&& Data)
+	{
+		CachedModel* NewModel = new CachedModel();
+		NewModel->Data = std::move(Data);
+		NewModel->NonScaledSize = NewModel->Data.CollisionBox.GetLength();
+		NewModel->Data.MakeCollisionBox();
+		for (const auto& i : NewModel->Data.Elements)
+		{
+			NewModel->Buffers.push_back(new VertexBuffer(i.Vertices, i.Indices, i.LODIndices));
+		}
+		NewModel->References = 1;
+		return NewModel;
+	}
+
+	size_t CachedModel::GetMemorySize() const
+	{
+		size_t Size = 0;
+		for (const auto& i : Data.Elements)
+		{
+			// The model data, the copy in the vertex buffer and the GPU buffers.
+			Size += (i.Vertices.size() * sizeof(Vertex) + i.Indices.size() * sizeof(unsigned int)) * 3;
+			// LODs are only stored in the model data and on the GPU.
+			for (const auto& LOD : i.LODIndices)
+			{
+				Size += LOD.size() * sizeof(unsigned int) * 2;
+			}
+		}
+		return Size;
+	}
+
+	CachedModel* Load(std::string File)
+	{
+		std::error_code Error;
+		auto WriteTime = std::filesystem::last_write_time(File, Error);
+		if (Error)
+		{
+			return nullptr;
+		}
+
+		auto Found = CachedModels.find(File);
+		if (Found != CachedModels.end())
+		{
+			if (Found->second->WriteTime == WriteTime)
+			{
+				CacheHits++;
+				Found->second->References++;
+				return Found->second;
+			}
+			// The file has changed since it was loaded. Models that still use the old version keep it until they are deleted.
+			Found->second->File.clear();
+			CachedModels.erase(Found);
+		}
+
+		CacheMisses++;
+		ModelGenerator::ModelData Data;
+		Data.LoadModelFromFile(File);
+		CachedModel* NewModel = MakeModel(std::move(Data));
+		NewModel->File = File;
+		NewModel->WriteTime = WriteTime;
+		CachedModels.insert({ File, NewModel });
+		return NewModel;
+	}
+
+	CachedModel* Create(ModelGenerator::ModelData Data)
+	{
+		return MakeModel(std::move(Data));
+	}
+
+	void Release(CachedModel* Model)
+	{
+		if (!Model || --Model->References)
+		{
+			return;
+		}
+
+		if (!Model->File.empty())
+		{
+			CachedModels.erase(Model->File);
+		}
+		for (VertexBuffer* i : Model->Buffers)
+		{
+			delete i;
+		}
+		delete Model;
+	}
+
+	CacheStats GetStats()
+	{
+		CacheStats Stats;
+		Stats.Hits = CacheHits;
+		Stats.Misses = CacheMisses;
+		for (const auto& [File, Model] : CachedModels)
+		{
+			size_t Size = Model->GetMemorySize();
+			Stats.UsedBytes += Size;
+			Stats.SavedBytes += Size * (Model->References - 1);
+		}
+		return Stats;
+	}
+
+	std::vector<const CachedModel*> GetCachedModels()
+	{
+		std::vector<const CachedModel*> Models;
+		for (const auto& [File, Model] : CachedModels)
+		{
+			Models.push_back(Model);
+		}
+		return Models;
+	}
+}
+#endif
@@ -0,0 +1,88 @@
+#if !SERVER
+#pragma once
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <Rendering/Mesh/ModelGenerator.h>
+
+struct VertexBuffer;
+
+/**
+* @file
+* @brief
+* Cache of loaded model files.
+*/
+
+/**
+* @brief
+* Loaded model files, shared between all Model instances that use the same file.
+*
+* A model file is only read from disk and uploaded to the GPU once, no matter how many models use it.
+* The cached data is reference counted like textures (see Texture::LoadTexture()), and unloaded when the last model using it is deleted.
+*
+* @ingroup Internal
+*/
+namespace ModelCache
+{
+	/**
+	* @brief
+	* Model data and GPU buffers shared by multiple models.
+	*/
+	struct CachedModel
+	{
+		/// The file the model was loaded from. Empty for models created from ModelData, which aren't shared.
+		std::string File;
+		/// The last write time of File when it was loaded. If the file changes, it's loaded again.
+		std::filesystem::file_time_type WriteTime;
+		ModelGenerator::ModelData Data;
+		/// The length of the model's bounds, as it was before Data.MakeCollisionBox() was called.
+		float NonScaledSize = 1;
+		/// The vertex and index buffers of each element in Data.
+		std::vector<VertexBuffer*> Buffers;
+		/// The number of models using this data.
+		size_t References = 0;
+
+		/// The approximate number of bytes this model uses in CPU and GPU memory.
+		size_t GetMemorySize() const;
+	};
+
+	/**
+	* @brief
+	* Gets the cached model data for the given .jsm file, loading it if it isn't loaded yet. Adds a reference.
+	*
+	* @return
+	* The cached model, or nullptr if the file doesn't exist.
+	*/
+	CachedModel* Load(std::string File);
+
+	/**
+	* @brief
+	* Creates model data that isn't shared, with one reference.
+	*/
+	CachedModel* Create(ModelGenerator::ModelData Data);
+
+	/**
+	* @brief
+	* Removes a reference from the model. The model is unloaded if it has no references left.
+	*/
+	void Release(CachedModel* Model);
+
+	/// Statistics of the model cache.
+	struct CacheStats
+	{
+		/// Number of calls to Load() that found the model in the cache.
+		size_t Hits = 0;
+		/// Number of calls to Load() that had to load the model from disk.
+		size_t Misses = 0;
+		/// The approximate memory used by cached models.
+		size_t UsedBytes = 0;
+		/// The approximate memory all references to cached models would use if every reference had its own copy.
+		size_t SavedBytes = 0;
+	};
+
+	CacheStats GetStats();
+
+	/// Returns all currently loaded models that were loaded from files.
+	std::vector<const CachedModel*> GetCachedModels();
+}
+#endif
@@ -4,11 +4,341 @@
 #include <iostream>
 #include <Engine/File/Assets.h>
 #include <Engine/Log.h>
+#include <Engine/Utility/FileUtility.h>
+#include <Rendering/Mesh/MeshSimplification.h>
 #include <glm/ext/vector_float2.hpp>
 #include <glm/geometric.hpp>
+#include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <unordered_map>
+#include <algorithm>
 
 namespace ModelGenerator
 {
+	// Old .jsm files start with the number of elements instead of a header.
+	// As a number, the magic value would be a model with over 800 million elements, so the formats can't be confused.
+	static const char JSM_MAGIC[4] = { 'J', 'S', 'M', 'B' };
+	constexpr uint32_t JSM_FILE_VERSION = 2;
+	// Vertex and index blocks start at a multiple of this, so they can be read directly from a mapped file.
+	constexpr size_t JSM_BLOCK_ALIGNMENT = 16;
+
+	enum JsmFlags : uint32_t
+	{
+		JSM_QUANTIZED = 1 << 0,
+		JSM_CAST_SHADOW = 1 << 1,
+		JSM_HAS_COLLISION = 1 << 2,
+		JSM_TWO_SIDED = 1 << 3,
+	};
+
+	struct JsmHeader
+	{
+		char Magic[4];
+		uint32_t Version;
+		uint32_t Flags;
+		uint32_t NumElements;
+		float BoundsMin[3];
+		float BoundsMax[3];
+	};
+
+	struct JsmElement
+	{
+		uint32_t NumVertices;
+		uint32_t NumIndices;
+		// Offsets from the start of the file.
+		uint64_t VertexOffset;
+		uint64_t IndexOffset;
+		uint64_t MaterialOffset;
+		uint32_t MaterialLength;
+		// The indices of the LODs follow the indices of the element. The number of indices of each LOD
+		// is stored as an array of uint32_t after the material name.
+		uint32_t NumLODs;
+	};
+
+	struct JsmVertex
+	{
+		float Position[3];
+		float Normal[3];
+		float TexCoord[2];
+	};
+
+	struct JsmQuantizedVertex
+	{
+		float Position[3];
+		// Octahedral encoded normal, as signed normalized values.
+		int16_t Normal[2];
+		// Texture coordinates as 16 bit floats.
+		uint16_t TexCoord[2];
+	};
+
+	static_assert(sizeof(JsmHeader) == 40 && sizeof(JsmElement) == 40, "The .jsm file structs must not contain padding");
+	static_assert(sizeof(JsmVertex) == 32 && sizeof(JsmQuantizedVertex) == 20, "The .jsm vertex structs must not contain padding");
+
+	static uint16_t FloatToHalf(float Value)
+	{
+		uint32_t Bits;
+		std::memcpy(&Bits, &Value, sizeof(Bits));
+		uint32_t Sign = (Bits >> 16) & 0x8000;
+		int32_t Exponent = int32_t((Bits >> 23) & 0xff) - 127 + 15;
+		uint32_t Mantissa = Bits & 0x7fffff;
+
+		// Infinity or NaN
+		if (((Bits >> 23) & 0xff) == 0xff)
+		{
+			return uint16_t(Sign | 0x7c00 | (Mantissa ? 0x200 : 0));
+		}
+		// Too large, rounded to infinity.
+		if (Exponent >= 31)
+		{
+			return uint16_t(Sign | 0x7c00);
+		}
+		// Too small for a normal half float.
+		if (Exponent <= 0)
+		{
+			if (Exponent < -10)
+			{
+				return uint16_t(Sign);
+			}
+			Mantissa |= 0x800000;
+			uint32_t Shift = uint32_t(14 - Exponent);
+			uint32_t Half = Mantissa >> Shift;
+			if ((Mantissa >> (Shift - 1)) & 1)
+			{
+				Half++;
+			}
+			return uint16_t(Sign | Half);
+		}
+		uint32_t Half = Sign | (uint32_t(Exponent) << 10) | (Mantissa >> 13);
+		// Rounding may carry into the exponent, which is still the correct result.
+		if (Mantissa & 0x1000)
+		{
+			Half++;
+		}
+		return uint16_t(Half);
+	}
+
+	static float HalfToFloat(uint16_t Value)
+	{
+		uint32_t Sign = uint32_t(Value & 0x8000) << 16;
+		uint32_t Exponent = (Value >> 10) & 0x1f;
+		uint32_t Mantissa = Value & 0x3ff;
+		uint32_t Bits = 0;
+		if (Exponent == 0)
+		{
+			Bits = Sign;
+			if (Mantissa)
+			{
+				Exponent = 127 - 15 + 1;
+				while (!(Mantissa & 0x400))
+				{
+					Mantissa <<= 1;
+					Exponent--;
+				}
+				Bits |= (Exponent << 23) | ((Mantissa & 0x3ff) << 13);
+			}
+		}
+		else if (Exponent == 31)
+		{
+			Bits = Sign | 0x7f800000 | (Mantissa << 13);
+		}
+		else
+		{
+			Bits = Sign | ((Exponent - 15 + 127) << 23) | (Mantissa << 13);
+		}
+		float Out;
+		std::memcpy(&Out, &Bits, sizeof(Out));
+		return Out;
+	}
+
+	static int16_t ToSnorm16(float Value)
+	{
+		return (int16_t)std::round(std::fmin(std::fmax(Value, -1.0f), 1.0f) * 32767.0f);
+	}
+
+	static void EncodeOctahedral(glm::vec3 Normal, int16_t Out[2])
+	{
+		float Length = std::abs(Normal.x) + std::abs(Normal.y) + std::abs(Normal.z);
+		if (Length == 0)
+		{
+			Out[0] = 0;
+			Out[1] = 0;
+			return;
+		}
+		float X = Normal.x / Length, Y = Normal.y / Length;
+		// The lower half of the octahedron is folded over the upper half.
+		if (Normal.z < 0)
+		{
+			float FoldedX = (1 - std::abs(Y)) * (X >= 0 ? 1.0f : -1.0f);
+			float FoldedY = (1 - std::abs(X)) * (Y >= 0 ? 1.0f : -1.0f);
+			X = FoldedX;
+			Y = FoldedY;
+		}
+		Out[0] = ToSnorm16(X);
+		Out[1] = ToSnorm16(Y);
+	}
+
+	static glm::vec3 DecodeOctahedral(const int16_t In[2])
+	{
+		glm::vec3 Normal = glm::vec3(In[0] / 32767.0f, In[1] / 32767.0f, 0);
+		Normal.z = 1 - std::abs(Normal.x) - std::abs(Normal.y);
+		float Fold = std::fmax(-Normal.z, 0.0f);
+		Normal.x += Normal.x >= 0 ? -Fold : Fold;
+		Normal.y += Normal.y >= 0 ? -Fold : Fold;
+		float Length = std::sqrt(Normal.x * Normal.x + Normal.y * Normal.y + Normal.z * Normal.z);
+		if (Length == 0)
+		{
+			return glm::vec3(0, 1, 0);
+		}
+		return Normal / Length;
+	}
+
+	static bool IsBinaryModelFile(const FileUtil::MappedFile& File)
+	{
+		return File.GetSize() >= sizeof(JsmHeader) && std::memcmp(File.GetData(), JSM_MAGIC, sizeof(JSM_MAGIC)) == 0;
+	}
+
+	static bool IsInFile(const FileUtil::MappedFile& File, uint64_t Offset, uint64_t Count, uint64_t ElementSize)
+	{
+		return Offset <= File.GetSize() && Count <= (File.GetSize() - Offset) / ElementSize;
+	}
+
+	static bool ReadBinaryModel(ModelData& Model, const FileUtil::MappedFile& File)
+	{
+		const uint8_t* Data = File.GetData();
+		JsmHeader Header;
+		std::memcpy(&Header, Data, sizeof(Header));
+		if (Header.Version != JSM_FILE_VERSION || !IsInFile(File, sizeof(JsmHeader), Header.NumElements, sizeof(JsmElement)))
+		{
+			return false;
+		}
+
+		const bool Quantized = Header.Flags & JSM_QUANTIZED;
+		const size_t VertexSize = Quantized ? sizeof(JsmQuantizedVertex) : sizeof(JsmVertex);
+
+		std::vector<ModelData::Element> Elements;
+		Elements.resize(Header.NumElements);
+		for (uint32_t i = 0; i < Header.NumElements; i++)
+		{
+			JsmElement FileElement;
+			std::memcpy(&FileElement, Data + sizeof(JsmHeader) + i * sizeof(JsmElement), sizeof(FileElement));
+			if (!IsInFile(File, FileElement.VertexOffset, FileElement.NumVertices, VertexSize)
+				|| !IsInFile(File, FileElement.IndexOffset, FileElement.NumIndices, sizeof(uint32_t))
+				|| !IsInFile(File, FileElement.MaterialOffset, FileElement.MaterialLength, 1)
+				|| !IsInFile(File, FileElement.MaterialOffset + FileElement.MaterialLength, FileElement.NumLODs, sizeof(uint32_t))
+				|| FileElement.VertexOffset % JSM_BLOCK_ALIGNMENT
+				|| FileElement.IndexOffset % JSM_BLOCK_ALIGNMENT)
+			{
+				return false;
+			}
+
+			ModelData::Element& Elem = Elements[i];
+			Elem.Vertices.resize(FileElement.NumVertices);
+			if (Quantized)
+			{
+				const JsmQuantizedVertex* FileVertices = reinterpret_cast<const JsmQuantizedVertex*>(Data + FileElement.VertexOffset);
+				for (uint32_t v = 0; v < FileElement.NumVertices; v++)
+				{
+					const JsmQuantizedVertex& In = FileVertices[v];
+					Vertex& Out = Elem.Vertices[v];
+					Out.Position = glm::vec3(In.Position[0], In.Position[1], In.Position[2]);
+					Out.Normal = DecodeOctahedral(In.Normal);
+					Out.TexCoord = glm::vec2(HalfToFloat(In.TexCoord[0]), HalfToFloat(In.TexCoord[1]));
+				}
+			}
+			else
+			{
+				const JsmVertex* FileVertices = reinterpret_cast<const JsmVertex*>(Data + FileElement.VertexOffset);
+				for (uint32_t v = 0; v < FileElement.NumVertices; v++)
+				{
+					const JsmVertex& In = FileVertices[v];
+					Vertex& Out = Elem.Vertices[v];
+					Out.Position = glm::vec3(In.Position[0], In.Position[1], In.Position[2]);
+					Out.Normal = glm::vec3(In.Normal[0], In.Normal[1], In.Normal[2]);
+					Out.TexCoord = glm::vec2(In.TexCoord[0], In.TexCoord[1]);
+				}
+			}
+
+			static_assert(sizeof(unsigned int) == sizeof(uint32_t));
+			Elem.Indices.resize(FileElement.NumIndices);
+			std::memcpy(Elem.Indices.data(), Data + FileElement.IndexOffset, FileElement.NumIndices * sizeof(uint32_t));
+			for (unsigned int Index : Elem.Indices)
+			{
+				if (Index >= FileElement.NumVertices)
+				{
+					return false;
+				}
+			}
+
+			Elem.ElemMaterial = std::string((const char*)Data + FileElement.MaterialOffset, FileElement.MaterialLength);
+
+			uint64_t LODOffset = FileElement.IndexOffset + FileElement.NumIndices * sizeof(uint32_t);
+			Elem.LODIndices.resize(FileElement.NumLODs);
+			for (uint32_t l = 0; l < FileElement.NumLODs; l++)
+			{
+				uint32_t NumLODIndices;
+				std::memcpy(&NumLODIndices, Data + FileElement.MaterialOffset + FileElement.MaterialLength + l * sizeof(uint32_t), sizeof(uint32_t));
+				if (!IsInFile(File, LODOffset, NumLODIndices, sizeof(uint32_t)))
+				{
+					return false;
+				}
+				Elem.LODIndices[l].resize(NumLODIndices);
+				std::memcpy(Elem.LODIndices[l].data(), Data + LODOffset, NumLODIndices * sizeof(uint32_t));
+				for (unsigned int Index : Elem.LODIndices[l])
+				{
+					if (Index >= FileElement.NumVertices)
+					{
+						return false;
+					}
+				}
+				LODOffset += NumLODIndices * sizeof(uint32_t);
+			}
+		}
+
+		// Like the old format, the bounds are added to the current collision box.
+		Model.CollisionBox.minX = std::fmin(Model.CollisionBox.minX, Header.BoundsMin[0]);
+		Model.CollisionBox.minY = std::fmin(Model.CollisionBox.minY, Header.BoundsMin[1]);
+		Model.CollisionBox.minZ = std::fmin(Model.CollisionBox.minZ, Header.BoundsMin[2]);
+		Model.CollisionBox.maxX = std::fmax(Model.CollisionBox.maxX, Header.BoundsMax[0]);
+		Model.CollisionBox.maxY = std::fmax(Model.CollisionBox.maxY, Header.BoundsMax[1]);
+		Model.CollisionBox.maxZ = std::fmax(Model.CollisionBox.maxZ, Header.BoundsMax[2]);
+
+		for (auto& i : Elements)
+		{
+			Model.Elements.push_back(std::move(i));
+		}
+		Model.CastShadow = Header.Flags & JSM_CAST_SHADOW;
+		Model.HasCollision = Header.Flags & JSM_HAS_COLLISION;
+		Model.TwoSided = Header.Flags & JSM_TWO_SIDED;
+		return true;
+	}
+
+	static void AlignBlock(std::vector<uint8_t>& Out)
+	{
+		Out.resize((Out.size() + JSM_BLOCK_ALIGNMENT - 1) / JSM_BLOCK_ALIGNMENT * JSM_BLOCK_ALIGNMENT, 0);
+	}
+
+	static void AppendData(std::vector<uint8_t>& Out, const void* Data, size_t Size)
+	{
+		const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+		Out.insert(Out.end(), Bytes, Bytes + Size);
+	}
+
+	uint32_t ModelData::GetFileVersion(std::string File)
+	{
+		FileUtil::MappedFile Mapped = FileUtil::MappedFile(File);
+		if (!Mapped.GetData())
+		{
+			return 0;
+		}
+		if (!IsBinaryModelFile(Mapped))
+		{
+			return 1;
+		}
+		uint32_t Version;
+		std::memcpy(&Version, Mapped.GetData() + offsetof(JsmHeader, Version), sizeof(Version));
+		return Version;
+	}
+
 	ModelData::Element& ModelData::AddElement()
 	{
 		Elements.push_back(Element());
@@ -26,6 +356,18 @@ namespace ModelGenerator
 				return;
 			}
 		}
+		{
+			FileUtil::MappedFile File = FileUtil::MappedFile(Path);
+			if (IsBinaryModelFile(File))
+			{
+				if (!ReadBinaryModel(*this, File))
+				{
+					Log::Print("Could not load model: " + Path + " is not a valid model file", Log::LogColor::Red);
+				}
+				return;
+			}
+		}
+
 		std::ifstream Input = std::ifstream(Path, std::ios::in | std::ios::binary);
 		Input.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 		uint32_t NumMeshes = 0;
@@ -116,46 +458,93 @@ namespace ModelGenerator
 		*this = ModelGenerator::ModelData();
 	}
 
-	void ModelData::SaveModelData(std::string Path)
+	void ModelData::SaveModelData(std::string Path, bool QuantizeVertices)
 	{
-		std::ofstream Output(Path, std::ios::out | std::ios::binary);
-
-		int NumElements = (int)Elements.size();
-		Output.write((char*)&NumElements, sizeof(int));
-		for (int j = 0; j < NumElements; j++)
+		JsmHeader Header;
+		std::memcpy(Header.Magic, JSM_MAGIC, sizeof(JSM_MAGIC));
+		Header.Version = JSM_FILE_VERSION;
+		Header.Flags = (QuantizeVertices ? JSM_QUANTIZED : 0)
+			| (CastShadow ? JSM_CAST_SHADOW : 0)
+			| (HasCollision ? JSM_HAS_COLLISION : 0)
+			| (TwoSided ? JSM_TWO_SIDED : 0);
+		Header.NumElements = (uint32_t)Elements.size();
+		for (int i = 0; i < 3; i++)
 		{
-			int NumVertices = (int)Elements[j].Vertices.size();
-			int NumIndices = (int)Elements[j].Indices.size();
+			Header.BoundsMin[i] = Elements.empty() ? 0 : INFINITY;
+			Header.BoundsMax[i] = Elements.empty() ? 0 : -INFINITY;
+		}
+		for (const Element& Elem : Elements)
+		{
+			for (const Vertex& v : Elem.Vertices)
+			{
+				for (int i = 0; i < 3; i++)
+				{
+					Header.BoundsMin[i] = std::fmin(Header.BoundsMin[i], v.Position[i]);
+					Header.BoundsMax[i] = std::fmax(Header.BoundsMax[i], v.Position[i]);
+				}
+			}
+		}
 
-			Output.write((char*)&NumVertices, sizeof(int));
-			Output.write((char*)&NumIndices, sizeof(int));
+		std::vector<JsmElement> FileElements = std::vector<JsmElement>(Elements.size());
+		std::vector<uint8_t> Out;
+		// The element table is filled in once the offsets of the blocks are known.
+		Out.resize(sizeof(JsmHeader) + Elements.size() * sizeof(JsmElement));
+		for (size_t j = 0; j < Elements.size(); j++)
+		{
+			const Element& Elem = Elements[j];
+			JsmElement& FileElement = FileElements[j];
+			FileElement.NumVertices = (uint32_t)Elem.Vertices.size();
+			FileElement.NumIndices = (uint32_t)Elem.Indices.size();
+			FileElement.NumLODs = (uint32_t)Elem.LODIndices.size();
 
-			auto& ElemVerts = Elements[j].Vertices;
-			auto& ElemInds = Elements[j].Indices;
+			AlignBlock(Out);
+			FileElement.VertexOffset = Out.size();
+			for (const Vertex& v : Elem.Vertices)
+			{
+				if (QuantizeVertices)
+				{
+					JsmQuantizedVertex FileVertex;
+					std::memcpy(FileVertex.Position, &v.Position, sizeof(FileVertex.Position));
+					EncodeOctahedral(v.Normal, FileVertex.Normal);
+					FileVertex.TexCoord[0] = FloatToHalf(v.TexCoord.x);
+					FileVertex.TexCoord[1] = FloatToHalf(v.TexCoord.y);
+					AppendData(Out, &FileVertex, sizeof(FileVertex));
+				}
+				else
+				{
+					JsmVertex FileVertex;
+					std::memcpy(FileVertex.Position, &v.Position, sizeof(FileVertex.Position));
+					std::memcpy(FileVertex.Normal, &v.Normal, sizeof(FileVertex.Normal));
+					std::memcpy(FileVertex.TexCoord, &v.TexCoord, sizeof(FileVertex.TexCoord));
+					AppendData(Out, &FileVertex, sizeof(FileVertex));
+				}
+			}
 
-			for (int i = 0; i < NumVertices; i++)
+			AlignBlock(Out);
+			FileElement.IndexOffset = Out.size();
+			AppendData(Out, Elem.Indices.data(), Elem.Indices.size() * sizeof(uint32_t));
+			for (const auto& LOD : Elem.LODIndices)
 			{
-				Output.write((char*)&ElemVerts[i].Position.x, sizeof(float));
-				Output.write((char*)&ElemVerts[i].Position.y, sizeof(float));
-				Output.write((char*)&ElemVerts[i].Position.z, sizeof(float));
-				Output.write((char*)&ElemVerts[i].Normal.x, sizeof(float));
-				Output.write((char*)&ElemVerts[i].Normal.y, sizeof(float));
-				Output.write((char*)&ElemVerts[i].Normal.z, sizeof(float));
-				Output.write((char*)&ElemVerts[i].TexCoord.x, sizeof(float));
-				Output.write((char*)&ElemVerts[i].TexCoord.y, sizeof(float));
+				AppendData(Out, LOD.data(), LOD.size() * sizeof(uint32_t));
 			}
-			for (int i = 0; i < NumIndices; i++)
+
+			FileElement.MaterialOffset = Out.size();
+			FileElement.MaterialLength = (uint32_t)Elem.ElemMaterial.size();
+			AppendData(Out, Elem.ElemMaterial.data(), Elem.ElemMaterial.size());
+			for (const auto& LOD : Elem.LODIndices)
 			{
-				Output.write((char*)&ElemInds[i], sizeof(int));
+				uint32_t NumLODIndices = (uint32_t)LOD.size();
+				AppendData(Out, &NumLODIndices, sizeof(NumLODIndices));
 			}
-			std::string MaterialString = Elements[j].ElemMaterial;
-			size_t size = MaterialString.size();
-			Output.write((char*)&size, sizeof(size_t));
-			Output.write(MaterialString.c_str(), sizeof(char) * size);
 		}
-		Output.write((char*)&CastShadow, sizeof(bool));
-		Output.write((char*)&HasCollision, sizeof(uint8_t));
-		Output.write((char*)&TwoSided, sizeof(uint8_t));
+		std::memcpy(Out.data(), &Header, sizeof(Header));
+		if (!FileElements.empty())
+		{
+			std::memcpy(Out.data() + sizeof(JsmHeader), FileElements.data(), FileElements.size() * sizeof(JsmElement));
+		}
+
+		std::ofstream Output(Path, std::ios::out | std::ios::binary);
+		Output.write((const char*)Out.data(), Out.size());
 		Output.close();
 	}
 	std::vector<Vertex> ModelData::GetMergedVertices() const
@@ -282,17 +671,437 @@ namespace ModelGenerator
 		}
 	}
 
-	void ModelData::Element::RemoveDuplicateVertices()
+	static int64_t GetWeldCell(float Value, float CellSize)
+	{
+		return (int64_t)std::floor(Value / CellSize);
+	}
+
+	static uint64_t HashWeldCell(int64_t X, int64_t Y, int64_t Z)
+	{
+		return (uint64_t)X * 73856093ull ^ (uint64_t)Y * 19349663ull ^ (uint64_t)Z * 83492791ull;
+	}
+
+	static bool NearlyEqualAxes(const float* A, const float* B, int NumAxes, float Threshold)
+	{
+		for (int i = 0; i < NumAxes; i++)
+		{
+			if (std::abs(A[i] - B[i]) >= Threshold)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Removes unused vertices and orders the vertices by their first use in the index buffer.
+	static void CompactVertices(std::vector<Vertex>& Vertices, std::vector<unsigned int>& Indices)
+	{
+		constexpr unsigned int UNUSED = UINT32_MAX;
+		std::vector<unsigned int> Remap = std::vector<unsigned int>(Vertices.size(), UNUSED);
+		std::vector<Vertex> NewVertices;
+		NewVertices.reserve(Vertices.size());
+		for (unsigned int& Index : Indices)
+		{
+			if (Remap[Index] == UNUSED)
+			{
+				Remap[Index] = (unsigned int)NewVertices.size();
+				NewVertices.push_back(Vertices[Index]);
+			}
+			Index = Remap[Index];
+		}
+		Vertices = std::move(NewVertices);
+	}
+
+	void ModelData::Element::RemoveDuplicateVertices(float PositionThreshold, bool CompareAttributes)
+	{
+		constexpr float NORMAL_THRESHOLD = 0.001f;
+		constexpr float TEXCOORD_THRESHOLD = 0.0001f;
+		constexpr uint32_t NONE = UINT32_MAX;
+
+		// Vertices are sorted into a grid with cells the size of the threshold.
+		// Two vertices that should be merged are always in the same or in neighboring cells.
+		std::unordered_map<uint64_t, uint32_t> FirstInCell;
+		FirstInCell.reserve(Vertices.size());
+		// The next kept vertex in the same cell, or NONE.
+		std::vector<uint32_t> NextInCell = std::vector<uint32_t>(Vertices.size(), NONE);
+		std::vector<unsigned int> Remap = std::vector<unsigned int>(Vertices.size());
+
+		for (uint32_t i = 0; i < Vertices.size(); i++)
+		{
+			const Vertex& Current = Vertices[i];
+			const int64_t CellX = GetWeldCell(Current.Position.x, PositionThreshold);
+			const int64_t CellY = GetWeldCell(Current.Position.y, PositionThreshold);
+			const int64_t CellZ = GetWeldCell(Current.Position.z, PositionThreshold);
+
+			uint32_t Found = NONE;
+			for (int64_t x = -1; x <= 1 && Found == NONE; x++)
+			{
+				for (int64_t y = -1; y <= 1 && Found == NONE; y++)
+				{
+					for (int64_t z = -1; z <= 1 && Found == NONE; z++)
+					{
+						auto Cell = FirstInCell.find(HashWeldCell(CellX + x, CellY + y, CellZ + z));
+						if (Cell == FirstInCell.end())
+						{
+							continue;
+						}
+						// Different cells may have the same hash, so the positions are always compared.
+						for (uint32_t Other = Cell->second; Other != NONE; Other = NextInCell[Other])
+						{
+							const Vertex& OtherVertex = Vertices[Other];
+							if (NearlyEqualAxes(&Current.Position.x, &OtherVertex.Position.x, 3, PositionThreshold)
+								&& (!CompareAttributes
+									|| (NearlyEqualAxes(&Current.Normal.x, &OtherVertex.Normal.x, 3, NORMAL_THRESHOLD)
+										&& NearlyEqualAxes(&Current.TexCoord.x, &OtherVertex.TexCoord.x, 2, TEXCOORD_THRESHOLD))))
+							{
+								Found = Other;
+								break;
+							}
+						}
+					}
+				}
+			}
+
+			if (Found != NONE)
+			{
+				Remap[i] = Found;
+				continue;
+			}
+			Remap[i] = i;
+			auto Inserted = FirstInCell.insert({ HashWeldCell(CellX, CellY, CellZ), i });
+			if (!Inserted.second)
+			{
+				NextInCell[i] = Inserted.first->second;
+				Inserted.first->second = i;
+			}
+		}
+
+		std::vector<unsigned int> NewIndices;
+		NewIndices.reserve(Indices.size());
+		for (size_t i = 0; i + 2 < Indices.size(); i += 3)
+		{
+			unsigned int A = Remap[Indices[i]], B = Remap[Indices[i + 1]], C = Remap[Indices[i + 2]];
+			if (A == B || B == C || A == C)
+			{
+				continue;
+			}
+			NewIndices.push_back(A);
+			NewIndices.push_back(B);
+			NewIndices.push_back(C);
+		}
+		Indices = std::move(NewIndices);
+		CompactVertices(Vertices, Indices);
+		LODIndices.clear();
+	}
+
+	// Orders triangles for the post transform vertex cache, using Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	// Each vertex gets a score from its position in a simulated LRU cache and the number of triangles still using it.
+	// The triangle with the highest score of its vertices is drawn next.
+	static void OptimizeVertexCache(std::vector<unsigned int>& Indices, size_t NumVertices)
 	{
-		for (size_t i = 0; i < Indices.size(); i++)
+		constexpr int CACHE_SIZE = 32;
+		constexpr float CACHE_DECAY_POWER = 1.5f;
+		constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+		constexpr float VALENCE_BOOST_SCALE = 2.0f;
+		constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+		const size_t NumTriangles = Indices.size() / 3;
+		if (NumTriangles < 2)
+		{
+			return;
+		}
+
+		// Triangles using each vertex. Triangles that have been drawn are moved to the end of a vertex's list.
+		std::vector<uint32_t> TriangleOffsets = std::vector<uint32_t>(NumVertices + 1, 0);
+		for (size_t i = 0; i < NumTriangles * 3; i++)
+		{
+			TriangleOffsets[Indices[i] + 1]++;
+		}
+		for (size_t i = 0; i < NumVertices; i++)
+		{
+			TriangleOffsets[i + 1] += TriangleOffsets[i];
+		}
+		std::vector<uint32_t> VertexTriangles = std::vector<uint32_t>(NumTriangles * 3);
+		std::vector<uint32_t> RemainingTriangles = std::vector<uint32_t>(NumVertices, 0);
+		for (size_t i = 0; i < NumTriangles * 3; i++)
+		{
+			unsigned int v = Indices[i];
+			VertexTriangles[TriangleOffsets[v] + RemainingTriangles[v]++] = uint32_t(i / 3);
+		}
+
+		auto GetVertexScore = [&](int CachePosition, uint32_t Remaining) -> float
+			{
+				if (Remaining == 0)
+				{
+					return -1.0f;
+				}
+				float Score = 0;
+				if (CachePosition >= 0)
+				{
+					// The vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse the same edge.
+					if (CachePosition < 3)
+					{
+						Score = LAST_TRIANGLE_SCORE;
+					}
+					else
+					{
+						Score = std::pow(1.0f - float(CachePosition - 3) / float(CACHE_SIZE - 3), CACHE_DECAY_POWER);
+					}
+				}
+				// Vertices with few triangles left get a boost, so they are finished and don't stay around.
+				return Score + VALENCE_BOOST_SCALE * std::pow(float(Remaining), -VALENCE_BOOST_POWER);
+			};
+
+		std::vector<int> CachePositions = std::vector<int>(NumVertices, -1);
+		std::vector<float> VertexScores = std::vector<float>(NumVertices);
+		for (size_t i = 0; i < NumVertices; i++)
 		{
-			for (size_t j = 0; j < Indices.size(); j++)
+			VertexScores[i] = GetVertexScore(-1, RemainingTriangles[i]);
+		}
+		std::vector<float> TriangleScores = std::vector<float>(NumTriangles);
+		std::vector<bool> TriangleDrawn = std::vector<bool>(NumTriangles, false);
+		for (size_t i = 0; i < NumTriangles; i++)
+		{
+			TriangleScores[i] = VertexScores[Indices[i * 3]] + VertexScores[Indices[i * 3 + 1]] + VertexScores[Indices[i * 3 + 2]];
+		}
+
+		std::vector<unsigned int> NewIndices;
+		NewIndices.reserve(NumTriangles * 3);
+		std::vector<unsigned int> Cache, NewCache;
+		Cache.reserve(CACHE_SIZE + 3);
+		NewCache.reserve(CACHE_SIZE + 3);
+
+		size_t BestTriangle = 0;
+		for (size_t i = 1; i < NumTriangles; i++)
+		{
+			if (TriangleScores[i] > TriangleScores[BestTriangle])
 			{
-				if (Vector3::NearlyEqual(Vertices[Indices[i]].Position, Vertices[Indices[j]].Position, 1))
+				BestTriangle = i;
+			}
+		}
+		// If no triangle around the cached vertices is left, the next triangle is the first one that hasn't been drawn.
+		// This keeps the algorithm linear, instead of searching all triangles for the best score.
+		size_t NextUndrawn = 0;
+
+		for (size_t Drawn = 0; Drawn < NumTriangles; Drawn++)
+		{
+			if (BestTriangle == SIZE_MAX)
+			{
+				while (TriangleDrawn[NextUndrawn])
 				{
-					Indices[j] = Indices[i];
+					NextUndrawn++;
 				}
+				BestTriangle = NextUndrawn;
+			}
+
+			const unsigned int* Triangle = &Indices[BestTriangle * 3];
+			TriangleDrawn[BestTriangle] = true;
+			NewCache.clear();
+			for (int i = 0; i < 3; i++)
+			{
+				unsigned int v = Triangle[i];
+				NewIndices.push_back(v);
+				NewCache.push_back(v);
+
+				// Move the triangle out of the vertex's list of remaining triangles.
+				uint32_t* List = &VertexTriangles[TriangleOffsets[v]];
+				for (uint32_t t = 0; t < RemainingTriangles[v]; t++)
+				{
+					if (List[t] == BestTriangle)
+					{
+						std::swap(List[t], List[RemainingTriangles[v] - 1]);
+						break;
+					}
+				}
+				RemainingTriangles[v]--;
+			}
+			for (unsigned int v : Cache)
+			{
+				if (v != Triangle[0] && v != Triangle[1] && v != Triangle[2])
+				{
+					NewCache.push_back(v);
+				}
+			}
+			std::swap(Cache, NewCache);
+
+			// Vertices that fall out of the cache lose their cache score.
+			for (size_t i = CACHE_SIZE; i < Cache.size(); i++)
+			{
+				CachePositions[Cache[i]] = -1;
+				VertexScores[Cache[i]] = GetVertexScore(-1, RemainingTriangles[Cache[i]]);
+			}
+			if (Cache.size() > CACHE_SIZE)
+			{
+				Cache.resize(CACHE_SIZE);
+			}
+
+			BestTriangle = SIZE_MAX;
+			float BestScore = -1;
+			for (size_t i = 0; i < Cache.size(); i++)
+			{
+				unsigned int v = Cache[i];
+				CachePositions[v] = (int)i;
+				VertexScores[v] = GetVertexScore((int)i, RemainingTriangles[v]);
+			}
+			for (unsigned int v : Cache)
+			{
+				const uint32_t* List = &VertexTriangles[TriangleOffsets[v]];
+				for (uint32_t t = 0; t < RemainingTriangles[v]; t++)
+				{
+					const size_t Tri = List[t];
+					float Score = VertexScores[Indices[Tri * 3]] + VertexScores[Indices[Tri * 3 + 1]] + VertexScores[Indices[Tri * 3 + 2]];
+					TriangleScores[Tri] = Score;
+					if (Score > BestScore)
+					{
+						BestScore = Score;
+						BestTriangle = Tri;
+					}
+				}
+			}
+		}
+		Indices = std::move(NewIndices);
+	}
+
+	// Orders clusters of triangles so that the parts of the mesh facing away from its center are drawn first,
+	// similar to "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Sander et al).
+	// The clusters are split where a simulated vertex cache misses all vertices of a triangle,
+	// so reordering them doesn't make the vertex cache order worse.
+	static void OptimizeOverdraw(std::vector<unsigned int>& Indices, const std::vector<Vertex>& Vertices)
+	{
+		constexpr size_t FIFO_CACHE_SIZE = 16;
+		constexpr size_t MIN_CLUSTER_SIZE = 16;
+		const size_t NumTriangles = Indices.size() / 3;
+		if (NumTriangles < MIN_CLUSTER_SIZE * 2)
+		{
+			return;
+		}
+
+		std::vector<size_t> ClusterStarts = { 0 };
+		std::vector<uint32_t> CacheTimestamps = std::vector<uint32_t>(Vertices.size(), 0);
+		uint32_t Time = FIFO_CACHE_SIZE + 1;
+		for (size_t i = 0; i < NumTriangles; i++)
+		{
+			int Misses = 0;
+			for (int j = 0; j < 3; j++)
+			{
+				unsigned int v = Indices[i * 3 + j];
+				if (Time - CacheTimestamps[v] > FIFO_CACHE_SIZE)
+				{
+					CacheTimestamps[v] = Time++;
+					Misses++;
+				}
+			}
+			if (Misses == 3 && i - ClusterStarts.back() >= MIN_CLUSTER_SIZE)
+			{
+				ClusterStarts.push_back(i);
+			}
+		}
+		ClusterStarts.push_back(NumTriangles);
+		const size_t NumClusters = ClusterStarts.size() - 1;
+		if (NumClusters < 2)
+		{
+			return;
+		}
+
+		glm::vec3 MeshCenter = glm::vec3(0);
+		float MeshArea = 0;
+		std::vector<glm::vec3> ClusterCenters = std::vector<glm::vec3>(NumClusters, glm::vec3(0));
+		std::vector<glm::vec3> ClusterNormals = std::vector<glm::vec3>(NumClusters, glm::vec3(0));
+		for (size_t c = 0; c < NumClusters; c++)
+		{
+			float ClusterArea = 0;
+			for (size_t i = ClusterStarts[c]; i < ClusterStarts[c + 1]; i++)
+			{
+				const glm::vec3& A = Vertices[Indices[i * 3]].Position;
+				const glm::vec3& B = Vertices[Indices[i * 3 + 1]].Position;
+				const glm::vec3& C = Vertices[Indices[i * 3 + 2]].Position;
+				// The length of the cross product is twice the triangle's area, so the sum is an area weighted normal.
+				glm::vec3 Normal = glm::cross(B - A, C - A);
+				float Area = glm::length(Normal);
+				ClusterNormals[c] += Normal;
+				ClusterCenters[c] += (A + B + C) * (Area / 3.0f);
+				ClusterArea += Area;
+			}
+			MeshCenter += ClusterCenters[c];
+			MeshArea += ClusterArea;
+			if (ClusterArea > 0)
+			{
+				ClusterCenters[c] = ClusterCenters[c] / ClusterArea;
+			}
+		}
+		if (MeshArea > 0)
+		{
+			MeshCenter = MeshCenter / MeshArea;
+		}
+
+		std::vector<std::pair<float, size_t>> SortKeys;
+		SortKeys.reserve(NumClusters);
+		for (size_t c = 0; c < NumClusters; c++)
+		{
+			float NormalLength = glm::length(ClusterNormals[c]);
+			glm::vec3 Normal = NormalLength > 0 ? ClusterNormals[c] / NormalLength : glm::vec3(0);
+			SortKeys.push_back({ glm::dot(ClusterCenters[c] - MeshCenter, Normal), c });
+		}
+		std::stable_sort(SortKeys.begin(), SortKeys.end(), [](const auto& A, const auto& B)
+			{
+				return A.first > B.first;
+			});
+
+		std::vector<unsigned int> NewIndices;
+		NewIndices.reserve(Indices.size());
+		for (const auto& [Key, c] : SortKeys)
+		{
+			NewIndices.insert(NewIndices.end(), Indices.begin() + ClusterStarts[c] * 3, Indices.begin() + ClusterStarts[c + 1] * 3);
+		}
+		Indices = std::move(NewIndices);
+	}
+
+	void ModelData::Element::Optimize()
+	{
+		if (Indices.size() % 3 != 0)
+		{
+			return;
+		}
+		OptimizeVertexCache(Indices, Vertices.size());
+		OptimizeOverdraw(Indices, Vertices);
+		CompactVertices(Vertices, Indices);
+		LODIndices.clear();
+	}
+
+	void ModelData::Element::GenerateLODs(size_t MaxLODs)
+	{
+		// A level isn't kept if it doesn't remove at least this fraction of the triangles of the level before.
+		constexpr float MIN_REDUCTION = 0.15f;
+
+		LODIndices.clear();
+		if (Indices.size() % 3 != 0 || Vertices.empty())
+		{
+			return;
+		}
+
+		glm::vec3 Min = Vertices[0].Position, Max = Vertices[0].Position;
+		for (const Vertex& v : Vertices)
+		{
+			Min = glm::min(Min, v.Position);
+			Max = glm::max(Max, v.Position);
+		}
+		const float MeshSize = glm::length(Max - Min);
+
+		const std::vector<unsigned int>* Previous = &Indices;
+		for (size_t Level = 1; Level <= MaxLODs; Level++)
+		{
+			// Each level is seen from twice as far away as the level before, so it may have twice the error.
+			float MaxDistance = MeshSize * 0.005f * float(1 << Level);
+			std::vector<unsigned int> Simplified = MeshSimplification::Simplify(Vertices, *Previous,
+				Previous->size() / 6 * 3, MaxDistance * MaxDistance);
+
+			if (Simplified.size() > Previous->size() * (1.0f - MIN_REDUCTION))
+			{
+				break;
 			}
+			OptimizeVertexCache(Simplified, Vertices.size());
+			LODIndices.push_back(std::move(Simplified));
+			Previous = &LODIndices.back();
 		}
 	}
 
@@ -377,5 +1186,6 @@ namespace ModelGenerator
 		Vertices.clear();
 		Indices.clear();
 		ElemMaterial.clear();
+		LODIndices.clear();
 	}
 }
\ No newline at end of file
@@ -24,13 +24,54 @@ namespace ModelGenerator
 			std::vector<unsigned int> Indices;
 			/// Name of the material used by the mesh.
 			std::string ElemMaterial;
+			/**
+			* @brief
+			* Lower detail versions of the mesh, see GenerateLODs().
+			*
+			* Each entry is an index buffer using the same vertices as Indices, with fewer triangles than the one before.
+			*/
+			std::vector<std::vector<unsigned int>> LODIndices;
 			/// Generates normals for each polygon using their positions.
 			void GenerateNormals();
 			/**
 			* @brief
-			* Attempts to remove duplicate vertices from this mesh, adjusts the indices.
+			* Merges vertices that are at the same position, adjusts the indices and removes vertices that aren't used anymore.
+			*
+			* Triangles that become degenerate by merging vertices are removed.
+			*
+			* @param PositionThreshold
+			* Vertices are merged if the distance on each axis is smaller than this value. Must be greater than 0.
+			*
+			* @param CompareAttributes
+			* If true, vertices are only merged if their normals and texture coordinates are nearly equal too.
+			* If false, only the positions are compared, which is useful before calling GenerateNormals().
+			*/
+			void RemoveDuplicateVertices(float PositionThreshold = 1.0f, bool CompareAttributes = false);
+
+			/**
+			* @brief
+			* Reorders the triangles and vertices of this mesh so it renders faster.
+			*
+			* - Triangles are ordered so the GPU's post transform vertex cache is used well.
+			* - Groups of triangles are then ordered so the outer, outward facing parts of the mesh are drawn first, which reduces overdraw.
+			* - Vertices are ordered by their first use, and unused vertices are removed.
+			*
+			* This doesn't change how the mesh looks, only the order it is drawn in.
+			* Removes the LODs of the mesh, since the vertices are reordered. RemoveDuplicateVertices() does the same.
 			*/
-			void RemoveDuplicateVertices();
+			void Optimize();
+
+			/**
+			* @brief
+			* Generates lower detail versions of this mesh and stores them in LODIndices.
+			*
+			* Each level has about half the triangles of the level before it. Fewer levels are generated if the mesh can't be simplified
+			* any further without changing its shape too much.
+			*
+			* @param MaxLODs
+			* The maximum number of levels to generate, not counting the full detail mesh.
+			*/
+			void GenerateLODs(size_t MaxLODs = 3);
 
 			/**
 			* @brief
@@ -64,13 +105,37 @@ namespace ModelGenerator
 		Element& AddElement();
 
 		bool CastShadow = true, CastStaticShadow = true, TwoSided = false, HasCollision = false;
-		/// Loads a model (.jsm) file with the given name, then adds the model data of that file to the current model.
+		/**
+		* @brief
+		* Loads a model (.jsm) file with the given name, then adds the model data of that file to the current model.
+		*
+		* Both the binary format written by SaveModelData() and the old format with a separate value for each vertex component can be loaded.
+		*/
 		void LoadModelFromFile(std::string File);
 
 		void Clear();
 
-		/// Saves this model data 
-		void SaveModelData(std::string File);
+		/**
+		* @brief
+		* Saves this model data to a .jsm file.
+		*
+		* The file contains a header with the bounds of the model, followed by a block of vertices and a block of indices for each element.
+		* The blocks are aligned, so they can be used directly from a memory mapped file.
+		*
+		* @param QuantizeVertices
+		* If true, normals are stored as 2 16 bit values (octahedral encoding) and texture coordinates as 16 bit floats.
+		* This makes the vertices smaller, but loses some precision.
+		*/
+		void SaveModelData(std::string File, bool QuantizeVertices = false);
+
+		/**
+		* @brief
+		* Gets the version of the given .jsm file.
+		*
+		* @return
+		* 1 for the old format, 2 for the format written by SaveModelData(), 0 if the file doesn't exist.
+		*/
+		static uint32_t GetFileVersion(std::string File);
 
 		/**
 		* @brief
@@ -17,6 +17,7 @@
 #include <Rendering/Graphics.h>
 #include <Engine/Log.h>
 #include <Rendering/Drawable.h>
+#include <Rendering/RenderState.h>
 
 struct Uniform
 {
@@ -302,17 +303,13 @@ void Particles::ParticleEmitter::Update(Camera* MainCamera)
 void Particles::ParticleEmitter::Draw(Camera* MainCamera , bool MainFrameBuffer, bool TransparencyPass)
 {
 	if (!TransparencyPass) return;
-	glEnable(GL_CULL_FACE);
+	RenderState::SetCullFace(true);
 	glEnable(GL_BLEND);
 
 	glBindBuffer(GL_ARRAY_BUFFER, MatBuffer);
 	for (size_t Elem = 0; Elem < ParticleElements.size(); Elem++)
 	{
-		unsigned int ElemShader = Contexts[Elem].GetShader()->GetShaderID();
 		Contexts[Elem].Bind();
-		glUniformMatrix4fv(glGetUniformLocation(ElemShader, "u_projection"), 1, GL_FALSE, &MainCamera->GetProjection()[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ElemShader, "u_viewpro"), 1, GL_FALSE, &MainCamera->GetViewProjection()[0][0]);
-		glUniformMatrix4fv(glGetUniformLocation(ElemShader, "u_view"), 1, GL_FALSE, &MainCamera->getView()[0][0]);
 		ParticleVertexBuffers[Elem]->Bind();
 		if (MainFrameBuffer)
 		{
@@ -0,0 +1,45 @@
+#include "RenderState.h"
+#include <GL/glew.h>
+
+namespace RenderState
+{
+	static unsigned int CurrentProgram = 0;
+	// -1 if unknown.
+	static int CullFaceEnabled = -1;
+}
+
+void RenderState::UseProgram(unsigned int Program)
+{
+	if (Program == CurrentProgram)
+	{
+		return;
+	}
+	glUseProgram(Program);
+	CurrentProgram = Program;
+}
+
+void RenderState::ForgetProgram(unsigned int Program)
+{
+	if (Program == CurrentProgram)
+	{
+		glUseProgram(0);
+		CurrentProgram = 0;
+	}
+}
+
+void RenderState::SetCullFace(bool Enabled)
+{
+	if (CullFaceEnabled == (int)Enabled)
+	{
+		return;
+	}
+	if (Enabled)
+	{
+		glEnable(GL_CULL_FACE);
+	}
+	else
+	{
+		glDisable(GL_CULL_FACE);
+	}
+	CullFaceEnabled = Enabled;
+}
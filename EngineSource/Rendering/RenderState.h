@@ -0,0 +1,22 @@
+#pragma once
+
+/**
+* @brief
+* Cache of OpenGL state that changes often while drawing.
+*
+* The functions only call OpenGL if the new state is different from the current one.
+* All changes of the cached state must go through this namespace, otherwise the cache is out of date.
+*
+* @ingroup Internal
+*/
+namespace RenderState
+{
+	/// Binds the given shader program. Use Shader::Bind() instead of calling this directly.
+	void UseProgram(unsigned int Program);
+
+	/// Must be called before a program is deleted, so a new program with the same name is bound again.
+	void ForgetProgram(unsigned int Program);
+
+	/// Enables or disables back face culling.
+	void SetCullFace(bool Enabled);
+}
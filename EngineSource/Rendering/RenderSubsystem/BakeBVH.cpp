@@ -0,0 +1,384 @@
+#if EDITOR
+#include "BakeBVH.h"
+#include <algorithm>
+#include <bit>
+
+namespace Bake
+{
+	// Nodes with this many triangles or less always become leaves. A leaf is intersected as one packet, so small leaves are wasteful.
+	constexpr uint32_t BVH_MIN_LEAF_SIZE = 4;
+	// Nodes with more triangles than this are always split, even if the SAH says a leaf would be cheaper.
+	constexpr uint32_t BVH_MAX_LEAF_SIZE = PACKET_SIZE;
+	static_assert(BVH_MIN_LEAF_SIZE <= BVH_MAX_LEAF_SIZE);
+	constexpr uint32_t BVH_NUM_BINS = 16;
+	// Traversal stack entries kept on the stack of Trace(). Deeper trees use a heap allocated stack instead.
+	constexpr uint32_t BVH_STACK_SIZE = 128;
+
+	// Cost of traversing a node relative to intersecting a packet of triangles.
+	constexpr float BVH_TRAVERSAL_COST = 1.0f;
+
+	// Triangles are intersected in packets, so the intersection cost only goes up every PACKET_SIZE triangles.
+	static float GetIntersectionCost(uint32_t NumTriangles)
+	{
+		return (float)((NumTriangles + PACKET_SIZE - 1) / PACKET_SIZE);
+	}
+
+	struct Bounds
+	{
+		glm::vec3 Min = glm::vec3(INFINITY);
+		glm::vec3 Max = glm::vec3(-INFINITY);
+
+		void Grow(const glm::vec3& Point)
+		{
+			Min = glm::min(Min, Point);
+			Max = glm::max(Max, Point);
+		}
+
+		void Grow(const Bounds& Other)
+		{
+			Min = glm::min(Min, Other.Min);
+			Max = glm::max(Max, Other.Max);
+		}
+
+		// Half of the surface area, which is enough for comparing costs.
+		float Area() const
+		{
+			glm::vec3 Extent = Max - Min;
+			if (Extent.x < 0)
+			{
+				return 0;
+			}
+			return Extent.x * Extent.y + Extent.y * Extent.z + Extent.z * Extent.x;
+		}
+	};
+
+	static Bounds GetTriangleBounds(const BVH::Triangle& Tri)
+	{
+		Bounds b;
+		b.Grow(Tri.A);
+		b.Grow(Tri.A + Tri.E1);
+		b.Grow(Tri.A + Tri.E2);
+		return b;
+	}
+
+	static inline bool IntersectNode(const BVH::Node& Node, const glm::vec3& Origin, const glm::vec3& InvDirection,
+		float MinDistance, float MaxDistance, float& Near, float& Far)
+	{
+		float tx1 = (Node.Min.x - Origin.x) * InvDirection.x, tx2 = (Node.Max.x - Origin.x) * InvDirection.x;
+		float ty1 = (Node.Min.y - Origin.y) * InvDirection.y, ty2 = (Node.Max.y - Origin.y) * InvDirection.y;
+		float tz1 = (Node.Min.z - Origin.z) * InvDirection.z, tz2 = (Node.Max.z - Origin.z) * InvDirection.z;
+
+		Near = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), std::max(std::min(tz1, tz2), MinDistance));
+		Far = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), std::min(std::max(tz1, tz2), MaxDistance));
+		return Near <= Far;
+	}
+
+	BVH::Triangle::Triangle(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C)
+	{
+		this->A = A;
+		E1 = C - A;
+		E2 = B - A;
+		N = glm::cross(E1, E2);
+	}
+
+	void BVH::Build(std::vector<Triangle> NewTriangles)
+	{
+		Clear();
+		Triangles = std::move(NewTriangles);
+		if (Triangles.empty())
+		{
+			return;
+		}
+
+		std::vector<glm::vec3> Centroids;
+		Centroids.reserve(Triangles.size());
+		for (const Triangle& i : Triangles)
+		{
+			Centroids.push_back(i.A + (i.E1 + i.E2) / 3.0f);
+		}
+
+		Nodes.reserve(Triangles.size() * 2);
+		Depth = 0;
+		BuildNode(0, (uint32_t)Triangles.size(), Centroids, 1);
+		Nodes.shrink_to_fit();
+		BuildPackets();
+	}
+
+	void BVH::BuildPackets()
+	{
+		// Move each leaf's triangles to the start of a new packet.
+		std::vector<Triangle> PackedTriangles;
+		PackedTriangles.reserve(Triangles.size() * 2);
+
+		for (Node& i : Nodes)
+		{
+			if (!i.TriangleCount)
+			{
+				continue;
+			}
+			uint32_t First = (uint32_t)PackedTriangles.size();
+			for (uint32_t Tri = i.Index; Tri < i.Index + i.TriangleCount; Tri++)
+			{
+				PackedTriangles.push_back(Triangles[Tri]);
+			}
+			PackedTriangles.resize(First + PACKET_SIZE, Triangle(glm::vec3(0), glm::vec3(0), glm::vec3(0)));
+			i.Index = First;
+		}
+		Triangles = std::move(PackedTriangles);
+
+		Packets.resize(Triangles.size() / PACKET_SIZE);
+		for (size_t i = 0; i < Triangles.size(); i++)
+		{
+			const Triangle& Tri = Triangles[i];
+			Packets[i / PACKET_SIZE].Set(i % PACKET_SIZE, Tri.A, Tri.E1, Tri.E2, Tri.N);
+		}
+	}
+
+	void BVH::Clear()
+	{
+		Nodes.clear();
+		Triangles.clear();
+		Packets.clear();
+		Depth = 0;
+	}
+
+	uint32_t BVH::BuildNode(uint32_t First, uint32_t Count, std::vector<glm::vec3>& Centroids, uint32_t NodeDepth)
+	{
+		uint32_t NodeIndex = (uint32_t)Nodes.size();
+		Nodes.push_back(Node());
+		Depth = std::max(Depth, NodeDepth);
+
+		Bounds NodeBounds, CentroidBounds;
+		for (uint32_t i = First; i < First + Count; i++)
+		{
+			NodeBounds.Grow(GetTriangleBounds(Triangles[i]));
+			CentroidBounds.Grow(Centroids[i]);
+		}
+		Nodes[NodeIndex].Min = NodeBounds.Min;
+		Nodes[NodeIndex].Max = NodeBounds.Max;
+
+		if (Count <= BVH_MIN_LEAF_SIZE)
+		{
+			Nodes[NodeIndex].Index = First;
+			Nodes[NodeIndex].TriangleCount = Count;
+			return NodeIndex;
+		}
+
+		// Find the best split using binned SAH.
+		float BestCost = INFINITY;
+		int BestAxis = -1;
+		uint32_t BestSplit = 0;
+		glm::vec3 CentroidExtent = CentroidBounds.Max - CentroidBounds.Min;
+
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			if (CentroidExtent[Axis] <= 0)
+			{
+				continue;
+			}
+
+			Bounds Bins[BVH_NUM_BINS];
+			uint32_t BinCounts[BVH_NUM_BINS] = {};
+			float BinScale = BVH_NUM_BINS / CentroidExtent[Axis];
+
+			for (uint32_t i = First; i < First + Count; i++)
+			{
+				uint32_t Bin = std::min(BVH_NUM_BINS - 1, (uint32_t)((Centroids[i][Axis] - CentroidBounds.Min[Axis]) * BinScale));
+				BinCounts[Bin]++;
+				Bins[Bin].Grow(GetTriangleBounds(Triangles[i]));
+			}
+
+			float LeftAreas[BVH_NUM_BINS - 1];
+			uint32_t LeftCounts[BVH_NUM_BINS - 1];
+			Bounds Left;
+			uint32_t LeftCount = 0;
+			for (uint32_t i = 0; i < BVH_NUM_BINS - 1; i++)
+			{
+				Left.Grow(Bins[i]);
+				LeftCount += BinCounts[i];
+				LeftAreas[i] = Left.Area();
+				LeftCounts[i] = LeftCount;
+			}
+
+			Bounds Right;
+			uint32_t RightCount = 0;
+			for (uint32_t i = BVH_NUM_BINS - 1; i > 0; i--)
+			{
+				Right.Grow(Bins[i]);
+				RightCount += BinCounts[i];
+				if (LeftCounts[i - 1] == 0 || RightCount == 0)
+				{
+					continue;
+				}
+				float Cost = LeftAreas[i - 1] * GetIntersectionCost(LeftCounts[i - 1]) + Right.Area() * GetIntersectionCost(RightCount);
+				if (Cost < BestCost)
+				{
+					BestCost = Cost;
+					BestAxis = Axis;
+					BestSplit = i;
+				}
+			}
+		}
+
+		float LeafCost = NodeBounds.Area() * GetIntersectionCost(Count);
+		BestCost = BestCost + BVH_TRAVERSAL_COST * NodeBounds.Area();
+		if (BestCost >= LeafCost && Count <= BVH_MAX_LEAF_SIZE)
+		{
+			Nodes[NodeIndex].Index = First;
+			Nodes[NodeIndex].TriangleCount = Count;
+			return NodeIndex;
+		}
+
+		uint32_t Middle = First;
+		if (BestAxis == -1)
+		{
+			// All centroids are in the same spot, so any split is as good as any other.
+			Middle = First + Count / 2;
+		}
+		else
+		{
+			float BinScale = BVH_NUM_BINS / CentroidExtent[BestAxis];
+			for (uint32_t i = First; i < First + Count; i++)
+			{
+				uint32_t Bin = std::min(BVH_NUM_BINS - 1, (uint32_t)((Centroids[i][BestAxis] - CentroidBounds.Min[BestAxis]) * BinScale));
+				if (Bin < BestSplit)
+				{
+					std::swap(Triangles[i], Triangles[Middle]);
+					std::swap(Centroids[i], Centroids[Middle]);
+					Middle++;
+				}
+			}
+		}
+
+		// The left child is always the node directly after this one.
+		BuildNode(First, Middle - First, Centroids, NodeDepth + 1);
+		uint32_t RightChild = BuildNode(Middle, First + Count - Middle, Centroids, NodeDepth + 1);
+		Nodes[NodeIndex].Index = RightChild;
+		Nodes[NodeIndex].TriangleCount = 0;
+		return NodeIndex;
+	}
+
+	BVH::Hit BVH::Trace(const glm::vec3& Origin, const glm::vec3& Direction, TraceMode Mode, float MinDistance, float MaxDistance) const
+	{
+		Hit Result;
+		if (Nodes.empty())
+		{
+			return Result;
+		}
+
+		struct StackEntry
+		{
+			uint32_t Node;
+			// Near distance of the node for TraceMode::Closest, far distance for TraceMode::Farthest.
+			float Distance;
+		};
+
+		const glm::vec3 InvDirection = glm::vec3(1.0f) / Direction;
+		// Every node pops one entry and pushes at most two, so the stack never holds more than Depth + 1 entries.
+		StackEntry LocalStack[BVH_STACK_SIZE];
+		std::vector<StackEntry> HeapStack;
+		StackEntry* Stack = LocalStack;
+		if (Depth + 1 > BVH_STACK_SIZE)
+		{
+			HeapStack.resize(Depth + 1);
+			Stack = HeapStack.data();
+		}
+		uint32_t StackSize = 0;
+
+		float Near = 0, Far = 0;
+		if (!IntersectNode(Nodes[0], Origin, InvDirection, MinDistance, MaxDistance, Near, Far))
+		{
+			return Result;
+		}
+		Stack[StackSize++] = StackEntry{ 0, Mode == TraceMode::Farthest ? Far : Near };
+
+		while (StackSize)
+		{
+			StackEntry Entry = Stack[--StackSize];
+
+			// The node might not be able to contain a better hit than the one found since it was pushed.
+			if (Result.Hit && Mode == TraceMode::Closest && Entry.Distance > Result.Distance)
+			{
+				continue;
+			}
+			if (Result.Hit && Mode == TraceMode::Farthest && Entry.Distance < Result.Distance)
+			{
+				continue;
+			}
+
+			const Node& Current = Nodes[Entry.Node];
+
+			if (Current.TriangleCount)
+			{
+				alignas(32) float Distances[PACKET_SIZE];
+				uint32_t HitMask = Kernel::IntersectPacket(Packets[Current.Index / PACKET_SIZE], Origin, Direction, MinDistance, MaxDistance, Distances);
+				HitMask &= (1u << Current.TriangleCount) - 1;
+
+				while (HitMask)
+				{
+					uint32_t Lane = (uint32_t)std::countr_zero(HitMask);
+					HitMask &= HitMask - 1;
+					float Distance = Distances[Lane];
+
+					if (Mode == TraceMode::Any)
+					{
+						Result.Hit = true;
+						Result.Distance = Distance;
+						Result.Triangle = Current.Index + Lane;
+						return Result;
+					}
+					if (!Result.Hit
+						|| (Mode == TraceMode::Closest && Distance < Result.Distance)
+						|| (Mode == TraceMode::Farthest && Distance > Result.Distance))
+					{
+						Result.Hit = true;
+						Result.Distance = Distance;
+						Result.Triangle = Current.Index + Lane;
+					}
+				}
+				continue;
+			}
+
+			float Min = MinDistance, Max = MaxDistance;
+			if (Result.Hit && Mode == TraceMode::Closest)
+			{
+				Max = Result.Distance;
+			}
+			else if (Result.Hit && Mode == TraceMode::Farthest)
+			{
+				Min = Result.Distance;
+			}
+
+			uint32_t Children[2] = { Entry.Node + 1, Current.Index };
+			float ChildNear[2], ChildFar[2];
+			bool ChildHit[2];
+			for (int i = 0; i < 2; i++)
+			{
+				ChildHit[i] = IntersectNode(Nodes[Children[i]], Origin, InvDirection, Min, Max, ChildNear[i], ChildFar[i]);
+			}
+
+			// Push the child that should be visited first last, so it's popped first.
+			int First = 0;
+			if (Mode == TraceMode::Farthest)
+			{
+				First = ChildFar[1] > ChildFar[0] ? 1 : 0;
+			}
+			else
+			{
+				First = ChildNear[1] < ChildNear[0] ? 1 : 0;
+			}
+			int Second = 1 - First;
+
+			if (ChildHit[Second])
+			{
+				Stack[StackSize++] = StackEntry{ Children[Second], Mode == TraceMode::Farthest ? ChildFar[Second] : ChildNear[Second] };
+			}
+			if (ChildHit[First])
+			{
+				Stack[StackSize++] = StackEntry{ Children[First], Mode == TraceMode::Farthest ? ChildFar[First] : ChildNear[First] };
+			}
+		}
+		return Result;
+	}
+}
+#endif
@@ -0,0 +1,142 @@
+#if EDITOR
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/geometric.hpp>
+#include "BakeRayKernel.h"
+
+/**
+* @file
+* @brief
+* Bounding volume hierarchy used to accelerate ray casts when baking lighting.
+*/
+
+namespace Bake
+{
+	/**
+	* @brief
+	* A static bounding volume hierarchy over the triangles of a scene.
+	*
+	* The tree is built once per bake using the surface area heuristic and stored as a flat array of nodes.
+	* A node's left child is always directly after it in the node array, so only the index of the right child has to be stored.
+	*
+	* @ingroup Internal
+	*/
+	struct BVH
+	{
+		/**
+		* @brief
+		* A triangle in the BVH. Edges and the normal are precomputed so the ray intersection kernel doesn't have to.
+		*/
+		struct Triangle
+		{
+			glm::vec3 A;
+			/// C - A
+			glm::vec3 E1;
+			/// B - A
+			glm::vec3 E2;
+			/// cross(E1, E2), not normalized.
+			glm::vec3 N;
+
+			Triangle() {}
+			Triangle(const glm::vec3& A, const glm::vec3& B, const glm::vec3& C);
+
+			/**
+			* @brief
+			* Intersects a ray with this triangle. Both sides of the triangle are hit.
+			*
+			* @param Distance
+			* Set to the distance along Direction, in multiples of its length.
+			*/
+			inline bool Intersect(const glm::vec3& Origin, const glm::vec3& Direction, float& Distance) const
+			{
+				float det = -glm::dot(Direction, N);
+				float invdet = 1.0f / det;
+				glm::vec3 AO = Origin - A;
+				glm::vec3 DAO = glm::cross(AO, Direction);
+				float u = glm::dot(E2, DAO) * invdet;
+				float v = -glm::dot(E1, DAO) * invdet;
+				Distance = glm::dot(AO, N) * invdet;
+				return Distance >= 0.0f && u >= 0.0f && v >= 0.0f && (u + v) <= 1.0f;
+			}
+		};
+
+		/**
+		* @brief
+		* A node of the BVH. Two nodes fit into one cache line.
+		*/
+		struct Node
+		{
+			glm::vec3 Min;
+			/// If TriangleCount is 0, the index of the right child. Otherwise the index of the first triangle, which is a multiple of PACKET_SIZE.
+			uint32_t Index = 0;
+			glm::vec3 Max;
+			/// The number of triangles in this node. 0 for interior nodes.
+			uint32_t TriangleCount = 0;
+		};
+
+		/// The ways a ray can be traced through the BVH.
+		enum class TraceMode
+		{
+			/// Finds the hit closest to the ray origin.
+			Closest,
+			/// Finds the hit furthest away from the ray origin.
+			Farthest,
+			/// Returns the first hit that is found. Useful for shadow rays, which only need to know if something is in the way.
+			Any,
+		};
+
+		/// The result of BVH::Trace().
+		struct Hit
+		{
+			bool Hit = false;
+			/// The distance along the ray direction, in multiples of the direction's length.
+			float Distance = 0;
+			/// Index into BVH::Triangles.
+			uint32_t Triangle = 0;
+		};
+
+		std::vector<Node> Nodes;
+		/// Triangles, sorted so that each leaf node references a contiguous range. Leaves are padded to PACKET_SIZE with empty triangles.
+		std::vector<Triangle> Triangles;
+		/// The same triangles as BVH::Triangles, as packets. Triangles[i] is in Packets[i / PACKET_SIZE].
+		std::vector<TrianglePacket> Packets;
+		/// The number of nodes on the longest path from the root to a leaf. Used to size the traversal stack.
+		uint32_t Depth = 0;
+
+		/**
+		* @brief
+		* Builds the BVH over the given triangles. Replaces the previous content of the BVH.
+		*/
+		void Build(std::vector<Triangle> NewTriangles);
+
+		/// Clears all nodes and triangles.
+		void Clear();
+
+		/**
+		* @brief
+		* Traces a ray through the BVH.
+		*
+		* @param Origin
+		* The start of the ray.
+		*
+		* @param Direction
+		* The direction of the ray. Does not need to be normalized, distances are given in multiples of its length.
+		*
+		* @param MinDistance
+		* Hits closer than this are ignored.
+		*
+		* @param MaxDistance
+		* Hits further away than this are ignored.
+		*/
+		Hit Trace(const glm::vec3& Origin, const glm::vec3& Direction, TraceMode Mode,
+			float MinDistance = 0, float MaxDistance = INFINITY) const;
+
+	private:
+		uint32_t BuildNode(uint32_t First, uint32_t Count, std::vector<glm::vec3>& Centroids, uint32_t NodeDepth);
+		void BuildPackets();
+	};
+}
+#endif
@@ -0,0 +1,246 @@
+#if EDITOR
+#include "BakeRayKernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BAKE_KERNEL_X64 1
+#include <immintrin.h>
+#if _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows AVX2 intrinsics in any function. GCC and Clang need the function to be compiled for AVX2.
+#if BAKE_KERNEL_X64 && (defined(__GNUC__) || defined(__clang__))
+#define BAKE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define BAKE_TARGET_AVX2
+#endif
+
+namespace Bake
+{
+	void TrianglePacket::Set(uint32_t Lane, const glm::vec3& A, const glm::vec3& E1, const glm::vec3& E2, const glm::vec3& N)
+	{
+		Ax[Lane] = A.x;
+		Ay[Lane] = A.y;
+		Az[Lane] = A.z;
+		E1x[Lane] = E1.x;
+		E1y[Lane] = E1.y;
+		E1z[Lane] = E1.z;
+		E2x[Lane] = E2.x;
+		E2y[Lane] = E2.y;
+		E2z[Lane] = E2.z;
+		Nx[Lane] = N.x;
+		Ny[Lane] = N.y;
+		Nz[Lane] = N.z;
+	}
+
+	// All kernels use the same math as BVH::Triangle::Intersect().
+
+	static uint32_t IntersectScalar(const TrianglePacket& p, const glm::vec3& O, const glm::vec3& D,
+		float MinDistance, float MaxDistance, float* Distances)
+	{
+		uint32_t HitMask = 0;
+		for (uint32_t i = 0; i < PACKET_SIZE; i++)
+		{
+			float det = -(D.x * p.Nx[i] + D.y * p.Ny[i] + D.z * p.Nz[i]);
+			float invdet = 1.0f / det;
+			float AOx = O.x - p.Ax[i], AOy = O.y - p.Ay[i], AOz = O.z - p.Az[i];
+			float DAOx = AOy * D.z - AOz * D.y;
+			float DAOy = AOz * D.x - AOx * D.z;
+			float DAOz = AOx * D.y - AOy * D.x;
+			float u = (p.E2x[i] * DAOx + p.E2y[i] * DAOy + p.E2z[i] * DAOz) * invdet;
+			float v = -(p.E1x[i] * DAOx + p.E1y[i] * DAOy + p.E1z[i] * DAOz) * invdet;
+			float t = (AOx * p.Nx[i] + AOy * p.Ny[i] + AOz * p.Nz[i]) * invdet;
+			Distances[i] = t;
+			if (t >= 0.0f && t >= MinDistance && t <= MaxDistance && u >= 0.0f && v >= 0.0f && (u + v) <= 1.0f)
+			{
+				HitMask |= 1u << i;
+			}
+		}
+		return HitMask;
+	}
+
+#if BAKE_KERNEL_X64
+	static uint32_t IntersectSSE(const TrianglePacket& p, const glm::vec3& O, const glm::vec3& D,
+		float MinDistance, float MaxDistance, float* Distances)
+	{
+		const __m128 Ox = _mm_set1_ps(O.x), Oy = _mm_set1_ps(O.y), Oz = _mm_set1_ps(O.z);
+		const __m128 Dx = _mm_set1_ps(D.x), Dy = _mm_set1_ps(D.y), Dz = _mm_set1_ps(D.z);
+		const __m128 Zero = _mm_setzero_ps(), One = _mm_set1_ps(1.0f);
+		const __m128 Min = _mm_max_ps(_mm_set1_ps(MinDistance), Zero), Max = _mm_set1_ps(MaxDistance);
+
+		uint32_t HitMask = 0;
+		for (uint32_t i = 0; i < PACKET_SIZE; i += 4)
+		{
+			__m128 Nx = _mm_load_ps(p.Nx + i), Ny = _mm_load_ps(p.Ny + i), Nz = _mm_load_ps(p.Nz + i);
+			__m128 det = _mm_sub_ps(Zero, _mm_add_ps(_mm_add_ps(_mm_mul_ps(Dx, Nx), _mm_mul_ps(Dy, Ny)), _mm_mul_ps(Dz, Nz)));
+			__m128 invdet = _mm_div_ps(One, det);
+
+			__m128 AOx = _mm_sub_ps(Ox, _mm_load_ps(p.Ax + i));
+			__m128 AOy = _mm_sub_ps(Oy, _mm_load_ps(p.Ay + i));
+			__m128 AOz = _mm_sub_ps(Oz, _mm_load_ps(p.Az + i));
+			__m128 DAOx = _mm_sub_ps(_mm_mul_ps(AOy, Dz), _mm_mul_ps(AOz, Dy));
+			__m128 DAOy = _mm_sub_ps(_mm_mul_ps(AOz, Dx), _mm_mul_ps(AOx, Dz));
+			__m128 DAOz = _mm_sub_ps(_mm_mul_ps(AOx, Dy), _mm_mul_ps(AOy, Dx));
+
+			__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_load_ps(p.E2x + i), DAOx),
+				_mm_mul_ps(_mm_load_ps(p.E2y + i), DAOy)),
+				_mm_mul_ps(_mm_load_ps(p.E2z + i), DAOz)), invdet);
+			__m128 v = _mm_mul_ps(_mm_sub_ps(Zero, _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_load_ps(p.E1x + i), DAOx),
+				_mm_mul_ps(_mm_load_ps(p.E1y + i), DAOy)),
+				_mm_mul_ps(_mm_load_ps(p.E1z + i), DAOz))), invdet);
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(AOx, Nx), _mm_mul_ps(AOy, Ny)), _mm_mul_ps(AOz, Nz)), invdet);
+
+			__m128 Hit = _mm_and_ps(_mm_cmpge_ps(t, Min), _mm_cmple_ps(t, Max));
+			Hit = _mm_and_ps(Hit, _mm_and_ps(_mm_cmpge_ps(u, Zero), _mm_cmpge_ps(v, Zero)));
+			Hit = _mm_and_ps(Hit, _mm_cmple_ps(_mm_add_ps(u, v), One));
+
+			_mm_storeu_ps(Distances + i, t);
+			HitMask |= (uint32_t)_mm_movemask_ps(Hit) << i;
+		}
+		return HitMask;
+	}
+
+	BAKE_TARGET_AVX2 static uint32_t IntersectAVX2(const TrianglePacket& p, const glm::vec3& O, const glm::vec3& D,
+		float MinDistance, float MaxDistance, float* Distances)
+	{
+		const __m256 Ox = _mm256_set1_ps(O.x), Oy = _mm256_set1_ps(O.y), Oz = _mm256_set1_ps(O.z);
+		const __m256 Dx = _mm256_set1_ps(D.x), Dy = _mm256_set1_ps(D.y), Dz = _mm256_set1_ps(D.z);
+		const __m256 Zero = _mm256_setzero_ps(), One = _mm256_set1_ps(1.0f);
+		const __m256 Min = _mm256_max_ps(_mm256_set1_ps(MinDistance), Zero), Max = _mm256_set1_ps(MaxDistance);
+
+		__m256 Nx = _mm256_load_ps(p.Nx), Ny = _mm256_load_ps(p.Ny), Nz = _mm256_load_ps(p.Nz);
+		__m256 det = _mm256_sub_ps(Zero, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(Dx, Nx), _mm256_mul_ps(Dy, Ny)), _mm256_mul_ps(Dz, Nz)));
+		__m256 invdet = _mm256_div_ps(One, det);
+
+		__m256 AOx = _mm256_sub_ps(Ox, _mm256_load_ps(p.Ax));
+		__m256 AOy = _mm256_sub_ps(Oy, _mm256_load_ps(p.Ay));
+		__m256 AOz = _mm256_sub_ps(Oz, _mm256_load_ps(p.Az));
+		__m256 DAOx = _mm256_sub_ps(_mm256_mul_ps(AOy, Dz), _mm256_mul_ps(AOz, Dy));
+		__m256 DAOy = _mm256_sub_ps(_mm256_mul_ps(AOz, Dx), _mm256_mul_ps(AOx, Dz));
+		__m256 DAOz = _mm256_sub_ps(_mm256_mul_ps(AOx, Dy), _mm256_mul_ps(AOy, Dx));
+
+		__m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_load_ps(p.E2x), DAOx),
+			_mm256_mul_ps(_mm256_load_ps(p.E2y), DAOy)),
+			_mm256_mul_ps(_mm256_load_ps(p.E2z), DAOz)), invdet);
+		__m256 v = _mm256_mul_ps(_mm256_sub_ps(Zero, _mm256_add_ps(_mm256_add_ps(
+			_mm256_mul_ps(_mm256_load_ps(p.E1x), DAOx),
+			_mm256_mul_ps(_mm256_load_ps(p.E1y), DAOy)),
+			_mm256_mul_ps(_mm256_load_ps(p.E1z), DAOz))), invdet);
+		__m256 t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(AOx, Nx), _mm256_mul_ps(AOy, Ny)), _mm256_mul_ps(AOz, Nz)), invdet);
+
+		__m256 Hit = _mm256_and_ps(_mm256_cmp_ps(t, Min, _CMP_GE_OQ), _mm256_cmp_ps(t, Max, _CMP_LE_OQ));
+		Hit = _mm256_and_ps(Hit, _mm256_and_ps(_mm256_cmp_ps(u, Zero, _CMP_GE_OQ), _mm256_cmp_ps(v, Zero, _CMP_GE_OQ)));
+		Hit = _mm256_and_ps(Hit, _mm256_cmp_ps(_mm256_add_ps(u, v), One, _CMP_LE_OQ));
+
+		_mm256_storeu_ps(Distances, t);
+		return (uint32_t)_mm256_movemask_ps(Hit);
+	}
+
+	static bool CpuSupportsAVX2()
+	{
+#if _MSC_VER
+		int Info[4];
+		__cpuid(Info, 0);
+		if (Info[0] < 7)
+		{
+			return false;
+		}
+		__cpuid(Info, 1);
+		bool OSXSave = Info[2] & (1 << 27);
+		bool AVX = Info[2] & (1 << 28);
+		__cpuidex(Info, 7, 0);
+		bool AVX2 = Info[1] & (1 << 5);
+		// The OS also has to save the AVX registers on context switches.
+		return OSXSave && AVX && AVX2 && (_xgetbv(0) & 0x6) == 0x6;
+#else
+		// The kernel is selected during static initialization, which might run before the CPU model has been initialized.
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	bool Kernel::IsSupported(Type KernelType)
+	{
+		switch (KernelType)
+		{
+		case Type::Scalar:
+			return true;
+#if BAKE_KERNEL_X64
+		// SSE2 is part of x86_64.
+		case Type::SSE:
+			return true;
+		case Type::AVX2:
+			return CpuSupportsAVX2();
+#endif
+		default:
+			return false;
+		}
+	}
+
+	Kernel::Type Kernel::GetBestSupported()
+	{
+		if (IsSupported(Type::AVX2))
+		{
+			return Type::AVX2;
+		}
+		if (IsSupported(Type::SSE))
+		{
+			return Type::SSE;
+		}
+		return Type::Scalar;
+	}
+
+	Kernel::IntersectFunction Kernel::GetFunction(Type KernelType)
+	{
+		switch (KernelType)
+		{
+#if BAKE_KERNEL_X64
+		case Type::SSE:
+			return IntersectSSE;
+		case Type::AVX2:
+			return IntersectAVX2;
+#endif
+		default:
+			return IntersectScalar;
+		}
+	}
+
+	static Kernel::Type SelectedKernel = Kernel::GetBestSupported();
+	Kernel::IntersectFunction Kernel::IntersectPacket = Kernel::GetFunction(SelectedKernel);
+
+	void Kernel::Select(Type KernelType)
+	{
+		if (!IsSupported(KernelType))
+		{
+			return;
+		}
+		SelectedKernel = KernelType;
+		IntersectPacket = GetFunction(KernelType);
+	}
+
+	Kernel::Type Kernel::GetSelected()
+	{
+		return SelectedKernel;
+	}
+
+	std::string Kernel::GetName(Type KernelType)
+	{
+		switch (KernelType)
+		{
+		case Type::Scalar:
+			return "Scalar";
+		case Type::SSE:
+			return "SSE";
+		case Type::AVX2:
+			return "AVX2";
+		default:
+			return "Unknown";
+		}
+	}
+}
+#endif
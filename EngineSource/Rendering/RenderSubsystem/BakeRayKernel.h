@@ -0,0 +1,82 @@
+#if EDITOR
+#pragma once
+#include <cstdint>
+#include <string>
+#include <glm/vec3.hpp>
+
+/**
+* @file
+* @brief
+* Vectorized ray-triangle intersection used by the lighting baker.
+*/
+
+namespace Bake
+{
+	/// The number of triangles in a TrianglePacket.
+	constexpr uint32_t PACKET_SIZE = 8;
+
+	/**
+	* @brief
+	* PACKET_SIZE triangles stored as a structure of arrays, so they can be intersected with a single ray at once.
+	*
+	* Unused lanes should be left zeroed. Zero triangles are never hit.
+	*/
+	struct alignas(32) TrianglePacket
+	{
+		float Ax[PACKET_SIZE] = {}, Ay[PACKET_SIZE] = {}, Az[PACKET_SIZE] = {};
+		float E1x[PACKET_SIZE] = {}, E1y[PACKET_SIZE] = {}, E1z[PACKET_SIZE] = {};
+		float E2x[PACKET_SIZE] = {}, E2y[PACKET_SIZE] = {}, E2z[PACKET_SIZE] = {};
+		float Nx[PACKET_SIZE] = {}, Ny[PACKET_SIZE] = {}, Nz[PACKET_SIZE] = {};
+
+		/// Sets the triangle in the given lane. The values are the same as the ones in BVH::Triangle.
+		void Set(uint32_t Lane, const glm::vec3& A, const glm::vec3& E1, const glm::vec3& E2, const glm::vec3& N);
+	};
+
+	/**
+	* @brief
+	* Ray-triangle intersection kernels.
+	*
+	* The best kernel supported by the CPU is selected at startup.
+	*/
+	namespace Kernel
+	{
+		enum class Type
+		{
+			Scalar,
+			/// 2x 4 triangles at once with SSE.
+			SSE,
+			/// 8 triangles at once with AVX2.
+			AVX2,
+		};
+
+		/**
+		* @brief
+		* Intersects one ray with all triangles in a packet.
+		*
+		* @param Distances
+		* Array of PACKET_SIZE floats. For each hit triangle, the distance along Direction is written to its lane.
+		*
+		* @return
+		* A bit mask of the hit lanes.
+		*/
+		using IntersectFunction = uint32_t(*)(const TrianglePacket& Packet, const glm::vec3& Origin, const glm::vec3& Direction,
+			float MinDistance, float MaxDistance, float* Distances);
+
+		/// The currently selected intersection kernel.
+		extern IntersectFunction IntersectPacket;
+
+		/// True if the CPU can run the given kernel type.
+		bool IsSupported(Type KernelType);
+		/// Returns the fastest kernel type supported by the CPU.
+		Type GetBestSupported();
+		/// Returns the intersection function for the given kernel type. The type must be supported.
+		IntersectFunction GetFunction(Type KernelType);
+
+		/// Sets Kernel::IntersectPacket to the given kernel type, if it's supported.
+		void Select(Type KernelType);
+		Type GetSelected();
+
+		std::string GetName(Type KernelType);
+	}
+}
+#endif
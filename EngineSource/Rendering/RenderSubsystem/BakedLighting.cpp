@@ -6,6 +6,7 @@
 #include <iostream>
 #include <Math/Collision/Collision.h>
 #include <Rendering/Graphics.h>
+#include <Rendering/Camera/Camera.h>
 #include <Objects/Components/MeshComponent.h>
 #include <Rendering/Mesh/ModelGenerator.h>
 #include <thread>
@@ -18,6 +19,14 @@
 #include <deque>
 #include <Engine/Subsystem/BackgroundTask.h>
 #include <Engine/Log.h>
+#include <Engine/Subsystem/Console.h>
+#include <limits>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include "BakeBVH.h"
+#include <Engine/Utility/CompressionUtility.h>
 
 unsigned int BakedLighting::LightTexture = 0;
 float BakedLighting::LightmapScaleMultiplier = 1;
@@ -39,7 +48,283 @@ int64_t BakedLighting::GetLightTextureSize()
 	return LightmapResolution;
 }
 
-constexpr uint8_t BKDAT_FILE_VERSION = 2;
+/**
+* @brief
+* The current .bkdat file version.
+*
+* Version 3 files divide the lightmap into bricks. A table with one entry per brick is followed by the brick data.
+* Bricks where all texels have the same value only store that value, all others are delta encoded along the X axis
+* and compressed with CompressionUtil.
+*/
+constexpr uint8_t BKDAT_FILE_VERSION = 3;
+/// Version 2 files store the whole lightmap as a single RLE stream. They can still be loaded.
+constexpr uint8_t BKDAT_RLE_FILE_VERSION = 2;
+
+/// How many bricks are uploaded per frame when streaming a lightmap.
+constexpr uint64_t STREAMED_BRICKS_PER_FRAME = 64;
+
+bool BakedLighting::StreamLightmap = true;
+int BakedLighting::LightmapStreamDistance = 8;
+
+enum class BakeBrickType : uint8_t
+{
+	/// All texels have the same value.
+	Uniform,
+	/// Delta encoded and compressed texels.
+	Compressed,
+	/// Texels that didn't get smaller when compressed, stored as they are.
+	Raw,
+};
+
+/**
+* @brief
+* An entry in the brick table of a version 3 .bkdat file.
+*/
+struct BakeFileBrick
+{
+	/// Hash of the inputs of the brick when it was baked.
+	uint64_t Hash = 0;
+	/// Offset of the brick data, relative to the start of the data of all bricks.
+	uint64_t Offset = 0;
+	uint32_t Size = 0;
+	BakeBrickType Type = BakeBrickType::Uniform;
+	/// For uniform bricks the value of all texels, otherwise the average value.
+	uint8_t Value = 128;
+	uint16_t Padding = 0;
+};
+static_assert(sizeof(BakeFileBrick) == 24, "BakeFileBrick is written to files directly and must not contain padding");
+
+/**
+* @brief
+* The contents of a .bkdat file.
+*
+* For version 3 files, the bricks are kept compressed and decoded one at a time with GetBrickTexels().
+* For version 2 files, the whole texture is decoded. They may have a table of brick hashes after the texture data.
+*/
+struct BakeFileData
+{
+	uint64_t Resolution = 0;
+	Vector3 Scale;
+	uint64_t BrickSize = 0;
+	/// Hashes of the inputs of each brick of the lightmap. Empty if the file doesn't have any.
+	std::vector<uint64_t> BrickHashes;
+	/// The brick table. Empty for version 2 files.
+	std::vector<BakeFileBrick> Bricks;
+	/// The data of all bricks.
+	std::vector<uint8_t> BrickData;
+	/// The decoded texture of a version 2 file.
+	std::vector<uint8_t> Texture;
+};
+
+static uint64_t GetBricksPerAxis(uint64_t Resolution, uint64_t BrickSize)
+{
+	return (Resolution + BrickSize - 1) / BrickSize;
+}
+
+static void GetBrickBounds(uint64_t Brick, uint64_t Resolution, uint64_t BrickSize, uint64_t Start[3], uint64_t End[3])
+{
+	const uint64_t BricksPerAxis = GetBricksPerAxis(Resolution, BrickSize);
+	const uint64_t BrickPos[3] = { Brick % BricksPerAxis, (Brick / BricksPerAxis) % BricksPerAxis, Brick / (BricksPerAxis * BricksPerAxis) };
+	for (int i = 0; i < 3; i++)
+	{
+		Start[i] = BrickPos[i] * BrickSize;
+		End[i] = std::min(Start[i] + BrickSize, Resolution);
+	}
+}
+
+/// Copies the texels of a brick between a tightly packed brick buffer and a texture with the given resolution.
+static void CopyBrick(uint8_t* Texture, uint8_t* BrickTexels, uint64_t Resolution, const uint64_t Start[3], const uint64_t End[3], bool ToTexture)
+{
+	const uint64_t RowSize = End[0] - Start[0];
+	for (uint64_t z = Start[2]; z < End[2]; z++)
+	{
+		for (uint64_t y = Start[1]; y < End[1]; y++)
+		{
+			uint8_t* TextureRow = Texture + Start[0] + y * Resolution + z * Resolution * Resolution;
+			uint8_t* BrickRow = BrickTexels + ((y - Start[1]) + (z - Start[2]) * (End[1] - Start[1])) * RowSize;
+			if (ToTexture)
+			{
+				std::memcpy(TextureRow, BrickRow, RowSize);
+			}
+			else
+			{
+				std::memcpy(BrickRow, TextureRow, RowSize);
+			}
+		}
+	}
+}
+
+static bool ReadRLEBakeFile(std::ifstream& InFile, BakeFileData& Out, std::string& Error)
+{
+	size_t FileLength = 0;
+	InFile.read((char*)&FileLength, sizeof(FileLength));
+	InFile.read((char*)&Out.Resolution, sizeof(Out.Resolution));
+	InFile.read((char*)&Out.Scale, sizeof(Out.Scale));
+
+	const size_t TextureSize = Out.Resolution * Out.Resolution * Out.Resolution * NUM_CHANNELS;
+	Out.Texture.clear();
+	Out.Texture.resize(TextureSize, 0);
+
+	size_t Iterator = 0;
+	for (size_t i = 0; i < FileLength; i++)
+	{
+		uint8_t Value = 0;
+		uint8_t Length = 0;
+		InFile.read((char*)&Length, sizeof(Length));
+		InFile.read((char*)&Value, sizeof(Value));
+		for (size_t i = 0; i < Length && Iterator < TextureSize; i++)
+		{
+			Out.Texture[Iterator] = Value;
+			Iterator++;
+		}
+	}
+	if (!InFile.good())
+	{
+		Error = "Unexpected end of file";
+		return false;
+	}
+
+	uint64_t NumBricks = 0;
+	Out.BrickHashes.clear();
+	if (InFile.read((char*)&Out.BrickSize, sizeof(Out.BrickSize)) && InFile.read((char*)&NumBricks, sizeof(NumBricks)))
+	{
+		Out.BrickHashes.resize(NumBricks);
+		if (!InFile.read((char*)Out.BrickHashes.data(), NumBricks * sizeof(uint64_t)))
+		{
+			Out.BrickHashes.clear();
+		}
+	}
+	return true;
+}
+
+static bool ReadBakeFile(const std::string& File, BakeFileData& Out, std::string& Error)
+{
+	std::ifstream InFile = std::ifstream(File, std::ios::binary | std::ios::in);
+	if (!InFile.good())
+	{
+		Error = "Could not open file";
+		return false;
+	}
+
+	uint8_t FileVer = 0;
+	InFile.read((char*)&FileVer, sizeof(FileVer));
+	if (FileVer == BKDAT_RLE_FILE_VERSION)
+	{
+		return ReadRLEBakeFile(InFile, Out, Error);
+	}
+	if (BKDAT_FILE_VERSION != FileVer)
+	{
+		Error = "File version mismatch of bkdat file. Supported version: " + std::to_string(BKDAT_FILE_VERSION) + ", Loaded version: " + std::to_string(FileVer);
+		return false;
+	}
+
+	uint64_t NumBricks = 0;
+	InFile.read((char*)&Out.Resolution, sizeof(Out.Resolution));
+	InFile.read((char*)&Out.Scale, sizeof(Out.Scale));
+	InFile.read((char*)&Out.BrickSize, sizeof(Out.BrickSize));
+	InFile.read((char*)&NumBricks, sizeof(NumBricks));
+	if (!InFile.good() || Out.BrickSize == 0
+		|| NumBricks != GetBricksPerAxis(Out.Resolution, Out.BrickSize) * GetBricksPerAxis(Out.Resolution, Out.BrickSize) * GetBricksPerAxis(Out.Resolution, Out.BrickSize))
+	{
+		Error = "Invalid bkdat file header";
+		return false;
+	}
+
+	Out.Bricks.resize(NumBricks);
+	InFile.read((char*)Out.Bricks.data(), NumBricks * sizeof(BakeFileBrick));
+
+	uint64_t DataSize = 0;
+	InFile.read((char*)&DataSize, sizeof(DataSize));
+	if (!InFile.good())
+	{
+		Error = "Unexpected end of file";
+		return false;
+	}
+	Out.BrickData.resize(DataSize);
+	if (!InFile.read((char*)Out.BrickData.data(), DataSize))
+	{
+		Error = "Unexpected end of file";
+		return false;
+	}
+
+	Out.BrickHashes.clear();
+	Out.BrickHashes.reserve(NumBricks);
+	for (const BakeFileBrick& i : Out.Bricks)
+	{
+		if (i.Type > BakeBrickType::Raw || i.Offset > DataSize || i.Size > DataSize - i.Offset)
+		{
+			Error = "Invalid brick in bkdat file";
+			return false;
+		}
+		Out.BrickHashes.push_back(i.Hash);
+	}
+	return true;
+}
+
+/**
+* @brief
+* Gets the texels of a brick of a loaded file, tightly packed.
+*/
+static bool GetBrickTexels(const BakeFileData& File, uint64_t Brick, std::vector<uint8_t>& Out)
+{
+	uint64_t Start[3], End[3];
+	GetBrickBounds(Brick, File.Resolution, File.BrickSize, Start, End);
+	const size_t NumTexels = (End[0] - Start[0]) * (End[1] - Start[1]) * (End[2] - Start[2]);
+	Out.resize(NumTexels);
+
+	if (File.Bricks.empty())
+	{
+		CopyBrick((uint8_t*)File.Texture.data(), Out.data(), File.Resolution, Start, End, false);
+		return true;
+	}
+
+	const BakeFileBrick& Entry = File.Bricks[Brick];
+	const uint8_t* Data = File.BrickData.data() + Entry.Offset;
+	switch (Entry.Type)
+	{
+	case BakeBrickType::Uniform:
+		std::memset(Out.data(), Entry.Value, NumTexels);
+		return true;
+	case BakeBrickType::Raw:
+		if (Entry.Size != NumTexels)
+		{
+			return false;
+		}
+		std::memcpy(Out.data(), Data, NumTexels);
+		return true;
+	case BakeBrickType::Compressed:
+		if (!CompressionUtil::Decompress(Data, Entry.Size, Out.data(), NumTexels))
+		{
+			return false;
+		}
+		for (size_t i = 1; i < NumTexels; i++)
+		{
+			Out[i] += Out[i - 1];
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+* @brief
+* The state of a lightmap that is loaded brick by brick around the camera.
+*
+* The GPU texture starts out with the average value of each brick. BakedLighting::Update()
+* then decodes and uploads the bricks closest to the camera, a few per frame.
+*/
+struct LightmapStream
+{
+	BakeFileData File;
+	std::vector<bool> LoadedBricks;
+	/// Bricks that should be loaded, the closest one last.
+	std::vector<uint64_t> PendingBricks;
+	int64_t CameraBrick[3] = { INT64_MAX, INT64_MAX, INT64_MAX };
+	std::vector<uint8_t> BrickTexels;
+};
+
+static LightmapStream Stream;
 
 #if EDITOR
 
@@ -54,186 +339,365 @@ namespace Bake
 	std::vector<BakeMesh> Meshes;
 	std::vector<Graphics::Light> Lights;
 	Vector3 BakeScale;
+	glm::vec3 SunDirection = glm::vec3(0, -1, 0);
+	BVH SceneBVH;
 
-	static Vector3 BakeMapToPos(uint64_t TextureElement)
+	static Vector3 BakeMapToPos(int64_t x, int64_t y, int64_t z)
 	{
-		int64_t x = TextureElement % BakedLighting::LightmapResolution;
-		int64_t y = (TextureElement / BakedLighting::LightmapResolution) % BakedLighting::LightmapResolution;
-		int64_t z = TextureElement / (BakedLighting::LightmapResolution * BakedLighting::LightmapResolution);
-
 		return Vector3((float)x, (float)y, (float)z) - ((float)BakedLighting::LightmapResolution / 2.0f);
 	}
 
 
 	std::byte* Texture = nullptr;
 
-	int ChunkSplits = 3;
-	std::deque<std::atomic<float>> ThreadProgress;
+	/// The size of a brick of lightmap texels. Each bake job bakes exactly one brick.
+	constexpr uint64_t BRICK_SIZE = 16;
 
-	static void BakeSection(int64_t x, int64_t y, int64_t z, size_t ThreadID)
+	/**
+	* @brief
+	* A queue of bricks owned by one bake thread.
+	*
+	* The owning thread takes bricks from the front. Other threads that ran out of work steal from the back.
+	*/
+	struct BrickQueue
 	{
-		const uint64_t SECTION_SIZE = BakedLighting::LightmapResolution / ChunkSplits;
-		const float ProgressPerPixel = 1.0f / (SECTION_SIZE * SECTION_SIZE * SECTION_SIZE);
+		std::mutex QueueMutex;
+		std::deque<uint64_t> Bricks;
+	};
+
+	std::deque<BrickQueue> BrickQueues;
+
+	/// The number of texels each bake thread has finished.
+	std::deque<std::atomic<uint64_t>> ThreadProgress;
+	/// The number of texels that need to be baked. Bricks that didn't change since the last bake aren't counted.
+	std::atomic<uint64_t> TotalTexels = 0;
+
+	/// If false, the whole scene is baked, even if most of it didn't change since the last bake.
+	bool IncrementalBake = true;
+
+	/// How far rays towards the sun are traced.
+	constexpr float SunTraceDistance = 2500;
 
-		const float TexelSize = BakeScale.X / BakedLighting::LightmapResolution;
+	/// Changing this changes all brick hashes, so every brick of every scene is rebaked.
+	constexpr uint64_t BAKE_ALGORITHM_VERSION = 1;
 
-		for (uint64_t i = 0; i < BakedLighting::LightmapResolution * BakedLighting::LightmapResolution * BakedLighting::LightmapResolution; i++)
+	/// A mesh or light that affects the baked lighting.
+	struct BakeInput
+	{
+		glm::vec3 Min = glm::vec3(INFINITY);
+		glm::vec3 Max = glm::vec3(-INFINITY);
+		uint64_t Hash = 0;
+	};
+
+	/// Hashes of the inputs of each brick in the current bake.
+	std::vector<uint64_t> BrickHashes;
+
+	static uint64_t GetBricksPerAxis()
+	{
+		return ::GetBricksPerAxis(BakedLighting::LightmapResolution, BRICK_SIZE);
+	}
+
+	static void GetBrickRange(uint64_t Brick, uint64_t Start[3], uint64_t End[3])
+	{
+		GetBrickBounds(Brick, BakedLighting::LightmapResolution, BRICK_SIZE, Start, End);
+	}
+
+	static uint64_t HashBytes(const void* Data, size_t Size, uint64_t Hash = 14695981039346656037ull)
+	{
+		// FNV-1a
+		const uint8_t* Bytes = (const uint8_t*)Data;
+		for (size_t i = 0; i < Size; i++)
 		{
-			int64_t px = i % BakedLighting::LightmapResolution;
-			int64_t py = (i / BakedLighting::LightmapResolution) % BakedLighting::LightmapResolution;
-			int64_t pz = i / (BakedLighting::LightmapResolution * BakedLighting::LightmapResolution);
-			px /= SECTION_SIZE;
-			py /= SECTION_SIZE;
-			pz /= SECTION_SIZE;
+			Hash ^= Bytes[i];
+			Hash *= 1099511628211ull;
+		}
+		return Hash;
+	}
 
-			if (px != x || py != y || pz != z)
+	static uint64_t MixHash(uint64_t Hash)
+	{
+		Hash ^= Hash >> 30;
+		Hash *= 0xbf58476d1ce4e5b9ull;
+		Hash ^= Hash >> 27;
+		Hash *= 0x94d049bb133111ebull;
+		Hash ^= Hash >> 31;
+		return Hash;
+	}
+
+	static bool BoxesOverlap(const glm::vec3& MinA, const glm::vec3& MaxA, const glm::vec3& MinB, const glm::vec3& MaxB)
+	{
+		return MinA.x <= MaxB.x && MaxA.x >= MinB.x
+			&& MinA.y <= MaxB.y && MaxA.y >= MinB.y
+			&& MinA.z <= MaxB.z && MaxA.z >= MinB.z;
+	}
+
+	/**
+	* @brief
+	* Checks if the mesh can block the sun for any point in the brick.
+	*
+	* This sweeps the brick towards the sun and checks if that hits the mesh's bounds.
+	*/
+	static bool MeshShadowsBrick(const BakeInput& Mesh, const glm::vec3& BrickMin, const glm::vec3& BrickMax)
+	{
+		glm::vec3 HalfExtent = (BrickMax - BrickMin) / 2.0f;
+		glm::vec3 Center = BrickMin + HalfExtent;
+		glm::vec3 Min = Mesh.Min - HalfExtent, Max = Mesh.Max + HalfExtent;
+
+		float Near = 0, Far = INFINITY;
+		for (int i = 0; i < 3; i++)
+		{
+			if (SunDirection[i] == 0)
 			{
+				if (Center[i] < Min[i] || Center[i] > Max[i])
+				{
+					return false;
+				}
 				continue;
 			}
+			float t1 = (Min[i] - Center[i]) / SunDirection[i], t2 = (Max[i] - Center[i]) / SunDirection[i];
+			Near = std::max(Near, std::min(t1, t2));
+			Far = std::min(Far, std::max(t1, t2));
+		}
+		return Near <= Far;
+	}
 
-			Vector3 Pos = BakeMapToPos(i);
-			Pos = Pos / (float)BakedLighting::LightmapResolution;
-			Pos = Pos * BakeScale;
-			float Intensity = BakedLighting::GetLightIntensityAt((int64_t)Pos.X, (int64_t)Pos.Y, (int64_t)Pos.Z, TexelSize);
-			Texture[i] = std::byte(Intensity * 255);
-			ThreadProgress[ThreadID] += ProgressPerPixel;
+	/**
+	* @brief
+	* Calculates a hash of everything that affects each brick of the lightmap.
+	*
+	* A brick depends on the lights that reach it, the meshes that can shadow it from the sun
+	* and the meshes that are inside the range of those lights.
+	* If the hash of a brick is the same as in the previous bake, the brick doesn't need to be baked again.
+	*/
+	static std::vector<uint64_t> CalculateBrickHashes()
+	{
+		std::vector<BakeInput> MeshInputs;
+		for (const BakeMesh& i : Meshes)
+		{
+			BakeInput NewInput;
+			uint64_t Hash = HashBytes(nullptr, 0);
+			for (const auto& elem : i.MeshData.Elements)
+			{
+				for (const Vertex& vert : elem.Vertices)
+				{
+					NewInput.Min = glm::min(NewInput.Min, vert.Position);
+					NewInput.Max = glm::max(NewInput.Max, vert.Position);
+					Hash = HashBytes(&vert.Position, sizeof(vert.Position), Hash);
+				}
+				Hash = HashBytes(elem.Indices.data(), elem.Indices.size() * sizeof(unsigned int), Hash);
+			}
+			NewInput.Hash = MixHash(Hash);
+			MeshInputs.push_back(NewInput);
+		}
+
+		std::vector<BakeInput> LightInputs;
+		// The meshes that are in range of each light.
+		std::vector<std::vector<size_t>> LightMeshes;
+		for (const Graphics::Light& i : Lights)
+		{
+			if (i.Falloff == 0 || i.Intensity == 0)
+			{
+				continue;
+			}
+			// Matches the range in GetLightIntensityAt().
+			float Range = i.Falloff * 10.0f;
+			BakeInput NewInput;
+			NewInput.Min = glm::vec3(i.Position) - glm::vec3(Range);
+			NewInput.Max = glm::vec3(i.Position) + glm::vec3(Range);
+			uint64_t Hash = HashBytes(&i.Position, sizeof(i.Position));
+			Hash = HashBytes(&i.Falloff, sizeof(i.Falloff), Hash);
+			Hash = HashBytes(&i.Intensity, sizeof(i.Intensity), Hash);
+			NewInput.Hash = MixHash(Hash);
+			LightInputs.push_back(NewInput);
+
+			LightMeshes.push_back({});
+			for (size_t Mesh = 0; Mesh < MeshInputs.size(); Mesh++)
+			{
+				if (BoxesOverlap(NewInput.Min, NewInput.Max, MeshInputs[Mesh].Min, MeshInputs[Mesh].Max))
+				{
+					LightMeshes[LightMeshes.size() - 1].push_back(Mesh);
+				}
+			}
 		}
+
+		uint64_t GlobalHash = HashBytes(&BakedLighting::LightmapResolution, sizeof(BakedLighting::LightmapResolution));
+		GlobalHash = HashBytes(&BRICK_SIZE, sizeof(BRICK_SIZE), GlobalHash);
+		GlobalHash = HashBytes(&BAKE_ALGORITHM_VERSION, sizeof(BAKE_ALGORITHM_VERSION), GlobalHash);
+		GlobalHash = HashBytes(&BakeScale, sizeof(BakeScale), GlobalHash);
+		GlobalHash = HashBytes(&SunDirection, sizeof(SunDirection), GlobalHash);
+
+		const uint64_t NumBricks = GetBricksPerAxis() * GetBricksPerAxis() * GetBricksPerAxis();
+		const float Resolution = (float)BakedLighting::LightmapResolution;
+		const float TexelSize = BakeScale.X / Resolution;
+		std::vector<uint64_t> Hashes;
+		Hashes.reserve(NumBricks);
+		std::vector<bool> UsedMeshes;
+
+		for (uint64_t Brick = 0; Brick < NumBricks; Brick++)
+		{
+			uint64_t Start[3], End[3];
+			GetBrickRange(Brick, Start, End);
+
+			// Bounds of all sample positions of the brick, including the border used for blurring. See BakeBrick().
+			glm::vec3 BrickMin = glm::vec3(BakeMapToPos((int64_t)Start[0] - 1, (int64_t)Start[1] - 1, (int64_t)Start[2] - 1) / Resolution * BakeScale) - glm::vec3(1.0f);
+			glm::vec3 BrickMax = glm::vec3(BakeMapToPos((int64_t)End[0], (int64_t)End[1], (int64_t)End[2]) / Resolution * BakeScale) + glm::vec3(TexelSize + 1.0f);
+
+			uint64_t Hash = 0;
+			UsedMeshes.assign(MeshInputs.size(), false);
+
+			for (size_t i = 0; i < LightInputs.size(); i++)
+			{
+				if (!BoxesOverlap(BrickMin, BrickMax, LightInputs[i].Min, LightInputs[i].Max))
+				{
+					continue;
+				}
+				Hash += LightInputs[i].Hash;
+				for (size_t Mesh : LightMeshes[i])
+				{
+					UsedMeshes[Mesh] = true;
+				}
+			}
+
+			for (size_t i = 0; i < MeshInputs.size(); i++)
+			{
+				if (UsedMeshes[i] || MeshShadowsBrick(MeshInputs[i], BrickMin, BrickMax))
+				{
+					Hash += MeshInputs[i].Hash;
+				}
+			}
+			Hashes.push_back(MixHash(Hash ^ GlobalHash));
+		}
+		return Hashes;
 	}
 
-	static bool BakeIteration()
+	static void BakeBrick(uint64_t Brick, size_t ThreadID)
 	{
-		bool Found = false;
-		uint64_t FoundX = 0, FoundY = 0, FoundZ = 0;
-		size_t FoundThreadID = 0;
+		const int64_t Resolution = (int64_t)BakedLighting::LightmapResolution;
+		uint64_t Start[3], End[3];
+		GetBrickRange(Brick, Start, End);
+
+		// The lightmap is blurred on the X and Z axes. To do that without depending on other bricks,
+		// one extra texel is baked on each side of the brick on those axes.
+		const int64_t BorderStartX = (int64_t)Start[0] - 1, BorderEndX = (int64_t)End[0] + 1;
+		const int64_t BorderStartZ = (int64_t)Start[2] - 1, BorderEndZ = (int64_t)End[2] + 1;
+		const int64_t SizeX = BorderEndX - BorderStartX, SizeY = (int64_t)(End[1] - Start[1]);
+		std::vector<uint8_t> Samples = std::vector<uint8_t>(SizeX * SizeY * (BorderEndZ - BorderStartZ), 128);
+
+		const float TexelSize = BakeScale.X / Resolution;
+
+		for (int64_t z = BorderStartZ; z < BorderEndZ; z++)
 		{
-			static std::mutex ChunkFindMutex;
-			std::lock_guard Guard{ ChunkFindMutex };
-			size_t ThreadID = 0;
+			for (int64_t y = (int64_t)Start[1]; y < (int64_t)End[1]; y++)
+			{
+				for (int64_t x = BorderStartX; x < BorderEndX; x++)
+				{
+					// Samples outside of the lightmap keep the default value.
+					if (x < 0 || x >= Resolution || z < 0 || z >= Resolution)
+					{
+						continue;
+					}
+					Vector3 Pos = BakeMapToPos(x, y, z);
+					Pos = Pos / (float)Resolution;
+					Pos = Pos * BakeScale;
+					float Intensity = BakedLighting::GetLightIntensityAt((int64_t)Pos.X, (int64_t)Pos.Y, (int64_t)Pos.Z, TexelSize);
+					Samples[(x - BorderStartX) + (y - (int64_t)Start[1]) * SizeX + (z - BorderStartZ) * SizeX * SizeY] = (uint8_t)(Intensity * 255);
+				}
+				if (z >= (int64_t)Start[2] && z < (int64_t)End[2])
+				{
+					ThreadProgress[ThreadID] += End[0] - Start[0];
+				}
+			}
+		}
 
-			for (size_t x = 0; x < ChunkSplits; x++)
+		for (int64_t z = (int64_t)Start[2]; z < (int64_t)End[2]; z++)
+		{
+			for (int64_t y = (int64_t)Start[1]; y < (int64_t)End[1]; y++)
 			{
-				for (size_t y = 0; y < ChunkSplits; y++)
+				for (int64_t x = (int64_t)Start[0]; x < (int64_t)End[0]; x++)
 				{
-					for (size_t z = 0; z < ChunkSplits; z++)
+					uint16_t val = 0;
+					for (int64_t bz = -1; bz <= 1; bz++)
 					{
-						if (ThreadProgress[ThreadID++] != 0)
+						for (int64_t bx = -1; bx <= 1; bx++)
 						{
-							continue;
+							val += Samples[(x + bx - BorderStartX) + (y - (int64_t)Start[1]) * SizeX + (z + bz - BorderStartZ) * SizeX * SizeY];
 						}
-						ThreadProgress[ThreadID - 1] = 0.0001f;
-						FoundX = x;
-						FoundY = y;
-						FoundZ = z;
-						FoundThreadID = ThreadID - 1;
-						Found = true;
-						break;
 					}
-					if (Found)
-						break;
+					Texture[x + y * Resolution + z * Resolution * Resolution] = (std::byte)(val / 9);
 				}
-				if (Found)
-					break;
 			}
 		}
+	}
 
-		if (!Found)
+	static bool GetNextBrick(size_t ThreadID, uint64_t& Brick)
+	{
 		{
-			return false;
+			BrickQueue& Own = BrickQueues[ThreadID];
+			std::lock_guard Guard{ Own.QueueMutex };
+			if (!Own.Bricks.empty())
+			{
+				Brick = Own.Bricks.front();
+				Own.Bricks.pop_front();
+				return true;
+			}
 		}
 
-		BakeSection(FoundX, FoundY, FoundZ, FoundThreadID);
-		return true;
+		// This thread's queue is empty. Steal from the other threads, so no thread sits idle while others still have work.
+		for (size_t i = 1; i < BrickQueues.size(); i++)
+		{
+			BrickQueue& Other = BrickQueues[(ThreadID + i) % BrickQueues.size()];
+			std::lock_guard Guard{ Other.QueueMutex };
+			if (!Other.Bricks.empty())
+			{
+				Brick = Other.Bricks.back();
+				Other.Bricks.pop_back();
+				return true;
+			}
+		}
+		return false;
 	}
 
-	static void BakeThread()
+	static void BakeThread(size_t ThreadID)
 	{
-		while (BakeIteration())
+		uint64_t Brick = 0;
+		while (GetNextBrick(ThreadID, Brick))
 		{
-			continue;
+			BakeBrick(Brick, ThreadID);
 		}
 	}
 }
 
 namespace Bake
 {
-	glm::vec3 SunDirection = glm::vec3(0, -1, 0);
-
-	static inline Collision::HitResponse BakeRayTrace(const glm::vec3& orig, const glm::vec3& end, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C)
-	{
-		glm::vec3 E1 = C - A;
-		glm::vec3 E2 = B - A;
-		glm::vec3 N = glm::cross(E1, E2);
-		float det = -glm::dot(end, N);
-		float invdet = 1.0f / det;
-		glm::vec3 AO = orig - A;
-		glm::vec3 DAO = glm::cross(AO, end);
-		float u = dot(E2, DAO) * invdet;
-		float v = -dot(E1, DAO) * invdet;
-		float t = dot(AO, N) * invdet;
-		if ((t >= 0.0f && u >= 0.0f && v >= 0.0f && (u + v) <= 1.0f))
-			return Collision::HitResponse(true, orig + end * t, normalize(N), t);
-		else return Collision::HitResponse();
-	}
-
 	const float ShadowBias = 2;
 
-	static Collision::HitResponse BakeLine(const glm::vec3& start, const glm::vec3& end, bool mode)
+	static void BuildSceneBVH()
 	{
-		Collision::HitResponse r;
-		if (mode)
-		{
-			r.Distance = INFINITY;
-		}
-		else
-		{
-			r.Distance = 0;
-		}
-		
+		std::vector<BVH::Triangle> Triangles;
 		for (auto& mesh : Bake::Meshes)
 		{
-			Collision::Box BroadPhaseBox = mesh.MeshData.CollisionBox.TransformBy(Transform(mesh.MeshTransform.Position, Vector3(), Vector3(1)));
-			if (!Collision::LineCheckForAABB(BroadPhaseBox,
-				start, end).Hit)
-			{
-				continue;
-			}
 			for (auto& elem : mesh.MeshData.Elements)
 			{
 				for (size_t i = 0; i < elem.Indices.size(); i += 3)
 				{
-					glm::vec3* CurrentTriangle[3] =
-					{
-						&elem.Vertices[elem.Indices[i]].Position,
-						&elem.Vertices[elem.Indices[i + 2]].Position,
-						&elem.Vertices[elem.Indices[i + 1]].Position
-					};
-					Collision::HitResponse newR
-						= (Bake::BakeRayTrace(start, end - start, *CurrentTriangle[0], *CurrentTriangle[1], *CurrentTriangle[2]));
-					if (newR.Hit)
-					{
-						if (mode && newR.Distance < r.Distance)
-						{
-							r = newR;
-						}
-						else if (!mode && newR.Distance > r.Distance)
-						{
-							r = newR;
-						}
-					}
+					Triangles.push_back(BVH::Triangle(
+						elem.Vertices[elem.Indices[i]].Position,
+						elem.Vertices[elem.Indices[i + 2]].Position,
+						elem.Vertices[elem.Indices[i + 1]].Position));
 				}
 			}
 		}
-		return r;
+		SceneBVH.Build(std::move(Triangles));
 	}
 }
 
 float BakedLighting::GetLightIntensityAt(int64_t x, int64_t y, int64_t z, float ElemSize)
 {
-	const float TraceDistance = 2500;
+	using Bake::BVH;
+
+	const float TraceDistance = Bake::SunTraceDistance;
 	glm::vec3 StartPos = glm::vec3((float)x, (float)y, (float)z);
 	StartPos = StartPos + glm::vec3(Bake::BakeScale / (float)LightmapResolution / 2);
-	Collision::HitResponse r;
-	r.Distance = 0;
 	
 	float TotalLightIntensity = 0;
 	
@@ -249,56 +713,151 @@ float BakedLighting::GetLightIntensityAt(int64_t x, int64_t y, int64_t z, float
 		float NewIntensity = std::pow(std::max((i.Falloff * 10.0f) - dist, 0.0f) / (i.Falloff * 10.0f), 16.0f) * i.Intensity * 32.0f;
 		if (NewIntensity > 0.25f)
 		{
-			r = Bake::BakeLine(i.Position, StartPos, true);
-			if (r.Distance && r.Distance < 0.9f)
-			{
-				NewIntensity = 0;
-			}
-			else
+			// The light is blocked if there is anything between it and the sample, so the first hit is enough.
+			BVH::Hit r = Bake::SceneBVH.Trace(i.Position, StartPos - i.Position, BVH::TraceMode::Any,
+				std::numeric_limits<float>::min(), 0.9f);
+			if (!r.Hit)
 			{
 				TotalLightIntensity += NewIntensity;
 			}
 		}
 	}
-	float LightInt = 0;
-	for (int i = 0; i < 1; i++)
+
+	// Any hit further away than this fully blocks the sun. Only closer hits need the exact distance.
+	const float SunShadowDistance = 10.0f / TraceDistance;
+	const glm::vec3 SunRay = Bake::SunDirection * TraceDistance;
+	float LightInt = 1;
+	if (Bake::SceneBVH.Trace(StartPos, SunRay, BVH::TraceMode::Any, SunShadowDistance).Hit)
+	{
+		LightInt = 0;
+	}
+	else
 	{
-		r = Bake::BakeLine(StartPos, StartPos
-			+ (Bake::SunDirection) * TraceDistance, false);
-		LightInt += r.Hit ? 1 - std::min(r.Distance * TraceDistance / 10.0f, 1.0f) : 1;
+		BVH::Hit r = Bake::SceneBVH.Trace(StartPos, SunRay, BVH::TraceMode::Farthest, 0, SunShadowDistance);
+		if (r.Hit)
+		{
+			LightInt = 1 - std::min(r.Distance * TraceDistance / 10.0f, 1.0f);
+		}
 	}
-	LightInt /= 1;
 
 	return std::min((LightInt / 2.0f + TotalLightIntensity / 4.0f), 1.0f);
 }
 
-static std::byte Sample3DArray(std::byte* Arr, int64_t x, int64_t y, int64_t z)
+namespace Bake
 {
-	if (x < 0 || x >= (int64_t)BakedLighting::LightmapResolution
-		|| y < 0 || y >= (int64_t)BakedLighting::LightmapResolution
-		|| z < 0 || z >= (int64_t)BakedLighting::LightmapResolution)
+	/**
+	* @brief
+	* Compares the ray-triangle kernels on a generated sphere mesh.
+	*
+	* Runs the scalar per-triangle kernel and each supported packet kernel, once brute force over all triangles
+	* and once through a BVH.
+	*/
+	static void RunKernelBenchmark(int32_t MeshResolution)
 	{
-		return std::byte(128);
-	}
+		ModelGenerator::ModelData::Element Mesh;
+		Mesh.MakeCube(MeshResolution, 0);
+		Mesh.Sphereize(100);
 
-	return Bake::Texture[x * BakedLighting::LightmapResolution * BakedLighting::LightmapResolution + y * BakedLighting::LightmapResolution + z];
-}
+		std::vector<BVH::Triangle> Triangles;
+		for (size_t i = 0; i < Mesh.Indices.size(); i += 3)
+		{
+			Triangles.push_back(BVH::Triangle(
+				Mesh.Vertices[Mesh.Indices[i]].Position,
+				Mesh.Vertices[Mesh.Indices[i + 2]].Position,
+				Mesh.Vertices[Mesh.Indices[i + 1]].Position));
+		}
 
-static int GetChunkSplits()
-{
-	if (BakedLighting::LightmapResolution <= 64)
-	{
-		return 2;
-	}
-	if (BakedLighting::LightmapResolution <= 128)
-	{
-		return 3;
-	}
-	if (BakedLighting::LightmapResolution <= 256)
-	{
-		return 4;
+		BVH BenchmarkBVH;
+		BenchmarkBVH.Build(Triangles);
+
+		// Rays from random points around the sphere to random points inside of it.
+		constexpr size_t NUM_RAYS = 100000;
+		constexpr size_t NUM_BRUTE_FORCE_RAYS = 1000;
+		std::mt19937 RandomEngine = std::mt19937(0);
+		std::uniform_real_distribution<float> Outside = std::uniform_real_distribution<float>(-150, 150);
+		std::uniform_real_distribution<float> Inside = std::uniform_real_distribution<float>(-50, 50);
+		std::vector<std::pair<glm::vec3, glm::vec3>> Rays;
+		for (size_t i = 0; i < NUM_RAYS; i++)
+		{
+			glm::vec3 Start = glm::vec3(Outside(RandomEngine), Outside(RandomEngine), Outside(RandomEngine));
+			glm::vec3 End = glm::vec3(Inside(RandomEngine), Inside(RandomEngine), Inside(RandomEngine));
+			Rays.push_back({ Start, End - Start });
+		}
+
+		BakeSystem->Print("Benchmarking bake kernels with " + std::to_string(Triangles.size()) + " triangles, "
+			+ std::to_string(BenchmarkBVH.Nodes.size()) + " BVH nodes.");
+
+		auto PrintResult = [](std::string Name, float Time, size_t NumRays, size_t NumHits)
+			{
+				BakeSystem->Print(Name + ": " + std::to_string(Time * 1000.0f) + "ms, "
+					+ std::to_string((float)NumRays / Time / 1000000.0f) + " MRays/s, "
+					+ std::to_string(NumHits) + " hits");
+			};
+
+		{
+			Application::Timer BenchmarkTimer;
+			size_t NumHits = 0;
+			for (size_t i = 0; i < NUM_BRUTE_FORCE_RAYS; i++)
+			{
+				float Closest = INFINITY;
+				for (const BVH::Triangle& Tri : Triangles)
+				{
+					float Distance = 0;
+					if (Tri.Intersect(Rays[i].first, Rays[i].second, Distance) && Distance < Closest)
+					{
+						Closest = Distance;
+					}
+				}
+				NumHits += Closest != INFINITY;
+			}
+			PrintResult("Brute force, per triangle", BenchmarkTimer.Get(), NUM_BRUTE_FORCE_RAYS, NumHits);
+		}
+
+		Kernel::Type PreviousKernel = Kernel::GetSelected();
+		for (Kernel::Type KernelType : { Kernel::Type::Scalar, Kernel::Type::SSE, Kernel::Type::AVX2 })
+		{
+			if (!Kernel::IsSupported(KernelType))
+			{
+				BakeSystem->Print(Kernel::GetName(KernelType) + ": Not supported by this CPU");
+				continue;
+			}
+			Kernel::Select(KernelType);
+
+			Application::Timer BenchmarkTimer;
+			size_t NumHits = 0;
+			for (size_t i = 0; i < NUM_BRUTE_FORCE_RAYS; i++)
+			{
+				float Closest = INFINITY;
+				for (const TrianglePacket& Packet : BenchmarkBVH.Packets)
+				{
+					alignas(32) float Distances[PACKET_SIZE];
+					uint32_t HitMask = Kernel::IntersectPacket(Packet, Rays[i].first, Rays[i].second, 0, INFINITY, Distances);
+					for (uint32_t Lane = 0; Lane < PACKET_SIZE; Lane++)
+					{
+						if ((HitMask & (1u << Lane)) && Distances[Lane] < Closest)
+						{
+							Closest = Distances[Lane];
+						}
+					}
+				}
+				NumHits += Closest != INFINITY;
+			}
+			PrintResult("Brute force, " + Kernel::GetName(KernelType) + " packets", BenchmarkTimer.Get(), NUM_BRUTE_FORCE_RAYS, NumHits);
+
+			for (BVH::TraceMode Mode : { BVH::TraceMode::Closest, BVH::TraceMode::Any })
+			{
+				BenchmarkTimer.Reset();
+				NumHits = 0;
+				for (const auto& Ray : Rays)
+				{
+					NumHits += BenchmarkBVH.Trace(Ray.first, Ray.second, Mode).Hit;
+				}
+				PrintResult(std::string(Mode == BVH::TraceMode::Closest ? "BVH closest hit, " : "BVH any hit, ")
+					+ Kernel::GetName(KernelType), BenchmarkTimer.Get(), Rays.size(), NumHits);
+			}
+		}
+		Kernel::Select(PreviousKernel);
 	}
-	return 5;
 }
 
 void BakedLighting::BakeCurrentSceneToFile()
@@ -345,17 +904,30 @@ void BakedLighting::BakeCurrentSceneToFile()
 	}
 	Bake::Lights = Graphics::MainFramebuffer->Lights;
 
+	// Set up the progress counters here, so they aren't modified while GetBakeProgress() reads them.
+	Bake::TotalTexels = 0;
+	Bake::ThreadProgress.clear();
+	size_t NumThreads = std::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+	for (size_t i = 0; i < NumThreads; i++)
+	{
+		Bake::ThreadProgress.emplace_back(0);
+	}
+
 	new BackgroundTask(BakeAsync);
 }
 
 float BakedLighting::GetBakeProgress()
 {
-	float Progress = 0;
-	for (float i : Bake::ThreadProgress)
+	if (!Bake::TotalTexels)
+	{
+		return 0;
+	}
+	uint64_t Progress = 0;
+	for (const auto& i : Bake::ThreadProgress)
 	{
 		Progress += i;
 	}
-	return Progress / (Bake::ChunkSplits * Bake::ChunkSplits * Bake::ChunkSplits);
+	return (float)((double)Progress / (double)Bake::TotalTexels);
 }
 
 void BakedLighting::BakeAsync()
@@ -365,10 +937,6 @@ void BakedLighting::BakeAsync()
 	Application::Timer BakeTimer;
 	BakeLogMessages.clear();
 	BakeLog("Baking lightmap for scene " + FileUtil::GetFileNameWithoutExtensionFromPath(Scene::CurrentScene) + "...");
-	for (auto& i : Bake::ThreadProgress)
-	{
-		i = 0;
-	}
 	Bake::Texture = new std::byte[LightmapResolution * LightmapResolution * LightmapResolution * NUM_CHANNELS]();
 
 	std::vector<std::thread*> BakeThreads;
@@ -418,125 +986,169 @@ void BakedLighting::BakeAsync()
 	BakeLog("Baking with scale: " + std::to_string(BakeScale.X));
 	SunDirection = (glm::vec3)Vector3::GetForwardVector(Graphics::WorldSun.Rotation);
 
-	ChunkSplits = GetChunkSplits();
+	Application::Timer BVHTimer;
+	BuildSceneBVH();
+	BakeLog("Built BVH with " + std::to_string(SceneBVH.Nodes.size()) + " nodes for " + std::to_string(SceneBVH.Triangles.size())
+		+ " triangles in " + std::to_string(BVHTimer.Get()) + " seconds.");
+
+	const uint64_t NumBricks = GetBricksPerAxis() * GetBricksPerAxis() * GetBricksPerAxis();
+	const size_t NumThreads = ThreadProgress.size();
 
-	int NumChunks = ChunkSplits * ChunkSplits * ChunkSplits;
-	for (int i = 0; i < NumChunks; i++)
+	std::string BakFile = Assets::GetAsset(FileUtil::GetFileNameWithoutExtensionFromPath(Scene::CurrentScene) + ".bkdat");
+	if (!std::filesystem::exists(BakFile))
 	{
-		ThreadProgress.emplace_back(0.0f);
+		BakFile = FileUtil::GetFilePathWithoutExtension(Scene::CurrentScene) + ".bkdat";
 	}
 
-	size_t ThreadID = 0;
-	size_t NumThreads = std::min(size_t(std::thread::hardware_concurrency()), size_t(NumChunks));
-	for (size_t i = 0; i < NumThreads; i++)
+	BrickHashes = CalculateBrickHashes();
+
+	// Reuse the bricks of the previous bake that have the same inputs.
+	BakeFileData PreviousBake;
+	std::string PreviousBakeError;
+	bool CanReuseBricks = IncrementalBake
+		&& std::filesystem::exists(BakFile)
+		&& ReadBakeFile(BakFile, PreviousBake, PreviousBakeError)
+		&& PreviousBake.Resolution == LightmapResolution
+		&& PreviousBake.BrickSize == BRICK_SIZE
+		&& PreviousBake.BrickHashes.size() == NumBricks;
+
+	std::vector<uint64_t> DirtyBricks;
+	std::vector<uint8_t> BrickTexels;
+	uint64_t DirtyTexels = 0;
+	for (uint64_t Brick = 0; Brick < NumBricks; Brick++)
 	{
-		BakeThreads.push_back(new std::thread(BakeThread));
-	}
+		uint64_t Start[3], End[3];
+		GetBrickRange(Brick, Start, End);
 
-	BakeLog("Invoked " + std::to_string(BakeThreads.size()) + " threads for " + std::to_string(NumChunks) + " chunks.");
+		if (!CanReuseBricks || PreviousBake.BrickHashes[Brick] != BrickHashes[Brick]
+			|| !GetBrickTexels(PreviousBake, Brick, BrickTexels))
+		{
+			DirtyBricks.push_back(Brick);
+			DirtyTexels += (End[0] - Start[0]) * (End[1] - Start[1]) * (End[2] - Start[2]);
+			continue;
+		}
+		CopyBrick((uint8_t*)Bake::Texture, BrickTexels.data(), LightmapResolution, Start, End, true);
+	}
+	PreviousBake = BakeFileData();
+	TotalTexels = DirtyTexels;
 
-	for (int i = (int)BakeThreads.size() - 1; i >= 0; i--)
+	if (!PreviousBakeError.empty())
 	{
-		BakeThreads[i]->join();
-		BakeLog("Thread " + std::to_string(BakeThreads.size() - i) + "/" + std::to_string(BakeThreads.size()) + " is done.");
+		BakeLog("Could not reuse the previous bake: " + PreviousBakeError);
 	}
 
-	BakeLog("Finished baking lightmap.");
-	BakeLog("Bake took " + std::to_string((int)BakeTimer.Get()) + " seconds.");
+	if (CanReuseBricks)
+	{
+		BakeLog("Baking " + std::to_string(DirtyBricks.size()) + " of " + std::to_string(NumBricks) + " bricks that changed since the last bake.");
+	}
+	else
+	{
+		BakeLog("Baking all " + std::to_string(NumBricks) + " bricks.");
+	}
 
-	for (int64_t x = 0; x < (int64_t)BakedLighting::LightmapResolution; x++)
+	// Give each thread a contiguous range of bricks. Neighboring bricks trace through the same parts of the BVH.
+	BrickQueues.clear();
+	for (size_t i = 0; i < NumThreads; i++)
 	{
-		for (int64_t y = 0; y < (int64_t)BakedLighting::LightmapResolution; y++)
+		BrickQueues.emplace_back();
+		for (size_t Brick = DirtyBricks.size() * i / NumThreads; Brick < DirtyBricks.size() * (i + 1) / NumThreads; Brick++)
 		{
-			for (int64_t z = 0; z < (int64_t)BakedLighting::LightmapResolution; z++)
-			{
-				uint16_t val = 0;
-				for (int64_t bx = -1; bx <= 1; bx++)
-				{
-					for (int64_t bz = -1; bz <= 1; bz++)
-					{
-						val += (uint16_t)Sample3DArray(Bake::Texture, x + bx, y, z + bz);
-					}
-				}
-				Bake::Texture[x * BakedLighting::LightmapResolution * BakedLighting::LightmapResolution
-					+ y * BakedLighting::LightmapResolution
-					+ z] = (std::byte)(val / 9);
-			}
+			BrickQueues[i].Bricks.push_back(DirtyBricks[Brick]);
 		}
 	}
 
-	// Simple RLE for lightmap compression.
-	std::byte* TexPtr = Bake::Texture;
-
-	std::string BakFile = Assets::GetAsset(FileUtil::GetFileNameWithoutExtensionFromPath(Scene::CurrentScene) + ".bkdat");
-	if (!std::filesystem::exists(BakFile))
+	for (size_t i = 0; i < NumThreads; i++)
 	{
-		BakFile = FileUtil::GetFilePathWithoutExtension(Scene::CurrentScene) + ".bkdat";
+		BakeThreads.push_back(new std::thread(BakeThread, i));
 	}
 
+	BakeLog("Invoked " + std::to_string(BakeThreads.size()) + " threads for " + std::to_string(DirtyBricks.size()) + " bricks.");
 
-	std::ofstream OutFile = std::ofstream(BakFile, std::ios::out | std::ios::binary);
-
-
-	uint8_t FileVersion = BKDAT_FILE_VERSION;
-	OutFile.write((char*)&FileVersion, sizeof(FileVersion));
-	struct RLEelem
+	for (int i = (int)BakeThreads.size() - 1; i >= 0; i--)
 	{
-		std::byte Value = std::byte(1);
-		uint8_t Length = 0;
-	};
+		BakeThreads[i]->join();
+		delete BakeThreads[i];
+		BakeLog("Thread " + std::to_string(BakeThreads.size() - i) + "/" + std::to_string(BakeThreads.size()) + " is done.");
+	}
 
-	RLEelem Current;
-	std::vector<RLEelem> Elements;
+	BakeLog("Finished baking lightmap.");
+	BakeLog("Bake took " + std::to_string((int)BakeTimer.Get()) + " seconds.");
 
 	BakeLog("Compressing lightmap...");
-	for (size_t i = 0; i < LightmapResolution * LightmapResolution * LightmapResolution * NUM_CHANNELS; i++)
+	std::vector<BakeFileBrick> FileBricks = std::vector<BakeFileBrick>(NumBricks);
+	std::vector<uint8_t> BrickData;
+	std::vector<uint8_t> DeltaTexels;
+	uint64_t NumUniformBricks = 0;
+	for (uint64_t Brick = 0; Brick < NumBricks; Brick++)
 	{
-		std::byte CurrentVal = Bake::Texture[i];
+		uint64_t Start[3], End[3];
+		GetBrickRange(Brick, Start, End);
+		BrickTexels.resize((End[0] - Start[0]) * (End[1] - Start[1]) * (End[2] - Start[2]));
+		CopyBrick((uint8_t*)Bake::Texture, BrickTexels.data(), LightmapResolution, Start, End, false);
+
+		BakeFileBrick& Entry = FileBricks[Brick];
+		Entry.Hash = BrickHashes[Brick];
+		Entry.Offset = BrickData.size();
+
+		uint64_t Sum = 0;
+		bool Uniform = true;
+		for (uint8_t i : BrickTexels)
+		{
+			Sum += i;
+			Uniform = Uniform && i == BrickTexels[0];
+		}
+		Entry.Value = (uint8_t)(Sum / BrickTexels.size());
 
-		// If the new value is different than the other one, start a new RLE element.
-		if (Current.Value != CurrentVal)
+		if (Uniform)
 		{
-			if (Current.Length != 0)
-			{
-				Elements.push_back(Current);
-			}
-			Current.Value = CurrentVal;
-			Current.Length = 0;
+			Entry.Type = BakeBrickType::Uniform;
+			NumUniformBricks++;
+			continue;
 		}
 
-		Current.Length++;
+		// The lightmap is mostly smooth gradients, which become runs of the same value when delta encoded.
+		DeltaTexels.resize(BrickTexels.size());
+		DeltaTexels[0] = BrickTexels[0];
+		for (size_t i = 1; i < BrickTexels.size(); i++)
+		{
+			DeltaTexels[i] = BrickTexels[i] - BrickTexels[i - 1];
+		}
 
-		// Don't write an RLE element with a size longer than the maximum size.
-		if (Current.Length == UINT8_MAX)
+		Entry.Type = BakeBrickType::Compressed;
+		Entry.Size = (uint32_t)CompressionUtil::Compress(DeltaTexels.data(), DeltaTexels.size(), BrickData);
+		if (Entry.Size >= BrickTexels.size())
 		{
-			Elements.push_back(Current);
-			Current.Length = 0;
+			BrickData.resize(Entry.Offset);
+			BrickData.insert(BrickData.end(), BrickTexels.begin(), BrickTexels.end());
+			Entry.Type = BakeBrickType::Raw;
+			Entry.Size = (uint32_t)BrickTexels.size();
 		}
 	}
 
-	size_t ElemsSize = Elements.size();
-	OutFile.write((char*)&ElemsSize, sizeof(ElemsSize));
+	std::ofstream OutFile = std::ofstream(BakFile, std::ios::out | std::ios::binary);
+	uint8_t FileVersion = BKDAT_FILE_VERSION;
+	uint64_t BrickSize = BRICK_SIZE;
+	uint64_t DataSize = BrickData.size();
+	OutFile.write((char*)&FileVersion, sizeof(FileVersion));
 	OutFile.write((char*)&LightmapResolution, sizeof(LightmapResolution));
 	OutFile.write((char*)&BakeScale, sizeof(BakeScale));
+	OutFile.write((char*)&BrickSize, sizeof(BrickSize));
+	OutFile.write((char*)&NumBricks, sizeof(NumBricks));
+	OutFile.write((char*)FileBricks.data(), FileBricks.size() * sizeof(BakeFileBrick));
+	OutFile.write((char*)&DataSize, sizeof(DataSize));
+	OutFile.write((char*)BrickData.data(), BrickData.size());
+	OutFile.close();
 
-	size_t TotalLength = 0;
-
-	BakeLog("Compressed lightmap with " + std::to_string(ElemsSize) + " RLE elements.");
-	for (auto& i : Elements)
-	{
-		TotalLength += i.Length;
-		OutFile.write((char*)&i.Length, sizeof(i.Length));
-		OutFile.write((char*)&i.Value, sizeof(i.Value));
-	}
-
-	BakeLog("Encoded voxels: " + std::to_string(TotalLength));
+	BakeLog("Compressed lightmap to " + std::to_string(DataSize + FileBricks.size() * sizeof(BakeFileBrick)) + " bytes. "
+		+ std::to_string(NumUniformBricks) + " of " + std::to_string(NumBricks) + " bricks are uniform.");
 
 	BakeSystem->Print("Finished baking lightmap for " + Scene::CurrentScene);
 	BakeSystem->Print(" -> " + BakFile);
 
 	delete[] Bake::Texture;
 	Meshes.clear();
+	BrickHashes.clear();
+	SceneBVH.Clear();
 	BakedLighting::FinishedBaking = true;
 }
 
@@ -548,11 +1160,122 @@ BakedLighting::BakedLighting()
 	Name = "LightMap";
 	BakeSystem = this;
 
+#if EDITOR
+	Print("Using " + Bake::Kernel::GetName(Bake::Kernel::GetSelected()) + " ray kernel for baking.", ErrorLevel::Note);
+
+	Console::ConsoleSystem->RegisterCommand(Console::Command("bake_benchmark", []()
+		{
+			int32_t MeshResolution = 64;
+			if (Console::ConsoleSystem->CommandArgs().size())
+			{
+				MeshResolution = std::max(std::stoi(Console::ConsoleSystem->CommandArgs()[0]), 2);
+			}
+			Bake::RunKernelBenchmark(MeshResolution);
+		}, { Console::Command::Argument("mesh_resolution", NativeType::Int, true) }));
+
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("bake_incremental", NativeType::Bool, &Bake::IncrementalBake, nullptr));
+#endif
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("lightmap_streaming", NativeType::Bool, &StreamLightmap, nullptr));
+	Console::ConsoleSystem->RegisterConVar(Console::Variable("lightmap_stream_distance", NativeType::Int, &LightmapStreamDistance, nullptr));
+
 	LoadEmpty();
 }
 
 void BakedLighting::Update()
 {
+	if (Stream.File.Bricks.empty() || !Graphics::MainCamera)
+	{
+		return;
+	}
+
+	const int64_t BrickSize = (int64_t)Stream.File.BrickSize;
+	const int64_t BricksPerAxis = (int64_t)GetBricksPerAxis(Stream.File.Resolution, Stream.File.BrickSize);
+
+	// The same position the shaders sample the lightmap at.
+	Vector3 CameraTexel = (Graphics::MainCamera->Position / LightmapScale + Vector3(0.5f)) * (float)Stream.File.Resolution;
+	int64_t CameraBrick[3];
+	for (int i = 0; i < 3; i++)
+	{
+		CameraBrick[i] = (int64_t)std::floor(CameraTexel[i] / (float)BrickSize);
+	}
+
+	if (CameraBrick[0] != Stream.CameraBrick[0] || CameraBrick[1] != Stream.CameraBrick[1] || CameraBrick[2] != Stream.CameraBrick[2])
+	{
+		std::copy(CameraBrick, CameraBrick + 3, Stream.CameraBrick);
+		Stream.PendingBricks.clear();
+
+		const int64_t Distance = std::max(LightmapStreamDistance, 0);
+		int64_t Start[3], End[3];
+		for (int i = 0; i < 3; i++)
+		{
+			Start[i] = std::max(CameraBrick[i] - Distance, int64_t(0));
+			End[i] = std::min(CameraBrick[i] + Distance + 1, BricksPerAxis);
+		}
+
+		for (int64_t z = Start[2]; z < End[2]; z++)
+		{
+			for (int64_t y = Start[1]; y < End[1]; y++)
+			{
+				for (int64_t x = Start[0]; x < End[0]; x++)
+				{
+					uint64_t Brick = x + y * BricksPerAxis + z * BricksPerAxis * BricksPerAxis;
+					if (!Stream.LoadedBricks[Brick])
+					{
+						Stream.PendingBricks.push_back(Brick);
+					}
+				}
+			}
+		}
+
+		auto GetDistance = [&](uint64_t Brick) -> int64_t
+			{
+				int64_t Pos[3] = { int64_t(Brick % BricksPerAxis), int64_t((Brick / BricksPerAxis) % BricksPerAxis), int64_t(Brick / (BricksPerAxis * BricksPerAxis)) };
+				int64_t Result = 0;
+				for (int i = 0; i < 3; i++)
+				{
+					Result += (Pos[i] - CameraBrick[i]) * (Pos[i] - CameraBrick[i]);
+				}
+				return Result;
+			};
+
+		std::sort(Stream.PendingBricks.begin(), Stream.PendingBricks.end(), [&](uint64_t a, uint64_t b)
+			{
+				return GetDistance(a) > GetDistance(b);
+			});
+	}
+
+	if (Stream.PendingBricks.empty())
+	{
+		return;
+	}
+
+	glBindTexture(GL_TEXTURE_3D, LightTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (uint64_t i = 0; i < STREAMED_BRICKS_PER_FRAME && !Stream.PendingBricks.empty(); i++)
+	{
+		uint64_t Brick = Stream.PendingBricks.back();
+		Stream.PendingBricks.pop_back();
+		if (Stream.LoadedBricks[Brick])
+		{
+			continue;
+		}
+		Stream.LoadedBricks[Brick] = true;
+
+		// A brick that can't be decoded keeps its average value.
+		if (!GetBrickTexels(Stream.File, Brick, Stream.BrickTexels))
+		{
+			Print("Could not decode lightmap brick " + std::to_string(Brick), ErrorLevel::Warn);
+			continue;
+		}
+
+		uint64_t Start[3], End[3];
+		GetBrickBounds(Brick, Stream.File.Resolution, Stream.File.BrickSize, Start, End);
+		glTexSubImage3D(GL_TEXTURE_3D, 0,
+			(GLint)Start[0], (GLint)Start[1], (GLint)Start[2],
+			(GLsizei)(End[0] - Start[0]), (GLsizei)(End[1] - Start[1]), (GLsizei)(End[2] - Start[2]),
+			GL_RED, GL_UNSIGNED_BYTE, Stream.BrickTexels.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 }
 
 void BakedLighting::LoadEmpty()
@@ -571,6 +1294,7 @@ void BakedLighting::LoadEmpty()
 	{
 		glDeleteTextures(1, &LightTexture);
 	}
+	Stream = LightmapStream();
 	LoadedLightmap = false;
 	LoadBakeTexture(Texture);
 	delete[] Texture;
@@ -594,43 +1318,87 @@ void BakedLighting::LoadBakeFile(std::string BakeFile)
 		return;
 	}
 
-	std::ifstream InFile = std::ifstream(File, std::ios::binary | std::ios::in);
-
-	uint8_t FileVer = 0;
 	BakeSystem->Print("Loading lightmap: " + File);
-	InFile.read((char*)&FileVer, sizeof(FileVer));
-	if (BKDAT_FILE_VERSION != FileVer)
+
+	BakeFileData LoadedFile;
+	std::string Error;
+	if (!ReadBakeFile(File, LoadedFile, Error))
 	{
-		BakeSystem->Print("File version mismatch of bkdat file. Supported version: " + std::to_string(BKDAT_FILE_VERSION) + ", Loaded version: " + std::to_string(FileVer), ErrorLevel::Warn);
+		BakeSystem->Print(Error, ErrorLevel::Warn);
 		return;
 	}
 
+	LightmapResolution = LoadedFile.Resolution;
+	LightmapScale = LoadedFile.Scale;
+	Stream = LightmapStream();
 
-	size_t FileLength = 0;
-	InFile.read((char*)&FileLength, sizeof(FileLength));
-	InFile.read((char*)&LightmapResolution, sizeof(LightmapResolution));
-
-	InFile.read((char*)&LightmapScale, sizeof(LightmapScale));
+	LoadedLightmap = true;
 
-	uint8_t* Texture = new uint8_t[LightmapResolution * LightmapResolution * LightmapResolution * NUM_CHANNELS * 2]();
+	if (StreamLightmap && !LoadedFile.Bricks.empty())
+	{
+		LoadStreamedBakeFile(std::move(LoadedFile));
+		return;
+	}
 
-	size_t Iterator = 0; 
-	for (size_t i = 0; i < FileLength; i++)
+	if (LoadedFile.Texture.empty())
 	{
-		uint8_t Value = 0;
-		uint8_t Length = 0;
-		InFile.read((char*)&Length, sizeof(Length));
-		InFile.read((char*)&Value, sizeof(Value));
-		for (size_t i = 0; i < Length; i++)
+		LoadedFile.Texture.resize(LightmapResolution * LightmapResolution * LightmapResolution * NUM_CHANNELS);
+		std::vector<uint8_t> BrickTexels;
+		for (uint64_t Brick = 0; Brick < LoadedFile.Bricks.size(); Brick++)
 		{
-			Texture[Iterator] = Value;
-			Iterator++;
+			if (!GetBrickTexels(LoadedFile, Brick, BrickTexels))
+			{
+				BakeSystem->Print("Could not decode lightmap brick " + std::to_string(Brick), ErrorLevel::Warn);
+				LoadEmpty();
+				return;
+			}
+			uint64_t Start[3], End[3];
+			GetBrickBounds(Brick, LightmapResolution, LoadedFile.BrickSize, Start, End);
+			CopyBrick(LoadedFile.Texture.data(), BrickTexels.data(), LightmapResolution, Start, End, true);
 		}
 	}
+	LoadBakeTexture(LoadedFile.Texture.data());
+}
 
-	LoadedLightmap = true;
-	LoadBakeTexture(Texture);
-	delete[] Texture;
+void BakedLighting::LoadStreamedBakeFile(BakeFileData&& File)
+{
+	const uint64_t Resolution = File.Resolution;
+	const uint64_t BricksPerAxis = GetBricksPerAxis(Resolution, File.BrickSize);
+
+	// Start out with the average value of every brick. Uniform bricks are already correct like this.
+	// The texture is filled one layer of bricks at a time, so the whole texture never has to be in memory at once.
+	LoadBakeTexture(nullptr);
+	Stream.LoadedBricks.resize(File.Bricks.size());
+	std::vector<uint8_t> Layer;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (uint64_t BrickZ = 0; BrickZ < BricksPerAxis; BrickZ++)
+	{
+		const uint64_t LayerStart = BrickZ * File.BrickSize;
+		const uint64_t LayerDepth = std::min(File.BrickSize, Resolution - LayerStart);
+		Layer.resize(Resolution * Resolution * LayerDepth);
+
+		for (uint64_t Brick = BrickZ * BricksPerAxis * BricksPerAxis; Brick < (BrickZ + 1) * BricksPerAxis * BricksPerAxis; Brick++)
+		{
+			uint64_t Start[3], End[3];
+			GetBrickBounds(Brick, Resolution, File.BrickSize, Start, End);
+			for (uint64_t z = Start[2]; z < End[2]; z++)
+			{
+				for (uint64_t y = Start[1]; y < End[1]; y++)
+				{
+					std::memset(Layer.data() + Start[0] + y * Resolution + (z - LayerStart) * Resolution * Resolution,
+						File.Bricks[Brick].Value, End[0] - Start[0]);
+				}
+			}
+			Stream.LoadedBricks[Brick] = File.Bricks[Brick].Type == BakeBrickType::Uniform;
+		}
+
+		glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, (GLint)LayerStart,
+			(GLsizei)Resolution, (GLsizei)Resolution, (GLsizei)LayerDepth,
+			GL_RED, GL_UNSIGNED_BYTE, Layer.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	File.Texture.clear();
+	Stream.File = std::move(File);
 }
 
 Vector3 BakedLighting::GetLightMapScale()
@@ -6,6 +6,8 @@
 #include <Math/Vector.h>
 #include "RenderSubsystem.h"
 
+struct BakeFileData;
+
 /**
 * @brief
 * Baked lighting subsystem.
@@ -45,11 +47,22 @@ public:
 	static float LightmapScaleMultiplier;
 	static uint64_t LightmapResolution;
 
+	/**
+	* @brief
+	* If true, lightmaps are loaded brick by brick around the camera instead of all at once.
+	*
+	* Bricks that aren't loaded yet use their average value.
+	*/
+	static bool StreamLightmap;
+	/// The distance around the camera, in lightmap bricks, where bricks of a streamed lightmap are loaded.
+	static int LightmapStreamDistance;
+
 	static std::vector<std::string> GetBakeLog();
 	static float GetLightIntensityAt(int64_t x, int64_t y, int64_t z, float ElemaSize);
 private:
 	static void BakeAsync();
 	static void BakeLog(std::string Msg);
 	static void LoadBakeTexture(uint8_t* Texture);
+	static void LoadStreamedBakeFile(BakeFileData&& File);
 };
 #endif
\ No newline at end of file
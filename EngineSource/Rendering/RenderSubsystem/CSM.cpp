@@ -17,6 +17,37 @@ int CSM::Cascades = 3;
 unsigned int CSM::ShadowMaps = 0;
 unsigned int CSM::matricesUBO = 0;
 Shader* CSM::ShadowShader = nullptr;
+int CSM::FirstCachedCascade = 1;
+unsigned int CSM::StaticShadowMaps = 0;
+unsigned int CSM::StaticFBO = 0;
+std::vector<CSM::CascadeCache> CSM::CachedCascades;
+
+static unsigned int CreateShadowMapArray()
+{
+	unsigned int Texture = 0;
+	glGenTextures(1, &Texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, Texture);
+	glTexImage3D(
+		GL_TEXTURE_2D_ARRAY,
+		0,
+		GL_DEPTH_COMPONENT32F,
+		Graphics::ShadowResolution,
+		Graphics::ShadowResolution,
+		int(CSM::shadowCascadeLevels.size()) + 1,
+		0,
+		GL_DEPTH_COMPONENT,
+		GL_FLOAT,
+		nullptr);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+
+	constexpr float bordercolor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, bordercolor);
+	return Texture;
+}
 
 std::vector<glm::vec4> CSM::GetFrustumCornersWorldSpace(const glm::mat4& projview)
 {
@@ -54,20 +85,6 @@ void CSM::UpdateMatricesUBO(Camera* From)
 	}
 }
 
-void CSM::BindLightSpaceMatricesToShader(const std::vector<glm::mat4>& Matrices, Shader* ShaderToBind)
-{
-	if (!Graphics::RenderShadows || Graphics::ShadowResolution <= 0)
-	{
-		return;
-	}
-	ShaderToBind->Bind();
-	for (size_t i = 0; i < Matrices.size(); ++i)
-	{
-		glUniformMatrix4fv(glGetUniformLocation(ShaderToBind->GetShaderID(),
-			((std::string("lightSpaceMatrices[") + std::to_string(i)) + "]").c_str()), 1, GL_FALSE, &Matrices.at(i)[0][0]);
-	}
-}
-
 std::vector<glm::vec4> CSM::GetFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view)
 {
 	return GetFrustumCornersWorldSpace(proj * view);
@@ -102,34 +119,25 @@ void CSM::ReInit()
 	if (ShadowMaps)
 	{
 		glDeleteTextures(1, &ShadowMaps);
+		glDeleteTextures(1, &StaticShadowMaps);
 		glDeleteFramebuffers(1, &LightFBO);
+		glDeleteFramebuffers(1, &StaticFBO);
 	}
 	glGenFramebuffers(1, &LightFBO);
+	glGenFramebuffers(1, &StaticFBO);
 	ShadowMaps = 0;
+	StaticShadowMaps = 0;
+	CachedCascades.clear();
+	CachedCascades.resize(shadowCascadeLevels.size() + 1);
 
 	if (Graphics::RenderShadows && Graphics::ShadowResolution > 0)
 	{
-		glGenTextures(1, &ShadowMaps);
-		glBindTexture(GL_TEXTURE_2D_ARRAY, ShadowMaps);
-		glTexImage3D(
-			GL_TEXTURE_2D_ARRAY,
-			0,
-			GL_DEPTH_COMPONENT32F,
-			Graphics::ShadowResolution,
-			Graphics::ShadowResolution,
-			int(shadowCascadeLevels.size()) + 1,
-			0,
-			GL_DEPTH_COMPONENT,
-			GL_FLOAT,
-			nullptr);
-
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-
-		constexpr float bordercolor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-		glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, bordercolor);
+		ShadowMaps = CreateShadowMapArray();
+		StaticShadowMaps = CreateShadowMapArray();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, StaticFBO);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
 
 		glBindFramebuffer(GL_FRAMEBUFFER, LightFBO);
 		glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, ShadowMaps, 0);
@@ -143,6 +151,35 @@ void CSM::ReInit()
 	}
 }
 
+bool CSM::BindStaticCascade(int Cascade, const glm::mat4& LightSpaceMatrix, const FramebufferObject* Owner, uint64_t StaticVersion)
+{
+	CascadeCache& Cache = CachedCascades[Cascade];
+	if (Cache.Valid
+		&& Cache.Owner == Owner
+		&& Cache.StaticVersion == StaticVersion
+		&& Cache.LightSpaceMatrix == LightSpaceMatrix)
+	{
+		return false;
+	}
+	Cache.Valid = true;
+	Cache.Owner = Owner;
+	Cache.StaticVersion = StaticVersion;
+	Cache.LightSpaceMatrix = LightSpaceMatrix;
+
+	// Only one layer is attached, so the layer written by the geometry shader is ignored.
+	glBindFramebuffer(GL_FRAMEBUFFER, StaticFBO);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, StaticShadowMaps, 0, Cascade);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+void CSM::CopyStaticCascade(int Cascade)
+{
+	glCopyImageSubData(StaticShadowMaps, GL_TEXTURE_2D_ARRAY, 0, 0, 0, Cascade,
+		ShadowMaps, GL_TEXTURE_2D_ARRAY, 0, 0, 0, Cascade,
+		Graphics::ShadowResolution, Graphics::ShadowResolution, 1);
+}
+
 glm::mat4 CSM::GetLightSpaceMatrix(const float nearPlane, const float farPlane, Camera* From)
 {
 	const auto proj = glm::perspective(
@@ -6,10 +6,12 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
+#include <cstdint>
 #include <string>
 #include <Rendering/Shader.h>
 
 class Camera;
+class FramebufferObject;
 
 /**
 * @brief
@@ -31,17 +33,54 @@ public:
 
 	static Shader* ShadowShader;
 
+	/**
+	* @brief
+	* The first cascade that caches the shadows of static objects. Cascades before it are fully rendered every frame.
+	*
+	* A cached cascade only renders its static objects again if its light space matrix changes, which happens if the sun rotates
+	* or the camera moves to another cell of the snapping grid used by GetLightSpaceMatrix(), or if the static objects change.
+	* Dynamic objects are rendered on top of the cached shadows every frame.
+	*/
+	static int FirstCachedCascade;
+
 	static std::vector<glm::vec4> GetFrustumCornersWorldSpace(const glm::mat4& projview);
 
 	static void UpdateMatricesUBO(Camera* From);
-	static void BindLightSpaceMatricesToShader(const std::vector<glm::mat4>& Matrices, Shader* ShaderToBind);
 	static std::vector<glm::vec4> GetFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view);
 	CSM();
 
 	static void ReInit();
 
+	/**
+	* @brief
+	* Binds the framebuffer for the static shadows of a cascade if they need to be rendered again.
+	*
+	* @param StaticVersion
+	* Version of the static objects, see CullingBVH::GetStaticVersion().
+	*
+	* @return
+	* True if the framebuffer was bound and cleared, false if the cached shadows are still valid.
+	*/
+	static bool BindStaticCascade(int Cascade, const glm::mat4& LightSpaceMatrix, const FramebufferObject* Owner, uint64_t StaticVersion);
+
+	/// Copies the cached static shadows of a cascade into ShadowMaps.
+	static void CopyStaticCascade(int Cascade);
+
 	static glm::mat4 GetLightSpaceMatrix(const float nearPlane, const float farPlane, Camera* From);
 
 	static std::vector<glm::mat4> GetLightSpaceMatrices(Camera* From);
+
+private:
+	struct CascadeCache
+	{
+		glm::mat4 LightSpaceMatrix = glm::mat4(0);
+		const FramebufferObject* Owner = nullptr;
+		uint64_t StaticVersion = 0;
+		bool Valid = false;
+	};
+
+	static unsigned int StaticShadowMaps;
+	static unsigned int StaticFBO;
+	static std::vector<CascadeCache> CachedCascades;
 };
 #endif
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <GL/glew.h>
 #include <Rendering/Framebuffer.h>
 #include <Rendering/Mesh/Model.h>
+#include <Rendering/Mesh/ModelBatch.h>
 #include <Engine/Application.h>
 #include <Rendering/ShaderManager.h>
 
@@ -22,7 +23,19 @@ OcclusionCulling::OcclusionCulling()
 	glGenQueries(256, OcclusionQueries);
 }
 
-bool OcclusionCulling::RenderOccluded(Model* m, size_t i, FramebufferObject* Buffer)
+static void RenderOrBatch(Model* m, FramebufferObject* Buffer, ModelBatch* Batch)
+{
+	if (!Batch)
+	{
+		m->Render(Buffer->FramebufferCamera, Buffer == Graphics::MainFramebuffer, false);
+	}
+	else if (m->IsVisible())
+	{
+		Batch->Add(m, m->GetLOD(Buffer->FramebufferCamera, false), ModelBatch::MeshFilter::Opaque);
+	}
+}
+
+bool OcclusionCulling::RenderOccluded(Model* m, size_t i, size_t NumDrawn, FramebufferObject* Buffer, ModelBatch* Batch)
 {
 	GLuint sampleCount = 0;
 	if (!m || !m->Visible)
@@ -33,10 +46,10 @@ bool OcclusionCulling::RenderOccluded(Model* m, size_t i, FramebufferObject* Buf
 	// Various conditions where the model should not be culled.
 	if (!Active
 		|| (m->Size.extents * m->ModelTransform.Scale).Length() > 500.0f
-		|| (!m->IsOcclusionCulled && i != Stats::FrameCount % Buffer->Renderables.size())
+		|| (!m->IsOcclusionCulled && i != Stats::FrameCount % NumDrawn)
 		|| !m->ShouldCull)
 	{
-		m->Render(Buffer->FramebufferCamera, Buffer == Graphics::MainFramebuffer, false);
+		RenderOrBatch(m, Buffer, Batch);
 		m->IsOcclusionCulled = false;
 		return true;
 	}
@@ -47,7 +60,7 @@ bool OcclusionCulling::RenderOccluded(Model* m, size_t i, FramebufferObject* Buf
 		// Render the model if the last query said it's visible.
 		if (!m->IsOcclusionCulled)
 		{
-			m->Render(Buffer->FramebufferCamera, Buffer == Graphics::MainFramebuffer, false);
+			RenderOrBatch(m, Buffer, Batch);
 		}
 
 		return !m->IsOcclusionCulled;
@@ -76,16 +89,29 @@ bool OcclusionCulling::RenderOccluded(Model* m, size_t i, FramebufferObject* Buf
 	{
 		if (!m->IsOcclusionCulled)
 		{
-			m->Render(Buffer->FramebufferCamera, Buffer == Graphics::MainFramebuffer, false);
+			RenderOrBatch(m, Buffer, Batch);
 		}
 		return !m->IsOcclusionCulled;
 	}
 
-	glBeginQuery(GL_ANY_SAMPLES_PASSED, Query);
+	// The other opaque models are only drawn when the batch is rendered.
+	// The query has to run after that, or it would be tested against an almost empty depth buffer.
+	if (Batch)
+	{
+		QueuedModels.push(m);
+		return true;
+	}
+
+	RenderWithQuery(m, Buffer);
+	return true;
+}
+
+void OcclusionCulling::RenderWithQuery(Model* m, FramebufferObject* Buffer)
+{
+	glBeginQuery(GL_ANY_SAMPLES_PASSED, OcclusionQueries[m->OcclusionQueryIndex]);
 	m->Render(Buffer->FramebufferCamera, Buffer == Graphics::MainFramebuffer, false);
 	glEndQuery(GL_ANY_SAMPLES_PASSED);
 	m->RunningQuery = true;
-	return true;
 }
 
 void OcclusionCulling::OcclusionCheck(Model* m, size_t i, FramebufferObject* Buffer)
@@ -158,6 +184,12 @@ void OcclusionCulling::UpdateOcclusionStatus(Model* m)
 
 void OcclusionCulling::QueryAllOccluded(FramebufferObject* Buffer)
 {
+	// Visible models are drawn first, so the bounding boxes of the culled models are also tested against them.
+	while (!OcclusionCulling::QueuedModels.empty())
+	{
+		RenderWithQuery(QueuedModels.top(), Buffer);
+		OcclusionCulling::QueuedModels.pop();
+	}
 	while (!OcclusionCulling::CulledModels.empty())
 	{
 		OcclusionCulling::OcclusionCheck(CulledModels.top(), 0, Buffer);
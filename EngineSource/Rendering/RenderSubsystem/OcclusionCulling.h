@@ -6,6 +6,7 @@
 
 class Model;
 class FramebufferObject;
+class ModelBatch;
 struct Shader;
 
 /**
@@ -26,7 +27,21 @@ public:
 
 	Shader* CullShader;
 
-	bool RenderOccluded(Model* m, size_t i, FramebufferObject* Buffer);
+	/**
+	* @brief
+	* Renders the model if it isn't occluded.
+	*
+	* @param i
+	* The index of the model in the list of drawn objects. Each frame, the visible model at index FrameCount % NumDrawn is checked with a query.
+	*
+	* @param NumDrawn
+	* The number of objects in the list of drawn objects.
+	*
+	* @param Batch
+	* If not nullptr, models that aren't used for an occlusion query are added to this batch instead of being rendered directly.
+	* Models that are used for a query are drawn by QueryAllOccluded(), which has to be called after the batch has been rendered.
+	*/
+	bool RenderOccluded(Model* m, size_t i, size_t NumDrawn, FramebufferObject* Buffer, ModelBatch* Batch = nullptr);
 	void OcclusionCheck(Model* m, size_t i, FramebufferObject* Buffer);
 
 	void UpdateOcclusionStatus(Model* m);
@@ -41,6 +56,10 @@ private:
 	unsigned int OcclusionQueries[256];
 	bool QueriesActive[256];
 	std::stack<Model*> CulledModels;
+	/// Visible models whose query waits until the batch has been rendered.
+	std::stack<Model*> QueuedModels;
+
+	void RenderWithQuery(Model* m, FramebufferObject* Buffer);
 };
 
 #endif
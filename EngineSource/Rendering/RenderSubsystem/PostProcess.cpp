@@ -10,6 +10,7 @@
 #include <Rendering/Framebuffer.h>
 #include <Rendering/Graphics.h>
 #include <Rendering/Shader.h>
+#include <Rendering/RenderState.h>
 #include <UI/UIBox.h>
 #include <UI/EditorUI/Viewport.h>
 #include <Engine/AppWindow.h>
@@ -21,7 +22,7 @@ unsigned int PostProcess::Effect::Render(unsigned int TargetBuffer) const
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, EffectBuffer);
 	glDisable(GL_DEPTH_TEST);
-	glDisable(GL_CULL_FACE);
+	RenderState::SetCullFace(false);
 	EffectShader->Bind();
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, TargetBuffer);
@@ -157,7 +158,7 @@ void PostProcess::Update()
 void PostProcess::Draw()
 {
 	glDisable(GL_BLEND);
-	glDisable(GL_CULL_FACE);
+	RenderState::SetCullFace(false);
 	glDisable(GL_DEPTH_TEST);
 
 #if !SERVER
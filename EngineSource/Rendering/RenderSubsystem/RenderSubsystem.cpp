@@ -8,6 +8,7 @@
 #include <Rendering/RenderSubsystem/BakedLighting.h>
 #include <Rendering/RenderSubsystem/CSM.h>
 #include <Rendering/Graphics.h>
+#include <Rendering/Mesh/ModelBatch.h>
 #include <Engine/Stats.h>
 #include <Engine/Subsystem/Console.h>
 #include <Engine/AppWindow.h>
@@ -48,6 +49,8 @@ RenderSubsystem::RenderSubsystem(bool IsDerived)
 		Subsystem::Load(new BakedLighting());
 
 		Console::ConsoleSystem->RegisterConVar(Console::Variable("wireframe", NativeType::Bool, &Graphics::IsWireframe, nullptr));
+		Console::ConsoleSystem->RegisterConVar(Console::Variable("mesh_batching", NativeType::Bool, &ModelBatch::Active, nullptr));
+		Console::ConsoleSystem->RegisterConVar(Console::Variable("lod_bias", NativeType::Float, &Graphics::LODBias, nullptr));
 		Console::ConsoleSystem->RegisterConVar(Console::Variable("vignette", NativeType::Float, &Graphics::Vignette, nullptr));
 		Console::ConsoleSystem->RegisterConVar(Console::Variable("vsync", NativeType::Bool, &Graphics::VSync, nullptr));
 		Console::ConsoleSystem->RegisterConVar(Console::Variable("timescale", NativeType::Float, &Stats::TimeMultiplier, nullptr));
@@ -13,6 +13,9 @@
 #include <Rendering/ShaderPreprocessor.h>
 #include <glm/mat4x4.hpp>
 #include <filesystem>
+#include <algorithm>
+#include <Rendering/FrameUniforms.h>
+#include <Rendering/RenderState.h>
 
 
 extern const bool IsInEditor;
@@ -20,54 +23,139 @@ extern const bool EngineDebug;
 
 Shader::Shader(std::string VertexShaderFilename, std::string FragmentShaderFilename, std::string GeometryShader)
 {
+	UniformSlots.fill(-1);
 	ShaderID = CreateShader(VertexShaderFilename.c_str(), FragmentShaderFilename.c_str(), GeometryShader.empty() ? nullptr : GeometryShader.c_str());
 	VertexFileName = VertexShaderFilename;
 	FragmetFileName = FragmentShaderFilename;
+#if !SERVER
+	FrameUniforms::BindToShader(this);
+#endif
 }
 
 Shader::~Shader()
 {
+	RenderState::ForgetProgram(ShaderID);
 	glDeleteProgram(ShaderID);
 }
 
 void Shader::Bind() const
 {
-	glUseProgram(ShaderID);
+	RenderState::UseProgram(ShaderID);
 }
 
 void Shader::Unbind()
 {
-	glUseProgram(0);
+	RenderState::UseProgram(0);
+}
+
+int Shader::GetUniformLocation(std::string_view Field) const
+{
+	auto Found = UniformLocations.find(Field);
+	if (Found == UniformLocations.end())
+	{
+		return -1;
+	}
+	return Found->second;
+}
+
+void Shader::SetInt(int Location, int Value) const
+{
+	glUniform1i(Location, Value);
 }
 
-void Shader::SetInt(std::string Field, int Value) const
+void Shader::SetFloat(int Location, float Value) const
 {
-	glUniform1i(glGetUniformLocation(ShaderID, Field.c_str()), Value);
+	glUniform1f(Location, Value);
 }
 
-void Shader::SetFloat(std::string Field, float Value) const
+void Shader::SetVector3(int Location, Vector3 Value) const
 {
-	glUniform1f(glGetUniformLocation(ShaderID, Field.c_str()), Value);
+	glUniform3f(Location, Value.X, Value.Y, Value.Z);
 }
 
-void Shader::SetVector4(std::string Field, Vector4 Value) const
+void Shader::SetMat4(int Location, const glm::mat4& Value) const
 {
-	glUniform4f(glGetUniformLocation(ShaderID, Field.c_str()), Value.X, Value.Y, Value.Z, Value.W);
+	glUniformMatrix4fv(Location, 1, GL_FALSE, &Value[0][0]);
 }
 
-void Shader::SetVector3(std::string Field, Vector3 Value) const
+void Shader::SetInt(std::string_view Field, int Value) const
 {
-	glUniform3f(glGetUniformLocation(ShaderID, Field.c_str()), Value.X, Value.Y, Value.Z);
+	glUniform1i(GetUniformLocation(Field), Value);
 }
 
-void Shader::SetVector2(std::string Field, Vector2 Value) const
+void Shader::SetFloat(std::string_view Field, float Value) const
 {
-	glUniform2f(glGetUniformLocation(ShaderID, Field.c_str()), Value.X, Value.Y);
+	glUniform1f(GetUniformLocation(Field), Value);
 }
 
-void Shader::SetMat4(std::string Field, glm::mat4 Value) const
+void Shader::SetVector4(std::string_view Field, Vector4 Value) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ShaderID, Field.c_str()), 1, GL_FALSE, &Value[0][0]);
+	glUniform4f(GetUniformLocation(Field), Value.X, Value.Y, Value.Z, Value.W);
+}
+
+void Shader::SetVector3(std::string_view Field, Vector3 Value) const
+{
+	glUniform3f(GetUniformLocation(Field), Value.X, Value.Y, Value.Z);
+}
+
+void Shader::SetVector2(std::string_view Field, Vector2 Value) const
+{
+	glUniform2f(GetUniformLocation(Field), Value.X, Value.Y);
+}
+
+void Shader::SetMat4(std::string_view Field, const glm::mat4& Value) const
+{
+	glUniformMatrix4fv(GetUniformLocation(Field), 1, GL_FALSE, &Value[0][0]);
+}
+
+void Shader::LoadUniformLocations()
+{
+	UniformLocations.clear();
+
+	GLint NumUniforms = 0, MaxNameLength = 0;
+	glGetProgramiv(ShaderID, GL_ACTIVE_UNIFORMS, &NumUniforms);
+	glGetProgramiv(ShaderID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &MaxNameLength);
+
+	std::string Name;
+	Name.resize(std::max(MaxNameLength, 1));
+	for (GLint i = 0; i < NumUniforms; i++)
+	{
+		GLsizei NameLength = 0;
+		GLint Size = 0;
+		GLenum Type = 0;
+		glGetActiveUniform(ShaderID, (GLuint)i, (GLsizei)Name.size(), &NameLength, &Size, &Type, Name.data());
+		std::string UniformName = Name.substr(0, NameLength);
+		GLint Location = glGetUniformLocation(ShaderID, UniformName.c_str());
+		if (Location < 0)
+		{
+			continue;
+		}
+
+		// Arrays are reported as "name[0]". Each element can be set by its own name.
+		if (UniformName.ends_with("[0]"))
+		{
+			std::string ArrayName = UniformName.substr(0, UniformName.size() - 3);
+			UniformLocations.insert({ ArrayName, Location });
+			for (GLint Element = 1; Element < Size; Element++)
+			{
+				std::string ElementName = ArrayName + "[" + std::to_string(Element) + "]";
+				UniformLocations.insert({ ElementName, glGetUniformLocation(ShaderID, ElementName.c_str()) });
+			}
+		}
+		UniformLocations.insert({ UniformName, Location });
+	}
+
+	// Same order as Shader::Uniform.
+	static constexpr std::array<std::string_view, (size_t)Uniform::NumUniforms> SlotNames = {
+		"u_useTexture",
+		"u_model",
+		"u_cascade",
+		"u_viewpro",
+	};
+	for (size_t i = 0; i < SlotNames.size(); i++)
+	{
+		UniformSlots[i] = GetUniformLocation(SlotNames[i]);
+	}
 }
 
 GLuint Shader::Compile(std::string ShaderCode, unsigned int NativeType)
@@ -210,6 +298,7 @@ GLuint Shader::CreateShader(const char* VertexShader, const char* FragmentShader
 		glAttachShader(ShaderID, geometry);
 	glLinkProgram(ShaderID);
 	checkCompileErrors(ShaderID, "PROGRAM", (VertexShader + std::string("-") + FragmentShader));
+	LoadUniformLocations();
 	// delete the shaders as they're linked into our program now and no longer necessary
 	glDeleteShader(vertex);
 	glDeleteShader(fragment);
@@ -1,5 +1,9 @@
 #pragma once
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <glm/fwd.hpp>
 
@@ -20,14 +24,70 @@ struct Shader
 		return ShaderID;
 	}
 
-	void SetInt(std::string Field, int Value) const;
-	void SetFloat(std::string Field, float Value) const;
-	void SetVector4(std::string Field, Vector4 Value) const;
-	void SetVector3(std::string Field, Vector3 Value) const;
-	void SetVector2(std::string Field, Vector2 Value) const;
-	void SetMat4(std::string Field, glm::mat4 Value) const;
+	/// Uniforms the engine sets for every draw call. Their locations are stored in fixed slots when the shader is linked.
+	enum class Uniform : uint8_t
+	{
+		/// u_useTexture
+		UseTexture,
+		/// u_model
+		Model,
+		/// u_cascade
+		Cascade,
+		/// u_viewpro
+		ViewProjection,
+		NumUniforms
+	};
+
+	/**
+	* @brief
+	* Returns the location of the given uniform, or -1 if the shader doesn't use it.
+	*
+	* Locations are resolved once when the shader is linked, so this doesn't call into OpenGL.
+	* Uniforms that are part of a uniform block don't have a location.
+	*/
+	int GetUniformLocation(std::string_view Field) const;
+	/// Returns the location of one of the engine's uniforms, or -1 if the shader doesn't use it. Doesn't look up any name.
+	int GetUniformLocation(Uniform Field) const
+	{
+		return UniformSlots[(size_t)Field];
+	}
+
+	void SetInt(std::string_view Field, int Value) const;
+	void SetFloat(std::string_view Field, float Value) const;
+	void SetVector4(std::string_view Field, Vector4 Value) const;
+	void SetVector3(std::string_view Field, Vector3 Value) const;
+	void SetVector2(std::string_view Field, Vector2 Value) const;
+	void SetMat4(std::string_view Field, const glm::mat4& Value) const;
+
+	/// Setters for a location returned by GetUniformLocation(), for uniforms that are set often.
+	void SetInt(int Location, int Value) const;
+	void SetFloat(int Location, float Value) const;
+	void SetVector3(int Location, Vector3 Value) const;
+	void SetMat4(int Location, const glm::mat4& Value) const;
+
+	void SetInt(Uniform Field, int Value) const
+	{
+		SetInt(GetUniformLocation(Field), Value);
+	}
+	void SetMat4(Uniform Field, const glm::mat4& Value) const
+	{
+		SetMat4(GetUniformLocation(Field), Value);
+	}
 
 private:
+	struct UniformNameHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view Name) const
+		{
+			return std::hash<std::string_view>()(Name);
+		}
+	};
+
+	void LoadUniformLocations();
+	std::unordered_map<std::string, int, UniformNameHash, std::equal_to<>> UniformLocations;
+	std::array<int, (size_t)Uniform::NumUniforms> UniformSlots;
+
 	unsigned int Compile(std::string ShaderCode, unsigned int NativeType);
 	std::string parse(const char* Filename);
 	unsigned int CreateShader(const char* VertexShader, const char* FragmentShader, const char* GeometryShader);
@@ -2,21 +2,56 @@
 #include "VertexBuffer.h"
 #include <GL/glew.h>
 #include <iostream>
+#include <algorithm>
 
-VertexBuffer::VertexBuffer(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices)
+VertexBuffer::VertexBuffer(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices, const std::vector<std::vector<unsigned int>>& LODIndices)
 {
 	this->Vertices = Vertices;
 	this->Indices = Indices;
-	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
-	glBindVertexArray(VAO);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * this->Vertices.size(), this->Vertices.data(), GL_STATIC_DRAW);
 
+	// The index buffer is filled through GL_ARRAY_BUFFER, because binding GL_ELEMENT_ARRAY_BUFFER
+	// would change the currently bound vertex array.
+	size_t TotalIndices = this->Indices.size();
+	for (const auto& LOD : LODIndices)
+	{
+		LODs.push_back(IndexRange{ TotalIndices, LOD.size() });
+		TotalIndices += LOD.size();
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ARRAY_BUFFER, TotalIndices * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, this->Indices.size() * sizeof(unsigned int), this->Indices.data());
+	for (size_t i = 0; i < LODs.size(); i++)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, LODs[i].Offset * sizeof(unsigned int), LODs[i].Count * sizeof(unsigned int), LODIndices[i].data());
+	}
+
+	IndicesSize = static_cast<unsigned int>(this->Indices.size());
+	CreateVertexArray();
+}
+
+VertexBuffer::VertexBuffer(const VertexBuffer* SharedBuffer)
+{
+	VBO = SharedBuffer->VBO;
+	EBO = SharedBuffer->EBO;
+	IndicesSize = SharedBuffer->IndicesSize;
+	LODs = SharedBuffer->LODs;
+	OwnsBuffers = false;
+	CreateVertexArray();
+}
+
+void VertexBuffer::CreateVertexArray()
+{
+	glGenVertexArrays(1, &VAO);
+	glBindVertexArray(VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, this->Indices.size() * sizeof(unsigned int), this->Indices.data(), GL_STATIC_DRAW);
 
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -31,15 +66,16 @@ VertexBuffer::VertexBuffer(std::vector<Vertex> Vertices, std::vector<unsigned in
 	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
 
 	glBindVertexArray(0);
-
-	IndicesSize = static_cast<unsigned int>(this->Indices.size());
 }
 
 VertexBuffer::~VertexBuffer()
 {
 	glDeleteVertexArrays(1, &VAO);
-	glDeleteBuffers(1, &VBO);
-	glDeleteBuffers(1, &EBO);
+	if (OwnsBuffers)
+	{
+		glDeleteBuffers(1, &VBO);
+		glDeleteBuffers(1, &EBO);
+	}
 }
 
 void VertexBuffer::Bind()
@@ -58,4 +94,33 @@ void VertexBuffer::Draw()
 	glDrawElements(GL_TRIANGLES, IndicesSize, GL_UNSIGNED_INT, nullptr);
 	Unbind();
 }
+
+void VertexBuffer::DrawInstanced(size_t NumInstances, size_t LOD)
+{
+	IndexRange Range = IndexRange{ 0, IndicesSize };
+	if (LOD > 0 && !LODs.empty())
+	{
+		Range = LODs[std::min(LOD, LODs.size()) - 1];
+	}
+
+	Bind();
+	glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)Range.Count, GL_UNSIGNED_INT,
+		(void*)(Range.Offset * sizeof(unsigned int)), (GLsizei)NumInstances);
+	Unbind();
+}
+
+void VertexBuffer::SetInstanceTransforms(unsigned int Buffer, size_t Offset)
+{
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, Buffer);
+	// A mat4 attribute takes up 4 vec4 attribute locations.
+	const size_t vec4Size = sizeof(float) * 4;
+	for (GLuint i = 0; i < 4; i++)
+	{
+		glEnableVertexAttribArray(4 + i);
+		glVertexAttribPointer(4 + i, 4, GL_FLOAT, GL_FALSE, 4 * (GLsizei)vec4Size, (void*)(Offset + i * vec4Size));
+		glVertexAttribDivisor(4 + i, 1);
+	}
+	glBindVertexArray(0);
+}
 #endif
\ No newline at end of file
@@ -7,13 +7,58 @@ struct VertexBuffer
 	unsigned int VAO = 0u, VBO = 0u, EBO = 0u, IndicesSize = 0u;
 	std::vector<Vertex> Vertices; std::vector<unsigned int> Indices;
 public:
+	/// A range of the index buffer used to draw a level of detail.
+	struct IndexRange
+	{
+		size_t Offset = 0;
+		size_t Count = 0;
+	};
+
+	/// The index ranges of the lower levels of detail. Level 0 (the full mesh) isn't included.
+	std::vector<IndexRange> LODs;
+
 	static VertexBuffer* MakeSquare();
 
-	VertexBuffer(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices);
+	/**
+	* @brief
+	* Creates a vertex buffer.
+	*
+	* @param LODIndices
+	* Index buffers of lower levels of detail, using the same vertices. They are stored in the same index buffer after Indices.
+	*/
+	VertexBuffer(std::vector<Vertex> Vertices, std::vector<unsigned int> Indices, const std::vector<std::vector<unsigned int>>& LODIndices = {});
+
+	/**
+	* @brief
+	* Creates a vertex buffer with its own vertex array object, which uses the vertex and index data of SharedBuffer.
+	*
+	* No vertex data is copied. SharedBuffer must not be deleted before this buffer.
+	*/
+	VertexBuffer(const VertexBuffer* SharedBuffer);
 	~VertexBuffer();
 	void Bind();
 	void Unbind();
 
 	void Draw();
+	/**
+	* @brief
+	* Draws NumInstances instances of the buffer. The instance transforms are read from the buffer set with SetInstanceTransforms().
+	*
+	* @param LOD
+	* The level of detail to draw. 0 is the full mesh. If the buffer has fewer levels, the lowest one is drawn.
+	*/
+	void DrawInstanced(size_t NumInstances, size_t LOD = 0);
+
+	/**
+	* @brief
+	* Sets the buffer the per instance model matrices (vertex attributes 4 to 7) are read from.
+	*
+	* @param Offset
+	* The offset of the first matrix in the buffer, in bytes.
+	*/
+	void SetInstanceTransforms(unsigned int Buffer, size_t Offset = 0);
+private:
+	bool OwnsBuffers = true;
+	void CreateVertexArray();
 };
 #endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <Engine/Application.h>
 #include <Engine/Subsystem/Console.h>
 #include <Engine/Log.h>
+#include <Rendering/Graphics.h>
 
 namespace Input
 {
@@ -163,6 +164,7 @@ void DebugUI::Tick()
 
 		DebugTexts[2]->SetText(DeltaString);
 		DebugTexts[3]->SetText("DrawCalls: " + std::to_string(Stats::DrawCalls));
+		DebugTexts[4]->SetText("LOD bias: " + std::to_string(Graphics::LODBias).substr(0, 4));
 		StatsRedrawTimer = 0;
 		FPS = 0;
 	}
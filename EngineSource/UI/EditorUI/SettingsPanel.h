@@ -139,6 +139,10 @@ class SettingsPanel : public EditorPanel
 				Graphics::RenderAntiAlias = std::stoi(NewValue);
 				Graphics::SetWindowResolution(Graphics::WindowResolution, true);
 			}),
+			SettingsCategory::Setting("Graphics:LOD bias", NativeType::Float, "0", [](std::string NewValue)
+			{
+				Graphics::LODBias = std::stof(NewValue);
+			}),
 			SettingsCategory::Setting("Display:VSync", NativeType::Bool, "1", [](std::string NewValue)
 			{
 				Graphics::VSync = std::stoi(NewValue);
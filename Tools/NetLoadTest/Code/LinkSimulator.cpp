@@ -0,0 +1,59 @@
+#include "LinkSimulator.h"
+#include <algorithm>
+
+LinkSimulator::LinkSimulator(const Settings& LinkSettings, uint32_t Seed)
+	: LinkSettings(LinkSettings), Random(Seed)
+{
+}
+
+void LinkSimulator::Add(const uint8_t* Data, size_t Length, Clock::time_point SendTime)
+{
+	std::uniform_real_distribution<double> Distribution = std::uniform_real_distribution<double>(0.0, 1.0);
+	if (Distribution(Random) < LinkSettings.Loss)
+	{
+		NumDropped++;
+		return;
+	}
+
+	double Delay = LinkSettings.Delay + Distribution(Random) * LinkSettings.Jitter;
+	if (Distribution(Random) < LinkSettings.Reorder)
+	{
+		Delay += LinkSettings.ReorderDelay;
+	}
+
+	Datagram NewDatagram;
+	NewDatagram.DeliveryTime = SendTime + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(Delay));
+	NewDatagram.Order = NextOrder++;
+	NewDatagram.Data.assign(Data, Data + Length);
+	Queue.push(std::move(NewDatagram));
+}
+
+void LinkSimulator::Update(const DeliverFunction& Deliver)
+{
+	Clock::time_point Now = Clock::now();
+	while (!Queue.empty() && Queue.top().DeliveryTime <= Now)
+	{
+		Deliver(Queue.top().Data.data(), Queue.top().Data.size(), Queue.top().DeliveryTime);
+		Queue.pop();
+	}
+}
+
+void LinkSimulator::Flush(const DeliverFunction& Deliver)
+{
+	Clock::time_point Now = Clock::now();
+	while (!Queue.empty())
+	{
+		Deliver(Queue.top().Data.data(), Queue.top().Data.size(), std::min(Queue.top().DeliveryTime, Now));
+		Queue.pop();
+	}
+}
+
+LinkSimulator::Clock::time_point LinkSimulator::GetNextDeliveryTime() const
+{
+	return Queue.empty() ? Clock::time_point::max() : Queue.top().DeliveryTime;
+}
+
+uint64_t LinkSimulator::GetNumDropped() const
+{
+	return NumDropped;
+}
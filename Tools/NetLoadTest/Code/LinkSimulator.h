@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <functional>
+
+/**
+* @brief
+* Simulates a bad network link in one direction.
+*
+* Datagrams passed to Add() are dropped with a probability of Loss. The others are delivered by Update() after
+* Delay plus a random jitter of up to Jitter. Jitter alone already reorders datagrams, and with a probability of Reorder
+* a datagram is held back for ReorderDelay longer, so datagrams sent after it arrive first.
+*/
+class LinkSimulator
+{
+public:
+	using Clock = std::chrono::steady_clock;
+	/// DeliveryTime is the time the datagram arrives on the simulated link, which might be earlier than the call.
+	using DeliverFunction = std::function<void(const uint8_t* Data, size_t Length, Clock::time_point DeliveryTime)>;
+
+	struct Settings
+	{
+		/// Probability of a datagram being dropped, 0 - 1.
+		float Loss = 0;
+		/// Probability of a datagram being held back, 0 - 1.
+		float Reorder = 0;
+		/// One way delay in seconds.
+		double Delay = 0;
+		/// Maximum random delay added to each datagram in seconds.
+		double Jitter = 0;
+		/// Additional delay of held back datagrams in seconds.
+		double ReorderDelay = 0.02;
+	};
+
+	LinkSimulator(const Settings& LinkSettings, uint32_t Seed);
+
+	/// Queues a datagram that entered the link at SendTime, or drops it.
+	void Add(const uint8_t* Data, size_t Length, Clock::time_point SendTime = Clock::now());
+	/// Delivers all datagrams whose delay has passed, in the order they arrive.
+	void Update(const DeliverFunction& Deliver);
+	/// Delivers all queued datagrams, ignoring their delay.
+	void Flush(const DeliverFunction& Deliver);
+	/// The time the next queued datagram arrives. Clock::time_point::max() if nothing is queued.
+	Clock::time_point GetNextDeliveryTime() const;
+
+	uint64_t GetNumDropped() const;
+
+private:
+	struct Datagram
+	{
+		Clock::time_point DeliveryTime;
+		/// Keeps datagrams with the same delivery time in the order they were added.
+		uint64_t Order = 0;
+		std::vector<uint8_t> Data;
+	};
+
+	struct DeliveredLater
+	{
+		bool operator()(const Datagram& a, const Datagram& b) const
+		{
+			if (a.DeliveryTime != b.DeliveryTime)
+			{
+				return a.DeliveryTime > b.DeliveryTime;
+			}
+			return a.Order > b.Order;
+		}
+	};
+
+	Settings LinkSettings;
+	std::mt19937 Random;
+	std::priority_queue<Datagram, std::vector<Datagram>, DeliveredLater> Queue;
+	uint64_t NextOrder = 0;
+	uint64_t NumDropped = 0;
+};
@@ -0,0 +1,381 @@
+// SDL_net includes SDL.h, which would otherwise replace main() with SDL_main().
+#define SDL_MAIN_HANDLED
+#include "SimulatedClient.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <cstdio>
+
+/*
+* Connects simulated clients to a running server and measures how it holds up.
+*
+* Usage: NetLoadTest server=[host:port] clients=[N] rate=[Hz] duration=[s] ramp=[s]
+*                    loss=[%] reorder=[%] delay=[ms] jitter=[ms]
+*
+* Loss, reorder, delay and jitter are applied in both directions, so the round trip delay is twice the delay.
+* Every second, the server tick rate seen in snapshots, the bandwidth per client and the round trip time percentiles are printed.
+*/
+
+namespace
+{
+	struct Options
+	{
+		std::string Host = "localhost";
+		uint16_t Port = 0;
+		int NumClients = 16;
+		int Rate = 64;
+		double Duration = 30;
+		/// Clients connect evenly spread over this many seconds, so the server isn't hit by all handshakes at once.
+		double Ramp = 1;
+		LinkSimulator::Settings Link;
+	};
+
+	// SDL_net waits for sockets with select(), which can't handle much more than this many sockets on most platforms.
+	constexpr size_t MAX_WAIT_SOCKETS = 1000;
+
+	/**
+	* Waits until WakeTime, or until a socket in Set received a datagram, so datagrams are read from the sockets right when they arrive.
+	* Without a socket set, it waits at most a millisecond at a time instead.
+	*/
+	void WaitForDatagrams(SDLNet_SocketSet Set, SimulatedClient::Clock::time_point WakeTime)
+	{
+		using Clock = SimulatedClient::Clock;
+		Clock::time_point Now = Clock::now();
+		if (WakeTime <= Now)
+		{
+			return;
+		}
+		if (!Set)
+		{
+			std::this_thread::sleep_until(std::min(WakeTime, Now + std::chrono::milliseconds(1)));
+			return;
+		}
+		auto Timeout = std::chrono::ceil<std::chrono::milliseconds>(WakeTime - Now).count();
+		SDLNet_CheckSockets(Set, (Uint32)std::min<long long>(Timeout, 1000));
+	}
+
+	void ArgumentError(std::string Message)
+	{
+		std::cout << "[Error]: " << Message << std::endl;
+		exit(1);
+	}
+
+	double ParseNumber(const std::string& Name, const std::string& Value)
+	{
+		try
+		{
+			return std::stod(Value);
+		}
+		catch (std::exception&)
+		{
+			ArgumentError("Invalid value for " + Name + ": " + Value);
+		}
+		return 0;
+	}
+
+	Options ParseOptions(int argc, char** argv)
+	{
+		Options Result;
+		for (int i = 1; i < argc; i++)
+		{
+			std::string ArgStr = argv[i];
+			size_t Equals = ArgStr.find_first_of("=");
+			if (Equals == std::string::npos)
+			{
+				ArgumentError("Expected name=value: " + ArgStr);
+			}
+			std::string Name = ArgStr.substr(0, Equals);
+			std::string Value = ArgStr.substr(Equals + 1);
+
+			if (Name == "server")
+			{
+				size_t Colon = Value.find_last_of(":");
+				if (Colon == std::string::npos)
+				{
+					ArgumentError("Expected server=[host:port]: " + Value);
+				}
+				Result.Host = Value.substr(0, Colon);
+				Result.Port = (uint16_t)ParseNumber(Name, Value.substr(Colon + 1));
+			}
+			else if (Name == "clients")
+			{
+				Result.NumClients = std::max(1, (int)ParseNumber(Name, Value));
+			}
+			else if (Name == "rate")
+			{
+				Result.Rate = std::clamp((int)ParseNumber(Name, Value), 1, 1000);
+			}
+			else if (Name == "duration")
+			{
+				Result.Duration = ParseNumber(Name, Value);
+			}
+			else if (Name == "ramp")
+			{
+				Result.Ramp = std::max(0.0, ParseNumber(Name, Value));
+			}
+			else if (Name == "loss")
+			{
+				Result.Link.Loss = (float)ParseNumber(Name, Value) / 100.0f;
+			}
+			else if (Name == "reorder")
+			{
+				Result.Link.Reorder = (float)ParseNumber(Name, Value) / 100.0f;
+			}
+			else if (Name == "delay")
+			{
+				Result.Link.Delay = ParseNumber(Name, Value) / 1000.0;
+			}
+			else if (Name == "jitter")
+			{
+				Result.Link.Jitter = ParseNumber(Name, Value) / 1000.0;
+			}
+			else
+			{
+				ArgumentError("Unknown argument: " + Name);
+			}
+		}
+		if (Result.Port == 0)
+		{
+			ArgumentError("Server has not been defined (server=[host:port])");
+		}
+		return Result;
+	}
+
+	float GetPercentile(const std::vector<float>& Sorted, float Percentile)
+	{
+		if (Sorted.empty())
+		{
+			return 0;
+		}
+		return Sorted[(size_t)(Percentile * (float)(Sorted.size() - 1))];
+	}
+
+	void PrintRoundTripTimes(std::vector<float> Samples)
+	{
+		std::sort(Samples.begin(), Samples.end());
+		std::printf("  RTT (%zu samples): p50 %.1fms, p90 %.1fms, p99 %.1fms, max %.1fms\n",
+			Samples.size(),
+			GetPercentile(Samples, 0.5f) * 1000.0f,
+			GetPercentile(Samples, 0.9f) * 1000.0f,
+			GetPercentile(Samples, 0.99f) * 1000.0f,
+			Samples.empty() ? 0.0f : Samples.back() * 1000.0f);
+	}
+
+	struct Totals
+	{
+		size_t NumConnected = 0;
+		uint64_t BytesSent = 0;
+		uint64_t BytesReceived = 0;
+	};
+
+	Totals GetTotals(const std::vector<std::unique_ptr<SimulatedClient>>& Clients)
+	{
+		Totals Result;
+		for (auto& i : Clients)
+		{
+			Result.NumConnected += i->GetIsConnected();
+			Result.BytesSent += i->GetStats().BytesSent;
+			Result.BytesReceived += i->GetStats().BytesReceived;
+		}
+		return Result;
+	}
+
+	/// The tick rate of the server, measured from the ticks of snapshots received by each client.
+	void PrintServerTicks(const std::vector<std::unique_ptr<SimulatedClient>>& Clients)
+	{
+		double Sum = 0;
+		double Min = 0;
+		size_t Count = 0;
+		uint32_t TickRate = 0;
+		for (auto& i : Clients)
+		{
+			const SimulatedClient::Stats& Stats = i->GetStats();
+			double Time = std::chrono::duration<double>(Stats.LatestSnapshotTime - Stats.FirstSnapshotTime).count();
+			TickRate = std::max(TickRate, i->GetServerTickRate());
+			if (Stats.NumSnapshots < 2 || Time <= 0)
+			{
+				continue;
+			}
+			double TicksPerSecond = double(Stats.LatestTick - Stats.FirstTick) / Time;
+			Min = Count == 0 ? TicksPerSecond : std::min(Min, TicksPerSecond);
+			Sum += TicksPerSecond;
+			Count++;
+		}
+		if (Count == 0)
+		{
+			std::printf("  Server ticks: no snapshots received (tick rate %u)\n", TickRate);
+			return;
+		}
+		std::printf("  Server ticks: %.1f/s average, %.1f/s lowest client (tick rate %u)\n", Sum / (double)Count, Min, TickRate);
+	}
+
+	void PrintSummary(std::vector<std::unique_ptr<SimulatedClient>>& Clients, const std::vector<float>& RoundTripSamples, double Duration)
+	{
+		size_t NumEverConnected = 0;
+		size_t NumKicked = 0;
+		size_t NumOwnedObjects = 0;
+		double ConnectTime = 0;
+		double MaxDown = 0;
+		uint64_t Dropped = 0;
+		Connection::Stats Total;
+		for (auto& i : Clients)
+		{
+			const SimulatedClient::Stats& Stats = i->GetStats();
+			if (Stats.ConnectTime >= 0)
+			{
+				NumEverConnected++;
+				ConnectTime += Stats.ConnectTime;
+			}
+			NumKicked += i->GetWasDisconnected();
+			NumOwnedObjects += i->GetNumOwnedObjects();
+			MaxDown = std::max(MaxDown, (double)Stats.BytesReceived / Duration);
+			Dropped += i->GetNumDropped();
+			for (const Connection::Stats& c : i->GetConnectionStats())
+			{
+				Total.NumSent += c.NumSent;
+				Total.NumReceived += c.NumReceived;
+				Total.NumResent += c.NumResent;
+			}
+		}
+		Totals Bytes = GetTotals(Clients);
+		double PerClient = 1.0 / std::max(1.0, (double)NumEverConnected) / Duration / 1000.0;
+
+		std::printf("Summary after %.1fs:\n", Duration);
+		std::printf("  Clients: %zu/%zu connected, %zu disconnected by the server, average connect time %.1fms, %zu owned objects\n",
+			NumEverConnected, Clients.size(), NumKicked, NumEverConnected ? ConnectTime / (double)NumEverConnected * 1000.0 : 0.0, NumOwnedObjects);
+		PrintServerTicks(Clients);
+		std::printf("  Bandwidth per client: %.2f kB/s down (max %.2f kB/s), %.2f kB/s up\n",
+			(double)Bytes.BytesReceived * PerClient, MaxDown / 1000.0, (double)Bytes.BytesSent * PerClient);
+		std::printf("  Datagrams: %llu sent, %llu received, %llu reliable fragments resent, %llu dropped by the simulated link\n",
+			(unsigned long long)Total.NumSent, (unsigned long long)Total.NumReceived, (unsigned long long)Total.NumResent, (unsigned long long)Dropped);
+		PrintRoundTripTimes(RoundTripSamples);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options LoadOptions = ParseOptions(argc, argv);
+
+	if (SDLNet_Init() < 0)
+	{
+		ArgumentError(std::string("Failed to initialize SDL_net: ") + SDLNet_GetError());
+	}
+	IPaddress Server;
+	if (SDLNet_ResolveHost(&Server, LoadOptions.Host.c_str(), LoadOptions.Port) < 0)
+	{
+		ArgumentError("Failed to resolve host: " + LoadOptions.Host);
+	}
+
+	std::vector<float> RoundTripSamples;
+	std::vector<std::unique_ptr<SimulatedClient>> Clients;
+	for (int i = 0; i < LoadOptions.NumClients; i++)
+	{
+		Clients.push_back(std::make_unique<SimulatedClient>(Server, LoadOptions.Link, (uint32_t)i + 1, &RoundTripSamples));
+		if (!Clients.back()->Open())
+		{
+			ArgumentError(std::string("Failed to open socket: ") + SDLNet_GetError());
+		}
+	}
+
+	SDLNet_SocketSet SocketSet = nullptr;
+	if (Clients.size() <= MAX_WAIT_SOCKETS)
+	{
+		SocketSet = SDLNet_AllocSocketSet((int)Clients.size());
+		for (auto& i : Clients)
+		{
+			i->AddToSocketSet(SocketSet);
+		}
+	}
+
+	std::printf("Connecting %i clients to %s:%u at %i Hz for %.1fs (loss %.1f%%, reorder %.1f%%, delay %.1fms, jitter %.1fms)\n",
+		LoadOptions.NumClients, LoadOptions.Host.c_str(), (unsigned)LoadOptions.Port, LoadOptions.Rate, LoadOptions.Duration,
+		LoadOptions.Link.Loss * 100.0f, LoadOptions.Link.Reorder * 100.0f, LoadOptions.Link.Delay * 1000.0, LoadOptions.Link.Jitter * 1000.0);
+
+	using Clock = SimulatedClient::Clock;
+	const Clock::time_point StartTime = Clock::now();
+	const auto TickDelta = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / LoadOptions.Rate));
+	Clock::time_point NextTick = StartTime;
+	Clock::time_point NextReport = StartTime + std::chrono::seconds(1);
+	Totals LastTotals;
+	size_t LastNumSamples = 0;
+
+	while (true)
+	{
+		Clock::time_point Now = Clock::now();
+		double Elapsed = std::chrono::duration<double>(Now - StartTime).count();
+		if (Elapsed >= LoadOptions.Duration)
+		{
+			break;
+		}
+
+		for (auto& i : Clients)
+		{
+			i->Receive();
+		}
+
+		if (Now >= NextTick)
+		{
+			size_t NumActive = LoadOptions.Ramp > 0
+				? std::min(Clients.size(), (size_t)(Elapsed / LoadOptions.Ramp * (double)Clients.size()) + 1)
+				: Clients.size();
+			for (size_t i = 0; i < NumActive; i++)
+			{
+				Clients[i]->Tick();
+			}
+			NextTick += TickDelta;
+			// Don't try to catch up on ticks after a stall, that would send bursts the server doesn't see from real clients.
+			if (NextTick < Now)
+			{
+				NextTick = Now + TickDelta;
+			}
+		}
+
+		for (auto& i : Clients)
+		{
+			i->FlushSends();
+		}
+
+		if (Now >= NextReport)
+		{
+			Totals NewTotals = GetTotals(Clients);
+			double PerClient = 1.0 / std::max((size_t)1, NewTotals.NumConnected) / 1000.0;
+			std::vector<float> NewSamples = std::vector<float>(RoundTripSamples.begin() + LastNumSamples, RoundTripSamples.end());
+			std::sort(NewSamples.begin(), NewSamples.end());
+			std::printf("[%5.1fs] %zu connected, %.2f kB/s down, %.2f kB/s up per client, RTT p50 %.1fms, p99 %.1fms\n",
+				Elapsed,
+				NewTotals.NumConnected,
+				double(NewTotals.BytesReceived - LastTotals.BytesReceived) * PerClient,
+				double(NewTotals.BytesSent - LastTotals.BytesSent) * PerClient,
+				GetPercentile(NewSamples, 0.5f) * 1000.0f,
+				GetPercentile(NewSamples, 0.99f) * 1000.0f);
+			LastTotals = NewTotals;
+			LastNumSamples = RoundTripSamples.size();
+			NextReport += std::chrono::seconds(1);
+		}
+
+		Clock::time_point WakeTime = std::min(NextTick, NextReport);
+		for (auto& i : Clients)
+		{
+			WakeTime = std::min(WakeTime, i->GetNextDeliveryTime());
+		}
+		WaitForDatagrams(SocketSet, WakeTime);
+	}
+
+	double Duration = std::chrono::duration<double>(Clock::now() - StartTime).count();
+	PrintSummary(Clients, RoundTripSamples, Duration);
+
+	for (auto& i : Clients)
+	{
+		i->Disconnect();
+	}
+	if (SocketSet)
+	{
+		SDLNet_FreeSocketSet(SocketSet);
+	}
+	Clients.clear();
+	SDLNet_Quit();
+	return 0;
+}
@@ -0,0 +1,363 @@
+#include "SimulatedClient.h"
+#include <Networking/Packet.h>
+#include <Networking/BitStream.h>
+#include <Networking/PacketLayout.h>
+#include <Networking/NetworkingInternal.h>
+#include <Networking/EventArguments.h>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace
+{
+	// Time between ConnectRequests until the server answers.
+	constexpr double CONNECT_RETRY_TIME = 1.0;
+	// If nothing has been sent for this long, an empty acknowledgement is sent so the server doesn't time out the client.
+	constexpr double KEEP_ALIVE_TIME = 1.0;
+	// Acknowledgements beyond this are dropped, the server then keeps using older baselines, like with real clients.
+	constexpr size_t MAX_ACKNOWLEDGEMENTS = 64;
+
+	double SecondsSince(SimulatedClient::Clock::time_point Time)
+	{
+		return std::chrono::duration<double>(SimulatedClient::Clock::now() - Time).count();
+	}
+
+	template<typename T>
+	void Write(std::vector<uint8_t>& Data, T Value)
+	{
+		size_t Size = Data.size();
+		Data.resize(Size + sizeof(T));
+		memcpy(Data.data() + Size, &Value, sizeof(T));
+	}
+
+	template<typename T>
+	T Read(const std::vector<uint8_t>& Data, size_t Offset)
+	{
+		T Value = T();
+		if (Offset + sizeof(T) <= Data.size())
+		{
+			memcpy(&Value, Data.data() + Offset, sizeof(T));
+		}
+		return Value;
+	}
+}
+
+SimulatedClient::SimulatedClient(IPaddress Server, const LinkSimulator::Settings& LinkSettings, uint32_t Seed, std::vector<float>* RoundTripSamples)
+	: Server(Server),
+	Connections([this](const uint8_t* Data, size_t Length, IPaddress*)
+		{
+			if (BypassLink)
+			{
+				SendDatagram(Data, Length);
+			}
+			else
+			{
+				Outgoing.Add(Data, Length);
+			}
+		}),
+	Outgoing(LinkSettings, Seed),
+	Incoming(LinkSettings, Seed ^ 0x5bd1e995)
+{
+	Connections.RoundTripSamples = RoundTripSamples;
+}
+
+SimulatedClient::~SimulatedClient()
+{
+	if (SocketPacket)
+	{
+		SDLNet_FreePacket(SocketPacket);
+	}
+	if (Socket)
+	{
+		SDLNet_UDP_Close(Socket);
+	}
+}
+
+bool SimulatedClient::Open()
+{
+	Socket = SDLNet_UDP_Open(0);
+	SocketPacket = SDLNet_AllocPacket((int)Networking::PACKET_BUFFER_SIZE);
+	return Socket && SocketPacket;
+}
+
+void SimulatedClient::Receive()
+{
+	while (SDLNet_UDP_Recv(Socket, SocketPacket) > 0)
+	{
+		// Taken right after the read, so the round trip time doesn't depend on how often the tool gets to process datagrams.
+		Clock::time_point ReadTime = Clock::now();
+		if (SocketPacket->address.host != Server.host || SocketPacket->address.port != Server.port)
+		{
+			continue;
+		}
+		ClientStats.BytesReceived += SocketPacket->len;
+		Incoming.Add(SocketPacket->data, SocketPacket->len, ReadTime);
+	}
+
+	std::vector<Packet> Received;
+	Incoming.Update([this, &Received](const uint8_t* Data, size_t Length, Clock::time_point DeliveryTime)
+		{
+			Connections.Receive(Data, Length, &Server, Received, DeliveryTime);
+		});
+	for (const Packet& p : Received)
+	{
+		HandlePacket(p.Data);
+	}
+}
+
+void SimulatedClient::Tick()
+{
+	NumTicks++;
+	if (WasDisconnected)
+	{
+		return;
+	}
+
+	if (!IsConnected)
+	{
+		if (LastConnectAttempt == Clock::time_point())
+		{
+			FirstConnectAttempt = Clock::now();
+		}
+		if (LastConnectAttempt == Clock::time_point() || SecondsSince(LastConnectAttempt) > CONNECT_RETRY_TIME)
+		{
+			SendPacket({ (uint8_t)Packet::PacketType::ConnectRequest }, Connection::Channel::Unreliable);
+			LastConnectAttempt = Clock::now();
+		}
+		Connections.Update();
+		return;
+	}
+
+	// Owned objects move in a circle, so every tick changes their position like player input would.
+	// They are sent like Replication::SendObjects() sends them from a real client: as full states in binary snapshots.
+	float Angle = (float)NumTicks * 0.05f;
+	BitWriter Content;
+	size_t HeaderBits = 0;
+	auto StartSnapshot = [&]()
+		{
+			Content = BitWriter();
+			// Clients don't track snapshot sequences, the tick and game time are the client's own.
+			PacketLayout::SnapshotHeader Header;
+			Header.Tick = NumTicks;
+			Header.Time = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - FirstConnectAttempt).count();
+			Header.Write(Content);
+			HeaderBits = Content.GetNumBits();
+		};
+	auto SendSnapshot = [&]()
+		{
+			std::vector<uint8_t> Snapshot = { (uint8_t)Packet::PacketType::Snapshot };
+			Snapshot.insert(Snapshot.end(), Content.GetData().begin(), Content.GetData().end());
+			SendPacket(Snapshot, Connection::Channel::Unreliable);
+		};
+
+	StartSnapshot();
+	for (uint64_t NetID : OwnedObjects)
+	{
+		BitWriter ObjectData;
+		// Clients always send full states, without a baseline.
+		PacketLayout::WriteObjectStart(ObjectData, NetID, 0);
+		// A transform owned by this client, without a correction. The simulated client never applies corrections.
+		PacketLayout::FullTransform ObjectTransform;
+		ObjectTransform.Owner = ClientID;
+		ObjectTransform.Position[0] = std::cos(Angle) * 10.0f;
+		ObjectTransform.Position[2] = std::sin(Angle) * 10.0f;
+		ObjectData.WriteBool(true);
+		ObjectTransform.Write(ObjectData);
+		// The simulated client doesn't know the net properties of its objects. The object ends here, so they are read as unchanged.
+
+		BitWriter ObjectHeader;
+		PacketLayout::WriteObjectSize(ObjectHeader, ObjectData.GetNumBits());
+		if (Content.GetNumBits() > HeaderBits
+			&& Content.GetNumBits() + ObjectHeader.GetNumBits() + ObjectData.GetNumBits() > PacketLayout::SNAPSHOT_CAPACITY)
+		{
+			SendSnapshot();
+			StartSnapshot();
+		}
+		Content.Append(ObjectHeader);
+		Content.Append(ObjectData);
+	}
+	if (Content.GetNumBits() > HeaderBits)
+	{
+		SendSnapshot();
+	}
+
+	if (!PendingAcknowledgements.empty() || SecondsSince(LastSendTime) > KEEP_ALIVE_TIME)
+	{
+		// Same format as Replication::SendAcknowledgements(), with no objects that failed to apply.
+		size_t NumAcks = std::min(PendingAcknowledgements.size(), MAX_ACKNOWLEDGEMENTS);
+		BitWriter Writer;
+		Writer.WriteVarUInt(NumAcks);
+		for (size_t i = 0; i < NumAcks; i++)
+		{
+			Writer.WriteVarUInt(PendingAcknowledgements[i]);
+			Writer.WriteVarUInt(0);
+		}
+		PendingAcknowledgements.clear();
+
+		std::vector<uint8_t> Ack = { (uint8_t)Packet::PacketType::SnapshotAck };
+		Ack.insert(Ack.end(), Writer.GetData().begin(), Writer.GetData().end());
+		SendPacket(Ack, Connection::Channel::Unreliable);
+	}
+
+	Connections.Update();
+}
+
+void SimulatedClient::FlushSends()
+{
+	Outgoing.Update([this](const uint8_t* Data, size_t Length, Clock::time_point)
+		{
+			SendDatagram(Data, Length);
+		});
+}
+
+void SimulatedClient::Disconnect()
+{
+	if (!IsConnected)
+	{
+		return;
+	}
+	BypassLink = true;
+	Outgoing.Flush([this](const uint8_t* Data, size_t Length, Clock::time_point)
+		{
+			SendDatagram(Data, Length);
+		});
+	SendPacket({ (uint8_t)Packet::PacketType::DisconnectRequest }, Connection::Channel::Unreliable);
+	IsConnected = false;
+}
+
+void SimulatedClient::AddToSocketSet(SDLNet_SocketSet Set)
+{
+	SDLNet_UDP_AddSocket(Set, Socket);
+}
+
+SimulatedClient::Clock::time_point SimulatedClient::GetNextDeliveryTime() const
+{
+	return std::min(Outgoing.GetNextDeliveryTime(), Incoming.GetNextDeliveryTime());
+}
+
+bool SimulatedClient::GetIsConnected() const
+{
+	return IsConnected;
+}
+
+bool SimulatedClient::GetWasDisconnected() const
+{
+	return WasDisconnected;
+}
+
+uint32_t SimulatedClient::GetServerTickRate() const
+{
+	return ServerTickRate;
+}
+
+size_t SimulatedClient::GetNumOwnedObjects() const
+{
+	return OwnedObjects.size();
+}
+
+const SimulatedClient::Stats& SimulatedClient::GetStats() const
+{
+	return ClientStats;
+}
+
+std::vector<Connection::Stats> SimulatedClient::GetConnectionStats()
+{
+	return Connections.GetStats();
+}
+
+uint64_t SimulatedClient::GetNumDropped() const
+{
+	return Outgoing.GetNumDropped() + Incoming.GetNumDropped();
+}
+
+void SimulatedClient::HandlePacket(const std::vector<uint8_t>& Data)
+{
+	if (Data.empty())
+	{
+		return;
+	}
+
+	switch ((Packet::PacketType)Data[0])
+	{
+	case Packet::PacketType::ConnectionAccept:
+		if (IsConnected || Data.size() < 1 + sizeof(uint64_t))
+		{
+			break;
+		}
+		ClientID = Read<uint64_t>(Data, 1);
+		IsConnected = true;
+		ClientStats.ConnectTime = SecondsSince(FirstConnectAttempt);
+		break;
+	case Packet::PacketType::DisconnectRequest:
+		IsConnected = false;
+		WasDisconnected = true;
+		break;
+	case Packet::PacketType::NetworkEventTrigger:
+	{
+		if (Data.size() < PacketLayout::EVENT_ARGUMENTS_OFFSET)
+		{
+			break;
+		}
+		uint64_t EventID = Read<uint64_t>(Data, 1);
+		uint64_t ObjectID = Read<uint64_t>(Data, PacketLayout::EVENT_OBJECT_OFFSET);
+		uint32_t Hash = Read<uint32_t>(Data, PacketLayout::EVENT_HASH_OFFSET);
+		// The server only sends objects once the scene travel has been accepted.
+		if (ObjectID == UINT64_MAX && Hash == NetworkEvent::SCENE_EVENT)
+		{
+			std::vector<uint8_t> Accept = { (uint8_t)Packet::PacketType::NetworkEventAccept };
+			Write(Accept, EventID);
+			SendPacket(Accept, Connection::Channel::ReliableOrdered);
+		}
+		break;
+	}
+	case Packet::PacketType::SpawnObject:
+		if (Data.size() >= PacketLayout::SPAWN_TRANSFORM_OFFSET && Read<uint64_t>(Data, PacketLayout::SPAWN_OWNER_OFFSET) == ClientID)
+		{
+			OwnedObjects.push_back(Read<uint64_t>(Data, PacketLayout::SPAWN_NETID_OFFSET));
+		}
+		break;
+	case Packet::PacketType::Snapshot:
+	{
+		BitReader Reader = BitReader(Data.data() + 1, Data.size() - 1);
+		PacketLayout::SnapshotHeader Header = PacketLayout::SnapshotHeader::Read(Reader);
+		uint64_t Tick = Header.Tick;
+		if (Reader.HasError())
+		{
+			break;
+		}
+		PendingAcknowledgements.push_back(Header.Sequence);
+		if (ClientStats.NumSnapshots == 0)
+		{
+			ClientStats.FirstTick = Tick;
+			ClientStats.FirstSnapshotTime = Clock::now();
+		}
+		if (Tick >= ClientStats.LatestTick)
+		{
+			ClientStats.LatestTick = Tick;
+			ClientStats.LatestSnapshotTime = Clock::now();
+		}
+		ClientStats.NumSnapshots++;
+		break;
+	}
+	case Packet::PacketType::TickRate:
+		ServerTickRate = Read<uint32_t>(Data, 1);
+		break;
+	default:
+		break;
+	}
+}
+
+void SimulatedClient::SendPacket(const std::vector<uint8_t>& Data, Connection::Channel UsedChannel)
+{
+	Connections.Send(Data, &Server, UsedChannel);
+	LastSendTime = Clock::now();
+}
+
+void SimulatedClient::SendDatagram(const uint8_t* Data, size_t Length)
+{
+	SocketPacket->address = Server;
+	SocketPacket->len = (int)Length;
+	memcpy(SocketPacket->data, Data, Length);
+	SDLNet_UDP_Send(Socket, -1, SocketPacket);
+	ClientStats.BytesSent += Length;
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL_net.h>
+#include <Networking/Connection.h>
+#include "LinkSimulator.h"
+
+/**
+* @brief
+* A client connecting to a server over loopback, without running the engine.
+*
+* It does what a real client does over the network: it sends a ConnectRequest, accepts the scene travel event,
+* acknowledges every snapshot and sends the position of each object it owns every tick, in binary snapshots like a real client.
+* Received snapshots are acknowledged without being decoded, since there are no objects to apply them to.
+*
+* All datagrams go through a LinkSimulator in each direction.
+*/
+class SimulatedClient
+{
+public:
+	using Clock = LinkSimulator::Clock;
+
+	struct Stats
+	{
+		uint64_t BytesSent = 0;
+		uint64_t BytesReceived = 0;
+		uint64_t NumSnapshots = 0;
+		uint64_t FirstTick = 0;
+		uint64_t LatestTick = 0;
+		Clock::time_point FirstSnapshotTime;
+		Clock::time_point LatestSnapshotTime;
+		/// Seconds between the first ConnectRequest and the ConnectionAccept. Negative if not connected yet.
+		double ConnectTime = -1;
+	};
+
+	SimulatedClient(IPaddress Server, const LinkSimulator::Settings& LinkSettings, uint32_t Seed, std::vector<float>* RoundTripSamples);
+	~SimulatedClient();
+	SimulatedClient(const SimulatedClient&) = delete;
+	SimulatedClient& operator=(const SimulatedClient&) = delete;
+
+	/// Opens the socket of the client. Returns false on failure.
+	bool Open();
+
+	/// Reads datagrams from the socket and handles the ones the simulated link delivers.
+	void Receive();
+	/// Connects, or sends input and acknowledgements if connected. Called once per client tick.
+	void Tick();
+	/// Sends the datagrams the simulated link delivers.
+	void FlushSends();
+	/// Sends a DisconnectRequest, bypassing the simulated link.
+	void Disconnect();
+
+	/// Adds the socket of the client to Set, so the caller can wait for datagrams.
+	void AddToSocketSet(SDLNet_SocketSet Set);
+	/// The time the next datagram is delivered by one of the simulated links.
+	Clock::time_point GetNextDeliveryTime() const;
+
+	bool GetIsConnected() const;
+	bool GetWasDisconnected() const;
+	uint32_t GetServerTickRate() const;
+	size_t GetNumOwnedObjects() const;
+	const Stats& GetStats() const;
+	std::vector<Connection::Stats> GetConnectionStats();
+	uint64_t GetNumDropped() const;
+
+private:
+	void HandlePacket(const std::vector<uint8_t>& Data);
+	void SendPacket(const std::vector<uint8_t>& Data, Connection::Channel UsedChannel);
+	void SendDatagram(const uint8_t* Data, size_t Length);
+
+	IPaddress Server;
+	UDPsocket Socket = nullptr;
+	UDPpacket* SocketPacket = nullptr;
+	Connection::Endpoint Connections;
+	LinkSimulator Outgoing;
+	LinkSimulator Incoming;
+	bool BypassLink = false;
+
+	bool IsConnected = false;
+	bool WasDisconnected = false;
+	uint64_t ClientID = 0;
+	uint32_t ServerTickRate = 0;
+	Clock::time_point FirstConnectAttempt;
+	Clock::time_point LastConnectAttempt;
+	Clock::time_point LastSendTime;
+	uint64_t NumTicks = 0;
+	std::vector<uint64_t> OwnedObjects;
+	std::vector<uint32_t> PendingAcknowledgements;
+	Stats ClientStats;
+};
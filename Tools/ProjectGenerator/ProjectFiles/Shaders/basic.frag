@@ -18,8 +18,6 @@ uniform vec3 u_emissive = vec3(0, 0, 0);
 // Should the rear side of a two-sided face have it's normal reversed
 uniform bool u_reverseNormal = true;
 
-uniform float u_time = 0;
-
 void main()
 {
 	bool transparent = false;
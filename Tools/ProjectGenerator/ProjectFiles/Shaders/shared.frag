@@ -3,19 +3,40 @@
 struct DirectionalLight
 {
 	vec3 Direction;
-	vec3 SunColor;
-	vec3 AmbientColor;
 	float Intensity;
+	vec3 SunColor;
 	float AmbientIntensity;
+	vec3 AmbientColor;
 };
 
-struct PointLight
+// Values that are the same for every object drawn into a framebuffer. Uploaded once per framebuffer by the engine.
+// Must be the same in shared.vert and shared.frag.
+layout (std140) uniform FrameData
 {
-	vec3 Position;
-	vec3 Color;
-	float Intensity;
-	float Falloff;
-	bool Active;
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewpro;
+	DirectionalLight u_directionallight;
+	float cascadePlaneDistances[8];
+	vec3 u_cameraposition;
+	float u_biasmodifier;
+	vec3 u_cameraforward;
+	float u_time;
+	vec3 FogColor;
+	float FogFalloff;
+	vec3 GiScale;
+	float FogDistance;
+	float FogMaxDensity;
+	int cascadeCount;
+	int u_shadows;
+	int u_shadowQuality;
+	int GiRes;
+	bool GiEnabled;
+	float farPlane;
+	float u_clusterScale;
+	uvec3 u_clusterCount;
+	float u_clusterBias;
+	vec2 u_screenSize;
 };
 
 uniform mat4 u_modelviewpro;
@@ -33,31 +54,46 @@ in vec3 v_screenposition;
 in vec3 v_screennormal;
 
 uniform sampler2DArray shadowMap;
-uniform mat4 u_view;
-uniform int cascadeCount = 4;
-uniform float cascadePlaneDistances[8];
-uniform float u_biasmodifier = 0;
-uniform DirectionalLight u_directionallight;
-uniform int u_shadowQuality = 0;
-uniform vec3 u_cameraposition = vec3(0);
-uniform int u_shadows = 0;
-uniform PointLight u_lights[8];
 uniform samplerCube Skybox;
 uniform sampler3D GiMap;
-uniform int GiRes;
-uniform bool GiEnabled;
-uniform vec3 GiScale;
 
 layout (std140, binding = 0) uniform LightSpaceMatrices
 {
 	mat4 lightSpaceMatrices[8];
 };
 
+struct PointLight
+{
+	vec3 Position;
+	float Intensity;
+	vec3 Color;
+	float Falloff;
+};
+
+// Point lights are sorted into a grid of clusters by the engine. See LightClusters.h.
+layout (std430, binding = 0) readonly buffer LightData
+{
+	PointLight u_lights[];
+};
+
+// x = first index in u_lightIndices, y = number of lights in the cluster.
+layout (std430, binding = 1) readonly buffer LightClusterData
+{
+	uvec2 u_lightClusters[];
+};
 
-uniform float FogFalloff = 0;
-uniform float FogDistance = 0;
-uniform float FogMaxDensity = 0;
-uniform vec3 FogColor = vec3(0);
+layout (std430, binding = 2) readonly buffer LightIndexData
+{
+	uint u_lightIndices[];
+};
+
+uvec2 GetLightCluster()
+{
+	uvec2 Tile = min(uvec2(gl_FragCoord.xy / u_screenSize * vec2(u_clusterCount.xy)), u_clusterCount.xy - 1u);
+	float Depth = max(-v_screenposition.z, 0.001);
+	uint Slice = uint(clamp(log(Depth) * u_clusterScale + u_clusterBias, 0, float(u_clusterCount.z - 1)));
+	return u_lightClusters[Tile.x + Tile.y * u_clusterCount.x + Slice * u_clusterCount.x * u_clusterCount.y];
+}
 
 vec4 ApplyFogColor(vec4 InColor)
 {
@@ -209,18 +245,16 @@ vec3 GetLightingNormal(vec3 color, float specularstrength, float specularsize, v
 
 	vec3 lightingColor = vec3(0);
 
-	for (int i = 0; i < 8; i++)
+	uvec2 cluster = GetLightCluster();
+	for (uint i = cluster.x; i < cluster.x + cluster.y; i++)
 	{
-		if (u_lights[i].Active)
-		{
-			vec3 pointLightDir = (u_lights[i].Position - v_position);
-			float LightingIntensity = max(dot(normal, normalize(pointLightDir)), 0);
-			vec3 newLightColor = vec3((u_lights[i].Falloff * 100) - (length(pointLightDir) * length(pointLightDir))) / (u_lights[i].Falloff);
-			newLightColor *= (u_lights[i].Color * u_lights[i].Intensity * LightingIntensity) / 200.0;
-			newLightColor = max(newLightColor, 0);
-			lightingColor += newLightColor;
-		}
-		else break;
+		PointLight pointLight = u_lights[u_lightIndices[i]];
+		vec3 pointLightDir = (pointLight.Position - v_position);
+		float LightingIntensity = max(dot(normal, normalize(pointLightDir)), 0);
+		vec3 newLightColor = vec3((pointLight.Falloff * 100) - (length(pointLightDir) * length(pointLightDir))) / (pointLight.Falloff);
+		newLightColor *= (pointLight.Color * pointLight.Intensity * LightingIntensity) / 200.0;
+		newLightColor = max(newLightColor, 0);
+		lightingColor += newLightColor;
 	}
 
 	return ambient + (DirectionalLightColor + specular * u_directionallight.Intensity * 0.5) * shadow + ambient * lightingColor;
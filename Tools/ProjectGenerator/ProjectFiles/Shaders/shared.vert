@@ -13,22 +13,54 @@ out vec3 v_screenposition;
 out vec3 v_normal;
 out vec3 v_screennormal;
 uniform mat4 u_modelviewpro;
-uniform mat4 u_invmodelview;
 uniform mat4 u_lightspacematrix;
-uniform mat4 u_view;
-uniform mat4 u_projection;
-uniform mat4 u_viewpro;
-uniform vec3 u_cameraposition = vec3(0);
 
 struct DirectionalLight
 {
 	vec3 Direction;
-	vec3 SunColor;
-	vec3 AmbientColor;
 	float Intensity;
+	vec3 SunColor;
 	float AmbientIntensity;
+	vec3 AmbientColor;
+};
+
+// Values that are the same for every object drawn into a framebuffer. Uploaded once per framebuffer by the engine.
+// Must be the same in shared.vert and shared.frag.
+layout (std140) uniform FrameData
+{
+	mat4 u_view;
+	mat4 u_projection;
+	mat4 u_viewpro;
+	DirectionalLight u_directionallight;
+	float cascadePlaneDistances[8];
+	vec3 u_cameraposition;
+	float u_biasmodifier;
+	vec3 u_cameraforward;
+	float u_time;
+	vec3 FogColor;
+	float FogFalloff;
+	vec3 GiScale;
+	float FogDistance;
+	float FogMaxDensity;
+	int cascadeCount;
+	int u_shadows;
+	int u_shadowQuality;
+	int GiRes;
+	bool GiEnabled;
+	float farPlane;
+	float u_clusterScale;
+	uvec3 u_clusterCount;
+	float u_clusterBias;
+	vec2 u_screenSize;
 };
-uniform DirectionalLight u_directionallight;
+
+// The inverse transposed model view matrix of the instance that is drawn.
+// Computed here since instanced draws use a different model matrix for every instance.
+mat4 GetInvModelView()
+{
+	return transpose(inverse(u_view * a_model));
+}
+#define u_invmodelview GetInvModelView()
 
 vec3 TranslatePosition(vec3 relativePos)
 {